@@ -0,0 +1,195 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <cctype>
+
+// --------------------------------------------------------
+// Turns a relative asset path into the key used by the caches
+//  - separators become '/', "." and "x/.." segments are removed
+//  - letters are lowered since the file system is case insensitive
+// so "Models\\DeadTree.obj" and "./models/DeadTree.obj" share an entry
+// --------------------------------------------------------
+inline std::string CanonicalAssetPath(const std::string& path)
+{
+	std::vector<std::string> parts;
+	std::string part;
+	bool rooted = !path.empty() && (path[0] == '/' || path[0] == '\\');
+
+	for (size_t i = 0; i <= path.size(); i++)
+	{
+		char c = i < path.size() ? path[i] : '/';
+		if (c != '/' && c != '\\')
+		{
+			part += (char)std::tolower((unsigned char)c);
+			continue;
+		}
+
+		// end of a segment
+		if (part == "..")
+		{
+			if (!parts.empty() && parts.back() != "..") parts.pop_back();
+			else if (!rooted) parts.push_back(part);
+		}
+		else if (!part.empty() && part != ".")
+		{
+			parts.push_back(part);
+		}
+		part.clear();
+	}
+
+	std::string result = rooted ? "/" : "";
+	for (size_t i = 0; i < parts.size(); i++)
+	{
+		if (i > 0) result += '/';
+		result += parts[i];
+	}
+	return result;
+}
+
+// --------------------------------------------------------
+// Hit/miss and memory counters for an asset cache
+// --------------------------------------------------------
+struct AssetCacheStats
+{
+	unsigned int hits = 0;
+	unsigned int misses = 0;
+	unsigned int failures = 0;
+	size_t bytes = 0;       // bytes held by the unique assets
+	size_t bytesSaved = 0;  // bytes a load per request would have cost on top
+};
+
+// --------------------------------------------------------
+// Keeps one shared instance of every asset that was loaded
+// from a given path.
+//
+// The cache knows nothing about DirectX, the loader and the
+// size callbacks are given to it by whoever owns the device.
+// --------------------------------------------------------
+template <typename T>
+class AssetCache
+{
+public:
+	using Loader = std::function<std::shared_ptr<T>(const std::string& path)>;
+	using Sizer = std::function<size_t(const T& asset)>;
+
+	AssetCache() = default;
+	AssetCache(Loader _loader, Sizer _sizer) : loader(_loader), sizer(_sizer) {}
+
+	// returns the cached asset, loading it the first time the path is seen
+	std::shared_ptr<T> Get(const std::string& path)
+	{
+		return GetOrLoad(CanonicalAssetPath(path), [this, &path]() { return loader ? loader(path) : nullptr; });
+	}
+
+	// same as Get(), for assets whose key needs more than the path,
+	// the caller builds the key and says how to load it on a miss
+	std::shared_ptr<T> GetOrLoad(const std::string& key, const std::function<std::shared_ptr<T>()>& load)
+	{
+		auto itr = assets.find(key);
+		if (itr != assets.end())
+		{
+			stats.hits++;
+			stats.bytesSaved += itr->second.bytes;
+			itr->second.hits++;
+			return itr->second.asset;
+		}
+
+		stats.misses++;
+		std::shared_ptr<T> asset = load();
+		if (asset == nullptr)
+		{
+			// don't remember failures, the file may show up later
+			stats.failures++;
+			return nullptr;
+		}
+
+		Entry entry;
+		entry.asset = asset;
+		entry.bytes = sizer ? sizer(*asset) : 0;
+		entry.hits = 0;
+		stats.bytes += entry.bytes;
+		assets.insert({ key, entry });
+		return asset;
+	}
+
+	// true if the path has already been loaded
+	bool Contains(const std::string& path) const { return ContainsKey(CanonicalAssetPath(path)); }
+	bool ContainsKey(const std::string& key) const { return assets.find(key) != assets.end(); }
+
+	// forgets assets nobody else is holding on to, returns how many were dropped
+	size_t Trim()
+	{
+		size_t dropped = 0;
+		for (auto itr = assets.begin(); itr != assets.end();)
+		{
+			if (itr->second.asset.use_count() == 1)
+			{
+				stats.bytes -= itr->second.bytes;
+				itr = assets.erase(itr);
+				dropped++;
+			}
+			else
+			{
+				++itr;
+			}
+		}
+		return dropped;
+	}
+
+	// forgets assets that were cached before their load finished and then turned out
+	// to have failed, so they're counted as failures and the next request tries again
+	size_t RemoveFailed(const std::function<bool(const T& asset)>& failed)
+	{
+		size_t removed = 0;
+		for (auto itr = assets.begin(); itr != assets.end();)
+		{
+			if (failed(*itr->second.asset))
+			{
+				stats.bytes -= itr->second.bytes;
+				stats.failures++;
+				itr = assets.erase(itr);
+				removed++;
+			}
+			else
+			{
+				++itr;
+			}
+		}
+		return removed;
+	}
+
+	void Clear() { assets.clear(); stats.bytes = 0; }
+
+	// asks the sizer again, for assets that were still loading when they were cached
+	void RecountBytes()
+	{
+		stats.bytes = 0;
+		stats.bytesSaved = 0;
+		for (auto& pair : assets)
+		{
+			Entry& entry = pair.second;
+			entry.bytes = sizer ? sizer(*entry.asset) : 0;
+			stats.bytes += entry.bytes;
+			stats.bytesSaved += entry.bytes * entry.hits;
+		}
+	}
+
+	inline size_t GetCount() const { return assets.size(); }
+	inline const AssetCacheStats& GetStats() const { return stats; }
+
+private:
+	struct Entry
+	{
+		std::shared_ptr<T> asset;
+		size_t bytes;
+		unsigned int hits;
+	};
+
+	std::unordered_map<std::string, Entry> assets;
+	AssetCacheStats stats;
+	Loader loader;
+	Sizer sizer;
+};
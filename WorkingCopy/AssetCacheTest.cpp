@@ -0,0 +1,113 @@
+#include "AssetCache.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Checks CanonicalAssetPath gives every spelling of a path
+// the same key, and that AssetCache loads each key once and
+// counts its hits, misses, failures and bytes the way the
+// mesh and texture caches report them
+// --------------------------------------------------------
+
+namespace
+{
+	// what the cache holds in place of a mesh, sized by its byte count
+	struct FakeAsset
+	{
+		std::string path;
+		size_t bytes;
+	};
+}
+
+int main()
+{
+	// separators, case, "." and ".." all come out the same
+	CHECK(CanonicalAssetPath("Models/DeadTree.obj") == "models/deadtree.obj");
+	CHECK(CanonicalAssetPath("Models\\DeadTree.obj") == "models/deadtree.obj");
+	CHECK(CanonicalAssetPath("./models/DEADTREE.OBJ") == "models/deadtree.obj");
+	CHECK(CanonicalAssetPath("Models//./DeadTree.obj") == "models/deadtree.obj");
+	CHECK(CanonicalAssetPath("Textures/../Models/DeadTree.obj") == "models/deadtree.obj");
+	CHECK(CanonicalAssetPath("Models\\Trees\\..\\.\\DeadTree.obj") == "models/deadtree.obj");
+	CHECK(CanonicalAssetPath("Models/DeadTree.obj/") == "models/deadtree.obj");
+	// ".." past the start is kept for relative paths and dropped at the root
+	CHECK(CanonicalAssetPath("../Assets/Models/a.obj") == "../assets/models/a.obj");
+	CHECK(CanonicalAssetPath("../../a.obj") == "../../a.obj");
+	CHECK(CanonicalAssetPath("a/../../b.obj") == "../b.obj");
+	CHECK(CanonicalAssetPath("/../a.obj") == "/a.obj");
+	CHECK(CanonicalAssetPath("\\Models\\a.obj") == "/models/a.obj");
+	CHECK(CanonicalAssetPath("") == "");
+	CHECK(CanonicalAssetPath("./") == "");
+	// different files stay different
+	CHECK(CanonicalAssetPath("Models/a.obj") != CanonicalAssetPath("Models/b.obj"));
+	CHECK(CanonicalAssetPath("Models/a.obj") != CanonicalAssetPath("a.obj"));
+
+	// a loader that knows a few files and counts what it's asked for
+	std::vector<std::string> loaded;
+	AssetCache<FakeAsset> cache(
+		[&](const std::string& path) -> std::shared_ptr<FakeAsset> {
+			loaded.push_back(path);
+			if (CanonicalAssetPath(path) == "models/missing.obj") return nullptr;
+			return std::make_shared<FakeAsset>(FakeAsset{ path, CanonicalAssetPath(path).size() * 100 });
+		},
+		[](const FakeAsset& asset) { return asset.bytes; });
+
+	std::shared_ptr<FakeAsset> tree = cache.Get("Models/DeadTree.obj");
+	std::shared_ptr<FakeAsset> again = cache.Get("./models\\deadtree.OBJ");
+	std::shared_ptr<FakeAsset> cube = cache.Get("Models/cube.obj");
+	CHECK(tree && tree == again);
+	CHECK(cube && cube != tree);
+	CHECK(loaded.size() == 2);
+	CHECK(cache.GetCount() == 2);
+	CHECK(cache.Contains("MODELS/DeadTree.obj") && !cache.Contains("Models/sphere.obj"));
+	const AssetCacheStats& stats = cache.GetStats();
+	CHECK(stats.hits == 1 && stats.misses == 2 && stats.failures == 0);
+	CHECK(stats.bytes == tree->bytes + cube->bytes);
+	CHECK(stats.bytesSaved == tree->bytes);
+
+	// failures aren't remembered, the next request asks the loader again
+	CHECK(cache.Get("Models/missing.obj") == nullptr);
+	CHECK(cache.Get("Models/Missing.obj") == nullptr);
+	CHECK(loaded.size() == 4);
+	CHECK(stats.misses == 4 && stats.failures == 2 && cache.GetCount() == 2);
+
+	// GetOrLoad takes the caller's key as it is
+	int loads = 0;
+	auto makeLinear = [&]() { loads++; return std::make_shared<FakeAsset>(FakeAsset{ "linear", 7 }); };
+	std::shared_ptr<FakeAsset> linear = cache.GetOrLoad("models/deadtree.obj|linear", makeLinear);
+	CHECK(cache.GetOrLoad("models/deadtree.obj|linear", makeLinear) == linear);
+	CHECK(loads == 1 && cache.GetCount() == 3);
+	CHECK(stats.bytes == tree->bytes + cube->bytes + 7);
+
+	// Trim drops only what nobody else holds
+	again.reset();
+	linear.reset();
+	CHECK(cache.Trim() == 1);
+	CHECK(cache.Contains("Models/DeadTree.obj") && !cache.ContainsKey("models/deadtree.obj|linear"));
+	CHECK(stats.bytes == tree->bytes + cube->bytes);
+	cube.reset();
+	CHECK(cache.Trim() == 1);
+	CHECK(cache.GetCount() == 1 && stats.bytes == tree->bytes);
+	CHECK(cache.Trim() == 0);
+
+	// an asset cached before its load finished: RemoveFailed counts it as a failure,
+	// RecountBytes picks up the size it has once loaded
+	std::shared_ptr<FakeAsset> pending = cache.GetOrLoad("pending", []() { return std::make_shared<FakeAsset>(FakeAsset{ "pending", 0 }); });
+	CHECK(cache.GetOrLoad("pending", []() { return std::shared_ptr<FakeAsset>(); }) == pending);
+	pending->bytes = 500;
+	cache.RecountBytes();
+	CHECK(stats.bytes == tree->bytes + 500);
+	CHECK(stats.bytesSaved == tree->bytes + 500);
+	unsigned int failures = stats.failures;
+	CHECK(cache.RemoveFailed([](const FakeAsset& asset) { return asset.path == "pending"; }) == 1);
+	CHECK(stats.failures == failures + 1 && stats.bytes == tree->bytes);
+	CHECK(!cache.ContainsKey("pending"));
+
+	cache.Clear();
+	CHECK(cache.GetCount() == 0 && stats.bytes == 0);
+	printf("%u hits, %u misses, %u failures\n", stats.hits, stats.misses, stats.failures);
+
+	return TestResult();
+}
@@ -0,0 +1,112 @@
+#include "AssetLoader.h"
+#include <cstdio>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <objbase.h>
+#endif
+
+AssetLoader::AssetLoader(unsigned int threadCount)
+{
+	if (threadCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		workers.push_back(std::thread(&AssetLoader::WorkerLoop, this));
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(jobLock);
+		stopping = true;
+	}
+	jobReady.notify_all();
+
+	for (auto& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+size_t AssetLoader::BeginAsset(const std::string& name)
+{
+	// a batch is timed from its first request to the end of Finish()
+	if (!batchStarted)
+	{
+		timings.clear();
+		batchStart = std::chrono::high_resolution_clock::now();
+		batchStarted = true;
+	}
+
+	timings.push_back(AssetTiming());
+	timings.back().name = name;
+	return timings.size() - 1;
+}
+
+void AssetLoader::Enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(jobLock);
+		jobs.push_back(job);
+	}
+	jobReady.notify_one();
+}
+
+void AssetLoader::WorkerLoop()
+{
+#ifdef _WIN32
+	// image decoding goes through WIC, which needs COM on this thread
+	CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+#endif
+
+	while (true)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(jobLock);
+			jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+			if (jobs.empty()) break;
+
+			job = jobs.front();
+			jobs.pop_front();
+		}
+		job();
+	}
+
+#ifdef _WIN32
+	CoUninitialize();
+#endif
+}
+
+void AssetLoader::Finish()
+{
+	// uploads wait on their own job, so this also waits for the workers
+	for (size_t i = 0; i < uploads.size(); i++)
+	{
+		uploads[i]();
+	}
+	uploads.clear();
+
+	totalMs = batchStarted ? std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - batchStart).count() : 0.0;
+	batchStarted = false;
+}
+
+void AssetLoader::PrintTimings() const
+{
+	double loadSum = 0;
+	double uploadSum = 0;
+	for (const AssetTiming& timing : timings)
+	{
+		printf("  %-40s load %8.2f ms  upload %8.2f ms\n", timing.name.c_str(), timing.loadMs, timing.uploadMs);
+		loadSum += timing.loadMs;
+		uploadSum += timing.uploadMs;
+	}
+	printf("Loaded %zu assets on %u threads in %.2f ms (%.2f ms of loading, %.2f ms of uploads)\n",
+		timings.size(), GetThreadCount(), totalMs, loadSum, uploadSum);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <chrono>
+
+// --------------------------------------------------------
+// How long one asset took in each stage
+// --------------------------------------------------------
+struct AssetTiming
+{
+	std::string name;
+	double loadMs = 0;      // decode / parse on a worker thread
+	double uploadMs = 0;    // creating the GPU resource on the owning thread
+};
+
+// --------------------------------------------------------
+// Loads assets on a pool of worker threads.
+//
+// Every asset is split in two stages:
+//  - work:   reads and decodes the file, runs on a worker
+//  - upload: hands the result to the device, runs on the
+//            thread that owns the loader, inside Finish()
+//
+// Finish() is the barrier before gameplay: it waits for all
+// the workers and runs the uploads in the order requested
+// --------------------------------------------------------
+class AssetLoader
+{
+public:
+	// 0 threads means one per core, minus the one we're on
+	explicit AssetLoader(unsigned int threadCount = 0);
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+
+	// queues an asset, the future holds the CPU result once the worker is done
+	template <typename T>
+	std::shared_future<std::shared_ptr<T>> Load(const std::string& name, std::function<std::shared_ptr<T>()> work, std::function<void(T&)> upload)
+	{
+		// the job records its own time, the future makes it visible to Finish()
+		auto loadMs = std::make_shared<double>(0.0);
+		auto task = std::make_shared<std::packaged_task<std::shared_ptr<T>()>>([work, loadMs]() {
+			auto start = std::chrono::high_resolution_clock::now();
+			std::shared_ptr<T> asset = work();
+			*loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			return asset;
+		});
+		std::shared_future<std::shared_ptr<T>> result = task->get_future().share();
+
+		size_t slot = BeginAsset(name);
+		Enqueue([task]() { (*task)(); });
+
+		uploads.push_back([this, result, upload, loadMs, slot]() {
+			std::shared_ptr<T> asset = result.get();
+			timings[slot].loadMs = *loadMs;
+			if (asset && upload)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				upload(*asset);
+				timings[slot].uploadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			}
+		});
+		return result;
+	}
+
+	// waits for every queued asset and uploads them on this thread
+	void Finish();
+
+	// prints the per asset and total times of the last Finish()
+	void PrintTimings() const;
+
+	inline const std::vector<AssetTiming>& GetTimings() const { return timings; }
+	inline double GetTotalMs() const { return totalMs; }
+	inline unsigned int GetThreadCount() const { return (unsigned int)workers.size(); }
+
+private:
+	size_t BeginAsset(const std::string& name);
+	void Enqueue(std::function<void()> job);
+	void WorkerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> jobs;
+	std::mutex jobLock;
+	std::condition_variable jobReady;
+	bool stopping = false;
+
+	// only touched by the owning thread
+	std::vector<std::function<void()>> uploads;
+	std::vector<AssetTiming> timings;
+	std::chrono::high_resolution_clock::time_point batchStart;
+	bool batchStarted = false;
+	double totalMs = 0;
+};
@@ -0,0 +1,169 @@
+#include "AssetCache.h"
+#include "AssetLoader.h"
+#include "MeshSource.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Loads meshes the way GameFactory does before the load
+// barrier: the cache hands out an empty placeholder at once
+// and a worker fills it in.  Files that fail on the worker
+// must not stay cached as if they had loaded.
+//
+// Then times the first run's loads of every model, parsing
+// and cooking them, into a stub upload sink that copies the
+// data like CreateBuffer would: one after another on this
+// thread, then through the pool
+// --------------------------------------------------------
+
+namespace
+{
+	// stands in for Mesh, which needs a device
+	struct Placeholder
+	{
+		int indexCount = 0;
+		inline bool IsLoaded() const { return indexCount > 0; }
+	};
+
+	const char* Models[] = {
+		"Models/Campfire.obj", "Models/Campfire_Rocks.obj", "Models/DeadTree.obj", "Models/Plane.obj", "Models/Wall.obj",
+		"Models/cone.obj", "Models/cube.obj", "Models/cylinder.obj", "Models/helix.obj", "Models/sphere.obj", "Models/torus.obj"
+	};
+	const int ModelCount = sizeof(Models) / sizeof(Models[0]);
+
+	// what the device would get, kept so nothing is optimized away
+	struct UploadSink
+	{
+		std::vector<std::vector<unsigned char>> buffers;
+		size_t bytes = 0;
+
+		void Upload(const MeshSource& source)
+		{
+			size_t vertexBytes = (size_t)source.GetVertexCount() * source.GetVertexStride();
+			size_t indexBytes = (size_t)source.GetIndexCount() * source.GetIndexStride();
+			buffers.emplace_back(vertexBytes + indexBytes);
+			memcpy(&buffers.back()[0], source.GetVertices(), vertexBytes);
+			memcpy(&buffers.back()[vertexBytes], source.GetIndices(), indexBytes);
+			bytes += vertexBytes + indexBytes;
+		}
+	};
+
+	// so every run parses and cooks like the first launch
+	void RemoveCooked()
+	{
+		for (const char* model : Models) remove(MeshBinary::GetCookedPath(model).c_str());
+	}
+
+	std::shared_ptr<MeshSource> LoadSource(const char* model)
+	{
+		std::shared_ptr<MeshSource> source = std::make_shared<MeshSource>();
+		if (!source->Load(model)) return std::shared_ptr<MeshSource>();
+		return source;
+	}
+}
+
+int main()
+{
+	// an OBJ that parses but has no faces to draw
+	const char* faceless = "AssetLoaderTestFaceless.obj";
+	FILE* file = fopen(faceless, "w");
+	fprintf(file, "v 0 0 0\nv 1 0 0\nv 0 1 0\n");
+	fclose(file);
+
+	AssetLoader loader(2);
+	AssetCache<Placeholder> cache(
+		[&loader](const std::string& path) {
+			std::shared_ptr<Placeholder> placeholder = std::make_shared<Placeholder>();
+			loader.Load<MeshSource>(path,
+				[path]() {
+					std::shared_ptr<MeshSource> source = std::make_shared<MeshSource>();
+					if (!source->Load(path.c_str())) return std::shared_ptr<MeshSource>();
+					return source;
+				},
+				[placeholder](MeshSource& source) { placeholder->indexCount = source.GetIndexCount(); });
+			return placeholder;
+		},
+		[](const Placeholder& placeholder) { return (size_t)placeholder.indexCount * 4; });
+
+	std::shared_ptr<Placeholder> cube = cache.Get("Models/cube.obj");
+	std::shared_ptr<Placeholder> missing = cache.Get("Models/NotThere.obj");
+	std::shared_ptr<Placeholder> empty = cache.Get(faceless);
+	CHECK(cache.Get("models/CUBE.obj") == cube);
+	CHECK(cache.GetCount() == 3);
+
+	loader.Finish();
+	CHECK(cube->IsLoaded());
+	CHECK(!missing->IsLoaded());
+	CHECK(!empty->IsLoaded());
+
+	// what GameFactory::FinishLoading does with them
+	CHECK(cache.RemoveFailed([](const Placeholder& placeholder) { return !placeholder.IsLoaded(); }) == 2);
+	cache.RecountBytes();
+	CHECK(cache.GetCount() == 1);
+	CHECK(cache.Contains("Models/cube.obj"));
+	CHECK(!cache.Contains("Models/NotThere.obj"));
+	CHECK(!cache.Contains(faceless));
+	CHECK(cache.GetStats().failures == 2);
+	CHECK(cache.GetStats().bytes == (size_t)cube->indexCount * 4);
+
+	// the next request for a failed file tries it again
+	std::shared_ptr<Placeholder> again = cache.Get("Models/NotThere.obj");
+	CHECK(again != missing);
+	CHECK(cache.GetStats().misses == 4);
+
+	remove(faceless);
+
+	// one after another on this thread, the way Game::Init loaded them
+	RemoveCooked();
+	UploadSink serialSink;
+	std::vector<double> serialMs;
+	TestTimer serialTimer;
+	for (const char* model : Models)
+	{
+		TestTimer timer;
+		std::shared_ptr<MeshSource> source = LoadSource(model);
+		CHECK(source != nullptr);
+		if (source) serialSink.Upload(*source);
+		serialMs.push_back(timer.Milliseconds());
+	}
+	double serialTotal = serialTimer.Milliseconds();
+
+	printf("\nserially:\n");
+	for (int i = 0; i < ModelCount; i++) printf("  %-40s %8.2f ms\n", Models[i], serialMs[i]);
+	printf("Loaded %d assets on this thread in %.2f ms\n", ModelCount, serialTotal);
+
+	// through the pool, uploads on this thread in Finish. one worker per core like the game, then four
+	for (unsigned int threads : { 0u, 4u })
+	{
+		RemoveCooked();
+		UploadSink pooledSink;
+		AssetLoader pool(threads);
+		for (const char* model : Models)
+		{
+			pool.Load<MeshSource>(model, [model]() { return LoadSource(model); }, [&pooledSink](MeshSource& source) { pooledSink.Upload(source); });
+		}
+		pool.Finish();
+
+		printf("\nthrough the pool:\n");
+		pool.PrintTimings();
+		printf("%.2fx the serial speed on %u workers, %u cores\n", serialTotal / pool.GetTotalMs(), pool.GetThreadCount(), std::thread::hardware_concurrency());
+
+		// the same data either way, in the order asked for
+		CHECK(pool.GetTimings().size() == (size_t)ModelCount);
+		CHECK(pooledSink.bytes == serialSink.bytes && pooledSink.buffers == serialSink.buffers);
+		for (int i = 0; i < ModelCount; i++)
+		{
+			CHECK(pool.GetTimings()[i].name == Models[i]);
+			CHECK(pool.GetTimings()[i].loadMs > 0.0);
+		}
+		CHECK(pool.GetTotalMs() > 0.0);
+		// with cores to spare, the slowest model is about all the pool has to wait for
+		if (std::thread::hardware_concurrency() >= 4 && pool.GetThreadCount() >= 3) CHECK(pool.GetTotalMs() < serialTotal);
+	}
+
+	return TestResult();
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cmath>
+
+// --------------------------------------------------------
+// A box and a sphere around the same thing, sharing a
+// center.  Meshes keep theirs in model space, the
+// TransformSystem keeps each entity's in world space
+// --------------------------------------------------------
+struct Bounds
+{
+	DirectX::XMFLOAT3 center = DirectX::XMFLOAT3(0, 0, 0);
+	DirectX::XMFLOAT3 extents = DirectX::XMFLOAT3(0, 0, 0);   // half the size of the box
+	float radius = 0.0f;
+
+	// the sphere goes through the corners of the box
+	static Bounds FromMinMax(DirectX::XMFLOAT3 boundsMin, DirectX::XMFLOAT3 boundsMax)
+	{
+		Bounds bounds;
+		bounds.center = DirectX::XMFLOAT3((boundsMin.x + boundsMax.x) * 0.5f, (boundsMin.y + boundsMax.y) * 0.5f, (boundsMin.z + boundsMax.z) * 0.5f);
+		bounds.extents = DirectX::XMFLOAT3((boundsMax.x - boundsMin.x) * 0.5f, (boundsMax.y - boundsMin.y) * 0.5f, (boundsMax.z - boundsMin.z) * 0.5f);
+		bounds.radius = sqrtf(bounds.extents.x * bounds.extents.x + bounds.extents.y * bounds.extents.y + bounds.extents.z * bounds.extents.z);
+		return bounds;
+	}
+
+	// the axis aligned box around this one once world (not transposed) is applied.
+	// each row of the matrix is where one local axis ends up, so the new extents
+	// are the old ones along the absolute rows
+	Bounds Transform(DirectX::FXMMATRIX world) const
+	{
+		using namespace DirectX;
+		Bounds result;
+		XMStoreFloat3(&result.center, XMVector3TransformCoord(XMLoadFloat3(&center), world));
+
+		XMVECTOR x = XMVectorAbs(world.r[0]);
+		XMVECTOR y = XMVectorAbs(world.r[1]);
+		XMVECTOR z = XMVectorAbs(world.r[2]);
+		XMVECTOR e = XMVectorScale(x, extents.x);
+		e = XMVectorAdd(e, XMVectorScale(y, extents.y));
+		e = XMVectorAdd(e, XMVectorScale(z, extents.z));
+		XMStoreFloat3(&result.extents, e);
+
+		// the sphere grows by the largest scale
+		float scaleSq = fmaxf(XMVectorGetX(XMVector3LengthSq(world.r[0])), fmaxf(XMVectorGetX(XMVector3LengthSq(world.r[1])), XMVectorGetX(XMVector3LengthSq(world.r[2]))));
+		result.radius = radius * sqrtf(scaleSq);
+		return result;
+	}
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "Collider.h"
+#include <vector>
+#include <DirectXMath.h>
+
+// which Broadphase CollisionManager files its colliders in
+enum class BROADPHASE_TYPE
+{
+    QUADTREE,
+    SPATIAL_HASH
+};
+
+// --------------------------------------------------------
+// How much work queries have been doing, to compare
+// broadphases and their settings.  tested is how many
+// colliders had their bounds checked, candidates how many
+// of those overlapped
+// --------------------------------------------------------
+struct BroadphaseQueryStats
+{
+    unsigned long long queries = 0;
+    unsigned long long tested = 0;
+    unsigned long long candidates = 0;
+
+    inline float AverageTested() const { return queries ? (float)tested / queries : 0.0f; }
+    inline float AverageCandidates() const { return queries ? (float)candidates / queries : 0.0f; }
+};
+
+// --------------------------------------------------------
+// Finds the colliders whose bounds overlap a given one, so
+// the exact collision tests only run on those.
+//
+// Queries dedup with Collider::queryStamp, so a collider
+// should only be in one broadphase at a time
+// --------------------------------------------------------
+class Broadphase
+{
+public:
+    virtual ~Broadphase() {}
+
+    virtual void Add(Collider* col) = 0;
+    // takes a collider out, e.g. before its entity is destroyed
+    virtual void Remove(Collider* col) = 0;
+    // call after a collider moves
+    virtual void Update(Collider* col) = 0;
+    // fills results with every collider whose bounds overlap col's, each one once.
+    // results is cleared first, reusing the same vector every frame means no allocations
+    virtual void GetCollidableObjects(Collider* col, std::vector<Collider*>& results) = 0;
+    // same for a min x, min y, max x, max y box, like the area a collider sweeps through
+    virtual void GetCollidableObjects(const DirectX::XMFLOAT4& box, std::vector<Collider*>& results) = 0;
+
+    inline const BroadphaseQueryStats& GetQueryStats() const { return queryStats; }
+    inline void ResetQueryStats() { queryStats = BroadphaseQueryStats(); }
+
+protected:
+    BroadphaseQueryStats queryStats;
+};
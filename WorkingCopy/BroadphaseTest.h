@@ -0,0 +1,82 @@
+#pragma once
+#include "ColliderStore.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+// --------------------------------------------------------
+// What the broadphase tests share: random colliders out of
+// the store and the brute force overlap test every query
+// is checked against
+// --------------------------------------------------------
+namespace BroadphaseTest
+{
+	inline float Random(float extent)
+	{
+		return (rand() / (float)RAND_MAX * 2 - 1) * extent;
+	}
+
+	// min x, min y, max x, max y, touching counts
+	inline bool Overlaps(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b)
+	{
+		return !(b.x > a.z || b.z < a.x || b.y > a.w || b.w < a.y);
+	}
+
+	// a tenth are rectangles, some of them big enough to straddle lots of nodes or cells
+	inline std::vector<Collider*> MakeColliders(int count, float extent)
+	{
+		ColliderStore* store = ColliderStore::Instance();
+		std::vector<Collider*> colliders;
+		for (int i = 0; i < count; i++)
+		{
+			ColliderHandle handle = i % 10 == 0
+				? store->CreateRect(DirectX::XMFLOAT2(1.0f + rand() % 12, 1.0f + rand() % 12))
+				: store->CreateCircle(0.3f + rand() / (float)RAND_MAX);
+			Collider* col = store->Get(handle);
+			col->SetCenter(DirectX::XMFLOAT2(Random(extent), Random(extent)));
+			colliders.push_back(col);
+		}
+		return colliders;
+	}
+
+	inline std::vector<Collider*> BruteForce(const std::vector<Collider*>& colliders, const DirectX::XMFLOAT4& box)
+	{
+		std::vector<Collider*> results;
+		for (Collider* col : colliders)
+		{
+			if (Overlaps(col->GetBounds(), box)) results.push_back(col);
+		}
+		return results;
+	}
+
+	// same colliders, each of them once
+	inline bool SameSet(std::vector<Collider*> results, std::vector<Collider*> expected)
+	{
+		std::sort(results.begin(), results.end());
+		std::sort(expected.begin(), expected.end());
+		return std::adjacent_find(results.begin(), results.end()) == results.end() && results == expected;
+	}
+
+	inline DirectX::XMFLOAT4 RandomBox(float extent)
+	{
+		DirectX::XMFLOAT2 center(Random(extent), Random(extent));
+		float half = 0.5f + rand() % 8;
+		return DirectX::XMFLOAT4(center.x - half, center.y - half, center.x + half, center.y + half);
+	}
+
+	// drifts every collider along its velocity, bouncing off the edges, and jumps a few across the map
+	inline void Move(const std::vector<Collider*>& colliders, std::vector<DirectX::XMFLOAT2>& velocity, float extent)
+	{
+		for (size_t i = 0; i < colliders.size(); i++)
+		{
+			DirectX::XMFLOAT2 center = colliders[i]->GetCenter();
+			DirectX::XMFLOAT2& v = velocity[i];
+			center.x += v.x;
+			center.y += v.y;
+			if (center.x > extent || center.x < -extent) v.x = -v.x;
+			if (center.y > extent || center.y < -extent) v.y = -v.y;
+			if (rand() % 500 == 0) center = DirectX::XMFLOAT2(Random(extent), Random(extent));
+			colliders[i]->SetCenter(center);
+		}
+	}
+}
@@ -8,6 +8,7 @@ Camera::Camera()
 	XMStoreFloat4x4(&viewMatrix, XMMatrixIdentity());
 	XMStoreFloat4x4(&projectionMatrix, XMMatrixIdentity());
 	position = XMFLOAT3(0, 0, -5);
+	previousPosition = position;
 	direction = XMFLOAT3(0, 0, 1);
 	rotX = 0;
 	rotY = 0;
@@ -32,12 +33,13 @@ Camera::Camera(float width, float height)
 	rotY = 0;
 	debug = false;
 
-	collider = new Collider(0.2f);
+	collider = ColliderStore::Instance()->CreateCircle(0.2f);
+	ColliderStore::Instance()->Get(collider)->SetLayer(COLLISION_LAYER::PLAYER);
 }
 
 Camera::~Camera()
 {
-	delete collider;
+	ColliderStore::Instance()->Destroy(collider);
 }
 
 DirectX::XMFLOAT4X4 Camera::GetViewMatrix()
@@ -50,6 +52,19 @@ DirectX::XMFLOAT4X4 Camera::GetProjectionMatrix()
 	return projectionMatrix;
 }
 
+Frustum Camera::GetFrustum()
+{
+	return Frustum(GetViewProjection());
+}
+
+XMMATRIX Camera::GetViewProjection()
+{
+	// both are stored transposed for the shaders
+	XMMATRIX view = XMMatrixTranspose(XMLoadFloat4x4(&viewMatrix));
+	XMMATRIX projection = XMMatrixTranspose(XMLoadFloat4x4(&projectionMatrix));
+	return view * projection;
+}
+
 DirectX::XMFLOAT3 Camera::GetPosition()
 {
 	return position;
@@ -70,7 +85,7 @@ DirectX::XMFLOAT3 Camera::GetDirection()
 
 Collider* Camera::GetCollider()
 {
-	return collider;
+	return ColliderStore::Instance()->Get(collider);
 }
 
 bool Camera::GetDebug()
@@ -81,6 +96,7 @@ bool Camera::GetDebug()
 void Camera::Update(float deltaTime)
 {
 	// get user input
+	previousPosition = position;
 	CheckForInput(4.0f, deltaTime);
 
 	// calculate the view quaternion
@@ -103,7 +119,8 @@ void Camera::Update(float deltaTime)
 	XMStoreFloat3(&right, rightV);
 	XMStoreFloat4x4(&viewMatrix, XMMatrixTranspose(result));
 
-	collider->SetCenter(XMFLOAT2(position.x, position.z));
+	Collider* col = GetCollider();
+	if (col != nullptr) col->SetCenter(XMFLOAT2(position.x, position.z));
 }
 
 void Camera::CheckForInput(float sensitivity, float dt)
@@ -2,7 +2,8 @@
 
 #include "DXCore.h"
 #include <DirectXMath.h>
-#include "Collider.h"
+#include "ColliderStore.h"
+#include "Frustum.h"
 #include "SimpleShader.h"
 #include <memory>
 
@@ -17,7 +18,13 @@ public:
 	// getters
 	DirectX::XMFLOAT4X4 GetViewMatrix();
 	DirectX::XMFLOAT4X4 GetProjectionMatrix();
+	// planes of what the camera sees, as of the last Update
+	Frustum GetFrustum();
+	// view * projection, not transposed
+	DirectX::XMMATRIX GetViewProjection();
 	DirectX::XMFLOAT3 GetPosition();
+	// where it was before this frame's input moved it
+	inline DirectX::XMFLOAT3 GetPreviousPosition() { return previousPosition; }
 	void SetPosition(DirectX::XMFLOAT3 pos);
 	DirectX::XMFLOAT3 GetDirection();
 	Collider * GetCollider();
@@ -46,6 +53,7 @@ private:
 	DirectX::XMFLOAT4X4 projectionMatrix;
 	// vectors
 	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 previousPosition;
 	DirectX::XMFLOAT3 direction;
 	DirectX::XMFLOAT3 right;
 	// rotation floats
@@ -53,7 +61,7 @@ private:
 	float rotY;
 	// debug flag
 	bool debug;
-	// Collider
-	Collider* collider;
+	// Collider, in the ColliderStore
+	ColliderHandle collider;
 };
 
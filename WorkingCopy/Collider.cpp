@@ -1,54 +1,112 @@
 #include "Collider.h"
+#include "ColliderStore.h"
 using namespace DirectX;
 
-Collider::Collider()
+Collider::Collider(ColliderStore* store, unsigned int index)
 {
-	radius = 1;
-	center = XMFLOAT2(0, 0);
-	type = (types)0;
+	this->store = store;
+	this->index = index;
+	treeBounds = XMFLOAT4(0, 0, 0, 0);
 }
 
-Collider::Collider(float r)
+float Collider::GetRadius()
 {
-	radius = r;
-	center = XMFLOAT2(0, 0);
-	type = (types)0;
+	return store->radius[index];
 }
 
-Collider::Collider(DirectX::XMFLOAT2 s)
+DirectX::XMFLOAT2 Collider::GetCenter()
 {
-	center = XMFLOAT2(0, 0);
-	size = s;
-	type = (types)1;
+	return XMFLOAT2(store->centerX[index], store->centerY[index]);
 }
 
-Collider::~Collider()
+int Collider::GetType()
 {
+	return (int)store->type[index];
 }
 
-float Collider::GetRadius()
+DirectX::XMFLOAT2 Collider::GetSize()
 {
-	return radius;
+	return XMFLOAT2(store->halfX[index] * 2.0f, store->halfY[index] * 2.0f);
 }
 
-DirectX::XMFLOAT2 Collider::GetCenter()
+DirectX::XMFLOAT4 Collider::GetBounds()
 {
-	return center;
+	// circles keep their radius in the half extents too
+	float x = store->centerX[index];
+	float y = store->centerY[index];
+	float hx = store->halfX[index];
+	float hy = store->halfY[index];
+	return XMFLOAT4(x - hx, y - hy, x + hx, y + hy);
 }
 
-int Collider::GetType()
+bool Collider::IsEnabled()
 {
-	return (int)type;
+	return store->enabled[index] != 0;
 }
 
-DirectX::XMFLOAT2 Collider::GetSize()
+void Collider::SetCenter(DirectX::XMFLOAT2 c)
 {
-	return size;
+	store->centerX[index] = c.x;
+	store->centerY[index] = c.y;
 }
 
-void Collider::SetCenter(DirectX::XMFLOAT2 c)
+void Collider::SetEnabled(bool enabled)
 {
-	center = c;
+	store->enabled[index] = enabled ? 1 : 0;
 }
 
+unsigned int Collider::GetLayer()
+{
+	return store->layers[index];
+}
+
+unsigned int Collider::GetMask()
+{
+	return store->masks[index];
+}
+
+bool Collider::IsTrigger()
+{
+	return store->triggers[index] != 0;
+}
+
+unsigned int Collider::GetTag()
+{
+	return store->tags[index];
+}
 
+Entity* Collider::GetOwner()
+{
+	return store->owners[index];
+}
+
+bool Collider::Interacts(Collider* other)
+{
+	return (store->masks[index] & other->store->layers[other->index]) != 0 &&
+		(other->store->masks[other->index] & store->layers[index]) != 0;
+}
+
+void Collider::SetLayer(unsigned int layer)
+{
+	store->layers[index] = layer;
+}
+
+void Collider::SetMask(unsigned int mask)
+{
+	store->masks[index] = mask;
+}
+
+void Collider::SetTrigger(bool trigger)
+{
+	store->triggers[index] = trigger ? 1 : 0;
+}
+
+void Collider::SetTag(unsigned int tag)
+{
+	store->tags[index] = tag;
+}
+
+void Collider::SetOwner(Entity* owner)
+{
+	store->owners[index] = owner;
+}
@@ -3,34 +3,75 @@
 
 #include <DirectXMath.h>
 
+class ColliderStore;
+class Entity;
+
+// bits for collider layers and masks, two colliders only interact when
+// each one's mask has the other's layer
+namespace COLLISION_LAYER
+{
+	const unsigned int DEFAULT = 1 << 0;
+	const unsigned int PLAYER = 1 << 1;
+	const unsigned int AGENT = 1 << 2;
+	const unsigned int PICKUP = 1 << 3;
+	const unsigned int ALL = 0xFFFFFFFF;
+}
+
+// --------------------------------------------------------
+// A view of one collider in the ColliderStore, which keeps
+// the shapes themselves in parallel arrays.  Made and
+// destroyed through the store, entities hold a
+// ColliderHandle and look this up when they need it
+// --------------------------------------------------------
 class Collider
 {
+	friend class ColliderStore;
 public:
-	Collider();
-	Collider(float r);
-	Collider(DirectX::XMFLOAT2 s);
-	~Collider();
-	bool enabled = true;
+	enum types
+	{
+		circle = 0,
+		rect = 1
+	};
+
+	// last broadphase query that returned this collider, so it's only returned once
+	unsigned int queryStamp = 0;
+	// the (loose) min x, min y, max x, max y the broadphase filed it under
+	DirectX::XMFLOAT4 treeBounds;
 	// getters
 	float GetRadius();
 	DirectX::XMFLOAT2 GetCenter();
 	int GetType();
 	DirectX::XMFLOAT2 GetSize();
+	// min x, min y, max x, max y of the circle's square or the rectangle
+	DirectX::XMFLOAT4 GetBounds();
+	bool IsEnabled();
+	unsigned int GetLayer();
+	unsigned int GetMask();
+	// triggers report contacts but nothing gets pushed out of them
+	bool IsTrigger();
+	// interned id from Tags, the same as the owner's
+	unsigned int GetTag();
+	// the entity this collider belongs to, nullptr for the camera's
+	Entity* GetOwner();
+	// slot in the store's arrays
+	inline unsigned int GetIndex() { return index; }
+	// both masks have the other's layer
+	bool Interacts(Collider* other);
 
 	// setter
 	void SetCenter(DirectX::XMFLOAT2 c);
+	void SetEnabled(bool enabled);
+	void SetLayer(unsigned int layer);
+	void SetMask(unsigned int mask);
+	void SetTrigger(bool trigger);
+	void SetTag(unsigned int tag);
+	void SetOwner(Entity* owner);
 
 
 private:
-	float radius;
-	DirectX::XMFLOAT2 center;
-    enum types
-    {
-        circle = 0,
-        rect = 1
-    }; 
-    types type;
-    // 0 = circle, 1 = rectangle
-	DirectX::XMFLOAT2 size; // x = x, y = z
+	Collider(ColliderStore* store, unsigned int index);
+
+	ColliderStore* store;
+	unsigned int index;
 };
 
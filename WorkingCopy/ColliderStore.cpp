@@ -0,0 +1,246 @@
+#include "ColliderStore.h"
+#include <cmath>
+#if defined(_XM_AVX_INTRINSICS_) || defined(_XM_SSE_INTRINSICS_)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	// every lane count the kernels use divides this, so they never need a tail
+	const size_t BatchPadding = 8;
+}
+
+ColliderStore* ColliderStore::Instance()
+{
+	static ColliderStore store;
+	return &store;
+}
+
+ColliderHandle ColliderStore::CreateCircle(float radius)
+{
+	return Create(Collider::circle, radius, radius, radius);
+}
+
+ColliderHandle ColliderStore::CreateRect(XMFLOAT2 size)
+{
+	return Create(Collider::rect, 0.0f, size.x / 2.0f, size.y / 2.0f);
+}
+
+ColliderHandle ColliderStore::Create(Collider::types shape, float r, float hx, float hy)
+{
+	unsigned int index;
+	if (!freeSlots.empty()) {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		index = (unsigned int)colliders.size();
+		centerX.push_back(0);
+		centerY.push_back(0);
+		radius.push_back(0);
+		halfX.push_back(0);
+		halfY.push_back(0);
+		type.push_back(0);
+		enabled.push_back(0);
+		layers.push_back(0);
+		masks.push_back(0);
+		triggers.push_back(0);
+		tags.push_back(0);
+		owners.push_back(nullptr);
+		generations.push_back(0);
+		colliders.push_back(std::unique_ptr<Collider>(new Collider(this, index)));
+	}
+
+	centerX[index] = 0.0f;
+	centerY[index] = 0.0f;
+	radius[index] = r;
+	halfX[index] = hx;
+	halfY[index] = hy;
+	type[index] = (unsigned char)shape;
+	enabled[index] = 1;
+	layers[index] = COLLISION_LAYER::DEFAULT;
+	masks[index] = COLLISION_LAYER::ALL;
+	triggers[index] = 0;
+	tags[index] = 0;
+	owners[index] = nullptr;
+
+	// the slot's collider may have been used before
+	Collider* col = colliders[index].get();
+	col->queryStamp = 0;
+	col->treeBounds = XMFLOAT4(0, 0, 0, 0);
+
+	ColliderHandle handle;
+	handle.index = index;
+	handle.generation = generations[index];
+	return handle;
+}
+
+void ColliderStore::Destroy(ColliderHandle handle)
+{
+	if (Get(handle) == nullptr) return;
+
+	// old handles to this slot stop resolving
+	generations[handle.index]++;
+	enabled[handle.index] = 0;
+	owners[handle.index] = nullptr;
+	freeSlots.push_back(handle.index);
+}
+
+Collider* ColliderStore::Get(ColliderHandle handle)
+{
+	if (handle.index >= colliders.size() || generations[handle.index] != handle.generation) return nullptr;
+	return colliders[handle.index].get();
+}
+
+int ColliderStore::GetBatchWidth()
+{
+#if defined(_XM_AVX_INTRINSICS_)
+	return 8;
+#elif defined(_XM_SSE_INTRINSICS_)
+	return 4;
+#else
+	return 1;
+#endif
+}
+
+void ColliderStore::TestCircle(XMFLOAT2 center, float r, const std::vector<Collider*>& candidates, std::vector<Collider*>& hits,
+	unsigned int layer, unsigned int mask)
+{
+	hits.clear();
+	Gather(candidates, layer, mask);
+
+	size_t count = batch.colliders.size();
+	CircleKernel(center.x, center.y, r, batch, count);
+	for (size_t i = 0; i < count; i++) {
+		if (batch.hits[i]) hits.push_back(batch.colliders[i]);
+	}
+}
+
+void ColliderStore::Gather(const std::vector<Collider*>& candidates, unsigned int layer, unsigned int mask)
+{
+	// padded with empty lanes so the kernels always run whole batches
+	size_t padded = (candidates.size() + BatchPadding - 1) / BatchPadding * BatchPadding;
+	batch.x.resize(padded);
+	batch.y.resize(padded);
+	batch.radius.resize(padded);
+	batch.halfX.resize(padded);
+	batch.halfY.resize(padded);
+	batch.rectMask.resize(padded);
+	batch.hits.resize(padded);
+	batch.colliders.clear();
+
+	size_t count = 0;
+	for (Collider* col : candidates) {
+		unsigned int i = col->index;
+		if (!enabled[i] || !(layers[i] & mask) || !(masks[i] & layer)) continue;
+
+		batch.x[count] = centerX[i];
+		batch.y[count] = centerY[i];
+		batch.radius[count] = radius[i];
+		batch.halfX[count] = halfX[i];
+		batch.halfY[count] = halfY[i];
+		batch.rectMask[count] = type[i] == Collider::rect ? 0xFFFFFFFF : 0;
+		batch.colliders.push_back(col);
+		count++;
+	}
+
+	for (size_t i = count; i < padded; i++) {
+		batch.x[i] = 0.0f;
+		batch.y[i] = 0.0f;
+		batch.radius[i] = 0.0f;
+		batch.halfX[i] = 0.0f;
+		batch.halfY[i] = 0.0f;
+		batch.rectMask[i] = 0;
+	}
+}
+
+void ColliderStore::CircleKernel(float x, float y, float r, Batch& batch, size_t count)
+{
+	size_t i = 0;
+
+#if defined(_XM_AVX_INTRINSICS_)
+	const __m256 cx = _mm256_set1_ps(x);
+	const __m256 cy = _mm256_set1_ps(y);
+	const __m256 cr = _mm256_set1_ps(r);
+	const __m256 crSq = _mm256_mul_ps(cr, cr);
+	for (; i < count; i += 8) {
+		__m256 bx = _mm256_loadu_ps(&batch.x[i]);
+		__m256 by = _mm256_loadu_ps(&batch.y[i]);
+
+		// circle against circle, closer than the radii
+		__m256 dx = _mm256_sub_ps(bx, cx);
+		__m256 dy = _mm256_sub_ps(by, cy);
+		__m256 distSq = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+		__m256 radSum = _mm256_add_ps(cr, _mm256_loadu_ps(&batch.radius[i]));
+		__m256 circleHit = _mm256_cmp_ps(distSq, _mm256_mul_ps(radSum, radSum), _CMP_LT_OQ);
+
+		// circle against rectangle, the closest point on it is within the radius
+		__m256 hx = _mm256_loadu_ps(&batch.halfX[i]);
+		__m256 hy = _mm256_loadu_ps(&batch.halfY[i]);
+		__m256 px = _mm256_min_ps(_mm256_max_ps(cx, _mm256_sub_ps(bx, hx)), _mm256_add_ps(bx, hx));
+		__m256 py = _mm256_min_ps(_mm256_max_ps(cy, _mm256_sub_ps(by, hy)), _mm256_add_ps(by, hy));
+		__m256 ex = _mm256_sub_ps(cx, px);
+		__m256 ey = _mm256_sub_ps(cy, py);
+		__m256 edgeSq = _mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey));
+		__m256 rectHit = _mm256_cmp_ps(edgeSq, crSq, _CMP_LE_OQ);
+
+		__m256 isRect = _mm256_castsi256_ps(_mm256_loadu_si256((const __m256i*)&batch.rectMask[i]));
+		int mask = _mm256_movemask_ps(_mm256_blendv_ps(circleHit, rectHit, isRect));
+		for (int lane = 0; lane < 8; lane++) {
+			batch.hits[i + lane] = (mask >> lane) & 1;
+		}
+	}
+#elif defined(_XM_SSE_INTRINSICS_)
+	const __m128 cx = _mm_set1_ps(x);
+	const __m128 cy = _mm_set1_ps(y);
+	const __m128 cr = _mm_set1_ps(r);
+	const __m128 crSq = _mm_mul_ps(cr, cr);
+	for (; i < count; i += 4) {
+		__m128 bx = _mm_loadu_ps(&batch.x[i]);
+		__m128 by = _mm_loadu_ps(&batch.y[i]);
+
+		// circle against circle, closer than the radii
+		__m128 dx = _mm_sub_ps(bx, cx);
+		__m128 dy = _mm_sub_ps(by, cy);
+		__m128 distSq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+		__m128 radSum = _mm_add_ps(cr, _mm_loadu_ps(&batch.radius[i]));
+		__m128 circleHit = _mm_cmplt_ps(distSq, _mm_mul_ps(radSum, radSum));
+
+		// circle against rectangle, the closest point on it is within the radius
+		__m128 hx = _mm_loadu_ps(&batch.halfX[i]);
+		__m128 hy = _mm_loadu_ps(&batch.halfY[i]);
+		__m128 px = _mm_min_ps(_mm_max_ps(cx, _mm_sub_ps(bx, hx)), _mm_add_ps(bx, hx));
+		__m128 py = _mm_min_ps(_mm_max_ps(cy, _mm_sub_ps(by, hy)), _mm_add_ps(by, hy));
+		__m128 ex = _mm_sub_ps(cx, px);
+		__m128 ey = _mm_sub_ps(cy, py);
+		__m128 edgeSq = _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+		__m128 rectHit = _mm_cmple_ps(edgeSq, crSq);
+
+		// SSE2 has no blend, pick by hand
+		__m128 isRect = _mm_castsi128_ps(_mm_loadu_si128((const __m128i*)&batch.rectMask[i]));
+		int mask = _mm_movemask_ps(_mm_or_ps(_mm_and_ps(isRect, rectHit), _mm_andnot_ps(isRect, circleHit)));
+		for (int lane = 0; lane < 4; lane++) {
+			batch.hits[i + lane] = (mask >> lane) & 1;
+		}
+	}
+#endif
+
+	// no SIMD, or whatever the batches didn't cover
+	for (; i < count; i++) {
+		if (batch.rectMask[i]) {
+			float px = fminf(fmaxf(x, batch.x[i] - batch.halfX[i]), batch.x[i] + batch.halfX[i]);
+			float py = fminf(fmaxf(y, batch.y[i] - batch.halfY[i]), batch.y[i] + batch.halfY[i]);
+			float ex = x - px;
+			float ey = y - py;
+			batch.hits[i] = ex * ex + ey * ey <= r * r;
+		}
+		else {
+			float dx = batch.x[i] - x;
+			float dy = batch.y[i] - y;
+			float radSum = r + batch.radius[i];
+			batch.hits[i] = dx * dx + dy * dy < radSum * radSum;
+		}
+	}
+}
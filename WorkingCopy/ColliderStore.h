@@ -0,0 +1,89 @@
+#pragma once
+#include "Collider.h"
+#include <vector>
+#include <memory>
+#include <DirectXMath.h>
+
+// refers to a collider in the ColliderStore, Get returns nullptr once it's destroyed
+struct ColliderHandle
+{
+	unsigned int index = 0xFFFFFFFF;
+	unsigned int generation = 0;
+
+	inline bool IsValid() const { return index != 0xFFFFFFFF; }
+};
+
+// --------------------------------------------------------
+// Owns every collider.  Centers, radii, half extents, type,
+// filtering and ownership live in parallel arrays indexed
+// by slot, so the narrowphase can test one shape against a
+// batch of colliders with SIMD instead of going through
+// getters one pair at a time.
+//
+// Slots are reused once freed, each one keeps a generation
+// so handles to a destroyed collider stop resolving
+// --------------------------------------------------------
+class ColliderStore
+{
+	friend class Collider;
+public:
+	// the store every entity and camera makes its collider in
+	static ColliderStore* Instance();
+
+	ColliderHandle CreateCircle(float radius);
+	ColliderHandle CreateRect(DirectX::XMFLOAT2 size);
+	void Destroy(ColliderHandle handle);
+	// nullptr for a destroyed collider or an invalid handle
+	Collider* Get(ColliderHandle handle);
+
+	// writes every candidate a circle overlaps into hits, in order, skipping disabled ones
+	// and ones that don't interact with the given layer and mask.
+	// circles overlap when closer than their radii, rectangles when the closest point
+	// is within the radius, same as CollisionManager's pair tests.  hits is cleared first
+	void TestCircle(DirectX::XMFLOAT2 center, float radius, const std::vector<Collider*>& candidates, std::vector<Collider*>& hits,
+		unsigned int layer = COLLISION_LAYER::ALL, unsigned int mask = COLLISION_LAYER::ALL);
+
+	// lane count of the batch kernels: 8 with AVX, 4 with SSE, 1 without either
+	static int GetBatchWidth();
+
+	inline size_t GetCount() const { return colliders.size() - freeSlots.size(); }
+
+private:
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> radius;
+	// half the rectangle's size, or the radius for circles
+	std::vector<float> halfX;
+	std::vector<float> halfY;
+	std::vector<unsigned char> type;
+	std::vector<unsigned char> enabled;
+	std::vector<unsigned int> layers;
+	std::vector<unsigned int> masks;
+	std::vector<unsigned char> triggers;
+	std::vector<unsigned int> tags;
+	std::vector<Entity*> owners;
+	std::vector<unsigned int> generations;
+	// one per slot and never moved, so Collider* stays valid for the broadphases
+	std::vector<std::unique_ptr<Collider>> colliders;
+	std::vector<unsigned int> freeSlots;
+
+	// candidates copied next to each other for the kernels
+	struct Batch
+	{
+		std::vector<float> x;
+		std::vector<float> y;
+		std::vector<float> radius;
+		std::vector<float> halfX;
+		std::vector<float> halfY;
+		// all bits set for rectangles
+		std::vector<unsigned int> rectMask;
+		std::vector<Collider*> colliders;
+		std::vector<unsigned char> hits;
+	};
+	Batch batch;
+
+	ColliderHandle Create(Collider::types shape, float radius, float halfX, float halfY);
+	void Gather(const std::vector<Collider*>& candidates, unsigned int layer, unsigned int mask);
+	static void CircleKernel(float x, float y, float r, Batch& batch, size_t count);
+};
+
@@ -0,0 +1,181 @@
+#include "ColliderStore.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Checks ColliderStore::TestCircle hits exactly what the
+// pair functions CollisionManager used before the store do,
+// in the same order, for whichever kernel this build has.
+// Built once with SSE and once without, see CMakeLists.txt
+// --------------------------------------------------------
+
+namespace
+{
+	float Random(float extent)
+	{
+		return (rand() / (float)RAND_MAX * 2 - 1) * extent;
+	}
+
+	// CollisionManager::CircleToCircleCollision
+	bool CircleToCircle(Collider* col1, Collider* col2)
+	{
+		XMFLOAT2 a = col1->GetCenter();
+		XMFLOAT2 b = col2->GetCenter();
+		XMVECTOR vLength = XMVector2LengthSq(XMVectorSubtract(XMLoadFloat2(&a), XMLoadFloat2(&b)));
+		XMFLOAT2 result;
+		XMStoreFloat2(&result, vLength);
+		float rad = col1->GetRadius() + col2->GetRadius();
+		rad *= rad;
+		return result.x < rad;
+	}
+
+	// CollisionManager::CircleToSquareCollision, without pushing the camera out
+	bool CircleToSquare(Collider* col1, Collider* col2)
+	{
+		float testX = col1->GetCenter().x;
+		float testY = col1->GetCenter().y;
+		float left = col2->GetCenter().x - (col2->GetSize().x / 2.0f);
+		float right = col2->GetCenter().x + (col2->GetSize().x / 2.0f);
+		float top = col2->GetCenter().y + (col2->GetSize().y / 2.0f);
+		float bottom = col2->GetCenter().y - (col2->GetSize().y / 2.0f);
+		if (col1->GetCenter().x < left) testX = left;
+		else if (col1->GetCenter().x > right) testX = right;
+		if (col1->GetCenter().y > top) testY = top;
+		else if (col1->GetCenter().y < bottom) testY = bottom;
+		XMFLOAT2 center = col1->GetCenter();
+		XMFLOAT2 closest(testX, testY);
+		XMVECTOR dist = XMVector2LengthSq(XMVectorSubtract(XMLoadFloat2(&center), XMLoadFloat2(&closest)));
+		XMFLOAT2 result;
+		XMStoreFloat2(&result, dist);
+		return result.x <= col1->GetRadius() * col1->GetRadius();
+	}
+
+	// the old loop over the nearby colliders
+	std::vector<Collider*> PairTests(Collider* player, const std::vector<Collider*>& candidates, unsigned int layer, unsigned int mask)
+	{
+		std::vector<Collider*> hits;
+		for (Collider* col : candidates)
+		{
+			if (!col->IsEnabled() || !(col->GetLayer() & mask) || !(col->GetMask() & layer)) continue;
+			bool hit = col->GetType() == Collider::circle ? CircleToCircle(player, col) : CircleToSquare(player, col);
+			if (hit) hits.push_back(col);
+		}
+		return hits;
+	}
+}
+
+int main()
+{
+	ColliderStore* store = ColliderStore::Instance();
+	printf("batch width %d\n", ColliderStore::GetBatchWidth());
+
+	// handles stop resolving once destroyed, and the slot is reused under a new generation
+	ColliderHandle first = store->CreateCircle(1.0f);
+	store->Destroy(first);
+	CHECK(store->Get(first) == nullptr);
+	ColliderHandle reused = store->CreateCircle(2.0f);
+	CHECK(reused.index == first.index && reused.generation != first.generation);
+	CHECK(store->Get(first) == nullptr);
+	CHECK(store->Get(reused) != nullptr && store->Get(reused)->GetRadius() == 2.0f);
+	store->Destroy(first);
+	CHECK(store->Get(reused) != nullptr);
+	store->Destroy(reused);
+	CHECK(store->GetCount() == 0);
+	CHECK(store->Get(ColliderHandle()) == nullptr);
+
+	// a fifth rectangles, some disabled, some on other layers.  Centers and sizes are on
+	// a quarter unit grid so plenty of them touch the player exactly
+	srand(1);
+	std::vector<Collider*> all;
+	for (int i = 0; i < 4099; i++)
+	{
+		ColliderHandle handle = i % 5 == 0
+			? store->CreateRect(XMFLOAT2(0.5f * (1 + rand() % 8), 0.5f * (1 + rand() % 8)))
+			: store->CreateCircle(0.25f * (1 + rand() % 6));
+		Collider* col = store->Get(handle);
+		col->SetCenter(XMFLOAT2(0.25f * (rand() % 161 - 80), 0.25f * (rand() % 161 - 80)));
+		if (i % 37 == 0) col->SetEnabled(false);
+		if (i % 11 == 0) col->SetLayer(COLLISION_LAYER::PICKUP);
+		if (i % 13 == 0) col->SetMask(COLLISION_LAYER::AGENT);
+		all.push_back(col);
+	}
+	Collider* player = store->Get(store->CreateCircle(1.0f));
+	player->SetLayer(COLLISION_LAYER::PLAYER);
+
+	// every candidate count around the lane widths, so the padding is covered
+	int wrong = 0;
+	unsigned long long touching = 0;
+	std::vector<Collider*> hits;
+	for (size_t count : { (size_t)0, (size_t)1, (size_t)3, (size_t)4, (size_t)5, (size_t)7, (size_t)8, (size_t)9, (size_t)17, (size_t)64, all.size() })
+	{
+		std::vector<Collider*> candidates(all.begin(), all.begin() + count);
+		for (int i = 0; i < 300; i++)
+		{
+			player->SetCenter(XMFLOAT2(0.25f * (rand() % 161 - 80), 0.25f * (rand() % 161 - 80)));
+			unsigned int mask = i % 3 == 0 ? COLLISION_LAYER::ALL : (COLLISION_LAYER::DEFAULT | COLLISION_LAYER::AGENT);
+			store->TestCircle(player->GetCenter(), player->GetRadius(), candidates, hits, COLLISION_LAYER::PLAYER, mask);
+			if (hits != PairTests(player, candidates, COLLISION_LAYER::PLAYER, mask)) wrong++;
+		}
+	}
+	CHECK(wrong == 0);
+
+	// a circle exactly touching counts for rectangles but not for circles, same as the pair functions
+	wrong = 0;
+	player->SetLayer(COLLISION_LAYER::ALL);
+	for (Collider* col : all)
+	{
+		XMFLOAT2 center = col->GetCenter();
+		float reach = col->GetType() == Collider::rect ? col->GetSize().x / 2.0f : col->GetRadius();
+		player->SetCenter(XMFLOAT2(center.x + reach + player->GetRadius(), center.y));
+		store->TestCircle(player->GetCenter(), player->GetRadius(), { col }, hits);
+		if (hits != PairTests(player, { col }, COLLISION_LAYER::ALL, COLLISION_LAYER::ALL)) wrong++;
+		if (col->IsEnabled()) touching += col->GetType() == Collider::rect ? !hits.empty() : hits.empty();
+	}
+	CHECK(wrong == 0);
+	CHECK(touching > all.size() * 9 / 10);
+
+	// the kernel against going through the pair functions, at the sizes GatherNearby returns
+	player->SetLayer(COLLISION_LAYER::PLAYER);
+	for (size_t count : { (size_t)16, (size_t)64, all.size() })
+	{
+		std::vector<Collider*> candidates(all.begin(), all.begin() + count);
+		std::vector<XMFLOAT2> centers;
+		for (int i = 0; i < 2000; i++) centers.push_back(XMFLOAT2(Random(20), Random(20)));
+		int reps = (int)(4000000 / count / centers.size()) + 1;
+
+		unsigned long long batchHits = 0;
+		TestTimer timer;
+		for (int r = 0; r < reps; r++)
+		{
+			for (const XMFLOAT2& center : centers)
+			{
+				store->TestCircle(center, 1.0f, candidates, hits, COLLISION_LAYER::PLAYER);
+				batchHits += hits.size();
+			}
+		}
+		double batchMs = timer.Milliseconds();
+
+		unsigned long long pairHits = 0;
+		timer = TestTimer();
+		for (int r = 0; r < reps; r++)
+		{
+			for (const XMFLOAT2& center : centers)
+			{
+				player->SetCenter(center);
+				pairHits += PairTests(player, candidates, COLLISION_LAYER::PLAYER, COLLISION_LAYER::ALL).size();
+			}
+		}
+		double pairMs = timer.Milliseconds();
+
+		double tests = (double)reps * centers.size() * count;
+		printf("%5zu candidates: %.1f M tests/s batched, %.1f M tests/s through the pair functions (%.2fx)\n",
+			count, tests / batchMs / 1e3, tests / pairMs / 1e3, pairMs / batchMs);
+		CHECK(batchHits == pairHits);
+	}
+
+	return TestResult();
+}
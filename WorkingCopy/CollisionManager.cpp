@@ -1,4 +1,6 @@
 #include "CollisionManager.h"
+#include <algorithm>
+#include <cmath>
 using namespace DirectX;
 
 
@@ -7,18 +9,166 @@ CollisionManager::CollisionManager()
 
 }
 
-CollisionManager::CollisionManager(shared_ptr<Camera> cam)
+CollisionManager::CollisionManager(shared_ptr<Camera> cam, BROADPHASE_TYPE type)
 {
   
 	player = cam;
+	broadphaseType = type;
 
 }
 
 CollisionManager::~CollisionManager()
 {
-    delete quad;
+    delete broadphase;
 }
 
+Broadphase* CollisionManager::CreateBroadphase()
+{
+	if (broadphaseType == BROADPHASE_TYPE::SPATIAL_HASH) {
+		// cells sized from the colliders as they're added
+		return new SpatialHashGrid();
+	}
+
+	// loose nodes keep each collider in one place, so moving ones refile cheaply
+	QuadtreeSettings settings;
+	settings.looseness = 0.5f;
+	return new Quadtree(settings);
+}
+
+
+void CollisionManager::removeCollider(shared_ptr<Entity> ent)
+{
+	Collider* col = ent->GetCollider();
+	if (col == nullptr || !isRegistered(col)) return;
+
+	if (isMoving(ent)) {
+		movers.Remove(col);
+		movingObjects.erase(std::remove(movingObjects.begin(), movingObjects.end(), ent), movingObjects.end());
+	}
+	else if (broadphase != NULL) {
+		broadphase->Remove(col);
+	}
+	registered[col->GetIndex()] = 0;
+
+	// it won't be around when the frame ends, so it leaves everything now
+	contacts.Remove(col);
+	collidableObjects.erase(std::remove(collidableObjects.begin(), collidableObjects.end(), ent), collidableObjects.end());
+}
+
+void CollisionManager::updateCollider(shared_ptr<Entity> ent)
+{
+	Collider* col = ent->GetCollider();
+	if (col == nullptr || !isRegistered(col)) return;
+
+	if (isMoving(ent)) movers.Update(col);
+	else if (broadphase != NULL) broadphase->Update(col);
+}
+
+bool CollisionManager::isRegistered(Collider* col)
+{
+	return col->GetIndex() < registered.size() && registered[col->GetIndex()];
+}
+
+bool CollisionManager::isMoving(shared_ptr<Entity> ent)
+{
+	// there are only ever a few movers
+	return std::find(movingObjects.begin(), movingObjects.end(), ent) != movingObjects.end();
+}
+
+void CollisionManager::GatherNearby(Collider* col)
+{
+	if (broadphase != NULL) broadphase->GetCollidableObjects(col, nearbyColliders);
+	else nearbyColliders.clear();
+	movers.VisitCollidableObjects(col, [this](Collider* other) { nearbyColliders.push_back(other); });
+}
+
+XMFLOAT2 CollisionManager::SweepCollider(Collider* col, XMFLOAT2 amount)
+{
+	XMFLOAT2 start = col->GetCenter();
+
+	// nothing on a slide is further than the move, plus the skin at each hit
+	float reach = sqrtf(amount.x * amount.x + amount.y * amount.y) + col->GetRadius() + 0.01f;
+	XMFLOAT4 box(start.x - reach, start.y - reach, start.x + reach, start.y + reach);
+	if (broadphase != NULL) broadphase->GetCollidableObjects(box, sweepCandidates);
+	else sweepCandidates.clear();
+	movers.VisitCollidableObjects(box, [this](Collider* other) { sweepCandidates.push_back(other); });
+
+	XMFLOAT2 end = SweptCollision::MoveAndSlide(col, start, amount, sweepCandidates);
+	col->SetCenter(end);
+	return XMFLOAT2(end.x - start.x, end.y - start.y);
+}
+
+void CollisionManager::MoveEntity(shared_ptr<Entity> ent, XMFLOAT3 amount)
+{
+	Collider* col = ent->GetCollider();
+	if (col == nullptr) {
+		ent->Move(amount);
+		return;
+	}
+
+	XMFLOAT2 moved = SweepCollider(col, XMFLOAT2(amount.x, amount.z));
+	ent->Move(XMFLOAT3(moved.x, amount.y, moved.y));
+	updateCollider(ent);
+}
+
+const std::vector<SweepAndPrune::Pair>& CollisionManager::FindMovingPairs()
+{
+	movers.FindPairs(movingPairs);
+	return movingPairs;
+}
+
+void CollisionManager::Step()
+{
+	solver.Clear();
+	for (auto& ent : movingObjects) {
+		Collider* col = ent->GetCollider();
+		if (col->GetIndex() >= bodyOfSlot.size()) bodyOfSlot.resize(col->GetIndex() + 1);
+		bodyOfSlot[col->GetIndex()] = solver.AddBody(col);
+		movers.Update(col);
+	}
+
+	// triggers only report contacts, solid pairs go to the solver and
+	// are recorded if they start out overlapping
+
+	// movers against each other
+	for (const SweepAndPrune::Pair& pair : FindMovingPairs()) {
+		if (!ContactTracker::CanTouch(pair.a, pair.b)) continue;
+
+		contacts.Touch(pair.a, pair.b);
+		if (!pair.a->IsTrigger() && !pair.b->IsTrigger()) {
+			solver.AddContact(bodyOfSlot[pair.a->GetIndex()], bodyOfSlot[pair.b->GetIndex()], pair.b);
+		}
+	}
+
+	// and against everything that stays put
+	if (broadphase != NULL) {
+		for (auto& ent : movingObjects) {
+			Collider* col = ent->GetCollider();
+			if (!col->IsEnabled()) continue;
+
+			broadphase->GetCollidableObjects(col, nearbyColliders);
+			for (Collider* other : nearbyColliders) {
+				if (!ContactTracker::CanTouch(col, other)) continue;
+
+				contacts.Touch(col, other);
+				if (!col->IsTrigger() && !other->IsTrigger()) {
+					solver.AddContact(bodyOfSlot[col->GetIndex()], ContactSolver::Static, other);
+				}
+			}
+		}
+	}
+
+	solver.Solve(solverSettings);
+
+	for (size_t i = 0; i < movingObjects.size(); i++) {
+		XMFLOAT2 correction = solver.GetCorrection((unsigned int)i);
+		if (correction.x != 0.0f || correction.y != 0.0f) {
+			movingObjects[i]->Move(XMFLOAT3(correction.x, 0.0f, correction.y));
+		}
+	}
+
+	contacts.BuildEvents();
+}
 
 bool CollisionManager::checkOverlap(shared_ptr<Entity> ent)
 {
@@ -35,9 +185,11 @@ bool CollisionManager::checkOverlap(shared_ptr<Entity> ent)
 		XMVECTOR theirCenter = XMLoadFloat2(&collision->GetCenter());
 		XMVECTOR dist = myCenter - theirCenter;
 		dist = XMVector2Normalize(dist);
-		dist *= radSum;
-		XMFLOAT3 offset; 
-		XMStoreFloat3(&offset, dist);
+		// out by how far they overlap, not the whole radius sum
+		dist *= radSum - sqrtf(distSqr);
+		XMFLOAT2 push;
+		XMStoreFloat2(&push, dist);
+		XMFLOAT3 offset(push.x, 0.0f, push.y);
 		ent->Move(offset);
 		return true;
 	}
@@ -60,9 +212,11 @@ bool CollisionManager::checkOverlap(shared_ptr<Camera> cam)
 		XMVECTOR theirCenter = XMLoadFloat2(&collision->GetCenter());
 		XMVECTOR dist = myCenter - theirCenter;
 		dist = XMVector2Normalize(dist);
-		dist *= radSum;
-		XMFLOAT3 offset;
-		XMStoreFloat3(&offset, dist);
+		// out by how far they overlap, not the whole radius sum
+		dist *= radSum - sqrtf(distSqr);
+		XMFLOAT2 push;
+		XMStoreFloat2(&push, dist);
+		XMFLOAT3 offset(push.x, 0.0f, push.y);
 		cam->Move(offset);
 		return true;
 	}
@@ -72,12 +226,12 @@ bool CollisionManager::checkOverlap(shared_ptr<Camera> cam)
 Collider* CollisionManager::checkOverlap(Collider* col, float* radSum, float* distSqr)
 {
 
-	//TODO: OCTREE
-	for (int i = 0; i < collidableObjects.size(); i++) {
+	GatherNearby(col);
+	for (Collider* other : nearbyColliders) {
+		if (other == col) continue;
 
-		
-		if (CircleToCircleCollision(collidableObjects[i]->GetCollider(), col, radSum, distSqr)) {
-			return collidableObjects[i]->GetCollider();
+		if (CircleToCircleCollision(other, col, radSum, distSqr)) {
+			return other;
 
 		}
 
@@ -85,54 +239,64 @@ Collider* CollisionManager::checkOverlap(Collider* col, float* radSum, float* di
 	return NULL;
 }
 
-shared_ptr<Entity> CollisionManager::HandlePlayerCollisions(const char* tag )
+shared_ptr<Entity> CollisionManager::HandlePlayerCollisions(unsigned int tag)
 {
 	if (player->GetDebug()) return nullptr;
-	int i = 0;
 
-    std::vector<Collider* > treeColliders = quad->GetCollidableObjects(player->GetCollider());
-	//printf("Objects: %i\n", treeColliders.size());
+    Collider* playerCol = player->GetCollider();
+
+	// this frame's move is swept first so a long frame can't carry the player through
+	// something thin, the overlap tests below then only have small pushes to do
+	XMFLOAT3 from = player->GetPreviousPosition();
+	XMFLOAT3 to = player->GetPosition();
+	playerCol->SetCenter(XMFLOAT2(from.x, from.z));
+	XMFLOAT2 moved = SweepCollider(playerCol, XMFLOAT2(to.x - from.x, to.z - from.z));
+	player->SetPosition(XMFLOAT3(from.x + moved.x, to.y, from.z + moved.y));
+
+    GatherNearby(playerCol);
+	//printf("Objects: %i\n", nearbyColliders.size());
 
-	for (auto itr : treeColliders)
+	// one batch test drops everything the player isn't touching or doesn't interact with,
+	// the pair tests below still run since resolving one collision moves the player
+	ColliderStore::Instance()->TestCircle(playerCol->GetCenter(), playerCol->GetRadius(), nearbyColliders, touchingColliders,
+		playerCol->GetLayer(), playerCol->GetMask());
+
+	// recorded up front, the loop can return early
+	for (auto itr : touchingColliders) {
+		contacts.Record(playerCol, itr);
+	}
+
+	for (auto itr : touchingColliders)
 	{
-		if (!itr->enabled) {
+		// untagged colliders are never what we're after
+		if (tag != Tags::None && itr->GetTag() == tag) {
+			itr->SetEnabled(false);
+			// only happens when something's picked up, so the owner's shared_ptr is looked up
+			Entity* owner = itr->GetOwner();
+			for (const shared_ptr<Entity>& ent : collidableObjects) {
+				if (ent.get() == owner) return ent;
+			}
+			return nullptr;
+		}
+		// triggers only report contacts
+		if (itr->IsTrigger()) {
 			continue;
 		}
+
 		// circle collisions
-		if (itr->GetType() == 0)
+		if (itr->GetType() == Collider::circle)
 		{
-
-			if (CircleToCircleCollision(player->GetCollider(), itr))
+			if (CircleToCircleCollision(playerCol, itr))
 			{
-
-				if (colliderDict[itr]->getTag() == tag) {
-					itr->enabled = false;
-					return colliderDict[itr];
-					
-				}
-				else {
-					ResolvePlayerCollision(itr);
-
-				}
-
-                /*
-				if (itr->getTag() == tag)
-				{
-					collidableObjects.erase(collidableObjects.begin() + i);
-					return itr;
-				}
-				else {
-					ResolvePlayerCollision(collidableObjects[i]->GetCollider());
-				}
-                */
+				ResolvePlayerCollision(itr);
 			}
 		}
 		else // AABB collision
 		{
-			CircleToSquareCollision(player->GetCollider(), itr);
+			CircleToSquareCollision(playerCol, itr);
 		}
-		i++;
 	}
+	return nullptr;
 }
 
 bool CollisionManager::CircleToCircleCollision(Collider* col1, Collider* col2)
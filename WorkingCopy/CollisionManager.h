@@ -4,38 +4,69 @@
 #include "Entity.h"
 #include "Camera.h"
 #include "Quadtree.h"
+#include "SpatialHashGrid.h"
+#include "SweepAndPrune.h"
+#include "ContactSolver.h"
+#include "ContactTracker.h"
+#include "SweptCollision.h"
 #include <DirectXMath.h>
-#include <unordered_map>
-
 
 class CollisionManager
 {
 public:
     CollisionManager();
-	CollisionManager(shared_ptr<Camera> cam);
+	CollisionManager(shared_ptr<Camera> cam, BROADPHASE_TYPE type = BROADPHASE_TYPE::QUADTREE);
     ~CollisionManager();
 
 
-	void addCollider(shared_ptr <Entity> ent) {
+	// moving colliders (agents, projectiles) go in the sweep and prune instead of the broadphase
+	void addCollider(shared_ptr <Entity> ent, bool moving = false) {
 		if (ent->GetCollider() != nullptr) {
 
-            if (quad == NULL) {
-                quad = new Quadtree();
-                quad->CreateQuadtree(std::vector<Collider*>{ent->GetCollider()});
-
+            if (moving) {
+                movers.Add(ent->GetCollider());
+                movingObjects.push_back(ent);
             }
             else {
-                quad->addToTree(ent->GetCollider());
+                if (broadphase == NULL) {
+                    broadphase = CreateBroadphase();
+                }
+                broadphase->Add(ent->GetCollider());
             }
-			colliderDict.insert({ ent->GetCollider(), ent });
+			unsigned int slot = ent->GetCollider()->GetIndex();
+			if (slot >= registered.size()) registered.resize(slot + 1);
+			registered[slot] = 1;
 			collidableObjects.push_back(ent);
 		}
 	}
 
+	// takes the entity's collider out of the broadphase and the lists, before the entity is destroyed
+	void removeCollider(shared_ptr <Entity> ent);
+	// refiles the collider of an entity that moved
+	void updateCollider(shared_ptr <Entity> ent);
+
 	bool checkOverlap(shared_ptr < Entity> ent);
 	bool checkOverlap(shared_ptr<Camera> cam);
 	Collider* checkOverlap(Collider* col, float* radSum, float* distSqr);
-	shared_ptr<Entity> HandlePlayerCollisions(const char* tag = nullptr);
+	// tag is an id from Tags, interned where the tag is set
+	shared_ptr<Entity> HandlePlayerCollisions(unsigned int tag = Tags::None);
+	// every pair of moving colliders whose bounds overlap, valid until the next call
+	const std::vector<SweepAndPrune::Pair>& FindMovingPairs();
+	// pushes the moving entities out of each other and out of everything else, call once
+	// a frame after they've moved.  also works out this frame's events
+	void Step();
+	// enter, stay and exit events from the last Step, covering the player and the movers.
+	// a collider removed mid frame gets exits for what it was touching, its owner may be gone
+	inline const std::vector<CollisionEvent>& GetEvents() { return contacts.GetEvents(); }
+
+	// moves col by amount, stopping at anything solid on the way and sliding along it instead
+	// of going through, and returns how far it got. sets its center but doesn't tell the
+	// broadphase, call updateCollider after
+	DirectX::XMFLOAT2 SweepCollider(Collider* col, DirectX::XMFLOAT2 amount);
+	// moves an entity with SweepCollider on x and z, y just moves
+	void MoveEntity(shared_ptr<Entity> ent, DirectX::XMFLOAT3 amount);
+	inline ContactSolverSettings& GetSolverSettings() { return solverSettings; }
+	inline const ContactSolver& GetSolver() { return solver; }
 
 	// detection method
 	bool CircleToCircleCollision(Collider* col1, Collider* col2);
@@ -44,10 +75,36 @@ public:
 
 	// collision resolution
 	void ResolvePlayerCollision(Collider* other);
+
+	inline BROADPHASE_TYPE GetBroadphaseType() { return broadphaseType; }
+	inline Broadphase* GetBroadphase() { return broadphase; }
 private:
-	std::unordered_map<Collider*, shared_ptr <Entity>> colliderDict;
-    Quadtree* quad = NULL;
+    BROADPHASE_TYPE broadphaseType = BROADPHASE_TYPE::QUADTREE;
+    Broadphase* broadphase = NULL;
+    // reused by every broadphase query so they don't allocate
+    std::vector<Collider*> nearbyColliders;
+    // the ones the narrowphase batch says the player overlaps
+    std::vector<Collider*> touchingColliders;
+    // everything a sweep might run into
+    std::vector<Collider*> sweepCandidates;
+    SweepAndPrune movers;
+    vector<shared_ptr<Entity>> movingObjects;
+    std::vector<SweepAndPrune::Pair> movingPairs;
+    ContactSolver solver;
+    ContactSolverSettings solverSettings;
+    // solver body of each ColliderStore slot, only valid for movers during Step
+    std::vector<unsigned int> bodyOfSlot;
+    // 1 for each ColliderStore slot whose entity was added and not removed yet
+    std::vector<unsigned char> registered;
 	vector<shared_ptr<Entity>> collidableObjects;
 	shared_ptr<Camera> player;
+
+	Broadphase* CreateBroadphase();
+	bool isRegistered(Collider* col);
+	bool isMoving(shared_ptr<Entity> ent);
+	// fills nearbyColliders from the broadphase and the movers
+	void GatherNearby(Collider* col);
+	// who touched whom this frame and last, for the events
+	ContactTracker contacts;
 };
 
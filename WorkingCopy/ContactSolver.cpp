@@ -0,0 +1,247 @@
+#include "ContactSolver.h"
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace DirectX;
+
+void ContactSolver::Clear()
+{
+    bodies.clear();
+    contacts.clear();
+    colorCount = 0;
+}
+
+unsigned int ContactSolver::AddBody(Collider* col)
+{
+    Body body;
+    body.col = col;
+    body.start = col->GetCenter();
+    body.position = body.start;
+    bodies.push_back(body);
+    return (unsigned int)bodies.size() - 1;
+}
+
+void ContactSolver::AddContact(unsigned int a, unsigned int b, Collider* other)
+{
+    Contact contact;
+    contact.a = a;
+    contact.b = b;
+    contact.other = other;
+    contacts.push_back(contact);
+}
+
+XMFLOAT2 ContactSolver::GetCorrection(unsigned int body) const
+{
+    const Body& b = bodies[body];
+    return XMFLOAT2(b.position.x - b.start.x, b.position.y - b.start.y);
+}
+
+float ContactSolver::GetMaxPenetration() const
+{
+    float deepest = 0.0f;
+    for (const Contact& contact : contacts) {
+        XMFLOAT2 positionB = contact.b == Static ? contact.other->GetCenter() : bodies[contact.b].position;
+        XMFLOAT2 normal;
+        float depth;
+        if (Penetration(bodies[contact.a].col, bodies[contact.a].position, contact.other, positionB, &normal, &depth)) {
+            deepest = std::max(deepest, depth);
+        }
+    }
+    return deepest;
+}
+
+bool ContactSolver::Penetration(Collider* a, XMFLOAT2 pa, Collider* b, XMFLOAT2 pb, XMFLOAT2* normal, float* depth)
+{
+    float dx = pb.x - pa.x;
+    float dy = pb.y - pa.y;
+
+    if (a->GetType() == Collider::circle && b->GetType() == Collider::circle) {
+        float radSum = a->GetRadius() + b->GetRadius();
+        float distSq = dx * dx + dy * dy;
+        if (distSq >= radSum * radSum) return false;
+
+        // right on top of each other, any direction will do
+        float dist = sqrtf(distSq);
+        *normal = dist > 1e-6f ? XMFLOAT2(dx / dist, dy / dist) : XMFLOAT2(1.0f, 0.0f);
+        *depth = radSum - dist;
+        return true;
+    }
+
+    if (a->GetType() == Collider::rect && b->GetType() == Collider::rect) {
+        XMFLOAT2 sizeA = a->GetSize();
+        XMFLOAT2 sizeB = b->GetSize();
+        float overlapX = (sizeA.x + sizeB.x) * 0.5f - fabsf(dx);
+        float overlapY = (sizeA.y + sizeB.y) * 0.5f - fabsf(dy);
+        if (overlapX <= 0.0f || overlapY <= 0.0f) return false;
+
+        // out along whichever axis is the shorter way
+        if (overlapX < overlapY) {
+            *normal = XMFLOAT2(dx < 0.0f ? -1.0f : 1.0f, 0.0f);
+            *depth = overlapX;
+        }
+        else {
+            *normal = XMFLOAT2(0.0f, dy < 0.0f ? -1.0f : 1.0f);
+            *depth = overlapY;
+        }
+        return true;
+    }
+
+    // circle and rectangle, worked out with the circle first then flipped back
+    bool flipped = a->GetType() == Collider::rect;
+    Collider* circle = flipped ? b : a;
+    Collider* rect = flipped ? a : b;
+    XMFLOAT2 center = flipped ? pb : pa;
+    XMFLOAT2 rectCenter = flipped ? pa : pb;
+    XMFLOAT2 half = rect->GetSize();
+    half.x *= 0.5f;
+    half.y *= 0.5f;
+    float r = circle->GetRadius();
+
+    float localX = center.x - rectCenter.x;
+    float localY = center.y - rectCenter.y;
+    XMFLOAT2 n;
+    float d;
+    if (fabsf(localX) < half.x && fabsf(localY) < half.y) {
+        // the center is inside, push out through the closest side
+        float toSideX = half.x - fabsf(localX);
+        float toSideY = half.y - fabsf(localY);
+        if (toSideX < toSideY) {
+            n = XMFLOAT2(localX < 0.0f ? 1.0f : -1.0f, 0.0f);
+            d = toSideX + r;
+        }
+        else {
+            n = XMFLOAT2(0.0f, localY < 0.0f ? 1.0f : -1.0f);
+            d = toSideY + r;
+        }
+    }
+    else {
+        float closestX = std::max(-half.x, std::min(half.x, localX));
+        float closestY = std::max(-half.y, std::min(half.y, localY));
+        float ex = closestX - localX;
+        float ey = closestY - localY;
+        float distSq = ex * ex + ey * ey;
+        if (distSq > r * r) return false;
+
+        float dist = sqrtf(distSq);
+        n = dist > 1e-6f ? XMFLOAT2(ex / dist, ey / dist) : XMFLOAT2(1.0f, 0.0f);
+        d = r - dist;
+        if (d <= 0.0f) return false;
+    }
+
+    *normal = flipped ? XMFLOAT2(-n.x, -n.y) : n;
+    *depth = d;
+    return true;
+}
+
+bool ContactSolver::SolveContact(const Contact& contact, XMFLOAT2* normal, float* depth)
+{
+    Body& a = bodies[contact.a];
+    XMFLOAT2 positionB = contact.b == Static ? contact.other->GetCenter() : bodies[contact.b].position;
+    if (!Penetration(a.col, a.position, contact.other, positionB, normal, depth)) return false;
+
+    // two bodies split it, against a static collider a goes the whole way
+    float share = contact.b == Static ? 1.0f : 0.5f;
+    a.position.x -= normal->x * *depth * share;
+    a.position.y -= normal->y * *depth * share;
+    if (contact.b != Static) {
+        Body& b = bodies[contact.b];
+        b.position.x += normal->x * *depth * share;
+        b.position.y += normal->y * *depth * share;
+    }
+    return true;
+}
+
+void ContactSolver::BuildColors()
+{
+    // greedy colouring, each contact takes the lowest colour neither of its bodies has yet.
+    // the last colour takes whatever runs out and is solved on one thread
+    const unsigned int lastColor = 63;
+    bodyColors.assign(bodies.size(), 0);
+    contactColor.resize(contacts.size());
+    colorCount = 0;
+    for (size_t i = 0; i < contacts.size(); i++) {
+        const Contact& contact = contacts[i];
+        unsigned long long used = bodyColors[contact.a];
+        if (contact.b != Static) used |= bodyColors[contact.b];
+
+        unsigned int color = 0;
+        while (color < lastColor && (used & (1ull << color))) color++;
+        contactColor[i] = (unsigned char)color;
+        if (color < lastColor) {
+            bodyColors[contact.a] |= 1ull << color;
+            if (contact.b != Static) bodyColors[contact.b] |= 1ull << color;
+        }
+        colorCount = std::max(colorCount, (size_t)color + 1);
+    }
+
+    // bucket the contacts by colour, keeping their order
+    colorStart.assign(colorCount + 1, 0);
+    for (size_t i = 0; i < contacts.size(); i++) colorStart[contactColor[i] + 1]++;
+    for (size_t c = 0; c < colorCount; c++) colorStart[c + 1] += colorStart[c];
+    sorted.resize(contacts.size());
+    nextContact.assign(colorStart.begin(), colorStart.end() - 1);
+    for (size_t i = 0; i < contacts.size(); i++) sorted[nextContact[contactColor[i]]++] = contacts[i];
+}
+
+void ContactSolver::SolveRange(unsigned int start, unsigned int end)
+{
+    XMFLOAT2 normal;
+    float depth;
+    for (unsigned int c = start; c < end; c++) {
+        SolveContact(sorted[c], &normal, &depth);
+    }
+}
+
+void ContactSolver::Solve(const ContactSolverSettings& settings)
+{
+    if (contacts.empty()) {
+        colorCount = 0;
+        return;
+    }
+    BuildColors();
+
+    size_t threads = (size_t)std::max(settings.threads, 1);
+    threads = std::min(threads, (size_t)(contacts.size() / std::max(settings.minContactsPerThread, 1u)));
+    if (threads <= 1) {
+        for (int i = 0; i < settings.iterations; i++) SolveRange(0, (unsigned int)contacts.size());
+        return;
+    }
+
+    // every thread takes its share of each colour, then waits for the others before the next.
+    // the waits are short, so they spin instead of sleeping
+    std::atomic<unsigned int> arrived(0);
+    std::atomic<unsigned int> generation(0);
+    auto wait = [&arrived, &generation, threads]() {
+        unsigned int current = generation.load();
+        if (arrived.fetch_add(1) + 1 == threads) {
+            arrived.store(0);
+            generation.fetch_add(1);
+            return;
+        }
+        while (generation.load() == current) std::this_thread::yield();
+    };
+
+    auto work = [this, &settings, &wait, threads](size_t thread) {
+        for (int i = 0; i < settings.iterations; i++) {
+            for (size_t color = 0; color < colorCount; color++) {
+                unsigned int start = colorStart[color];
+                unsigned int count = colorStart[color + 1] - start;
+                if (color == 63) {
+                    // the overflow colour can share bodies
+                    if (thread == 0) SolveRange(start, start + count);
+                }
+                else {
+                    SolveRange(start + (unsigned int)(count * thread / threads), start + (unsigned int)(count * (thread + 1) / threads));
+                }
+                wait();
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(work, t);
+    work(0);
+    for (std::thread& worker : workers) worker.join();
+}
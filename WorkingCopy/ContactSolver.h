@@ -0,0 +1,92 @@
+#pragma once
+#include "Collider.h"
+#include <vector>
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// How hard the ContactSolver works
+// --------------------------------------------------------
+struct ContactSolverSettings
+{
+    int iterations = 4;
+    // each colour is split between this many threads, 1 solves everything here
+    int threads = 1;
+    // fewer contacts than this aren't worth starting threads for
+    unsigned int minContactsPerThread = 256;
+};
+
+// --------------------------------------------------------
+// Pushes overlapping colliders apart.
+//
+// Bodies are colliders that can move, contacts are pairs
+// of a body and either another body or a static collider
+// that the broadphase says might overlap.  Solve goes over
+// the contacts a few times Gauss-Seidel style, working out
+// each one's normal and penetration from where the bodies
+// are now and moving them apart by it, static colliders
+// never move.
+//
+// The contacts are coloured so no two of the same colour
+// share a body, one colour's contacts can then be solved
+// on separate threads with a wait between colours.  The
+// colours are always solved in the same order, so the
+// result doesn't depend on the thread count
+// --------------------------------------------------------
+class ContactSolver
+{
+public:
+    // the other side of a contact with a static collider
+    static const unsigned int Static = 0xFFFFFFFF;
+
+    // empties everything but keeps the memory
+    void Clear();
+    // returns the body's index
+    unsigned int AddBody(Collider* col);
+    // b is Static when other is a static collider
+    void AddContact(unsigned int a, unsigned int b, Collider* other);
+
+    void Solve(const ContactSolverSettings& settings);
+
+    // how far the body was moved
+    DirectX::XMFLOAT2 GetCorrection(unsigned int body) const;
+    inline size_t GetBodyCount() const { return bodies.size(); }
+    inline size_t GetContactCount() const { return contacts.size(); }
+    inline size_t GetColorCount() const { return colorCount; }
+    // deepest overlap left after the last Solve
+    float GetMaxPenetration() const;
+
+    // normal from a to b and how far b is inside a, false if they don't overlap
+    static bool Penetration(Collider* a, DirectX::XMFLOAT2 positionA, Collider* b, DirectX::XMFLOAT2 positionB, DirectX::XMFLOAT2* normal, float* depth);
+
+private:
+    struct Body
+    {
+        Collider* col;
+        DirectX::XMFLOAT2 start;
+        DirectX::XMFLOAT2 position;
+    };
+
+    struct Contact
+    {
+        unsigned int a;
+        unsigned int b;
+        Collider* other;
+    };
+
+    std::vector<Body> bodies;
+    std::vector<Contact> contacts;
+
+    // contacts sorted by colour, each colour's range starts at colorStart
+    std::vector<unsigned char> contactColor;
+    std::vector<unsigned long long> bodyColors;
+    std::vector<unsigned int> colorStart;
+    std::vector<Contact> sorted;
+    std::vector<unsigned int> nextContact;
+    size_t colorCount = 0;
+
+    void BuildColors();
+    // solves sorted[start, end)
+    void SolveRange(unsigned int start, unsigned int end);
+    bool SolveContact(const Contact& contact, DirectX::XMFLOAT2* normal, float* depth);
+};
+
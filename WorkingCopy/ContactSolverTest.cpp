@@ -0,0 +1,179 @@
+#include "ContactSolver.h"
+#include "ColliderStore.h"
+#include "SpatialHashGrid.h"
+#include "SweepAndPrune.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Feeds the ContactSolver a crowd of agents jammed in among
+// trees and crates the way CollisionManager::Step does,
+// and checks more iterations leave less overlap, contacts
+// that run out of colours still get solved, and splitting
+// the colours between threads moves every body exactly as
+// far as solving them on one does
+// --------------------------------------------------------
+
+namespace
+{
+	const float AgentRadius = 0.5f;
+	const float TreeRadius = 1.5f;
+
+	struct Scene
+	{
+		std::vector<Collider*> agents;
+		SweepAndPrune movers;
+		SpatialHashGrid statics;
+		std::vector<SweepAndPrune::Pair> pairs;
+		std::vector<Collider*> nearby;
+		// body index by collider slot
+		std::vector<unsigned int> bodyOfSlot;
+	};
+
+	// bodies and contacts as Step adds them: every agent, the pairs of agents
+	// whose bounds overlap, then whatever static colliders are near each agent
+	void Fill(Scene& scene, ContactSolver& solver)
+	{
+		solver.Clear();
+		for (Collider* agent : scene.agents)
+		{
+			if (agent->GetIndex() >= scene.bodyOfSlot.size()) scene.bodyOfSlot.resize(agent->GetIndex() + 1);
+			scene.bodyOfSlot[agent->GetIndex()] = solver.AddBody(agent);
+		}
+		scene.movers.FindPairs(scene.pairs);
+		for (const SweepAndPrune::Pair& pair : scene.pairs)
+		{
+			solver.AddContact(scene.bodyOfSlot[pair.a->GetIndex()], scene.bodyOfSlot[pair.b->GetIndex()], pair.b);
+		}
+		for (Collider* agent : scene.agents)
+		{
+			scene.statics.GetCollidableObjects(agent, scene.nearby);
+			for (Collider* other : scene.nearby) solver.AddContact(scene.bodyOfSlot[agent->GetIndex()], ContactSolver::Static, other);
+		}
+	}
+}
+
+int main()
+{
+	ColliderStore* store = ColliderStore::Instance();
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	// a 30 by 30 clearing with trees and crates in it, and 1500 agents crowded in
+	// at random so most of them start inside something
+	Scene scene;
+	std::vector<Collider*> obstacles;
+	for (int i = 0; i < 40; i++)
+	{
+		Collider* tree = store->Get(store->CreateCircle(TreeRadius));
+		tree->SetCenter(XMFLOAT2(uniform(random) * 15.0f, uniform(random) * 15.0f));
+		obstacles.push_back(tree);
+	}
+	for (int i = 0; i < 15; i++)
+	{
+		Collider* crate = store->Get(store->CreateRect(XMFLOAT2(2.0f + uniform(random), 2.0f - uniform(random))));
+		crate->SetCenter(XMFLOAT2(uniform(random) * 15.0f, uniform(random) * 15.0f));
+		obstacles.push_back(crate);
+	}
+	scene.statics.Build(obstacles);
+	for (int i = 0; i < 1500; i++)
+	{
+		Collider* agent = store->Get(store->CreateCircle(AgentRadius));
+		agent->SetCenter(XMFLOAT2(uniform(random) * 15.0f, uniform(random) * 15.0f));
+		scene.agents.push_back(agent);
+		scene.movers.Add(agent);
+	}
+
+	// more iterations, less overlap left
+	ContactSolver solver;
+	ContactSolverSettings settings;
+	Fill(scene, solver);
+	settings.iterations = 0;
+	solver.Solve(settings);
+	float previous = solver.GetMaxPenetration();
+	printf("%zu bodies, %zu contacts in %zu colours, %.3f deepest to start with\n",
+		solver.GetBodyCount(), solver.GetContactCount(), solver.GetColorCount(), previous);
+	CHECK(previous > AgentRadius);
+	for (int iterations : { 1, 4, 16, 64 })
+	{
+		Fill(scene, solver);
+		settings.iterations = iterations;
+		TestTimer timer;
+		solver.Solve(settings);
+		double ms = timer.Milliseconds();
+		float deepest = solver.GetMaxPenetration();
+		printf("%2d iterations: %.4f deepest left, %.3f ms\n", iterations, deepest, ms);
+		CHECK(deepest < previous);
+		previous = deepest;
+	}
+
+	// the same crowd on four threads, forced to start even for this few contacts,
+	// moves every body bit for bit the same as one thread does
+	ContactSolver threaded;
+	settings.iterations = 4;
+	settings.threads = 1;
+	Fill(scene, solver);
+	solver.Solve(settings);
+	settings.threads = 4;
+	settings.minContactsPerThread = 1;
+	Fill(scene, threaded);
+	threaded.Solve(settings);
+	int different = 0;
+	for (unsigned int i = 0; i < (unsigned int)scene.agents.size(); i++)
+	{
+		XMFLOAT2 one = solver.GetCorrection(i);
+		XMFLOAT2 four = threaded.GetCorrection(i);
+		different += one.x != four.x || one.y != four.y;
+	}
+	printf("4 threads: %d of %zu corrections differ from 1 thread\n", different, scene.agents.size());
+	CHECK(different == 0);
+	CHECK(threaded.GetMaxPenetration() == solver.GetMaxPenetration());
+
+	// an agent pressed into a hedge of 80 posts, more contacts than there are colours.
+	// the deepest go in last, so only the overflow colour gets them
+	std::vector<Collider*> posts;
+	for (int i = 0; i < 80; i++)
+	{
+		Collider* post = store->Get(store->CreateCircle(0.05f));
+		float x = (i % 2 ? 1.0f : -1.0f) * (0.4f - i * 0.005f);
+		post->SetCenter(XMFLOAT2(100.0f + x, 0.0f));
+		posts.push_back(post);
+	}
+	SpatialHashGrid hedge;
+	hedge.Build(posts);
+	Collider* pressed = store->Get(store->CreateCircle(AgentRadius));
+	pressed->SetCenter(XMFLOAT2(100.0f, 0.3f));
+	std::vector<Collider*> nearby;
+
+	for (int threads : { 1, 4 })
+	{
+		// GetCollidableObjects hands them back in no particular order, put them in shallowest first
+		hedge.GetCollidableObjects(pressed, nearby);
+		std::sort(nearby.begin(), nearby.end(), [](Collider* a, Collider* b) {
+			return fabsf(a->GetCenter().x - 100.0f) > fabsf(b->GetCenter().x - 100.0f);
+		});
+		solver.Clear();
+		solver.AddBody(pressed);
+		for (Collider* post : nearby) solver.AddContact(0, ContactSolver::Static, post);
+		settings.iterations = 1;
+		settings.threads = threads;
+		solver.Solve(settings);
+		XMFLOAT2 correction = solver.GetCorrection(0);
+		printf("hedge on %d thread(s): %zu contacts in %zu colours, pushed %.3f, %.5f deepest left\n",
+			threads, solver.GetContactCount(), solver.GetColorCount(), correction.y, solver.GetMaxPenetration());
+		CHECK(solver.GetContactCount() == posts.size());
+		CHECK(solver.GetColorCount() == 64);
+		CHECK(solver.GetMaxPenetration() < 1e-4f);
+		// out the way it was already leaning, clear of the middle post
+		CHECK(correction.y > 0.0f && fabsf(correction.x) < 1e-4f);
+		CHECK(0.3f + correction.y > AgentRadius + 0.05f - 1e-4f);
+	}
+
+	return TestResult();
+}
@@ -0,0 +1,76 @@
+#include "ContactTracker.h"
+#include "ContactSolver.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+bool ContactTracker::CanTouch(Collider* a, Collider* b)
+{
+	return a->IsEnabled() && b->IsEnabled() && a->Interacts(b);
+}
+
+bool ContactTracker::Touch(Collider* a, Collider* b)
+{
+	XMFLOAT2 normal;
+	float depth;
+	if (!ContactSolver::Penetration(a, a->GetCenter(), b, b->GetCenter(), &normal, &depth)) return false;
+	Record(a, b);
+	return true;
+}
+
+void ContactTracker::Record(Collider* a, Collider* b)
+{
+	if (a->GetIndex() > b->GetIndex()) std::swap(a, b);
+	TrackedContact contact = { ((unsigned long long)a->GetIndex() << 32) | b->GetIndex(), a, b };
+	touching.push_back(contact);
+}
+
+void ContactTracker::Remove(Collider* col)
+{
+	for (const TrackedContact& contact : touchingLastFrame) {
+		if (contact.a == col || contact.b == col) {
+			CollisionEvent exit = { COLLISION_EVENT::EXIT, contact.a, contact.b, contact.a->IsTrigger() || contact.b->IsTrigger() };
+			removedEvents.push_back(exit);
+		}
+	}
+	auto involves = [col](const TrackedContact& contact) { return contact.a == col || contact.b == col; };
+	touchingLastFrame.erase(std::remove_if(touchingLastFrame.begin(), touchingLastFrame.end(), involves), touchingLastFrame.end());
+	touching.erase(std::remove_if(touching.begin(), touching.end(), involves), touching.end());
+}
+
+void ContactTracker::BuildEvents()
+{
+	auto byKey = [](const TrackedContact& x, const TrackedContact& y) { return x.key < y.key; };
+	auto sameKey = [](const TrackedContact& x, const TrackedContact& y) { return x.key == y.key; };
+	std::sort(touching.begin(), touching.end(), byKey);
+	touching.erase(std::unique(touching.begin(), touching.end(), sameKey), touching.end());
+
+	// both lists are sorted, walk them together
+	events.swap(removedEvents);
+	removedEvents.clear();
+	size_t now = 0;
+	size_t before = 0;
+	while (now < touching.size() || before < touchingLastFrame.size()) {
+		const TrackedContact* contact;
+		COLLISION_EVENT type;
+		if (before == touchingLastFrame.size() || (now < touching.size() && touching[now].key < touchingLastFrame[before].key)) {
+			contact = &touching[now++];
+			type = COLLISION_EVENT::ENTER;
+		}
+		else if (now == touching.size() || touchingLastFrame[before].key < touching[now].key) {
+			contact = &touchingLastFrame[before++];
+			type = COLLISION_EVENT::EXIT;
+		}
+		else {
+			contact = &touching[now++];
+			before++;
+			type = COLLISION_EVENT::STAY;
+		}
+
+		CollisionEvent event = { type, contact->a, contact->b, contact->a->IsTrigger() || contact->b->IsTrigger() };
+		events.push_back(event);
+	}
+
+	touchingLastFrame.swap(touching);
+	touching.clear();
+}
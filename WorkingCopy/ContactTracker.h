@@ -0,0 +1,57 @@
+#pragma once
+#include "Collider.h"
+#include <vector>
+
+enum class COLLISION_EVENT { ENTER, STAY, EXIT };
+
+// two colliders that started, kept on or stopped touching this frame,
+// a is always the one in the lower ColliderStore slot
+struct CollisionEvent
+{
+	COLLISION_EVENT type;
+	Collider* a;
+	Collider* b;
+	// either one is a trigger
+	bool trigger;
+};
+
+// --------------------------------------------------------
+// Remembers which colliders touched last frame, so the
+// pairs recorded this frame can be turned into enter, stay
+// and exit events.  Pairs are keyed by their two slots and
+// both frames are kept sorted by key, so the events come
+// from walking the two lists together
+// --------------------------------------------------------
+class ContactTracker
+{
+public:
+	// both enabled and each one's mask has the other's layer
+	static bool CanTouch(Collider* a, Collider* b);
+
+	// records a and b if they overlap where they are now, returns whether they do
+	bool Touch(Collider* a, Collider* b);
+	// records a and b as touching this frame, in either order and as often as they're found
+	void Record(Collider* a, Collider* b);
+	// col is going away before the frame ends, it leaves everything it was touching now
+	void Remove(Collider* col);
+	// ends the frame, the events cover this frame against the last
+	void BuildEvents();
+
+	// enter, stay and exit events from the last BuildEvents, and exits for whatever was removed before it
+	inline const std::vector<CollisionEvent>& GetEvents() const { return events; }
+
+private:
+	struct TrackedContact
+	{
+		unsigned long long key;
+		Collider* a;
+		Collider* b;
+	};
+
+	// this frame's, sorted once it ends, and last frame's
+	std::vector<TrackedContact> touching;
+	std::vector<TrackedContact> touchingLastFrame;
+	std::vector<CollisionEvent> events;
+	// exits for colliders removed since the last BuildEvents
+	std::vector<CollisionEvent> removedEvents;
+};
@@ -0,0 +1,136 @@
+#include "ContactTracker.h"
+#include "ColliderStore.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Walks the player, Slenderman, a tree and a letter in and
+// out of each other frame by frame, testing every pair the
+// way CollisionManager::Step does, and checks each pair
+// gets one enter, a stay a frame while they touch and one
+// exit.  Slenderman's mask leaves out pickups, so he never
+// touches the letter even standing on it
+// --------------------------------------------------------
+
+namespace
+{
+	// one frame: every pair that can touch is tested, then the events are built
+	void Frame(ContactTracker& tracker, const std::vector<Collider*>& colliders)
+	{
+		for (size_t i = 0; i < colliders.size(); i++)
+		{
+			for (size_t j = i + 1; j < colliders.size(); j++)
+			{
+				if (ContactTracker::CanTouch(colliders[i], colliders[j])) tracker.Touch(colliders[i], colliders[j]);
+			}
+		}
+		tracker.BuildEvents();
+	}
+
+	// how many of the last frame's events are for a and b, and the type of the last one
+	int Count(const ContactTracker& tracker, Collider* a, Collider* b, COLLISION_EVENT* type = nullptr, bool* trigger = nullptr)
+	{
+		int count = 0;
+		for (const CollisionEvent& event : tracker.GetEvents())
+		{
+			if (!((event.a == a && event.b == b) || (event.a == b && event.b == a))) continue;
+			// the lower slot always comes first
+			CHECK(event.a->GetIndex() < event.b->GetIndex());
+			if (type) *type = event.type;
+			if (trigger) *trigger = event.trigger;
+			count++;
+		}
+		return count;
+	}
+
+	bool Is(const ContactTracker& tracker, Collider* a, Collider* b, COLLISION_EVENT expected)
+	{
+		COLLISION_EVENT type = COLLISION_EVENT::ENTER;
+		return Count(tracker, a, b, &type) == 1 && type == expected;
+	}
+}
+
+int main()
+{
+	// set up the way Game does
+	ColliderStore* store = ColliderStore::Instance();
+	Collider* player = store->Get(store->CreateCircle(0.2f));
+	player->SetLayer(COLLISION_LAYER::PLAYER);
+	Collider* slenderman = store->Get(store->CreateCircle(0.5f));
+	slenderman->SetLayer(COLLISION_LAYER::AGENT);
+	slenderman->SetMask(COLLISION_LAYER::ALL & ~COLLISION_LAYER::PICKUP);
+	Collider* tree = store->Get(store->CreateCircle(1.5f));
+	tree->SetCenter(XMFLOAT2(10, 0));
+	Collider* letter = store->Get(store->CreateRect(XMFLOAT2(0.5f, 0.35f)));
+	letter->SetLayer(COLLISION_LAYER::PICKUP);
+	letter->SetTrigger(true);
+	letter->SetCenter(XMFLOAT2(-10, 0));
+	player->SetCenter(XMFLOAT2(0, 10));
+	std::vector<Collider*> colliders = { player, slenderman, tree, letter };
+
+	CHECK(ContactTracker::CanTouch(player, letter) && ContactTracker::CanTouch(slenderman, tree));
+	CHECK(!ContactTracker::CanTouch(slenderman, letter) && !ContactTracker::CanTouch(letter, slenderman));
+
+	// apart, nothing happens
+	ContactTracker tracker;
+	Frame(tracker, colliders);
+	CHECK(tracker.GetEvents().empty());
+
+	// Slenderman walks into the tree, stays against it a couple of frames and walks off
+	slenderman->SetCenter(XMFLOAT2(8.5f, 0));
+	Frame(tracker, colliders);
+	bool trigger = true;
+	COLLISION_EVENT type = COLLISION_EVENT::EXIT;
+	CHECK(Count(tracker, slenderman, tree, &type, &trigger) == 1 && type == COLLISION_EVENT::ENTER && !trigger);
+	CHECK(tracker.GetEvents().size() == 1);
+	for (int frame = 0; frame < 2; frame++)
+	{
+		slenderman->SetCenter(XMFLOAT2(8.2f + frame * 0.1f, 0.1f));
+		Frame(tracker, colliders);
+		CHECK(Is(tracker, slenderman, tree, COLLISION_EVENT::STAY));
+		CHECK(tracker.GetEvents().size() == 1);
+	}
+	slenderman->SetCenter(XMFLOAT2(5, 0));
+	Frame(tracker, colliders);
+	CHECK(Is(tracker, slenderman, tree, COLLISION_EVENT::EXIT));
+	Frame(tracker, colliders);
+	CHECK(tracker.GetEvents().empty());
+
+	// standing on the letter he doesn't touch it, the player does and it's a trigger
+	slenderman->SetCenter(XMFLOAT2(-10, 0));
+	Frame(tracker, colliders);
+	CHECK(tracker.GetEvents().empty());
+	player->SetCenter(XMFLOAT2(-10.3f, 0));
+	Frame(tracker, colliders);
+	CHECK(Count(tracker, player, letter, &type, &trigger) == 1 && type == COLLISION_EVENT::ENTER && trigger);
+	CHECK(Is(tracker, player, slenderman, COLLISION_EVENT::ENTER));
+	CHECK(Count(tracker, slenderman, letter) == 0);
+	CHECK(tracker.GetEvents().size() == 2);
+
+	// the same pair found twice in a frame, by the broadphase and the player's test, is one event
+	tracker.Record(letter, player);
+	Frame(tracker, colliders);
+	CHECK(Is(tracker, player, letter, COLLISION_EVENT::STAY));
+
+	// picked up: it's disabled, so it stops touching without moving
+	letter->SetEnabled(false);
+	Frame(tracker, colliders);
+	CHECK(Is(tracker, player, letter, COLLISION_EVENT::EXIT));
+	CHECK(Is(tracker, player, slenderman, COLLISION_EVENT::STAY));
+
+	// removed mid frame, what it was touching gets an exit at the end of it even though
+	// it's still there, and it isn't entered again
+	tracker.Remove(slenderman);
+	Frame(tracker, { player, tree, letter });
+	CHECK(Is(tracker, player, slenderman, COLLISION_EVENT::EXIT));
+	CHECK(tracker.GetEvents().size() == 1);
+	Frame(tracker, { player, tree, letter });
+	CHECK(tracker.GetEvents().empty());
+
+	printf("enter, stay and exit for the tree, the letter and the player, none for Slenderman on the letter\n");
+
+	return TestResult();
+}
@@ -0,0 +1,295 @@
+#include "CullingQuadtree.h"
+#include "LinearQuadtree.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+using namespace DirectX;
+
+CullingQuadtree::CullingQuadtree(const QuadtreeSettings& settings) : settings(settings)
+{
+    if (this->settings.maxDepth > 16) this->settings.maxDepth = 16;
+    if (this->settings.maxDepth < 0) this->settings.maxDepth = 0;
+    if (this->settings.leafCapacity < 1) this->settings.leafCapacity = 1;
+}
+
+void CullingQuadtree::Build(const std::vector<unsigned int>& items, size_t idCount, const float* x, const float* y, const float* z,
+    const float* extentX, const float* extentY, const float* extentZ)
+{
+    size_t count = items.size();
+    nodes.clear();
+    refitQueue.clear();
+    keys.resize(count);
+    order.resize(count);
+    unsigned int notInTree = NotInTree;
+    itemOf.assign(idCount, notInTree);
+    leafOf.resize(count);
+    leafVisible.resize(count);
+
+    // a square around every center on x and z
+    float left = FLT_MAX, back = FLT_MAX, right = -FLT_MAX, front = -FLT_MAX;
+    for (unsigned int id : items)
+    {
+        left = std::min(left, x[id]);
+        right = std::max(right, x[id]);
+        back = std::min(back, z[id]);
+        front = std::max(front, z[id]);
+    }
+    float size = std::max(std::max(right - left, front - back), 0.001f);
+
+    // key every item by the finest cell its center is in
+    unsigned int cells = 1u << settings.maxDepth;
+    float cellsPerUnit = cells / size;
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned int id = items[i];
+        float cx = (x[id] - left) * cellsPerUnit;
+        float cz = (z[id] - back) * cellsPerUnit;
+        unsigned int cellX = cx <= 0.0f ? 0 : (cx >= cells ? cells - 1 : (unsigned int)cx);
+        unsigned int cellZ = cz <= 0.0f ? 0 : (cz >= cells ? cells - 1 : (unsigned int)cz);
+        keys[i] = LinearQuadtree::MortonCode(cellX, cellZ);
+        order[i] = (unsigned int)i;
+    }
+    SortByKey(count);
+
+    // lay the boxes out in key order
+    ids.resize(count);
+    this->x.resize(count);
+    this->y.resize(count);
+    this->z.resize(count);
+    this->extentX.resize(count);
+    this->extentY.resize(count);
+    this->extentZ.resize(count);
+    sortScratch.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        unsigned int id = items[order[i]];
+        ids[i] = id;
+        itemOf[id] = (unsigned int)i;
+        this->x[i] = x[id];
+        this->y[i] = y[id];
+        this->z[i] = z[id];
+        this->extentX[i] = extentX[id];
+        this->extentY[i] = extentY[id];
+        this->extentZ[i] = extentZ[id];
+        sortScratch[i] = keys[order[i]];
+    }
+    keys.swap(sortScratch);
+
+    Node root;
+    root.itemStart = 0;
+    root.itemCount = (unsigned int)count;
+    root.firstChild = 0;
+    root.parent = 0;
+    root.refit = false;
+    nodes.push_back(root);
+    Split(0, 0, 0);
+}
+
+void CullingQuadtree::SortByKey(size_t count)
+{
+    // the same radix sort as LinearQuadtree's, 8 bits a pass
+    sortScratch.resize(count);
+    int keyBits = settings.maxDepth * 2;
+    for (int shift = 0; shift < keyBits; shift += 8)
+    {
+        unsigned int counts[257] = {};
+        for (size_t i = 0; i < count; i++)
+        {
+            counts[((keys[order[i]] >> shift) & 0xFF) + 1]++;
+        }
+        for (int d = 0; d < 256; d++)
+        {
+            counts[d + 1] += counts[d];
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            unsigned int digit = (keys[order[i]] >> shift) & 0xFF;
+            sortScratch[counts[digit]++] = order[i];
+        }
+        order.swap(sortScratch);
+    }
+}
+
+void CullingQuadtree::Split(unsigned int node, int depth, unsigned int prefix)
+{
+    unsigned int start = nodes[node].itemStart;
+    unsigned int end = start + nodes[node].itemCount;
+
+    if (nodes[node].itemCount <= settings.leafCapacity || depth >= settings.maxDepth)
+    {
+        for (unsigned int i = start; i < end; i++)
+        {
+            leafOf[i] = node;
+        }
+        FitLeaf(node);
+        return;
+    }
+
+    // the children split the node's key range in four, find where each quarter starts
+    unsigned int firstChild = (unsigned int)nodes.size();
+    nodes[node].firstChild = firstChild;
+    int shift = 2 * (settings.maxDepth - depth - 1);
+    unsigned int childStart = start;
+    for (unsigned int quadrant = 0; quadrant < 4; quadrant++)
+    {
+        unsigned int childEnd = end;
+        if (quadrant < 3)
+        {
+            unsigned int nextKey = ((prefix << 2) | (quadrant + 1)) << shift;
+            childEnd = (unsigned int)(std::lower_bound(keys.begin() + childStart, keys.begin() + end, nextKey) - keys.begin());
+        }
+
+        Node child;
+        child.itemStart = childStart;
+        child.itemCount = childEnd - childStart;
+        child.firstChild = 0;
+        child.parent = node;
+        child.refit = false;
+        nodes.push_back(child);
+        childStart = childEnd;
+    }
+
+    // the pool can grow while the children split, so nothing holds a reference into it
+    for (unsigned int quadrant = 0; quadrant < 4; quadrant++)
+    {
+        Split(firstChild + quadrant, depth + 1, (prefix << 2) | quadrant);
+    }
+    FitParent(node);
+}
+
+void CullingQuadtree::FitLeaf(unsigned int node)
+{
+    // empty leaves end up inside out, which Cull never visits
+    Node& n = nodes[node];
+    XMFLOAT3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+    XMFLOAT3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    unsigned int end = n.itemStart + n.itemCount;
+    for (unsigned int i = n.itemStart; i < end; i++)
+    {
+        boundsMin.x = std::min(boundsMin.x, x[i] - extentX[i]);
+        boundsMin.y = std::min(boundsMin.y, y[i] - extentY[i]);
+        boundsMin.z = std::min(boundsMin.z, z[i] - extentZ[i]);
+        boundsMax.x = std::max(boundsMax.x, x[i] + extentX[i]);
+        boundsMax.y = std::max(boundsMax.y, y[i] + extentY[i]);
+        boundsMax.z = std::max(boundsMax.z, z[i] + extentZ[i]);
+    }
+    n.boundsMin = boundsMin;
+    n.boundsMax = boundsMax;
+}
+
+void CullingQuadtree::FitParent(unsigned int node)
+{
+    Node& n = nodes[node];
+    XMFLOAT3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX);
+    XMFLOAT3 boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+    for (unsigned int child = n.firstChild; child < n.firstChild + 4; child++)
+    {
+        const Node& c = nodes[child];
+        boundsMin.x = std::min(boundsMin.x, c.boundsMin.x);
+        boundsMin.y = std::min(boundsMin.y, c.boundsMin.y);
+        boundsMin.z = std::min(boundsMin.z, c.boundsMin.z);
+        boundsMax.x = std::max(boundsMax.x, c.boundsMax.x);
+        boundsMax.y = std::max(boundsMax.y, c.boundsMax.y);
+        boundsMax.z = std::max(boundsMax.z, c.boundsMax.z);
+    }
+    n.boundsMin = boundsMin;
+    n.boundsMax = boundsMax;
+}
+
+void CullingQuadtree::Move(unsigned int id, const Bounds& bounds)
+{
+    unsigned int i = itemOf[id];
+    x[i] = bounds.center.x;
+    y[i] = bounds.center.y;
+    z[i] = bounds.center.z;
+    extentX[i] = bounds.extents.x;
+    extentY[i] = bounds.extents.y;
+    extentZ[i] = bounds.extents.z;
+
+    // queue the leaf and everything above it once
+    unsigned int node = leafOf[i];
+    while (!nodes[node].refit)
+    {
+        nodes[node].refit = true;
+        refitQueue.push_back(node);
+        if (node == 0) break;
+        node = nodes[node].parent;
+    }
+}
+
+void CullingQuadtree::Refit()
+{
+    if (refitQueue.empty()) return;
+
+    // children always come after their parent in the pool, so going
+    // from the back fits every child before the node above it
+    std::sort(refitQueue.begin(), refitQueue.end());
+    for (size_t i = refitQueue.size(); i-- > 0;)
+    {
+        unsigned int node = refitQueue[i];
+        if (nodes[node].firstChild == 0) FitLeaf(node);
+        else FitParent(node);
+        nodes[node].refit = false;
+    }
+    refitQueue.clear();
+}
+
+size_t CullingQuadtree::Cull(const Frustum& frustum, unsigned char* visible)
+{
+    stats = CullStats();
+    if (!itemOf.empty()) memset(visible, 0, itemOf.size());
+    if (nodes.empty()) return 0;
+    Refit();
+
+    size_t kept = 0;
+    walk.clear();
+    walk.push_back(std::make_pair(0u, Frustum::AllPlanes));
+    while (!walk.empty())
+    {
+        unsigned int node = walk.back().first;
+        unsigned int planeMask = walk.back().second;
+        walk.pop_back();
+
+        const Node& n = nodes[node];
+        if (n.itemCount == 0) continue;
+        stats.nodesVisited++;
+
+        XMFLOAT3 center((n.boundsMin.x + n.boundsMax.x) * 0.5f, (n.boundsMin.y + n.boundsMax.y) * 0.5f, (n.boundsMin.z + n.boundsMax.z) * 0.5f);
+        XMFLOAT3 extents((n.boundsMax.x - n.boundsMin.x) * 0.5f, (n.boundsMax.y - n.boundsMin.y) * 0.5f, (n.boundsMax.z - n.boundsMin.z) * 0.5f);
+        if (!frustum.TestBox(center, extents, planeMask)) continue;
+
+        unsigned int end = n.itemStart + n.itemCount;
+        if (planeMask == 0)
+        {
+            // all of it is inside, nothing below needs testing
+            stats.nodesInside++;
+            kept += n.itemCount;
+            for (unsigned int i = n.itemStart; i < end; i++)
+            {
+                visible[ids[i]] = 1;
+            }
+        }
+        else if (n.firstChild == 0)
+        {
+            unsigned int start = n.itemStart;
+            frustum.Cull(&x[start], &y[start], &z[start], &extentX[start], &extentY[start], &extentZ[start],
+                n.itemCount, &leafVisible[start]);
+            stats.itemsTested += n.itemCount;
+            for (unsigned int i = start; i < end; i++)
+            {
+                visible[ids[i]] = leafVisible[i];
+                kept += leafVisible[i];
+            }
+        }
+        else
+        {
+            for (unsigned int child = n.firstChild; child < n.firstChild + 4; child++)
+            {
+                walk.push_back(std::make_pair(child, planeMask));
+            }
+        }
+    }
+
+    return kept;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "Frustum.h"
+#include "QuadtreeSettings.h"
+#include <vector>
+#include <utility>
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// A quadtree over world space boxes for culling, laid out
+// the same way as LinearQuadtree: items sorted by the
+// Morton code of their center on x and z, so every node is
+// one range of the sorted items and its four children sit
+// next to each other in the pool.  Nodes keep the 3D box
+// around everything below them.
+//
+// Cull walks it against a frustum.  Nodes outside it are
+// skipped with everything in them, nodes inside it mark
+// their whole range visible without testing anything, and
+// only the leaves it cuts through test their own items, in
+// SIMD batches.
+//
+// Moving an item refits the boxes above it without sorting
+// again.  Items keep their place in the order, so a leaf
+// whose items drift apart just gets a bigger box until the
+// next Build.  The root is fitted to the items when it's
+// built, settings.center and halfSize aren't used
+// --------------------------------------------------------
+class CullingQuadtree
+{
+public:
+    CullingQuadtree(const QuadtreeSettings& settings = QuadtreeSettings());
+
+    // replaces everything. ids are what Cull marks, each below idCount, and the
+    // boxes are parallel arrays of centers and extents indexed by id
+    void Build(const std::vector<unsigned int>& items, size_t idCount, const float* x, const float* y, const float* z,
+        const float* extentX, const float* extentY, const float* extentZ);
+
+    // an item moved, its node boxes are fixed by the next Refit or Cull
+    void Move(unsigned int id, const Bounds& bounds);
+    void Refit();
+
+    // sets visible[id] to 1 for every item whose box is at least partly inside the frustum,
+    // visible has to hold idCount entries and is cleared first. returns how many it set
+    size_t Cull(const Frustum& frustum, unsigned char* visible);
+
+    inline bool Contains(unsigned int id) const { return id < itemOf.size() && itemOf[id] != NotInTree; }
+    inline size_t GetIdCount() const { return itemOf.size(); }
+    inline const QuadtreeSettings& GetSettings() const { return settings; }
+    inline size_t GetNodeCount() const { return nodes.size(); }
+    inline size_t GetItemCount() const { return ids.size(); }
+
+    // what the last Cull did
+    struct CullStats
+    {
+        unsigned int nodesVisited = 0;
+        unsigned int nodesInside = 0;       // accepted with everything below them
+        unsigned int itemsTested = 0;
+    };
+    inline const CullStats& GetCullStats() const { return stats; }
+
+private:
+    struct Node
+    {
+        DirectX::XMFLOAT3 boundsMin;
+        DirectX::XMFLOAT3 boundsMax;
+        unsigned int itemStart;
+        unsigned int itemCount;
+        unsigned int firstChild;    // 0 for leaves, the root is never anyone's child
+        unsigned int parent;
+        bool refit;                 // queued for Refit
+    };
+
+    static const unsigned int NotInTree = 0xFFFFFFFF;
+
+    QuadtreeSettings settings;
+    std::vector<Node> nodes;
+    // sorted by key, each node owns a range
+    std::vector<unsigned int> ids;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+    std::vector<unsigned int> keys;
+    // where each id ended up, and the leaf holding each item
+    std::vector<unsigned int> itemOf;
+    std::vector<unsigned int> leafOf;
+    std::vector<unsigned int> refitQueue;
+    // per item, for the leaves Cull tests
+    std::vector<unsigned char> leafVisible;
+    // nodes still to visit and the planes they still have to be tested against
+    std::vector<std::pair<unsigned int, unsigned int>> walk;
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> sortScratch;
+    CullStats stats;
+
+    void SortByKey(size_t count);
+    void Split(unsigned int node, int depth, unsigned int prefix);
+    void FitLeaf(unsigned int node);
+    void FitParent(unsigned int node);
+};
@@ -0,0 +1,252 @@
+#include "CullingQuadtree.h"
+#include "TransformSystem.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Checks CullingQuadtree::Cull keeps exactly what
+// Frustum::Cull over every box keeps, for a forest seen
+// from a camera going round it, after items move, and
+// through TransformSystem::Cull for both views.  Prints
+// what each costs and how much of the forest the tree
+// tested.  Built once with SIMD and once without, see
+// CMakeLists.txt
+// --------------------------------------------------------
+
+namespace
+{
+	const float Pi = 3.1415926535f;
+
+	struct Boxes
+	{
+		std::vector<float> x, y, z, extentX, extentY, extentZ;
+
+		void Resize(size_t count)
+		{
+			x.resize(count);
+			y.resize(count);
+			z.resize(count);
+			extentX.resize(count);
+			extentY.resize(count);
+			extentZ.resize(count);
+		}
+
+		void Set(size_t i, const Bounds& bounds)
+		{
+			x[i] = bounds.center.x;
+			y[i] = bounds.center.y;
+			z[i] = bounds.center.z;
+			extentX[i] = bounds.extents.x;
+			extentY[i] = bounds.extents.y;
+			extentZ[i] = bounds.extents.z;
+		}
+
+		Bounds Get(size_t i) const
+		{
+			Bounds bounds;
+			bounds.center = XMFLOAT3(x[i], y[i], z[i]);
+			bounds.extents = XMFLOAT3(extentX[i], extentY[i], extentZ[i]);
+			bounds.radius = sqrtf(extentX[i] * extentX[i] + extentY[i] * extentY[i] + extentZ[i] * extentZ[i]);
+			return bounds;
+		}
+	};
+
+	// how far inside the frustum the box's best corner is for its worst plane, near 0 it's on a plane
+	float Margin(const Frustum& frustum, const Boxes& boxes, size_t i)
+	{
+		float worst = 1e30f;
+		for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+		{
+			const XMFLOAT4& plane = frustum.GetPlane(p);
+			float distance = plane.x * boxes.x[i] + plane.y * boxes.y[i] + plane.z * boxes.z[i] + plane.w;
+			float reach = fabsf(plane.x) * boxes.extentX[i] + fabsf(plane.y) * boxes.extentY[i] + fabsf(plane.z) * boxes.extentZ[i];
+			worst = fminf(worst, distance + reach);
+		}
+		return worst;
+	}
+
+	// the camera walking a circle around the middle of the forest and looking about
+	Frustum CameraAt(float t, float lookDown = 0.0f)
+	{
+		XMFLOAT3 position(cosf(t) * 150, 1.5f, sinf(t) * 150);
+		float yaw = t * 3 + sinf(t * 7);
+		float pitch = 0.2f * sinf(t * 5) - lookDown;
+		XMVECTOR direction = XMVectorSet(cosf(pitch) * sinf(yaw), sinf(pitch), cosf(pitch) * cosf(yaw), 0);
+		XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&position), direction, XMVectorSet(0, 1, 0, 0));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(0.25f * Pi, 16.0f / 9.0f, 0.1f, 100.0f);
+		return Frustum(view * projection);
+	}
+}
+
+int main()
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> spread(-250.0f, 250.0f);
+	std::uniform_real_distribution<float> scale(0.5f, 3.0f);
+
+	// a forest of trees up to 24 high and one ground box under all of it, with every
+	// seventh id left out of the tree the way destroyed transforms are
+	const size_t count = 50001;
+	Boxes boxes;
+	boxes.Resize(count);
+	std::vector<unsigned int> items;
+	for (size_t i = 0; i < count; i++)
+	{
+		float size = scale(random);
+		if (i == 0) boxes.Set(i, Bounds::FromMinMax(XMFLOAT3(-250, 0, -250), XMFLOAT3(250, 0, 250)));
+		else boxes.Set(i, Bounds::FromMinMax(XMFLOAT3(0, 0, 0), XMFLOAT3(size, 8 * size, size)));
+		if (i > 0)
+		{
+			boxes.x[i] += spread(random);
+			boxes.z[i] += spread(random);
+		}
+		if (i % 7 != 3) items.push_back((unsigned int)i);
+	}
+	std::vector<unsigned char> inItems(count, 0);
+	for (unsigned int id : items) inItems[id] = 1;
+
+	CullingQuadtree tree;
+	TestTimer timer;
+	tree.Build(items, count, &boxes.x[0], &boxes.y[0], &boxes.z[0], &boxes.extentX[0], &boxes.extentY[0], &boxes.extentZ[0]);
+	printf("built %zu items into %zu nodes in %.3f ms\n", tree.GetItemCount(), tree.GetNodeCount(), timer.Milliseconds());
+	CHECK(tree.GetItemCount() == items.size());
+	CHECK(tree.Contains(0) && !tree.Contains(3) && !tree.Contains((unsigned int)count));
+
+	// frames around the circle, half of them after some trees moved
+	const int frames = 240;
+	std::vector<unsigned char> flat(count);
+	std::vector<unsigned char> culled(count);
+	int wrong = 0;
+	int unsure = 0;
+	double flatMs = 0.0;
+	double treeMs = 0.0;
+	size_t kept = 0;
+	size_t tested = 0;
+	size_t nodesInside = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		float t = frame / (float)frames * 2 * Pi;
+		if (frame >= frames / 2)
+		{
+			for (int k = 0; k < 500; k++)
+			{
+				unsigned int id = items[(frame * 500 + k) % items.size()];
+				if (id == 0) continue;
+				boxes.x[id] += 3.0f * sinf(t * 3 + k);
+				boxes.z[id] += 3.0f * cosf(t * 2 + k);
+				tree.Move(id, boxes.Get(id));
+			}
+		}
+		Frustum frustum = CameraAt(t);
+
+		timer = TestTimer();
+		frustum.Cull(&boxes.x[0], &boxes.y[0], &boxes.z[0], &boxes.extentX[0], &boxes.extentY[0], &boxes.extentZ[0], count, &flat[0]);
+		flatMs += timer.Milliseconds();
+
+		std::fill(culled.begin(), culled.end(), 7);
+		timer = TestTimer();
+		size_t set = tree.Cull(frustum, &culled[0]);
+		treeMs += timer.Milliseconds();
+
+		size_t counted = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (culled[i] > 1) wrong++;
+			counted += culled[i] == 1;
+			// left out of the tree, it's never marked
+			if (!inItems[i])
+			{
+				if (culled[i] != 0) wrong++;
+				continue;
+			}
+			if ((culled[i] == 1) == (flat[i] == 1)) continue;
+			if (fabsf(Margin(frustum, boxes, i)) < 1e-3f) unsure++;
+			else wrong++;
+		}
+		if (counted != set) wrong++;
+		// the ground is always partly in view
+		if (culled[0] != 1) wrong++;
+
+		kept += set;
+		tested += tree.GetCullStats().itemsTested;
+		nodesInside += tree.GetCullStats().nodesInside;
+	}
+	printf("%zu boxes, %.0f kept a frame, %d wrong, %d on a plane\n", count, kept / (double)frames, wrong, unsure);
+	printf("tested %.0f a frame in the tree, %.0f nodes taken whole: %.3f ms tree, %.3f ms testing every box\n",
+		tested / (double)frames, nodesInside / (double)frames, treeMs / frames, flatMs / frames);
+	CHECK(wrong == 0);
+	CHECK(kept > 0);
+	// the point of it, most of the forest is thrown away a node at a time
+	CHECK(tested < count * frames / 4);
+
+	// the same through the TransformSystem, for the camera and for the flashlight
+	TransformSystem system;
+	std::vector<TransformHandle> handles;
+	Bounds treeBounds = Bounds::FromMinMax(XMFLOAT3(-1, 0, -1), XMFLOAT3(1, 8, 1));
+	for (int i = 0; i < 20000; i++)
+	{
+		TransformHandle handle = system.Create();
+		system.SetLocalBounds(handle, treeBounds);
+		system.SetPosition(handle, XMFLOAT3(spread(random), 0, spread(random)));
+		float size = scale(random);
+		system.SetScale(handle, XMFLOAT3(size, size, size));
+		system.SetRotation(handle, XMFLOAT4(0, sinf(size), 0, cosf(size)));
+		handles.push_back(handle);
+	}
+	system.Update(1);
+
+	wrong = 0;
+	unsure = 0;
+	Boxes world;
+	world.Resize(handles.size());
+	std::vector<unsigned char> flatShadow(handles.size());
+	for (int frame = 0; frame < 60; frame++)
+	{
+		float t = frame / 60.0f * 2 * Pi;
+		// some move each frame, the tree is only refitted
+		for (int k = 0; k < 200; k++)
+		{
+			TransformHandle handle = handles[(frame * 200 + k) % handles.size()];
+			XMFLOAT3 position = system.GetPosition(handle);
+			system.SetPosition(handle, XMFLOAT3(position.x + 0.5f * sinf(t * 3 + k), 0, position.z + 0.5f * cosf(t * 2 + k)));
+		}
+		system.Update(1);
+		for (size_t i = 0; i < handles.size(); i++) world.Set(i, system.GetWorldBounds(handles[i]));
+
+		Frustum camera = CameraAt(t);
+		Frustum flashlight = CameraAt(t, 0.3f);
+		system.Cull(camera);
+		system.Cull(flashlight, CULL_VIEW::SHADOW);
+		camera.Cull(&world.x[0], &world.y[0], &world.z[0], &world.extentX[0], &world.extentY[0], &world.extentZ[0], handles.size(), &flat[0]);
+		flashlight.Cull(&world.x[0], &world.y[0], &world.z[0], &world.extentX[0], &world.extentY[0], &world.extentZ[0], handles.size(), &flatShadow[0]);
+
+		size_t counted = 0;
+		for (size_t i = 0; i < handles.size(); i++)
+		{
+			bool seen = system.IsVisible(handles[i]);
+			bool lit = system.IsVisible(handles[i], CULL_VIEW::SHADOW);
+			counted += seen;
+			if (seen != (flat[i] == 1))
+			{
+				if (fabsf(Margin(camera, world, i)) < 1e-3f) unsure++;
+				else wrong++;
+			}
+			if (lit != (flatShadow[i] == 1))
+			{
+				if (fabsf(Margin(flashlight, world, i)) < 1e-3f) unsure++;
+				else wrong++;
+			}
+		}
+		if (counted != system.GetVisibleCount()) wrong++;
+	}
+	printf("through the TransformSystem: %d wrong, %d on a plane\n", wrong, unsure);
+	CHECK(wrong == 0);
+
+	return TestResult();
+}
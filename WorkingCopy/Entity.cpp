@@ -1,100 +1,80 @@
 #include "Entity.h"
+#include "MeshSimplifier.h"
 using namespace DirectX;
 
 Entity::Entity()
 {
 
-	// set the initial world matrix
-	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
-
-	// set initial scale and position
-	position = XMFLOAT3(0, 0, 0);
-	scale = XMFLOAT3(1, 1, 1);
-	// set the initial rotation quaternion
-	XMStoreFloat4(&rotation, XMQuaternionIdentity());
+	// identity transform, at the origin
+	transform = TransformSystem::Instance()->Create();
 	mesh = make_shared<Mesh>();
-	isDirty = true;
 }
 
 Entity::Entity(std::shared_ptr<Mesh> m, std::shared_ptr < Material> mat, float rad)
 {
-	// set the initial world matrix
-	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
-
-	// set initial scale and position
-	position = XMFLOAT3(0, 0, 0);
-	scale = XMFLOAT3(1, 1, 1);
-
-	// set the initial rotation quaternion
-	XMStoreFloat4(&rotation, XMQuaternionIdentity());
+	// identity transform, at the origin
+	transform = TransformSystem::Instance()->Create();
 
 	// set the mesh pointer
 	mesh = m;
-
-	isDirty = true;
+	if (mesh) TransformSystem::Instance()->SetLocalBounds(transform, mesh->GetBounds());
 
 	material = mat;
 
-	collider = new Collider(rad);
-
-	doRender = true;
+	collider = ColliderStore::Instance()->CreateCircle(rad);
+	ColliderStore::Instance()->Get(collider)->SetOwner(this);
 }
 
 Entity::Entity(shared_ptr<Mesh> m, shared_ptr<Material> mat, DirectX::XMFLOAT2 s)
 {
-	// set the initial world matrix
-	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
-
-	// set initial scale and position
-	position = XMFLOAT3(0, 0, 0);
-	scale = XMFLOAT3(1, 1, 1);
-
-	// set the initial rotation quaternion
-	XMStoreFloat4(&rotation, XMQuaternionIdentity());
+	// identity transform, at the origin
+	transform = TransformSystem::Instance()->Create();
 
 	// set the mesh pointer
 	mesh = m;
-
-	isDirty = true;
+	if (mesh) TransformSystem::Instance()->SetLocalBounds(transform, mesh->GetBounds());
 
 	material = mat;
 
-	collider = new Collider(s);
+	collider = ColliderStore::Instance()->CreateRect(s);
+	ColliderStore::Instance()->Get(collider)->SetOwner(this);
 }
 
 Entity::~Entity()
 {
-	delete collider;
+	ColliderStore::Instance()->Destroy(collider);
+	TransformSystem::Instance()->Destroy(transform);
 }
 
 DirectX::XMFLOAT4X4 Entity::GetWorldMatrix()
 {
-	return worldMatrix;
+	return TransformSystem::Instance()->GetWorldMatrix(transform);
 }
 
 void Entity::SetTranslation(DirectX::XMFLOAT3 tran)
 {
-	position = tran;
+	TransformSystem::Instance()->SetPosition(transform, tran);
 
 	SetDirtyMatrix();
 }
 
 void Entity::SetScale(DirectX::XMFLOAT3 sc)
 {
-	scale = sc;
+	TransformSystem::Instance()->SetScale(transform, sc);
 	SetDirtyMatrix();
 }
 
 void Entity::SetRotation(DirectX::XMFLOAT4 rot)
 {
-	rotation = rot;
+	TransformSystem::Instance()->SetRotation(transform, rot);
 	SetDirtyMatrix();
 }
 
 void Entity::RotateAroundAxis(DirectX::XMFLOAT3 axis, float angle)
 {
+	XMFLOAT4 rotation = GetRotation();
 	XMStoreFloat4(&rotation, XMQuaternionMultiply(XMLoadFloat4(&rotation), XMQuaternionRotationAxis(XMLoadFloat3(&axis), angle)));
-	SetDirtyMatrix();
+	SetRotation(rotation);
 }
 
 void Entity::Move(DirectX::XMFLOAT3 amount)
@@ -102,84 +82,98 @@ void Entity::Move(DirectX::XMFLOAT3 amount)
 	// convert position and the amount to vectors
 	// add them
 	// store back into the position float
+	XMFLOAT3 position = GetPosition();
 	XMStoreFloat3(&position, XMVectorAdd(XMLoadFloat3(&position), XMLoadFloat3(&amount)));
 
-	SetDirtyMatrix();
+	SetTranslation(position);
 }
 void Entity::MoveForward(float amount)
 {
+	XMFLOAT3 position = GetPosition();
+	XMFLOAT4 rotation = GetRotation();
 	XMVECTOR dir = XMVector3Rotate(XMVectorSet(0, 0, amount, 0), XMLoadFloat4(&rotation));
 
 	XMStoreFloat3(&position, XMVectorAdd(XMLoadFloat3(&position), dir));
 
-	SetDirtyMatrix();
+	SetTranslation(position);
+}
+
+void Entity::SetTag(const char* tag)
+{
+	this->tag = tag;
+	tagId = Tags::Intern(tag);
+
+	Collider* col = ColliderStore::Instance()->Get(collider);
+	if (col != nullptr) col->SetTag(tagId);
 }
 
 void Entity::SetDirtyMatrix()
 {
-	isDirty = true;
-	collider->SetCenter(XMFLOAT2(position.x, position.z));
+	// the TransformSystem already knows, the collider just follows along
+	XMFLOAT3 position = GetPosition();
+	Collider* col = ColliderStore::Instance()->Get(collider);
+	if (col != nullptr) col->SetCenter(XMFLOAT2(position.x, position.z));
+}
+
+void Entity::RefreshBounds()
+{
+	if (mesh) TransformSystem::Instance()->SetLocalBounds(transform, mesh->GetBounds());
 }
 
 void Entity::ComputeWorldMatrix()
 {
-	if (isDirty == false) return;
+	TransformSystem::Instance()->Update(transform);
+}
 
-	XMMATRIX translation = XMMatrixTranslation(position.x, position.y, position.z);
-	XMMATRIX scaling = XMMatrixScaling(scale.x, scale.y, scale.z);
-	XMMATRIX rot = XMMatrixRotationQuaternion(XMLoadFloat4(&rotation));
-	XMMATRIX world = XMLoadFloat4x4(&worldMatrix);
+ID3D11Buffer* Entity::GetVertexBuffer()
+{
+	return mesh->GetVertexBuffer();
+}
 
-	world = scaling * rot * translation;
+ID3D11Buffer* Entity::GetIndexBuffer()
+{
+	return mesh->GetIndexBuffer();
+}
 
-	XMStoreFloat4x4(&worldMatrix, XMMatrixTranspose(world));
+void Entity::SelectLod(std::shared_ptr<Camera> cam, float screenHeight, float pixelError)
+{
+	lod = 0;
+	int lodCount = mesh->GetLodCount();
+	if (lodCount < 2) return;
 
-	isDirty = false;
+	XMFLOAT3 camPosition = cam->GetPosition();
+	XMFLOAT3 position = GetPosition();
+	XMFLOAT3 scale = GetScale();
+	float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&position) - XMLoadFloat3(&camPosition)));
+	float maxScale = fmaxf(scale.x, fmaxf(scale.y, scale.z));
 
-	collider->SetCenter(XMFLOAT2(position.x, position.z));
+	// _22 of the projection is cot(fov / 2)
+	lod = MeshSimplifier::SelectLod(&mesh->GetLod(0), lodCount, maxScale, distance, cam->GetProjectionMatrix()._22, screenHeight, pixelError);
 }
 
-void Entity::CheckForDraw(std::shared_ptr<Camera> cam, float renderDistance)
+int Entity::GetIndexCount()
 {
-	XMVECTOR camPos = XMLoadFloat3(&cam->GetPosition());
-	XMVECTOR camForward = XMLoadFloat3(&cam->GetDirection());
-	XMVECTOR entPos = XMLoadFloat3(&position);
-	// are we in front or behind of the player?
-	XMVECTOR dotResult = XMVector3Dot(camForward, entPos - camPos);
-	XMFLOAT3 fResult;
-	XMStoreFloat3(&fResult, dotResult);
-	// don't draw if behind
-	if (fResult.x < 0)
-	{
-		doRender = false;
-		return;
-	}
-	// in front, but is it too far away?
-	XMVECTOR lengthResult = XMVector3LengthSq(entPos - camPos);
-	XMStoreFloat3(&fResult, lengthResult);
-	// if greater than set value, don't draw
-	if (fResult.x > renderDistance)
-	{
-		doRender = false;
-		return;
-	}
+	return mesh->GetLodCount() > 0 ? (int)mesh->GetLod(lod).indexCount : 0;
+}
 
-	doRender = true;
+int Entity::GetIndexStart()
+{
+	return mesh->GetLodCount() > 0 ? (int)mesh->GetLod(lod).indexStart : 0;
 }
 
-ID3D11Buffer* Entity::GetVertexBuffer()
+DXGI_FORMAT Entity::GetIndexFormat()
 {
-	return mesh->GetVertexBuffer();
+	return mesh->GetIndexFormat();
 }
 
-ID3D11Buffer* Entity::GetIndexBuffer()
+unsigned int Entity::GetVertexStride()
 {
-	return mesh->GetIndexBuffer();
+	return mesh->GetVertexStride();
 }
 
-int Entity::GetIndexCount()
+bool Entity::HasPackedVertices()
 {
-	return mesh->GetIndexCount();
+	return mesh->GetVertexFormat() == VERTEX_FORMAT::PACKED;
 }
 
 shared_ptr<Material> Entity::GetMaterial()
@@ -189,14 +183,24 @@ shared_ptr<Material> Entity::GetMaterial()
 
 Collider* Entity::GetCollider()
 {
-    collider->SetCenter(XMFLOAT2(position.x, position.z));
-    
-	return collider;
+	Collider* col = ColliderStore::Instance()->Get(collider);
+	if (col != nullptr) {
+		XMFLOAT3 position = GetPosition();
+		col->SetCenter(XMFLOAT2(position.x, position.z));
+	}
+	return col;
 }
 
 void Entity::SendWorldMatrixToGPU(shared_ptr<SimpleVertexShader> vs, const char* name)
 {
-	vs->SetMatrix4x4(name, worldMatrix);
+	vs->SetMatrix4x4(name, GetWorldMatrix());
+}
+
+void Entity::SendQuantizationToGPU(shared_ptr<SimpleVertexShader> vs)
+{
+	const VertexQuantization& quantization = mesh->GetQuantization();
+	vs->SetFloat3("positionOffset", quantization.offset);
+	vs->SetFloat3("positionScale", quantization.scale);
 }
 
 //void PrepareMaterial(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 proj, SpotLight const& light, PointLight const& light2);
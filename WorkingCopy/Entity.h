@@ -6,7 +6,9 @@
 #include "Mesh.h"
 #include "Material.h"
 #include "Lights.h"
-#include "Collider.h"
+#include "ColliderStore.h"
+#include "Tags.h"
+#include "TransformSystem.h"
 #include <memory>
 
 using namespace std;
@@ -18,6 +20,7 @@ public:
 	Entity(shared_ptr<Mesh> m, shared_ptr < Material> mat, DirectX::XMFLOAT2 s);
 	~Entity();
 	
+	// transposed, from the TransformSystem's last Update
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	void SetTranslation(DirectX::XMFLOAT3 tran);
     void SetTranslation(float x, float y, float z) {
@@ -31,34 +34,63 @@ public:
 	void Move(DirectX::XMFLOAT3 amount);
 	void MoveForward(float amount);
 	void SetDirtyMatrix();
+	// takes the mesh's bounds again, for a mesh that was still loading when the entity was made
+	void RefreshBounds();
+	// rebuilds just this entity's matrix, TransformSystem::Update does all of them at once
 	void ComputeWorldMatrix();
-	inline void SetTag(const char* tag) { this->tag = tag; };
-	void CheckForDraw(std::shared_ptr<Camera> cam, float renderDistance);
+	// also interns it, the collider gets the id
+	void SetTag(const char* tag);
+	// picks the coarsest LOD whose error stays under pixelError pixels on screen
+	void SelectLod(std::shared_ptr<Camera> cam, float screenHeight, float pixelError = 1.0f);
 
 	ID3D11Buffer* GetVertexBuffer();
 	ID3D11Buffer* GetIndexBuffer();
+	// index range of the selected LOD
 	int GetIndexCount();
+	int GetIndexStart();
+	DXGI_FORMAT GetIndexFormat();
+	unsigned int GetVertexStride();
+	// packed meshes need a vertex shader that unpacks them
+	bool HasPackedVertices();
 	shared_ptr<Material> GetMaterial();
+	// nullptr for entities made without one
 	Collider* GetCollider();
+	inline ColliderHandle GetColliderHandle() { return collider; }
 
 	void SendWorldMatrixToGPU(shared_ptr<SimpleVertexShader> vs, const char* name);
+	// positionOffset and positionScale, for shaders that unpack PackedVertex
+	void SendQuantizationToGPU(shared_ptr<SimpleVertexShader> vs);
 	inline const char* getTag() { return tag; }
-	inline bool GetDraw() { return doRender; }
-	inline DirectX::XMFLOAT3 GetPosition() { return position; }
+	inline unsigned int GetTagId() { return tagId; }
+	// whether it was in that view's frustum at the last TransformSystem::Cull for it
+	inline bool GetDraw(CULL_VIEW view = CULL_VIEW::CAMERA) { return TransformSystem::Instance()->IsVisible(transform, view); }
+	// the mesh's bounds moved into world space
+	inline Bounds GetWorldBounds() { return TransformSystem::Instance()->GetWorldBounds(transform); }
+	inline int GetLod() { return lod; }
+	inline DirectX::XMFLOAT3 GetPosition() { return TransformSystem::Instance()->GetPosition(transform); }
+	inline DirectX::XMFLOAT3 GetScale() { return TransformSystem::Instance()->GetScale(transform); }
+	inline DirectX::XMFLOAT4 GetRotation() { return TransformSystem::Instance()->GetRotation(transform); }
+	inline TransformHandle GetTransformHandle() { return transform; }
+	// big solid things that can hide others from the OcclusionCuller
+	inline void SetOccluder(bool occluder) { this->occluder = occluder; }
+	inline bool IsOccluder() { return occluder; }
+	// a coarse copy of the mesh to rasterize, nullptr unless it's an occluder
+	inline const OccluderMesh* GetOccluderMesh() { return occluder ? &mesh->GetOccluder() : nullptr; }
 
 
 protected:
-	DirectX::XMFLOAT4X4 worldMatrix;
-	DirectX::XMFLOAT3 position;
-	DirectX::XMFLOAT3 scale;
-	DirectX::XMFLOAT4 rotation;
+	// position, rotation, scale and world matrix live in the TransformSystem
+	TransformHandle transform;
 	shared_ptr<Mesh> mesh;
-	bool isDirty;
 	shared_ptr<Material> material;
-	Collider* collider;
+	// the collider lives in the ColliderStore
+	ColliderHandle collider;
 	// tag that describes entity
-	const char* tag;
-	bool doRender;
+	const char* tag = nullptr;
+	unsigned int tagId = Tags::None;
+	// LOD of the mesh to draw, picked every frame by SelectLod
+	int lod = 0;
+	bool occluder = false;
 	
 };
 
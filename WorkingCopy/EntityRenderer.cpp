@@ -0,0 +1,77 @@
+#include "EntityRenderer.h"
+
+EntityRenderer::EntityRenderer(ID3D11DeviceContext* context, shared_ptr<SimpleVertexShader> shadowVS, shared_ptr<SimpleVertexShader> packedShadowVS)
+	: context(context), shadowVS(shadowVS), packedShadowVS(packedShadowVS)
+{
+}
+
+void EntityRenderer::SetFrame(const vector<shared_ptr<Entity>>* entities, shared_ptr<Camera> camera, DirectX::XMFLOAT4X4 shadowView, DirectX::XMFLOAT4X4 shadowProjection,
+	ComPtr<ID3D11ShaderResourceView> shadowMap, ComPtr<ID3D11SamplerState> shadowSampler)
+{
+	this->entities = entities;
+	this->camera = camera;
+	this->shadowView = shadowView;
+	this->shadowProjection = shadowProjection;
+	this->shadowMap = shadowMap;
+	this->shadowSampler = shadowSampler;
+	vs = nullptr;
+}
+
+shared_ptr<SimpleVertexShader> EntityRenderer::GetVertexShader(RENDER_PASS pass, Entity& entity)
+{
+	// packed meshes are unpacked by their own shader
+	if (pass == RENDER_PASS::SHADOW) return entity.HasPackedVertices() ? packedShadowVS : shadowVS;
+	return entity.GetMaterial()->GetVertexShader();
+}
+
+void EntityRenderer::BindShader(RENDER_PASS pass, unsigned int object)
+{
+	Entity& entity = *(*entities)[object];
+	vs = GetVertexShader(pass, entity);
+
+	// the shadow pass's view and projection were set once by RenderShadows, and it has no pixel shader
+	if (pass == RENDER_PASS::SHADOW)
+	{
+		vs->SetShader();
+		return;
+	}
+
+	camera->SendViewMatrixToGPU(vs, "view");
+	camera->SendProjectionMatrixToGPU(vs, "projection");
+	entity.GetMaterial()->PrepareShaders(shadowView, shadowProjection);
+}
+
+void EntityRenderer::BindMaterial(RENDER_PASS pass, unsigned int object)
+{
+	// nothing is shaded into the shadow map
+	if (pass == RENDER_PASS::SHADOW) return;
+
+	(*entities)[object]->GetMaterial()->PreparePixelShader(shadowMap, shadowSampler);
+}
+
+void EntityRenderer::BindMesh(RENDER_PASS pass, unsigned int object)
+{
+	Entity& entity = *(*entities)[object];
+	ID3D11Buffer* vb = entity.GetVertexBuffer();
+	UINT stride = entity.GetVertexStride();
+	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+	context->IASetIndexBuffer(entity.GetIndexBuffer(), entity.GetIndexFormat(), 0);
+
+	if (entity.HasPackedVertices()) entity.SendQuantizationToGPU(vs);
+}
+
+void EntityRenderer::Draw(RENDER_PASS pass, unsigned int object)
+{
+	Entity& entity = *(*entities)[object];
+
+	// the world matrix is the only thing that changes every draw, but it shares
+	// a buffer with everything else the vertex shader takes
+	entity.SendWorldMatrixToGPU(vs, "world");
+	vs->CopyAllBufferData();
+
+	context->DrawIndexed(
+		entity.GetIndexCount(),     // The number of indices in the entity's LOD
+		entity.GetIndexStart(),     // Offset to the first index of that LOD
+		0);    // Offset to add to each index when looking up vertices
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "DXCore.h"
+#include "SimpleShader.h"
+#include <DirectXMath.h>
+#include "RenderQueue.h"
+#include "Entity.h"
+#include "Camera.h"
+#include <memory>
+#include <vector>
+
+// --------------------------------------------------------
+// Draws entities for a RenderQueue with D3D11.  Objects in
+// the queue are indices into the entity list SetFrame gets.
+//
+// The shadow pass uses the shadow map vertex shaders and no
+// pixel shader, the main pass uses each entity's material
+// --------------------------------------------------------
+class EntityRenderer : public RenderBackend
+{
+public:
+	EntityRenderer(ID3D11DeviceContext* context, shared_ptr<SimpleVertexShader> shadowVS, shared_ptr<SimpleVertexShader> packedShadowVS);
+
+	// what the next Submit draws, the list has to stay the same until it's done
+	void SetFrame(const vector<shared_ptr<Entity>>* entities, shared_ptr<Camera> camera, DirectX::XMFLOAT4X4 shadowView, DirectX::XMFLOAT4X4 shadowProjection,
+		ComPtr<ID3D11ShaderResourceView> shadowMap, ComPtr<ID3D11SamplerState> shadowSampler);
+
+	// the vertex shader an entity is drawn with in a pass, for sorting by it
+	shared_ptr<SimpleVertexShader> GetVertexShader(RENDER_PASS pass, Entity& entity);
+
+	void BindShader(RENDER_PASS pass, unsigned int object) override;
+	void BindMaterial(RENDER_PASS pass, unsigned int object) override;
+	void BindMesh(RENDER_PASS pass, unsigned int object) override;
+	void Draw(RENDER_PASS pass, unsigned int object) override;
+
+private:
+	ID3D11DeviceContext* context;
+	shared_ptr<SimpleVertexShader> shadowVS;
+	shared_ptr<SimpleVertexShader> packedShadowVS;
+
+	const vector<shared_ptr<Entity>>* entities = nullptr;
+	shared_ptr<Camera> camera;
+	DirectX::XMFLOAT4X4 shadowView;
+	DirectX::XMFLOAT4X4 shadowProjection;
+	ComPtr<ID3D11ShaderResourceView> shadowMap;
+	ComPtr<ID3D11SamplerState> shadowSampler;
+
+	// from the last BindShader, meshes and draws set their constants on it
+	shared_ptr<SimpleVertexShader> vs;
+};
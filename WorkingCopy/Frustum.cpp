@@ -0,0 +1,155 @@
+#include "Frustum.h"
+#include <cmath>
+#if defined(_XM_AVX_INTRINSICS_) || defined(_XM_SSE_INTRINSICS_)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+Frustum::Frustum()
+{
+	// keeps everything until it's given a camera
+	for (int i = 0; i < PLANE_COUNT; i++) {
+		planes[i] = XMFLOAT4(0, 0, 0, 1);
+	}
+}
+
+Frustum::Frustum(FXMMATRIX viewProjection)
+{
+	// clip = p * viewProjection, and a point is inside when -w <= x <= w, -w <= y <= w
+	// and 0 <= z <= w, so each plane is a sum or difference of the matrix's columns
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, viewProjection);
+	XMFLOAT4 column[4];
+	for (int c = 0; c < 4; c++) {
+		column[c] = XMFLOAT4(m.m[0][c], m.m[1][c], m.m[2][c], m.m[3][c]);
+	}
+
+	auto combine = [&column](int c, float sign) {
+		return XMFLOAT4(column[3].x + column[c].x * sign, column[3].y + column[c].y * sign,
+			column[3].z + column[c].z * sign, column[3].w + column[c].w * sign);
+	};
+	planes[PLANE_LEFT] = combine(0, 1.0f);
+	planes[PLANE_RIGHT] = combine(0, -1.0f);
+	planes[PLANE_BOTTOM] = combine(1, 1.0f);
+	planes[PLANE_TOP] = combine(1, -1.0f);
+	planes[PLANE_NEAR] = column[2];
+	planes[PLANE_FAR] = combine(2, -1.0f);
+
+	// unit normals, so w is a real distance
+	for (int i = 0; i < PLANE_COUNT; i++) {
+		XMFLOAT4& p = planes[i];
+		float length = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+		if (length > 0.0f) {
+			p.x /= length;
+			p.y /= length;
+			p.z /= length;
+			p.w /= length;
+		}
+	}
+}
+
+bool Frustum::TestSphere(XMFLOAT3 center, float radius) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++) {
+		const XMFLOAT4& p = planes[i];
+		if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius) return false;
+	}
+	return true;
+}
+
+bool Frustum::TestBox(XMFLOAT3 center, XMFLOAT3 extents) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++) {
+		// how far the box reaches towards the plane's normal
+		const XMFLOAT4& p = planes[i];
+		float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+		float reach = fabsf(p.x) * extents.x + fabsf(p.y) * extents.y + fabsf(p.z) * extents.z;
+		if (distance + reach < 0.0f) return false;
+	}
+	return true;
+}
+
+bool Frustum::TestBox(XMFLOAT3 center, XMFLOAT3 extents, unsigned int& planeMask) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++) {
+		if (!(planeMask & (1u << i))) continue;
+
+		const XMFLOAT4& p = planes[i];
+		float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+		float reach = fabsf(p.x) * extents.x + fabsf(p.y) * extents.y + fabsf(p.z) * extents.z;
+		if (distance + reach < 0.0f) return false;
+		// even the farthest corner is on the inside
+		if (distance - reach >= 0.0f) planeMask &= ~(1u << i);
+	}
+	return true;
+}
+
+void Frustum::Cull(const float* x, const float* y, const float* z, const float* extentX, const float* extentY, const float* extentZ,
+	size_t count, unsigned char* visible) const
+{
+	size_t i = 0;
+
+#if defined(_XM_AVX_INTRINSICS_)
+	const __m256 signBits = _mm256_set1_ps(-0.0f);
+	for (; i + 8 <= count; i += 8) {
+		__m256 cx = _mm256_loadu_ps(&x[i]);
+		__m256 cy = _mm256_loadu_ps(&y[i]);
+		__m256 cz = _mm256_loadu_ps(&z[i]);
+		__m256 ex = _mm256_loadu_ps(&extentX[i]);
+		__m256 ey = _mm256_loadu_ps(&extentY[i]);
+		__m256 ez = _mm256_loadu_ps(&extentZ[i]);
+
+		// all bits set in a lane once any plane has the whole box behind it
+		__m256 outside = _mm256_setzero_ps();
+		for (int p = 0; p < PLANE_COUNT; p++) {
+			__m256 nx = _mm256_set1_ps(planes[p].x);
+			__m256 ny = _mm256_set1_ps(planes[p].y);
+			__m256 nz = _mm256_set1_ps(planes[p].z);
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, cx), _mm256_mul_ps(ny, cy)),
+				_mm256_add_ps(_mm256_mul_ps(nz, cz), _mm256_set1_ps(planes[p].w)));
+			__m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(signBits, nx), ex), _mm256_mul_ps(_mm256_andnot_ps(signBits, ny), ey)),
+				_mm256_mul_ps(_mm256_andnot_ps(signBits, nz), ez));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+
+		int mask = _mm256_movemask_ps(outside);
+		for (int lane = 0; lane < 8; lane++) {
+			visible[i + lane] = ((mask >> lane) & 1) ^ 1;
+		}
+	}
+#elif defined(_XM_SSE_INTRINSICS_)
+	const __m128 signBits = _mm_set1_ps(-0.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128 cx = _mm_loadu_ps(&x[i]);
+		__m128 cy = _mm_loadu_ps(&y[i]);
+		__m128 cz = _mm_loadu_ps(&z[i]);
+		__m128 ex = _mm_loadu_ps(&extentX[i]);
+		__m128 ey = _mm_loadu_ps(&extentY[i]);
+		__m128 ez = _mm_loadu_ps(&extentZ[i]);
+
+		// all bits set in a lane once any plane has the whole box behind it
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < PLANE_COUNT; p++) {
+			__m128 nx = _mm_set1_ps(planes[p].x);
+			__m128 ny = _mm_set1_ps(planes[p].y);
+			__m128 nz = _mm_set1_ps(planes[p].z);
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)),
+				_mm_add_ps(_mm_mul_ps(nz, cz), _mm_set1_ps(planes[p].w)));
+			__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signBits, nx), ex), _mm_mul_ps(_mm_andnot_ps(signBits, ny), ey)),
+				_mm_mul_ps(_mm_andnot_ps(signBits, nz), ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; lane++) {
+			visible[i + lane] = ((mask >> lane) & 1) ^ 1;
+		}
+	}
+#endif
+
+	// no SIMD, or whatever the batches didn't cover
+	for (; i < count; i++) {
+		visible[i] = TestBox(XMFLOAT3(x[i], y[i], z[i]), XMFLOAT3(extentX[i], extentY[i], extentZ[i])) ? 1 : 0;
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "Bounds.h"
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// The six planes of a camera's view volume, pointing in,
+// pulled straight out of its view * projection matrix.
+//
+// Boxes are tested against every plane at their closest
+// corner, so anything that might be visible is kept, and
+// at their farthest one to tell when they're entirely
+// inside, which a hierarchy can use to stop early.  Cull
+// tests a whole array of boxes at once, 8 or 4 at a time
+// with AVX or SSE
+// --------------------------------------------------------
+class Frustum
+{
+public:
+	enum sides { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+
+	Frustum();
+	// viewProjection is row vector and not transposed, like XMMatrixLookToLH * XMMatrixPerspectiveFovLH
+	Frustum(DirectX::FXMMATRIX viewProjection);
+
+	bool TestSphere(DirectX::XMFLOAT3 center, float radius) const;
+	bool TestBox(DirectX::XMFLOAT3 center, DirectX::XMFLOAT3 extents) const;
+	inline bool Test(const Bounds& bounds) const { return TestBox(bounds.center, bounds.extents); }
+	// for walking a hierarchy: planeMask holds a bit for each plane still worth testing, and the
+	// planes the box is entirely inside of are cleared from it, so a box inside one of them tells
+	// its children they can skip it. once it's 0 the box and everything in it is inside
+	bool TestBox(DirectX::XMFLOAT3 center, DirectX::XMFLOAT3 extents, unsigned int& planeMask) const;
+	static const unsigned int AllPlanes = (1u << PLANE_COUNT) - 1;
+
+	// sets visible[i] to 1 for every box at least partly inside and 0 for the rest.
+	// boxes are given as parallel arrays of centers and extents
+	void Cull(const float* x, const float* y, const float* z, const float* extentX, const float* extentY, const float* extentZ,
+		size_t count, unsigned char* visible) const;
+
+	// xyz is the normal and w the distance, inside is where dot(normal, p) + w >= 0
+	inline const DirectX::XMFLOAT4& GetPlane(int plane) const { return planes[plane]; }
+
+private:
+	DirectX::XMFLOAT4 planes[PLANE_COUNT];
+};
@@ -0,0 +1,137 @@
+#include "Frustum.h"
+#include "TransformSystem.h"
+#include "ObjParser.h"
+#include "MeshBinary.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Checks Frustum::Cull, in whichever kernel this build has,
+// keeps exactly the boxes that aren't entirely behind one
+// of the planes, going by their eight corners.  Then puts a
+// tree just off the side of the screen with only its
+// branches in view: culled with the empty placeholder's
+// bounds an entity gets while its mesh loads, kept once it
+// has the mesh's.  Built once with SIMD and once without,
+// see CMakeLists.txt
+// --------------------------------------------------------
+
+namespace
+{
+	// how far inside the plane the box's furthest corner is, below 0 it's entirely outside
+	float FurthestCorner(const XMFLOAT4& plane, XMFLOAT3 center, XMFLOAT3 extents)
+	{
+		float furthest = -1e30f;
+		for (int corner = 0; corner < 8; corner++)
+		{
+			float x = center.x + (corner & 1 ? extents.x : -extents.x);
+			float y = center.y + (corner & 2 ? extents.y : -extents.y);
+			float z = center.z + (corner & 4 ? extents.z : -extents.z);
+			furthest = fmaxf(furthest, plane.x * x + plane.y * y + plane.z * z + plane.w);
+		}
+		return furthest;
+	}
+
+	// what Camera builds, at the origin and turned yaw from looking down +z
+	XMMATRIX ViewProjection(float yaw)
+	{
+		XMVECTOR direction = XMVectorSet(sinf(yaw), 0, cosf(yaw), 0);
+		XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0, 0, 0, 0), direction, XMVectorSet(0, 1, 0, 0));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(0.25f * 3.1415926535f, 1280.0f / 720.0f, 0.1f, 100.0f);
+		return view * projection;
+	}
+}
+
+int main()
+{
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+	// boxes all over and around a few views, counts that leave a tail after the batches
+	int wrong = 0;
+	int unsure = 0;
+	size_t kept = 0;
+	size_t total = 0;
+	for (float yaw : { 0.0f, 1.0f, 2.5f, -2.0f })
+	{
+		Frustum frustum(ViewProjection(yaw));
+		const size_t count = 10003;
+		std::vector<float> x(count), y(count), z(count), ex(count), ey(count), ez(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			x[i] = uniform(random) * 120;
+			y[i] = uniform(random) * 20;
+			z[i] = uniform(random) * 120;
+			ex[i] = 0.1f + fabsf(uniform(random)) * 6;
+			ey[i] = 0.1f + fabsf(uniform(random)) * 8;
+			ez[i] = 0.1f + fabsf(uniform(random)) * 6;
+		}
+		std::vector<unsigned char> visible(count, 7);
+		frustum.Cull(&x[0], &y[0], &z[0], &ex[0], &ey[0], &ez[0], count, &visible[0]);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			XMFLOAT3 center(x[i], y[i], z[i]);
+			XMFLOAT3 extents(ex[i], ey[i], ez[i]);
+			float worst = 1e30f;
+			for (int p = 0; p < Frustum::PLANE_COUNT; p++) worst = fminf(worst, FurthestCorner(frustum.GetPlane(p), center, extents));
+
+			// right on a plane either answer is fine
+			if (fabsf(worst) < 1e-3f) unsure++;
+			else if ((visible[i] == 1) != (worst >= 0.0f)) wrong++;
+			if (visible[i] > 1) wrong++;
+			if ((visible[i] == 1) != frustum.TestBox(center, extents)) wrong++;
+			kept += visible[i] == 1;
+		}
+		total += count;
+	}
+	printf("%zu of %zu boxes kept, %d wrong, %d on a plane\n", kept, total, wrong, unsure);
+	CHECK(wrong == 0);
+	CHECK(kept > 0 && kept < total);
+
+	// the tree's real bounds, with its pivot at the bottom of the trunk
+	MeshData data;
+	CHECK(ObjParser::ParseFile("Models/DeadTree.obj", data));
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	ObjParser::WeldVertices(data, verts, indices);
+	XMFLOAT3 boundsMin, boundsMax;
+	MeshBinary::GetBounds(verts, &boundsMin, &boundsMax);
+	Bounds treeBounds = Bounds::FromMinMax(boundsMin, boundsMax);
+
+	// 10 units ahead the right edge of the screen is this far out, the trunk goes just past it
+	Frustum frustum(ViewProjection(0.0f));
+	float edge = 10.0f * tanf(0.125f * 3.1415926535f) * 1280.0f / 720.0f;
+	XMFLOAT3 position(edge - boundsMin.x - 0.5f, -3.0f, 10.0f);
+	CHECK(!frustum.TestBox(XMFLOAT3(position.x, position.y, position.z), XMFLOAT3(0.25f, 0.25f, 0.25f)));
+
+	// what an entity made before FinishLoading has, then what RefreshBounds gives it
+	TransformSystem system;
+	TransformHandle tree = system.Create();
+	system.SetPosition(tree, position);
+	system.SetLocalBounds(tree, Bounds());
+	system.Update();
+	system.Cull(frustum);
+	CHECK(!system.IsVisible(tree));
+	CHECK(system.GetWorldBounds(tree).radius == 0.0f);
+
+	system.SetLocalBounds(tree, treeBounds);
+	system.Update();
+	system.Cull(frustum);
+	CHECK(system.IsVisible(tree));
+	Bounds world = system.GetWorldBounds(tree);
+	printf("tree at x %.2f with the screen's edge at %.2f: world box from %.2f to %.2f\n",
+		position.x, edge, world.center.x - world.extents.x, world.center.x + world.extents.x);
+	CHECK(world.radius > 5.0f);
+
+	// turned away, it goes
+	system.Cull(Frustum(ViewProjection(3.1415926535f)));
+	CHECK(!system.IsVisible(tree));
+
+	return TestResult();
+}
@@ -3,6 +3,8 @@
 #include "DXCore.h"
 #include "WICTextureLoader.h"
 #include <sstream>
+#include <thread>
+#include <algorithm>
 
 // For the DirectX Math library
 using namespace DirectX;
@@ -52,9 +54,22 @@ void Game::Init()
 	gameOver = false;
 	youWin = false;
 	LoadShaders();
+	entityRenderer = make_unique<EntityRenderer>(context, shadowVS, packedShadowVS);
 	CreateEmitters();
 	SetupShadows();
 	CreateBasicGeometry();
+
+	// textures and meshes were queued above, wait for them before the first frame
+	gameFactory->FinishLoading();
+
+	// every tree shares one mesh, report how much loading that saved
+	const AssetCacheStats& meshStats = gameFactory->GetMeshCacheStats();
+	printf("Mesh cache: %u loaded, %u reused, %zu KB on the GPU, %zu KB saved\n",
+		meshStats.misses - meshStats.failures, meshStats.hits, meshStats.bytes / 1024, meshStats.bytesSaved / 1024);
+	const AssetCacheStats& textureStats = gameFactory->GetTextureCacheStats();
+	printf("Texture cache: %u loaded, %u reused, %zu KB on the GPU, %zu KB saved\n",
+		textureStats.misses - textureStats.failures, textureStats.hits, textureStats.bytes / 1024, textureStats.bytesSaved / 1024);
+
 	lightCount = 0;
 	letterCount = 0;
 	GenerateLights();
@@ -129,6 +144,12 @@ void Game::LoadShaders()
     shadowVS = make_shared <SimpleVertexShader>(device, context);
     shadowVS->LoadShaderFile(L"ShadowVS.cso");
 
+    // packed verts need their formats spelled out, reflection would assume 32 bit floats
+    packedVS = make_shared<SimpleVertexShader>(device, context, PackedVertexLayout, PACKED_VERTEX_LAYOUT_COUNT);
+    packedVS->LoadShaderFile(L"VertexShaderPacked.cso");
+    packedShadowVS = make_shared<SimpleVertexShader>(device, context, PackedVertexLayout, PACKED_VERTEX_LAYOUT_COUNT);
+    packedShadowVS->LoadShaderFile(L"ShadowVSPacked.cso");
+
     
 
     defaultMaterial = gameFactory->CreateMaterial(vertexShader, pixelShader, XMFLOAT3(0.955008f, 0.637427f, 0.538163f));
@@ -139,7 +160,8 @@ void Game::LoadShaders()
     tent = gameFactory->CreateMaterial(vertexShader, pixelShader, XMFLOAT3(0.02f, 0.02f, 0.02f));
     tower = gameFactory->CreateMaterial(vertexShader, pixelShader, XMFLOAT3(0.05f, 0.05f, 0.05f));
     truck = gameFactory->CreateMaterial(vertexShader, pixelShader, XMFLOAT3(0.04f, 0.04f, 0.04f));
-    treeMat = gameFactory->CreateMaterial(vertexShader, pixelShader, XMFLOAT3(0.01f, 0.01f, 0.01f));
+    // CreateTree() gives trees packed verts
+    treeMat = gameFactory->CreateMaterial(packedVS, pixelShader, XMFLOAT3(0.01f, 0.01f, 0.01f));
     note = gameFactory->CreateMaterial(vertexShader, pixelShader, XMFLOAT3(0.05f, 0.05f, 0.05f));
     lamp = gameFactory->CreateMaterial(vertexShader, pixelShader, XMFLOAT3(0.05f, 0.05f, 0.05f));
     slendermanMaterial = gameFactory->CreateMaterial(vertexShader, pixelShader, XMFLOAT3(0.05f, 0.05f, 0.05f));
@@ -252,6 +274,7 @@ void Game::CreateBasicGeometry()
     auto e1 = gameFactory->CreateEntity("Models/Container.obj", paint, XMFLOAT2(4.6f, 9.4f));
     e1->SetTranslation(-15.0f, 0.0f, 100.0f);
     e1->SetScale(XMFLOAT3(2.0f, 2.0f, 2.0f));
+    e1->SetOccluder(true);
     collisionManager->addCollider(e1);
     entities.push_back(e1);
 
@@ -259,6 +282,7 @@ void Game::CreateBasicGeometry()
     auto e2 = gameFactory->CreateEntity("Models/Cabin.obj", cabin, XMFLOAT2(5.5f, 7.8f));
     e2->SetScale(XMFLOAT3(0.1f, 0.1f, 0.1f));
     e2->SetTranslation(100.0f, -2.0f, 70.0f);
+    e2->SetOccluder(true);
     collisionManager->addCollider(e2);
     entities.push_back(e2);
 
@@ -295,6 +319,7 @@ void Game::CreateBasicGeometry()
     // tower
     auto e5 = gameFactory->CreateEntity("Models/Tower.obj", tower, XMFLOAT2(5.5f, 5.5f));
     e5->SetTranslation(-3.0f, -2.0f, 8.0f);
+    e5->SetOccluder(true);
     collisionManager->addCollider(e5);
     entities.push_back(e5);
 
@@ -313,7 +338,9 @@ void Game::CreateBasicGeometry()
 
     slenderman = gameFactory->CreateSlenderman(slendermanMaterial, 1.0f, camera);
     slenderman->SetTranslation(16.0f, 0.0f, 0.0f);
-    collisionManager->addCollider(slenderman);
+    slenderman->GetCollider()->SetLayer(COLLISION_LAYER::AGENT);
+    slenderman->GetCollider()->SetMask(COLLISION_LAYER::ALL & ~COLLISION_LAYER::PICKUP);
+    collisionManager->addCollider(slenderman, true);
     entities.push_back(slenderman);
 
     // Walls
@@ -425,6 +452,7 @@ void Game::SpawnTreeGrid(int x, int y, int step)
             if (spawnSeed <= spawnChance) {
                 auto tree = gameFactory->CreateTree(treeMat, 1.5f);
                 tree->SetTag("tree");
+                tree->SetOccluder(true);
                 spawnStrenght = 1;
                 float offsetX = (rand() % 10 + 1) / 10.0f;
                 float offsetZ = (rand() % 10 + 1) / 10.0f;
@@ -506,12 +534,16 @@ void Game::SpawnLetters(float x, float y, float z, XMVECTOR rotation)
     // create a mesh for letters and push to vector of meshes
     auto letter = gameFactory->CreateLetter(note, 1.0f);
     letter->SetTag("letter");
+    letterTag = letter->GetTagId();
     XMFLOAT3 SCALE = XMFLOAT3(0.5f, 0.35f, 0.02f);
     XMFLOAT4 rot;
     XMStoreFloat4(&rot, rotation);
     letter->SetScale(SCALE);
     letter->SetTranslation(x, y, z);
     letter->SetRotation(rot);
+    // picked up by walking into it, it never pushes anyone
+    letter->GetCollider()->SetLayer(COLLISION_LAYER::PICKUP);
+    letter->GetCollider()->SetTrigger(true);
     collisionManager->addCollider(letter);
 
 
@@ -720,9 +752,10 @@ void Game::Update(float deltaTime, float totalTime)
 
 
     // if letter is found
-    auto objToRemove = collisionManager->HandlePlayerCollisions("letter");
+    auto objToRemove = collisionManager->HandlePlayerCollisions(letterTag);
     if (objToRemove != nullptr)
     {
+        collisionManager->removeCollider(objToRemove);
         Destroy(objToRemove);
         slenderman->setAgroLevel(slenderman->getAgroLevel() + 1); // increment 
         printf("Agrolevel is now %d", slenderman->getAgroLevel());
@@ -732,12 +765,27 @@ void Game::Update(float deltaTime, float totalTime)
     //entities[0]->SetTranslation(XMFLOAT3(val - 0.5, 0, 0));
     //entities[1]->SetScale(XMFLOAT3(val + 1, val + 1, val + 1));
     //entities[0]->RotateAroundAxis(XMFLOAT3(0.0, 1.0, 0.0), deltaTime * 0.5f);
+    // every matrix that changed, in one pass. only worth threading with thousands of them
+    TransformSystem::Instance()->Update((int)std::thread::hardware_concurrency());
+    // then whatever's in view, against the world bounds that came out of it, for the
+    // camera and for the flashlight's shadow map, which can see things the camera can't
+    TransformSystem::Instance()->Cull(camera->GetFrustum());
+    TransformSystem::Instance()->Cull(Frustum(viewShadow * XMMatrixTranspose(XMLoadFloat4x4(&shadowProjectionMatrix))), CULL_VIEW::SHADOW);
+    // and out of what the camera sees, whatever's behind the trees and buildings.
+    // the shadow map keeps everything, the flashlight sees around them
+    CullOccluded();
+    // 4 pixels lets the trees' coarsest LOD in before the far plane, at 1 they'd never leave LOD 0
+    const float lodPixelError = 4.0f;
     for (int i = 0; i < entities.size(); i++) {
-        entities[i]->ComputeWorldMatrix();
-        entities[i]->CheckForDraw(camera, 4000.0f);
+        if (!entities[i]->GetDraw()) continue;
+        entities[i]->SelectLod(camera, (float)height, lodPixelError);
     }
 
     slenderman->Update(deltaTime);
+    // he may have teleported
+    collisionManager->updateCollider(slenderman);
+    // keeps him out of the trees
+    collisionManager->Step();
 
 	XMFLOAT3 playerPos = camera->GetPosition();
 	playerPos.x = clamp(playerPos.x, -159.0f, 159.0f);
@@ -770,6 +818,72 @@ void Game::FlashlightBob(float deltaTime)
     XMStoreFloat3(&lights[0].Position, XMLoadFloat3(&camera->GetPosition()) + (XMLoadFloat3(&camera->GetRight()) * 0.5f) + XMVectorSet(x, y, 0, 0));
 }
 
+// --------------------------------------------------------
+// Rasterizes the biggest occluders the camera can see into
+// the OcclusionCuller and unmarks whatever is behind them.
+// Far away and small ones hide little and cost as much to
+// draw, so only the nearest big ones are used
+// --------------------------------------------------------
+void Game::CullOccluded()
+{
+    occluderEntities.clear();
+    occluderBounds.clear();
+    for (int i = 0; i < entities.size(); i++) {
+        if (!entities[i]->IsOccluder() || !entities[i]->GetDraw()) continue;
+        occluderEntities.push_back(entities[i]);
+        occluderBounds.push_back(entities[i]->GetWorldBounds());
+    }
+    occlusionCuller.ChooseOccluders(camera->GetPosition(), occluderBounds, occluders);
+
+    int threads = (int)std::thread::hardware_concurrency();
+    occlusionCuller.Begin(camera->GetViewProjection());
+    for (unsigned int i : occluders) {
+        // stored transposed for the shaders
+        XMFLOAT4X4 world = occluderEntities[i]->GetWorldMatrix();
+        occlusionCuller.AddOccluder(occluderEntities[i]->GetOccluderMesh(), XMMatrixTranspose(XMLoadFloat4x4(&world)));
+    }
+    occlusionCuller.Render(threads);
+    TransformSystem::Instance()->Occlude(occlusionCuller, threads);
+}
+
+// --------------------------------------------------------
+// Fills the render queue with every entity the shadow map
+// and the camera can see.  Items are keyed by the shaders,
+// material and vertex buffer they're drawn with, and main
+// pass ones by distance so nearer ones go first
+// --------------------------------------------------------
+void Game::QueueEntities()
+{
+    // the camera's far plane
+    const float drawDistance = 100.0f;
+
+    renderQueue.Begin();
+    entityRenderer->SetFrame(&entities, camera, shadowViewMatrix, shadowProjectionMatrix, shadowSRV, shadowSampler);
+    XMFLOAT3 position = camera->GetPosition();
+    XMVECTOR eye = XMLoadFloat3(&position);
+    // the shadow pass has no materials
+    unsigned int noMaterial = renderQueue.GetMaterialId(nullptr);
+
+    for (int i = 0; i < entities.size(); i++) {
+        // a mesh that failed to load has nothing to draw
+        if (entities[i]->GetVertexBuffer() == nullptr) continue;
+        unsigned int mesh = renderQueue.GetMeshId(entities[i]->GetVertexBuffer());
+
+        if (entities[i]->GetDraw(CULL_VIEW::SHADOW)) {
+            unsigned int shader = renderQueue.GetShaderId(entityRenderer->GetVertexShader(RENDER_PASS::SHADOW, *entities[i]).get(), nullptr);
+            renderQueue.Add(RENDER_PASS::SHADOW, shader, noMaterial, mesh, 0.0f, i);
+        }
+
+        if (entities[i]->GetDraw()) {
+            shared_ptr<Material> material = entities[i]->GetMaterial();
+            unsigned int shader = renderQueue.GetShaderId(material->GetVertexShader().get(), material->GetPixelShader().get());
+            Bounds bounds = entities[i]->GetWorldBounds();
+            float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.center) - eye));
+            renderQueue.Add(RENDER_PASS::MAIN, shader, renderQueue.GetMaterialId(material.get()), mesh, distance / drawDistance, i);
+        }
+    }
+}
+
 void Game::RenderShadows()
 {
     // Initial pipeline setup - No RTV necessary - Clear shadow map
@@ -787,36 +901,16 @@ void Game::RenderShadows()
     viewport.MaxDepth = 1.0f;
     context->RSSetViewports(1, &viewport);
 
-    // Turn on our shadow map Vertex Shader
+    // Set up our shadow map Vertex Shaders (turned on per entity)
     // and turn OFF the pixel shader entirely
-    shadowVS->SetShader();
     shadowVS->SetMatrix4x4("view", shadowViewMatrix);
     shadowVS->SetMatrix4x4("projection", shadowProjectionMatrix);
+    packedShadowVS->SetMatrix4x4("view", shadowViewMatrix);
+    packedShadowVS->SetMatrix4x4("projection", shadowProjectionMatrix);
     context->PSSetShader(nullptr, nullptr, 0); // No PS
 
-
-    UINT stride = sizeof(Vertex);
-    UINT offset = 0;
-
-    for (int i = 0; i < entities.size(); i++) {
-        // don't try to draw shadows on objects that aren't rendered
-        if (!entities[i]->GetDraw()) continue;
-
-        ID3D11Buffer* vb = entities[i]->GetVertexBuffer();
-        ID3D11Buffer* ib = entities[i]->GetIndexBuffer();
-
-        // Set buffers in the input assembler
-        context->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
-        context->IASetIndexBuffer(ib, DXGI_FORMAT_R32_UINT, 0);
-
-
-        shadowVS->SetMatrix4x4("world", entities[i]->GetWorldMatrix());
-        shadowVS->CopyAllBufferData();
-
-
-        // Finally do the actual drawing
-        context->DrawIndexed(entities[i]->GetIndexCount(), 0, 0);
-    }
+    // only what the light can see casts a shadow into the map
+    renderQueue.Submit(*entityRenderer, RENDER_PASS::SHADOW);
 
     // After rendering the shadow map, go back to the screen
     context->OMSetRenderTargets(1, &backBufferRTV, depthStencilView);
@@ -832,7 +926,8 @@ void Game::RenderShadows()
 // --------------------------------------------------------
 void Game::Draw(float deltaTime, float totalTime)
 {
-	// Render shadows first
+	// sort what both passes draw, then render shadows first
+	QueueEntities();
 	RenderShadows();
 
 	// Background color (Cornflower Blue in this case) for clearing
@@ -876,8 +971,7 @@ void Game::Draw(float deltaTime, float totalTime)
 		else {
 			pixelShader->SetFloat("gammaLevel", 1.0f);
 		}
-		
-		pixelShader->CopyAllBufferData();
+		// uploaded along with each material the queue binds
 
 
 		// Set buffers in the input assembler
@@ -887,37 +981,9 @@ void Game::Draw(float deltaTime, float totalTime)
 		UINT offset = 0;
 
 
-		int drawn = 0;
-		// loop through each mesh
-		for (int i = 0; i < entities.size(); i++) {
-			// prepare the material by setting the matrices and shaders in these order
-			if (!entities[i]->GetDraw() && i > 10) continue;
-			drawn++;
-			entities[i]->SendWorldMatrixToGPU(vertexShader, "world");
-			camera->SendViewMatrixToGPU(vertexShader, "view");
-			camera->SendProjectionMatrixToGPU(vertexShader, "projection");
-			camera->SendPositionToGPU(pixelShader, "CameraPosition");
-			entities[i]->GetMaterial()->PrepareMaterial(shadowViewMatrix, shadowProjectionMatrix, shadowSRV, shadowSampler);
-
-
-			// get a temp variable to access the buffer
-			ID3D11Buffer* vTemp = entities[i]->GetVertexBuffer();
-
-			// set the buffers
-			context->IASetVertexBuffers(0, 1, &vTemp, &stride, &offset);
-			context->IASetIndexBuffer(entities[i]->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-			// Finally do the actual drawing
-			//  - Do this ONCE PER OBJECT you intend to draw
-			//  - This will use all of the currently set DirectX "stuff" (shaders, buffers, etc)
-			//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
-			//     vertices in the currently set VERTEX BUFFER
-			context->DrawIndexed(
-				entities[i]->GetIndexCount(),     // The number of indices to use (we could draw a subset if we wanted)
-				0,     // Offset to the first index we want to use
-				0);    // Offset to add to each index when looking up vertices
-		}
-		//printf("Drawn Entities: %i\n", drawn);
+		// everything the camera sees, grouped by shader, material and mesh so each is
+		// only bound when it changes
+		renderQueue.Submit(*entityRenderer, RENDER_PASS::MAIN);
 		// === Sky box drawing ======================
 	// Draw the sky AFTER everything else to prevent overdraw
 
@@ -928,10 +994,11 @@ void Game::Draw(float deltaTime, float totalTime)
 		// Grab the data from the box mesh
 		ID3D11Buffer* skyVB = skyMesh->GetVertexBuffer();
 		ID3D11Buffer* skyIB = skyMesh->GetIndexBuffer();
+		stride = skyMesh->GetVertexStride();
 
 		// Set buffers in the input assembler
 		context->IASetVertexBuffers(0, 1, &skyVB, &stride, &offset);
-		context->IASetIndexBuffer(skyIB, DXGI_FORMAT_R32_UINT, 0);
+		context->IASetIndexBuffer(skyIB, skyMesh->GetIndexFormat(), 0);
 
 		// Set up the new sky shaders
 		skyVS->SetMatrix4x4("view", camera->GetViewMatrix());
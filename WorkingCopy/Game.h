@@ -13,6 +13,9 @@
 #include "GameFactory.h"
 #include "Emitter.h"
 #include "Config.h"
+#include "OcclusionCuller.h"
+#include "RenderQueue.h"
+#include "EntityRenderer.h"
 class Game 
 	: public DXCore
 {
@@ -50,6 +53,8 @@ private:
     void SpawnTreeGrid(int x, int y, int step);
 	void Destroy(shared_ptr<Entity> objectToDestroy);
 	void RenderShadows();
+	void CullOccluded();
+	void QueueEntities();
 	void FlashlightBob(float deltaTime);
 
 	std::vector<Light> lights;
@@ -57,6 +62,8 @@ private:
 	int lightCount;
 	// Letter Stuffs
 	int letterCount;
+	// the letters' tag id, interned when the first one is tagged
+	unsigned int letterTag = Tags::None;
 	float staticValue;		// Controls static effect, may change depending on post processing implementation
 
 	// Wrappers for DirectX shaders to provide simplified functionality
@@ -65,6 +72,9 @@ private:
     shared_ptr<SimpleVertexShader> skyVS;
 	shared_ptr<SimplePixelShader> skyPS;
 	shared_ptr<SimpleVertexShader> shadowVS;
+	// the same two shaders for meshes with PackedVertex verts
+	shared_ptr<SimpleVertexShader> packedVS;
+	shared_ptr<SimpleVertexShader> packedShadowVS;
 
 	shared_ptr<SimpleVertexShader> emitterVS;
 	shared_ptr<SimplePixelShader> emitterPS;
@@ -154,6 +164,18 @@ private:
 	DirectX::XMFLOAT4X4 shadowViewMatrix;
 	DirectX::XMFLOAT4X4 shadowProjectionMatrix;
 
+	// occlusion culling, drops what's hidden behind the biggest occluders in view
+	OcclusionCuller occlusionCuller;
+	// scratch for picking them each frame, every occluder entity being drawn and
+	// the ones the culler chose by how big they are on screen
+	vector<shared_ptr<Entity>> occluderEntities;
+	vector<Bounds> occluderBounds;
+	vector<unsigned int> occluders;
+
+	// entities are drawn sorted by state, through the renderer
+	RenderQueue renderQueue;
+	std::unique_ptr<EntityRenderer> entityRenderer;
+
 	// Post Process
 	ComPtr<ID3D11RenderTargetView> postProcessRTV;
 	ComPtr<ID3D11ShaderResourceView> postProcessSRV;
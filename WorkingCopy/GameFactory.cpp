@@ -1,18 +1,110 @@
 #include "GameFactory.h"
 #include "WICTextureLoader.h"
 #include "DDSTextureLoader.h"
+#include "TextureDecoder.h"
 
-shared_ptr<Entity> GameFactory::CreateEntityWithFile(const char* file, shared_ptr<Material> material, float pos)
+GameFactory::GameFactory(ID3D11Device* _device, ID3D11DeviceContext* _context) :context(_context), device(_device)
 {
-	shared_ptr<Mesh> mesh = make_shared<Mesh>(file, device);
-	return make_shared<Entity>(mesh, material, pos);
+	// the cache only calls back into the factory on the first request for a file
+	meshCache = MeshCache(
+		[this](const std::string& path) { return CreateMesh(path, VERTEX_FORMAT::FULL); },
+		[](const Mesh& mesh) { return mesh.GetByteSize(); });
+
+	textureCache = TextureCache<Texture>(
+		[this](const TextureKey& key) -> shared_ptr<Texture> {
+			std::wstring file(key.path.begin(), key.path.end());
+			if (!loadingAsync)
+				return Texture::Load(device, context, file.c_str(), key.srgb, (D3D11_USAGE)key.usage);
+
+			// decoded on a worker, the view is created by FinishLoading()
+			shared_ptr<Texture> texture = make_shared<Texture>();
+			bool srgb = key.srgb;
+			D3D11_USAGE usage = (D3D11_USAGE)key.usage;
+			assetLoader.Load<DecodedImage>(key.path,
+				[file]() {
+					shared_ptr<DecodedImage> image = make_shared<DecodedImage>();
+					if (!TextureDecoder::Decode(file.c_str(), *image)) return shared_ptr<DecodedImage>();
+					return image;
+				},
+				[this, texture, srgb, usage](DecodedImage& image) {
+					TextureDecoder::CreateTexture(device, context, image, srgb, usage, texture->ReleaseAndGetAddressOf());
+				});
+			return texture;
+		},
+		[](const Texture& texture) { return texture.GetByteSize(); });
+}
+
+void GameFactory::FinishLoading()
+{
+	assetLoader.Finish();
+	assetLoader.PrintTimings();
+	loadingAsync = false;
+
+	// a failed load leaves its empty placeholder in the cache, don't count it as loaded
+	size_t failedMeshes = meshCache.RemoveFailed([](const Mesh& mesh) { return !mesh.IsLoaded(); });
+	size_t failedTextures = textureCache.RemoveFailed([](const Texture& texture) { return !texture.IsLoaded(); });
+	if (failedMeshes + failedTextures > 0) printf("%zu meshes and %zu textures failed to load\n", failedMeshes, failedTextures);
+
+	// the meshes and textures had no GPU resources yet when they were cached
+	meshCache.RecountBytes();
+	textureCache.RecountBytes();
+
+	// and the entities took the empty placeholder's bounds, culling would throw them all away
+	for (const std::weak_ptr<Entity>& waiting : waitingForMesh) {
+		if (shared_ptr<Entity> entity = waiting.lock()) entity->RefreshBounds();
+	}
+	waitingForMesh.clear();
+}
+
+shared_ptr<Mesh> GameFactory::CreateMesh(const std::string& path, VERTEX_FORMAT format)
+{
+	if (!loadingAsync)
+	{
+		shared_ptr<Mesh> mesh = make_shared<Mesh>(path.c_str(), device, format);
+		// a mesh without buffers failed to load, don't keep it around
+		if (!mesh->IsLoaded()) return nullptr;
+		return mesh;
+	}
+
+	// entities get the mesh straight away, its buffers are filled in by FinishLoading()
+	shared_ptr<Mesh> mesh = make_shared<Mesh>();
+	assetLoader.Load<MeshSource>(path,
+		[path, format]() {
+			shared_ptr<MeshSource> source = make_shared<MeshSource>();
+			if (!source->Load(path.c_str(), format)) return shared_ptr<MeshSource>();
+			return source;
+		},
+		[this, mesh](MeshSource& source) { mesh->Upload(source, device); });
+	return mesh;
+}
+
+shared_ptr<Mesh> GameFactory::LoadMesh(const char* file, VERTEX_FORMAT format)
+{
+	// the same model packed and unpacked are two different meshes
+	std::string path(file);
+	shared_ptr<Mesh> mesh = format == VERTEX_FORMAT::PACKED
+		? meshCache.GetOrLoad(CanonicalAssetPath(path) + "|packed", [this, &path]() { return CreateMesh(path, VERTEX_FORMAT::PACKED); })
+		: meshCache.Get(path);
+	// fall back to an empty mesh so a missing file just draws nothing
+	if (mesh == nullptr) mesh = make_shared<Mesh>();
+	return mesh;
+}
+
+shared_ptr<Entity> GameFactory::CreateEntityWithFile(const char* file, shared_ptr<Material> material, float pos, VERTEX_FORMAT format)
+{
+	shared_ptr<Mesh> mesh = LoadMesh(file, format);
+	shared_ptr<Entity> entity = make_shared<Entity>(mesh, material, pos);
+	if (loadingAsync) waitingForMesh.push_back(entity);
+	return entity;
 
 }
 
 shared_ptr<Entity> GameFactory::CreateEntityWithFile(const char* file, shared_ptr<Material> material, DirectX::XMFLOAT2 s)
 {
-	shared_ptr<Mesh> mesh = make_shared<Mesh>(file, device);
-	return make_shared<Entity>(mesh, material, s);
+	shared_ptr<Mesh> mesh = LoadMesh(file);
+	shared_ptr<Entity> entity = make_shared<Entity>(mesh, material, s);
+	if (loadingAsync) waitingForMesh.push_back(entity);
+	return entity;
 }
 
 shared_ptr<Entity> GameFactory::CreateEntityWithVertex(Vertex vertices[], unsigned int indices[], shared_ptr<Material> material, float pos)
@@ -37,7 +129,7 @@ shared_ptr<Entity> GameFactory::CreateFloor(shared_ptr<Material> floorMaterial,
 
 shared_ptr<Entity> GameFactory::CreateTree(shared_ptr<Material> material, float pos)
 {
-	return CreateEntityWithFile("Models/DeadTree.obj", material, pos);
+	return CreateEntityWithFile("Models/DeadTree.obj", material, pos, VERTEX_FORMAT::PACKED);
 }
 
 shared_ptr<Entity> GameFactory::CreateLetter(shared_ptr<Material> letterMaterial, float pos)
@@ -59,8 +151,10 @@ shared_ptr<Entity> GameFactory::CreateEntity(const char* file, shared_ptr<Materi
 
 shared_ptr<SlenderMan> GameFactory::CreateSlenderman(shared_ptr<Material> slendermanMaterial, float pos, shared_ptr<Camera> player)
 {
-	shared_ptr<Mesh> mesh = make_shared<Mesh>("Models/slenderman.obj", device);
-	return make_shared<SlenderMan>(mesh, slendermanMaterial, pos, player);
+	shared_ptr<Mesh> mesh = LoadMesh("Models/slenderman.obj");
+	shared_ptr<SlenderMan> slenderman = make_shared<SlenderMan>(mesh, slendermanMaterial, pos, player);
+	if (loadingAsync) waitingForMesh.push_back(slenderman);
+	return slenderman;
 }
 
 shared_ptr<Entity> GameFactory::CreateWall(shared_ptr<Material> wallMaterial)
@@ -78,9 +172,9 @@ shared_ptr<Entity> GameFactory::CreateWall(shared_ptr<Material> wallMaterial)
 }
 
 
-shared_ptr<CollisionManager> GameFactory::CreateCollisionManager(shared_ptr<Camera> camera)
+shared_ptr<CollisionManager> GameFactory::CreateCollisionManager(shared_ptr<Camera> camera, BROADPHASE_TYPE broadphase)
 {
-	return make_shared<CollisionManager>(camera);
+	return make_shared<CollisionManager>(camera, broadphase);
 }
 
 
@@ -104,7 +198,9 @@ shared_ptr<Material> GameFactory::CreateMaterial(shared_ptr<SimpleVertexShader>
 	sampDesc.MaxLOD = D3D11_FLOAT32_MAX;
 
 	device->CreateSamplerState(&sampDesc, &samplerOptions);
-	return make_shared<Material>(context, device, vShader, pShader,samplerOptions, specColor);
+	shared_ptr<Material> material = make_shared<Material>(context, device, vShader, pShader,samplerOptions, specColor);
+	material->SetTextureCache(&textureCache);
+	return material;
 
 }
 
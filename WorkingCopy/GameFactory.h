@@ -7,24 +7,42 @@
 #include <wrl/client.h>
 #include "SlenderMan.h"
 #include "Emitter.h"
+#include "AssetCache.h"
+#include "AssetLoader.h"
+#include "TextureCache.h"
+#include "Texture.h"
 
 
 using namespace Microsoft::WRL;
 
 
 using namespace DirectX;
+
+// one GPU mesh per model file, shared by every entity that uses it
+using MeshCache = AssetCache<Mesh>;
+
 class GameFactory
 {
 private:
 	ID3D11DeviceContext* context;
 	ID3D11Device* device;
-	shared_ptr<Entity> CreateEntityWithFile(const char* file, shared_ptr<Material> material, float pos);
+	MeshCache meshCache;
+	TextureCache<Texture> textureCache;
+	AssetLoader assetLoader;
+	// until FinishLoading() meshes and textures are loaded on the worker threads
+	bool loadingAsync = true;
+	// entities made before their mesh had bounds, FinishLoading() gives them the real ones
+	std::vector<std::weak_ptr<Entity>> waitingForMesh;
+	shared_ptr<Mesh> CreateMesh(const std::string& path, VERTEX_FORMAT format);
+	shared_ptr<Mesh> LoadMesh(const char* file, VERTEX_FORMAT format = VERTEX_FORMAT::FULL);
+	shared_ptr<Entity> CreateEntityWithFile(const char* file, shared_ptr<Material> material, float pos, VERTEX_FORMAT format = VERTEX_FORMAT::FULL);
 	shared_ptr<Entity> CreateEntityWithFile(const char* file, shared_ptr<Material> material, DirectX::XMFLOAT2 s);
 	shared_ptr<Entity> CreateEntityWithVertex(Vertex vertices[], unsigned int indices[], shared_ptr<Material> material, float pos);
 
 public:
-	explicit GameFactory(ID3D11Device* _device, ID3D11DeviceContext* _context) :context(_context), device(_device) {}
+	explicit GameFactory(ID3D11Device* _device, ID3D11DeviceContext* _context);
 	shared_ptr<Entity> CreateFloor(shared_ptr<Material> floorMaterial, float pos);
+	// trees use packed verts, their material needs a vertex shader that unpacks them
 	shared_ptr<Entity> CreateTree(shared_ptr<Material> treeMaterial, float pos);
 	shared_ptr<Entity> CreateLetter(shared_ptr<Material> letterMaterial, float pos);
 	shared_ptr<Entity> CreateEntity(const char* file, shared_ptr<Material> material, float pos);
@@ -32,14 +50,20 @@ public:
 	shared_ptr<SlenderMan> CreateSlenderman(shared_ptr<Material> slendermanMaterial, float pos, shared_ptr<Camera> player);
 	shared_ptr<Entity> CreateWall(shared_ptr<Material> wallMaterial);
 
-	shared_ptr<CollisionManager> CreateCollisionManager(shared_ptr<Camera> camera);
+	// the map is mostly same sized trees, which a flat grid handles best
+	shared_ptr<CollisionManager> CreateCollisionManager(shared_ptr<Camera> camera, BROADPHASE_TYPE broadphase = BROADPHASE_TYPE::SPATIAL_HASH);
 	shared_ptr<Camera> CreateCamera(float width, float height);
 
 	shared_ptr<Material> CreateMaterial(shared_ptr<SimpleVertexShader> vShader, shared_ptr<SimplePixelShader> pShader, XMFLOAT3 specColor);
 	shared_ptr<Material> CreateSkyBox(const wchar_t* ddsFile, shared_ptr<SimpleVertexShader> vShader, shared_ptr<SimplePixelShader> pShader);
 	void SetUpPostProcess(ComPtr<ID3D11RenderTargetView> RTV, ComPtr<ID3D11ShaderResourceView> SRV, ComPtr<ID3D11SamplerState> postProcessSS, unsigned int width, unsigned int height);
-	inline shared_ptr<Mesh> CreateCubeMesh() { return make_shared<Mesh>("Models/cube.obj", device); }
-	inline shared_ptr<Mesh> CreateSphereMesh() { return make_shared<Mesh>("Models/sphere.obj", device); }
+	inline shared_ptr<Mesh> CreateCubeMesh() { return LoadMesh("Models/cube.obj"); }
+	inline shared_ptr<Mesh> CreateSphereMesh() { return LoadMesh("Models/sphere.obj"); }
+	inline const AssetCacheStats& GetMeshCacheStats() const { return meshCache.GetStats(); }
+	inline const AssetCacheStats& GetTextureCacheStats() const { return textureCache.GetStats(); }
+
+	// waits for everything queued since construction and creates the GPU resources
+	void FinishLoading();
 
 	Light CreateSpotlight(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 direction , DirectX::XMFLOAT3 color, float range, float intensity, float spotFalloff );
 	Light CreatePointLight(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 color, float range, float intensity);
@@ -0,0 +1,169 @@
+#include "LinearQuadtree.h"
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace
+{
+    // spreads the low 16 bits out to the even bits
+    unsigned int Part1By1(unsigned int x)
+    {
+        x &= 0x0000FFFF;
+        x = (x | (x << 8)) & 0x00FF00FF;
+        x = (x | (x << 4)) & 0x0F0F0F0F;
+        x = (x | (x << 2)) & 0x33333333;
+        x = (x | (x << 1)) & 0x55555555;
+        return x;
+    }
+
+    // bounds that overlap nothing, for empty nodes
+    const XMFLOAT4 EmptyBounds(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+}
+
+LinearQuadtree::LinearQuadtree(const QuadtreeSettings& settings) : settings(settings)
+{
+    if (this->settings.maxDepth > 16) this->settings.maxDepth = 16;
+    if (this->settings.maxDepth < 0) this->settings.maxDepth = 0;
+}
+
+unsigned int LinearQuadtree::MortonCode(unsigned int x, unsigned int y)
+{
+    return Part1By1(x) | (Part1By1(y) << 1);
+}
+
+void LinearQuadtree::Build(const std::vector<Collider*>& colliders)
+{
+    size_t count = colliders.size();
+    nodes.clear();
+    objects.resize(count);
+    objectBounds.resize(count);
+    keys.resize(count);
+    order.resize(count);
+
+    // key every collider by the finest cell its center is in, anything
+    // outside the root is clamped to the edge cells
+    unsigned int cells = 1u << settings.maxDepth;
+    float cellsPerUnit = cells / (settings.halfSize * 2.0f);
+    float left = settings.center.x - settings.halfSize;
+    float bottom = settings.center.y - settings.halfSize;
+    for (size_t i = 0; i < count; i++)
+    {
+        XMFLOAT2 center = colliders[i]->GetCenter();
+        float x = (center.x - left) * cellsPerUnit;
+        float y = (center.y - bottom) * cellsPerUnit;
+        unsigned int cellX = x <= 0.0f ? 0 : (x >= cells ? cells - 1 : (unsigned int)x);
+        unsigned int cellY = y <= 0.0f ? 0 : (y >= cells ? cells - 1 : (unsigned int)y);
+        keys[i] = MortonCode(cellX, cellY);
+        order[i] = (unsigned int)i;
+    }
+    SortByKey(count);
+
+    // lay the colliders out in key order
+    keyScratch.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        objects[i] = colliders[order[i]];
+        objectBounds[i] = objects[i]->GetBounds();
+        keyScratch[i] = keys[order[i]];
+    }
+    keys.swap(keyScratch);
+
+    Node root;
+    root.bounds = EmptyBounds;
+    root.objectStart = 0;
+    root.objectCount = (unsigned int)count;
+    root.firstChild = 0;
+    nodes.push_back(root);
+    Split(0, 0, 0);
+}
+
+void LinearQuadtree::SortByKey(size_t count)
+{
+    // least significant digit radix sort of order by keys, 8 bits a pass,
+    // skipping the passes above the bits the keys can use
+    sortScratch.resize(count);
+    int keyBits = settings.maxDepth * 2;
+    for (int shift = 0; shift < keyBits; shift += 8)
+    {
+        unsigned int counts[257] = {};
+        for (size_t i = 0; i < count; i++)
+        {
+            counts[((keys[order[i]] >> shift) & 0xFF) + 1]++;
+        }
+        for (int d = 0; d < 256; d++)
+        {
+            counts[d + 1] += counts[d];
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            unsigned int digit = (keys[order[i]] >> shift) & 0xFF;
+            sortScratch[counts[digit]++] = order[i];
+        }
+        order.swap(sortScratch);
+    }
+}
+
+void LinearQuadtree::Split(unsigned int node, int depth, unsigned int prefix)
+{
+    unsigned int start = nodes[node].objectStart;
+    unsigned int end = start + nodes[node].objectCount;
+
+    if (nodes[node].objectCount <= settings.leafCapacity || depth >= settings.maxDepth)
+    {
+        // a leaf, its bounds are its objects'
+        XMFLOAT4 bounds = EmptyBounds;
+        for (unsigned int i = start; i < end; i++)
+        {
+            bounds.x = std::min(bounds.x, objectBounds[i].x);
+            bounds.y = std::min(bounds.y, objectBounds[i].y);
+            bounds.z = std::max(bounds.z, objectBounds[i].z);
+            bounds.w = std::max(bounds.w, objectBounds[i].w);
+        }
+        nodes[node].bounds = bounds;
+        return;
+    }
+
+    // the children split the node's key range in four, find where each quarter starts
+    unsigned int firstChild = (unsigned int)nodes.size();
+    nodes[node].firstChild = firstChild;
+    int shift = 2 * (settings.maxDepth - depth - 1);
+    unsigned int childStart = start;
+    for (unsigned int quadrant = 0; quadrant < 4; quadrant++)
+    {
+        unsigned int childEnd = end;
+        if (quadrant < 3)
+        {
+            unsigned int nextKey = ((prefix << 2) | (quadrant + 1)) << shift;
+            childEnd = (unsigned int)(std::lower_bound(keys.begin() + childStart, keys.begin() + end, nextKey) - keys.begin());
+        }
+
+        Node child;
+        child.bounds = EmptyBounds;
+        child.objectStart = childStart;
+        child.objectCount = childEnd - childStart;
+        child.firstChild = 0;
+        nodes.push_back(child);
+        childStart = childEnd;
+    }
+
+    // the pool can grow while the children split, so nothing holds a reference into it
+    XMFLOAT4 bounds = EmptyBounds;
+    for (unsigned int quadrant = 0; quadrant < 4; quadrant++)
+    {
+        Split(firstChild + quadrant, depth + 1, (prefix << 2) | quadrant);
+
+        const XMFLOAT4& childBounds = nodes[firstChild + quadrant].bounds;
+        bounds.x = std::min(bounds.x, childBounds.x);
+        bounds.y = std::min(bounds.y, childBounds.y);
+        bounds.z = std::max(bounds.z, childBounds.z);
+        bounds.w = std::max(bounds.w, childBounds.w);
+    }
+    nodes[node].bounds = bounds;
+}
+
+void LinearQuadtree::GetCollidableObjects(Collider* col, std::vector<Collider*>& results) const
+{
+    results.clear();
+    VisitCollidableObjects(col, [&results](Collider* other) { results.push_back(other); });
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include "Collider.h"
+#include "QuadtreeSettings.h"
+#include <vector>
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// A quadtree stored as arrays instead of linked nodes.
+//
+// Build() sorts the colliders by the Morton code of their
+// centers, so every node's objects are one range of the
+// sorted array and a node's four children sit next to each
+// other in the pool, in Morton order.  Each node also keeps
+// the bounds of everything under it, so colliders only live
+// in one leaf no matter how big they are.
+//
+// Built in one go, rebuilding reuses the same storage
+// --------------------------------------------------------
+class LinearQuadtree
+{
+public:
+    LinearQuadtree(const QuadtreeSettings& settings = QuadtreeSettings());
+
+    void Build(const std::vector<Collider*>& colliders);
+
+    // fills results with every collider whose bounds overlap col's, results is cleared first
+    void GetCollidableObjects(Collider* col, std::vector<Collider*>& results) const;
+
+    // calls visit(Collider*) for every collider GetCollidableObjects would return
+    template<class Visitor>
+    void VisitCollidableObjects(Collider* col, Visitor visit) const;
+
+    inline const QuadtreeSettings& GetSettings() const { return settings; }
+    inline size_t GetNodeCount() const { return nodes.size(); }
+    inline size_t GetObjectCount() const { return objects.size(); }
+
+    // interleaves the bits of x and y, x in the even bits
+    static unsigned int MortonCode(unsigned int x, unsigned int y);
+
+private:
+    struct Node
+    {
+        DirectX::XMFLOAT4 bounds;   // min x, min y, max x, max y of everything below
+        unsigned int objectStart;
+        unsigned int objectCount;
+        unsigned int firstChild;    // 0 for leaves, the root is never anyone's child
+    };
+
+    QuadtreeSettings settings;
+    std::vector<Node> nodes;
+    // sorted by key, each node owns a range
+    std::vector<Collider*> objects;
+    std::vector<DirectX::XMFLOAT4> objectBounds;
+    std::vector<unsigned int> keys;
+
+    // kept between builds so rebuilding doesn't allocate
+    std::vector<unsigned int> order;
+    std::vector<unsigned int> sortScratch;
+    std::vector<unsigned int> keyScratch;
+
+    void SortByKey(size_t count);
+    void Split(unsigned int node, int depth, unsigned int prefix);
+};
+
+template<class Visitor>
+void LinearQuadtree::VisitCollidableObjects(Collider* col, Visitor visit) const
+{
+    if (nodes.empty() || nodes[0].objectCount == 0) return;
+    DirectX::XMFLOAT4 query = col->GetBounds();
+
+    // each level pushes at most 4 and pops 1
+    unsigned int stack[4 + 3 * 16];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0)
+    {
+        const Node& node = nodes[stack[--stackSize]];
+        if (node.bounds.x > query.z || node.bounds.z < query.x || node.bounds.y > query.w || node.bounds.w < query.y) continue;
+
+        if (node.firstChild != 0)
+        {
+            for (unsigned int i = 0; i < 4; i++) stack[stackSize++] = node.firstChild + i;
+            continue;
+        }
+
+        for (unsigned int i = node.objectStart; i < node.objectStart + node.objectCount; i++)
+        {
+            const DirectX::XMFLOAT4& b = objectBounds[i];
+            if (b.x > query.z || b.z < query.x || b.y > query.w || b.w < query.y) continue;
+            visit(objects[i]);
+        }
+    }
+}
@@ -0,0 +1,133 @@
+// --------------------------------------------------------
+// Scalar stand-in for the parts of DirectXMath the engine's
+// device independent code uses, so CMakeLists.txt can build
+// and test it off Windows.  Never on the include path of
+// the game itself, which uses the Windows SDK's header.
+//
+// Like the real header it turns on the SSE (and AVX) paths
+// when the compiler targets them and _XM_NO_INTRINSICS_ isn't
+// defined.  Only code that uses intrinsics directly takes
+// them, XMVECTOR itself is always plain floats here
+// --------------------------------------------------------
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(_XM_NO_INTRINSICS_)
+#if defined(__AVX__) && !defined(_XM_AVX_INTRINSICS_)
+#define _XM_AVX_INTRINSICS_
+#endif
+#if (defined(__SSE2__) || defined(__x86_64__)) && !defined(_XM_SSE_INTRINSICS_)
+#define _XM_SSE_INTRINSICS_
+#endif
+#endif
+
+#define XM_CALLCONV
+namespace DirectX {
+struct XMFLOAT2 { float x, y; XMFLOAT2() = default; constexpr XMFLOAT2(float a, float b) : x(a), y(b) {} };
+struct XMFLOAT3 { float x, y, z; XMFLOAT3() = default; constexpr XMFLOAT3(float a, float b, float c) : x(a), y(b), z(c) {} };
+struct XMFLOAT4 { float x, y, z, w; XMFLOAT4() = default; constexpr XMFLOAT4(float a, float b, float c, float d) : x(a), y(b), z(c), w(d) {} };
+struct XMFLOAT4X4 { float m[4][4]; };
+struct XMVECTOR { float v[4]; };
+typedef const XMVECTOR& FXMVECTOR; typedef const XMVECTOR& GXMVECTOR; typedef const XMVECTOR& HXMVECTOR; typedef const XMVECTOR& CXMVECTOR;
+struct XMMATRIX { XMVECTOR r[4]; XMMATRIX() = default; XMMATRIX(const XMVECTOR& a, const XMVECTOR& b, const XMVECTOR& c, const XMVECTOR& d) { r[0]=a; r[1]=b; r[2]=c; r[3]=d; } };
+struct XMFLOAT4A { float x, y, z, w; };
+typedef const XMMATRIX& FXMMATRIX; typedef const XMMATRIX& CXMMATRIX;
+const float XM_PI = 3.141592654f;
+inline XMVECTOR XMVectorSet(float a, float b, float c, float d) { return {{a,b,c,d}}; }
+inline XMVECTOR XMVectorReplicate(float a) { return {{a,a,a,a}}; }
+inline XMVECTOR XMVectorZero() { return {{0,0,0,0}}; }
+inline XMVECTOR XMLoadFloat2(const XMFLOAT2* p) { return {{p->x,p->y,0,0}}; }
+inline XMVECTOR XMLoadFloat3(const XMFLOAT3* p) { return {{p->x,p->y,p->z,0}}; }
+inline XMVECTOR XMLoadFloat4(const XMFLOAT4* p) { return {{p->x,p->y,p->z,p->w}}; }
+inline XMVECTOR XMLoadFloat(const float* p) { return {{*p,0,0,0}}; }
+inline void XMStoreFloat2(XMFLOAT2* p, FXMVECTOR v) { p->x=v.v[0]; p->y=v.v[1]; }
+inline void XMStoreFloat3(XMFLOAT3* p, FXMVECTOR v) { p->x=v.v[0]; p->y=v.v[1]; p->z=v.v[2]; }
+inline void XMStoreFloat4(XMFLOAT4* p, FXMVECTOR v) { p->x=v.v[0]; p->y=v.v[1]; p->z=v.v[2]; p->w=v.v[3]; }
+inline void XMStoreFloat(float* p, FXMVECTOR v) { *p=v.v[0]; }
+inline float XMVectorGetX(FXMVECTOR v) { return v.v[0]; }
+inline float XMVectorGetY(FXMVECTOR v) { return v.v[1]; }
+inline float XMVectorGetZ(FXMVECTOR v) { return v.v[2]; }
+inline float XMVectorGetW(FXMVECTOR v) { return v.v[3]; }
+#define XM_BIN(name, op) inline XMVECTOR name(FXMVECTOR a, FXMVECTOR b) { XMVECTOR r; for(int i=0;i<4;i++) r.v[i]=a.v[i] op b.v[i]; return r; }
+XM_BIN(XMVectorAdd, +) XM_BIN(XMVectorSubtract, -) XM_BIN(XMVectorMultiply, *) XM_BIN(XMVectorDivide, /)
+inline XMVECTOR operator+(FXMVECTOR a, FXMVECTOR b) { return XMVectorAdd(a,b); }
+inline XMVECTOR operator-(FXMVECTOR a, FXMVECTOR b) { return XMVectorSubtract(a,b); }
+inline XMVECTOR operator*(FXMVECTOR a, FXMVECTOR b) { return XMVectorMultiply(a,b); }
+inline XMVECTOR operator/(FXMVECTOR a, FXMVECTOR b) { return XMVectorDivide(a,b); }
+inline XMVECTOR operator*(FXMVECTOR a, float s) { return XMVectorMultiply(a,XMVectorReplicate(s)); }
+inline XMVECTOR operator*(float s, FXMVECTOR a) { return XMVectorMultiply(a,XMVectorReplicate(s)); }
+inline XMVECTOR operator-(FXMVECTOR a) { return XMVectorSubtract(XMVectorZero(),a); }
+inline XMVECTOR& operator+=(XMVECTOR& a, FXMVECTOR b) { a = a + b; return a; }
+inline XMVECTOR& operator-=(XMVECTOR& a, FXMVECTOR b) { a = a - b; return a; }
+inline XMVECTOR& operator*=(XMVECTOR& a, float s) { a = a * s; return a; }
+inline XMVECTOR& operator*=(XMVECTOR& a, FXMVECTOR b) { a = a * b; return a; }
+inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return a*b+c; }
+inline XMVECTOR XMVectorNegativeMultiplySubtract(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return c-a*b; }
+inline XMVECTOR XMVectorScale(FXMVECTOR a, float s) { return a*s; }
+inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) { XMVECTOR r; for(int i=0;i<4;i++) r.v[i]=fminf(a.v[i],b.v[i]); return r; }
+inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) { XMVECTOR r; for(int i=0;i<4;i++) r.v[i]=fmaxf(a.v[i],b.v[i]); return r; }
+inline XMVECTOR XMVectorAbs(FXMVECTOR a) { XMVECTOR r; for(int i=0;i<4;i++) r.v[i]=fabsf(a.v[i]); return r; }
+inline XMVECTOR XMVectorSqrt(FXMVECTOR a) { XMVECTOR r; for(int i=0;i<4;i++) r.v[i]=sqrtf(a.v[i]); return r; }
+inline XMVECTOR XMVectorReciprocal(FXMVECTOR a) { XMVECTOR r; for(int i=0;i<4;i++) r.v[i]=1.0f/a.v[i]; return r; }
+inline XMVECTOR XMVectorClamp(FXMVECTOR a, FXMVECTOR lo, FXMVECTOR hi) { return XMVectorMin(XMVectorMax(a,lo),hi); }
+inline XMVECTOR XMVectorSaturate(FXMVECTOR a) { return XMVectorClamp(a, XMVectorZero(), XMVectorReplicate(1)); }
+inline XMVECTOR XMVectorTrueInt() { XMVECTOR r; uint32_t u=0xFFFFFFFFu; for(int i=0;i<4;i++) memcpy(&r.v[i],&u,4); return r; }
+#define XM_CMP(name, op) inline XMVECTOR name(FXMVECTOR a, FXMVECTOR b) { XMVECTOR r; for(int i=0;i<4;i++){ uint32_t u = (a.v[i] op b.v[i]) ? 0xFFFFFFFFu : 0u; memcpy(&r.v[i],&u,4);} return r; }
+XM_CMP(XMVectorLess, <) XM_CMP(XMVectorLessOrEqual, <=) XM_CMP(XMVectorGreater, >) XM_CMP(XMVectorGreaterOrEqual, >=) XM_CMP(XMVectorEqual, ==)
+#define XM_BITS(name, op) inline XMVECTOR name(FXMVECTOR a, FXMVECTOR b) { XMVECTOR r; for(int i=0;i<4;i++){ uint32_t x,y; memcpy(&x,&a.v[i],4); memcpy(&y,&b.v[i],4); x = x op y; memcpy(&r.v[i],&x,4);} return r; }
+XM_BITS(XMVectorAndInt, &) XM_BITS(XMVectorOrInt, |)
+inline XMVECTOR XMVectorSelect(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { XMVECTOR r; for(int i=0;i<4;i++){ uint32_t x,y,m; memcpy(&x,&a.v[i],4); memcpy(&y,&b.v[i],4); memcpy(&m,&c.v[i],4); x=(x&~m)|(y&m); memcpy(&r.v[i],&x,4);} return r; }
+inline uint32_t XMVectorGetIntX(FXMVECTOR a) { uint32_t u; memcpy(&u,&a.v[0],4); return u; }
+inline void XMVectorGetIntPtr(uint32_t* p, FXMVECTOR a) { memcpy(p,a.v,16); }
+inline XMVECTOR XMVectorSplatX(FXMVECTOR a) { return XMVectorReplicate(a.v[0]); }
+inline XMVECTOR XMVectorSplatY(FXMVECTOR a) { return XMVectorReplicate(a.v[1]); }
+inline XMVECTOR XMVectorSplatZ(FXMVECTOR a) { return XMVectorReplicate(a.v[2]); }
+inline XMVECTOR XMVectorSplatW(FXMVECTOR a) { return XMVectorReplicate(a.v[3]); }
+inline XMVECTOR XMLoadFloat4A(const float* p) { return {{p[0],p[1],p[2],p[3]}}; }
+inline void XMStoreFloat4A(float* p, FXMVECTOR v) { memcpy(p,v.v,16); }
+inline void XMStoreFloat4A(XMFLOAT4A* p, FXMVECTOR v) { memcpy(p,v.v,16); }
+inline XMVECTOR XMVector2Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a.v[0]*b.v[0]+a.v[1]*b.v[1]); }
+inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a.v[0]*b.v[0]+a.v[1]*b.v[1]+a.v[2]*b.v[2]); }
+inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b) { return XMVectorReplicate(a.v[0]*b.v[0]+a.v[1]*b.v[1]+a.v[2]*b.v[2]+a.v[3]*b.v[3]); }
+inline XMVECTOR XMVector2LengthSq(FXMVECTOR a) { return XMVector2Dot(a,a); }
+inline XMVECTOR XMVector3LengthSq(FXMVECTOR a) { return XMVector3Dot(a,a); }
+inline XMVECTOR XMVector2Length(FXMVECTOR a) { return XMVectorSqrt(XMVector2Dot(a,a)); }
+inline XMVECTOR XMVector3Length(FXMVECTOR a) { return XMVectorSqrt(XMVector3Dot(a,a)); }
+inline XMVECTOR XMVector2Normalize(FXMVECTOR a) { float l = sqrtf(a.v[0]*a.v[0]+a.v[1]*a.v[1]); return l>0? a*(1.0f/l) : XMVectorZero(); }
+inline XMVECTOR XMVector3Normalize(FXMVECTOR a) { float l = XMVectorGetX(XMVector3Length(a)); return l>0? a*(1.0f/l) : XMVectorZero(); }
+inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(a.v[1]*b.v[2]-a.v[2]*b.v[1], a.v[2]*b.v[0]-a.v[0]*b.v[2], a.v[0]*b.v[1]-a.v[1]*b.v[0], 0); }
+inline bool XMVector3Equal(FXMVECTOR a, FXMVECTOR b) { return a.v[0]==b.v[0]&&a.v[1]==b.v[1]&&a.v[2]==b.v[2]; }
+inline XMMATRIX XMMatrixIdentity() { XMMATRIX m; for(int i=0;i<4;i++) for(int j=0;j<4;j++) m.r[i].v[j]= i==j; return m; }
+inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* p) { XMMATRIX m; for(int i=0;i<4;i++) for(int j=0;j<4;j++) m.r[i].v[j]=p->m[i][j]; return m; }
+inline void XMStoreFloat4x4(XMFLOAT4X4* p, FXMMATRIX m) { for(int i=0;i<4;i++) for(int j=0;j<4;j++) p->m[i][j]=m.r[i].v[j]; }
+inline XMMATRIX XMMatrixTranspose(FXMMATRIX m) { XMMATRIX r; for(int i=0;i<4;i++) for(int j=0;j<4;j++) r.r[i].v[j]=m.r[j].v[i]; return r; }
+inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b) { XMMATRIX r; for(int i=0;i<4;i++) for(int j=0;j<4;j++){ float s=0; for(int k=0;k<4;k++) s+=a.r[i].v[k]*b.r[k].v[j]; r.r[i].v[j]=s;} return r; }
+inline XMMATRIX operator*(FXMMATRIX a, CXMMATRIX b) { return XMMatrixMultiply(a,b); }
+inline XMMATRIX XMMatrixTranslation(float x, float y, float z) { XMMATRIX m = XMMatrixIdentity(); m.r[3]=XMVectorSet(x,y,z,1); return m; }
+inline XMMATRIX XMMatrixScaling(float x, float y, float z) { XMMATRIX m = XMMatrixIdentity(); m.r[0].v[0]=x; m.r[1].v[1]=y; m.r[2].v[2]=z; return m; }
+inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR q) { float x=q.v[0],y=q.v[1],z=q.v[2],w=q.v[3]; XMMATRIX m=XMMatrixIdentity();
+ m.r[0]=XMVectorSet(1-2*(y*y+z*z),2*(x*y+z*w),2*(x*z-y*w),0); m.r[1]=XMVectorSet(2*(x*y-z*w),1-2*(x*x+z*z),2*(y*z+x*w),0); m.r[2]=XMVectorSet(2*(x*z+y*w),2*(y*z-x*w),1-2*(x*x+y*y),0); return m; }
+inline XMMATRIX XMMatrixAffineTransformation(FXMVECTOR s, FXMVECTOR o, FXMVECTOR q, GXMVECTOR t) { XMMATRIX m = XMMatrixScaling(s.v[0],s.v[1],s.v[2]) * XMMatrixRotationQuaternion(q); m.r[3]=XMVectorSet(t.v[0],t.v[1],t.v[2],1); return m; }
+inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eye, FXMVECTOR dir, FXMVECTOR up) {
+  auto norm=[](XMVECTOR v){ float l=sqrtf(v.v[0]*v.v[0]+v.v[1]*v.v[1]+v.v[2]*v.v[2]); XMVECTOR r=v; for(int i=0;i<3;i++) r.v[i]/=l; r.v[3]=0; return r; };
+  auto cross=[](XMVECTOR a, XMVECTOR b){ XMVECTOR r; r.v[0]=a.v[1]*b.v[2]-a.v[2]*b.v[1]; r.v[1]=a.v[2]*b.v[0]-a.v[0]*b.v[2]; r.v[2]=a.v[0]*b.v[1]-a.v[1]*b.v[0]; r.v[3]=0; return r; };
+  auto dot=[](XMVECTOR a, XMVECTOR b){ return a.v[0]*b.v[0]+a.v[1]*b.v[1]+a.v[2]*b.v[2]; };
+  XMVECTOR z=norm(dir); XMVECTOR x=norm(cross(up,z)); XMVECTOR y=cross(z,x);
+  XMMATRIX m=XMMatrixIdentity();
+  for(int i=0;i<3;i++){ m.r[i].v[0]=x.v[i]; m.r[i].v[1]=y.v[i]; m.r[i].v[2]=z.v[i]; m.r[i].v[3]=0; }
+  m.r[3].v[0]=-dot(x,eye); m.r[3].v[1]=-dot(y,eye); m.r[3].v[2]=-dot(z,eye); m.r[3].v[3]=1; return m; }
+inline XMMATRIX XMMatrixPerspectiveFovLH(float fov, float aspect, float n, float f) {
+  float h=1.0f/tanf(fov*0.5f), w=h/aspect, r=f/(f-n); XMMATRIX m; for(int i=0;i<4;i++) for(int j=0;j<4;j++) m.r[i].v[j]=0;
+  m.r[0].v[0]=w; m.r[1].v[1]=h; m.r[2].v[2]=r; m.r[2].v[3]=1; m.r[3].v[2]=-r*n; return m; }
+inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m) { XMVECTOR r; for(int j=0;j<4;j++) r.v[j]=v.v[0]*m.r[0].v[j]+v.v[1]*m.r[1].v[j]+v.v[2]*m.r[2].v[j]+m.r[3].v[j]; return r; }
+inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m) { XMVECTOR r; for(int j=0;j<4;j++) r.v[j]=v.v[0]*m.r[0].v[j]+v.v[1]*m.r[1].v[j]+v.v[2]*m.r[2].v[j]+v.v[3]*m.r[3].v[j]; return r; }
+inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m) { XMVECTOR r = XMVector3Transform(v,m); return r*(1.0f/r.v[3]); }
+inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m) { XMVECTOR r; for(int j=0;j<4;j++) r.v[j]=v.v[0]*m.r[0].v[j]+v.v[1]*m.r[1].v[j]+v.v[2]*m.r[2].v[j]; return r; }
+inline XMVECTOR XMQuaternionIdentity() { return XMVectorSet(0,0,0,1); }
+inline XMVECTOR XMQuaternionRotationAxis(FXMVECTOR a, float ang) { float s=sinf(ang/2); return XMVectorSet(a.v[0]*s,a.v[1]*s,a.v[2]*s,cosf(ang/2)); }
+inline XMVECTOR XMVector3Rotate(FXMVECTOR v, FXMVECTOR q) { return XMVector3Transform(XMVectorSet(v.v[0],v.v[1],v.v[2],0), XMMatrixRotationQuaternion(q)) - XMVectorSet(0,0,0,1); }
+inline float XMConvertToRadians(float d) { return d*XM_PI/180.0f; }
+inline float XMConvertToDegrees(float r) { return r * (180.0f / 3.14159265f); }
+}
@@ -0,0 +1,15 @@
+// Scalar stand-in for DirectXPackedVector.h, see DirectXMath.h in this folder
+#pragma once
+#include <cstring>
+#include <cmath>
+namespace DirectX { namespace PackedVector {
+inline unsigned short XMConvertFloatToHalf(float f) {
+  unsigned int x; memcpy(&x,&f,4);
+  unsigned int sign=(x>>16)&0x8000; int e=((x>>23)&0xff)-127+15; unsigned int m=x&0x7fffff;
+  if(e<=0){ if(e<-10) return sign; m|=0x800000; unsigned int sh=14-e; unsigned int h=m>>sh; if((m>>(sh-1))&1) h++; return sign|h;}
+  if(e>=31) return sign|0x7c00;
+  unsigned int h=sign|(e<<10)|(m>>13); if(m&0x1000) h++; return h; }
+inline float XMConvertHalfToFloat(unsigned short h) {
+  int e=(h>>10)&0x1f; int m=h&0x3ff; float v = e==0? ldexpf((float)m,-24) : ldexpf((float)(m|0x400), e-25);
+  return (h&0x8000)?-v:v; }
+}}
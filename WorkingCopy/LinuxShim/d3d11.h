@@ -0,0 +1,6 @@
+// The few D3D11 types the device independent code names, see DirectXMath.h in this folder
+#pragma once
+typedef int DXGI_FORMAT;
+enum { DXGI_FORMAT_R16G16B16A16_UNORM=1, DXGI_FORMAT_R16G16_SNORM, DXGI_FORMAT_R16G16_FLOAT, DXGI_FORMAT_R16_UINT, DXGI_FORMAT_R32_UINT };
+enum D3D11_INPUT_CLASSIFICATION { D3D11_INPUT_PER_VERTEX_DATA };
+struct D3D11_INPUT_ELEMENT_DESC { const char* SemanticName; unsigned SemanticIndex; DXGI_FORMAT Format; unsigned InputSlot; unsigned AlignedByteOffset; D3D11_INPUT_CLASSIFICATION InputSlotClass; unsigned InstanceDataStepRate; };
@@ -0,0 +1,99 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = (const unsigned char*)view;
+	size = (size_t)fileSize.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data) UnmapViewOfFile(data);
+	if (mappingHandle) CloseHandle((HANDLE)mappingHandle);
+	if (fileHandle) CloseHandle((HANDLE)fileHandle);
+	data = nullptr;
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+	size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const char* filename)
+{
+	Close();
+
+	int file = open(filename, O_RDONLY);
+	if (file < 0) return false;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping keeps the file alive on its own
+	close(file);
+	if (view == MAP_FAILED) return false;
+
+	data = (const unsigned char*)view;
+	size = (size_t)info.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data) munmap((void*)data, size);
+	data = nullptr;
+	size = 0;
+}
+
+#endif
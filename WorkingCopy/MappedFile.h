@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+// --------------------------------------------------------
+// Read only view of a whole file mapped into memory.
+// The data stays valid until Close() or the destructor
+// --------------------------------------------------------
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* filename);
+	void Close();
+
+	inline const unsigned char* GetData() const { return data; }
+	inline size_t GetSize() const { return size; }
+	inline bool IsOpen() const { return data != nullptr; }
+
+private:
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
@@ -8,12 +8,12 @@ Material::Material(shared_ptr<SimpleVertexShader> vertex, shared_ptr<SimplePixel
 {
 	vertexShader = vertex;
 	pixelShader = pixel;
-	texture = tex;
-	normalMap = norm;
+	texture = make_shared<Texture>(tex);
+	normalMap = make_shared<Texture>(norm);
 	samplerOptions = opt;
 	shininess = shine;
-	roughness = rough;
-	metalness = metal;
+	roughness = make_shared<Texture>(rough);
+	metalness = make_shared<Texture>(metal);
 	usePBR = 1;
 }
 
@@ -21,8 +21,8 @@ Material::Material(shared_ptr<SimpleVertexShader> vertex, shared_ptr<SimplePixel
 {
 		vertexShader = vertex;
 		pixelShader = pixel;
-		texture = tex;
-		normalMap = norm;
+		texture = make_shared<Texture>(tex);
+		normalMap = make_shared<Texture>(norm);
 		samplerOptions = opt;
 		shininess = shine;
 		usePBR = 1;
@@ -47,37 +47,34 @@ void Material::SetUsePBR(int val)
 	usePBR = val;
 }
 
-void Material::AddTextureProperties(const wchar_t* file, MATERIAL_FEATURES options)
+shared_ptr<Texture>& Material::GetTextureSlot(MATERIAL_FEATURES options)
 {
-	// new CreateWICTextureFromFileEx doe gamma correction on hardware automaticcaly and faster
 	switch (options)
 	{
-	case MATERIAL_FEATURES::METALNESS:
-	{
-		CreateWICTextureFromFileEx(device, context, file, 0,D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0,0, WIC_LOADER_FORCE_SRGB, nullptr , &metalness);
-		break;
+	case MATERIAL_FEATURES::METALNESS: return metalness;
+	case MATERIAL_FEATURES::NORMAL_MAP: return normalMap;
+	case MATERIAL_FEATURES::ROUGHNESS: return roughness;
+	default: return texture;
 	}
+}
 
+void Material::AddTextureProperties(const wchar_t* file, MATERIAL_FEATURES options)
+{
+	shared_ptr<Texture>& slot = GetTextureSlot(options);
 
-	case MATERIAL_FEATURES::NORMAL_MAP:
-	{
-		CreateWICTextureFromFileEx(device, context, file, 0, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, WIC_LOADER_FORCE_SRGB, nullptr, &normalMap);
-		break;
-	}
-
-	case MATERIAL_FEATURES::ROUGHNESS:
-	{
-		CreateWICTextureFromFileEx(device, context, file, 0, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, WIC_LOADER_FORCE_SRGB, nullptr, &roughness);
-		break;
-	}
-	default:
+	if (textures == nullptr)
 	{
-		CreateWICTextureFromFileEx(device, context, file, 0, D3D11_USAGE_DEFAULT, D3D11_BIND_SHADER_RESOURCE, 0, 0, WIC_LOADER_FORCE_SRGB, nullptr, &texture);
-		break;
+		slot = Texture::Load(device, context, file, true, D3D11_USAGE_DEFAULT);
+		return;
 	}
 
-	}
-		 
+	// asset paths are plain ASCII, so narrowing is enough for the key
+	std::wstring path(file);
+	TextureKey key;
+	key.path = std::string(path.begin(), path.end());
+	key.srgb = true;
+	key.usage = D3D11_USAGE_DEFAULT;
+	slot = textures->Get(key);
 }
 
 void Material::PrepareMaterial(DirectX::XMFLOAT4X4 shadowView, DirectX::XMFLOAT4X4 shadowProj, ComPtr<ID3D11ShaderResourceView> shadowMap, ComPtr<ID3D11SamplerState> shadowSample)
@@ -87,36 +84,40 @@ void Material::PrepareMaterial(DirectX::XMFLOAT4X4 shadowView, DirectX::XMFLOAT4
 		//  - This is actually a complex process of copying data to a local buffer
 		//    and then copying that entire buffer to the GPU.  
 		//  - The "SimpleShader" class handles all of that for you.
-	// might remove
-	vertexShader->SetMatrix4x4("shadowView", shadowView);
-	vertexShader->SetMatrix4x4("shadowProjection", shadowProj);
-
-	if (shininess) pixelShader->SetFloat("shininess", shininess);
-	pixelShader->SetFloat3("specularColor", specColor);
-	pixelShader->SetShaderResourceView("roughnessMap", roughness.Get());
-	pixelShader->SetShaderResourceView("metalnessMap", metalness.Get());
-	pixelShader->SetShaderResourceView("diffuseTexture", texture.Get());
-	pixelShader->SetShaderResourceView("normalMap", normalMap.Get());
-	pixelShader->SetSamplerState("basicSampler", samplerOptions.Get());
-	pixelShader->SetShaderResourceView("shadowMap", shadowMap.Get());
-	pixelShader->SetSamplerState("shadowSampler", shadowSample.Get());
-	pixelShader->SetInt("UsePBR", usePBR);
-
+	PrepareShaders(shadowView, shadowProj);
+	PreparePixelShader(shadowMap, shadowSample);
 
 	// Once you've set all of the data you care to change for
 	// the next draw call, you need to actually send it to the GPU
 	//  - If you skip this, the "SetMatrix" calls above won't make it to the GPU!
 	vertexShader->CopyAllBufferData();
-	pixelShader->CopyAllBufferData();
+}
+
+void Material::PrepareShaders(DirectX::XMFLOAT4X4 shadowView, DirectX::XMFLOAT4X4 shadowProj)
+{
+	// might remove
+	vertexShader->SetMatrix4x4("shadowView", shadowView);
+	vertexShader->SetMatrix4x4("shadowProjection", shadowProj);
 
 	// Set the vertex and pixel shaders to use for the next Draw() command
-	//  - These don't technically need to be set every frame...YET
 	//  - Once you start applying different shaders to different objects,
 	//    you'll need to swap the current shaders before each draw
 	vertexShader->SetShader();
 	pixelShader->SetShader();
 }
 
+void Material::PreparePixelShader(ComPtr<ID3D11ShaderResourceView> shadowMap, ComPtr<ID3D11SamplerState> shadowSample)
+{
+	if (shininess) pixelShader->SetFloat("shininess", shininess);
+	pixelShader->SetFloat3("specularColor", specColor);
+	pixelShader->SetShaderResourceView("roughnessMap", GetRoughness().Get());
+	pixelShader->SetShaderResourceView("metalnessMap", GetMetalness().Get());
+	pixelShader->SetShaderResourceView("diffuseTexture", GetTexture().Get());
+	pixelShader->SetShaderResourceView("normalMap", GetNormalMap().Get());
+	pixelShader->SetSamplerState("basicSampler", samplerOptions.Get());
+	pixelShader->SetShaderResourceView("shadowMap", shadowMap.Get());
+	pixelShader->SetSamplerState("shadowSampler", shadowSample.Get());
+	pixelShader->SetInt("UsePBR", usePBR);
 
-
-
+	pixelShader->CopyAllBufferData();
+}
@@ -7,6 +7,8 @@
 #include <memory>
 #include "Camera.h"
 #include "Lights.h"
+#include "Texture.h"
+#include "TextureCache.h"
 
 using namespace std;
 using namespace DirectX;
@@ -39,35 +41,45 @@ public:
 	void SetPixelShader(shared_ptr<SimplePixelShader> p);
 	void SetUsePBR(int val);
 	void AddTextureProperties(const wchar_t* file, MATERIAL_FEATURES options);
+	// textures added while a cache is set are shared with every other material using it
+	inline void SetTextureCache(TextureCache<Texture>* _textures) { textures = _textures; }
 
 
 	// getters
 	inline shared_ptr<SimpleVertexShader> GetVertexShader() const { return vertexShader; }
 	inline shared_ptr<SimplePixelShader> GetPixelShader() const { return pixelShader; }
-	inline ComPtr<ID3D11ShaderResourceView> GetTexture() const { return texture; }
-	inline ComPtr<ID3D11ShaderResourceView> GetNormalMap() const { return normalMap; }
+	inline ComPtr<ID3D11ShaderResourceView> GetTexture() const { return GetSRV(texture); }
+	inline ComPtr<ID3D11ShaderResourceView> GetNormalMap() const { return GetSRV(normalMap); }
 	inline ComPtr<ID3D11SamplerState> GetSampler() const { return samplerOptions; }
 	inline float GetShininess() const { return shininess; }
 	inline ComPtr<ID3D11ShaderResourceView> GetSkySRV() const { return skySRV; }
 	inline ComPtr<ID3D11RasterizerState> GetSkyRastState() const { return skyRastState; }
 	inline ComPtr<ID3D11DepthStencilState> GetSkyDepthState() const { return skyDepthState; }
 	inline ComPtr< ID3D11SamplerState> GetSkySamplerState() const { return skySamplerOpt; }
-	inline ComPtr< ID3D11ShaderResourceView> GetRoughness() const { return roughness; }
-	inline ComPtr<ID3D11ShaderResourceView> GetMetalness() const { return metalness; }
+	inline ComPtr< ID3D11ShaderResourceView> GetRoughness() const { return GetSRV(roughness); }
+	inline ComPtr<ID3D11ShaderResourceView> GetMetalness() const { return GetSRV(metalness); }
 	inline DirectX::XMFLOAT3 GetSpecularColor() const { return specColor; }
 	void PrepareMaterial(DirectX::XMFLOAT4X4 shadowView, DirectX::XMFLOAT4X4 shadowProj, ComPtr<ID3D11ShaderResourceView> shadowMap, ComPtr<ID3D11SamplerState> shadowSample);
+	// the same in two halves, for drawing many things with one material. sets both
+	// shaders and the vertex shader's shadow matrices, nothing is uploaded
+	void PrepareShaders(DirectX::XMFLOAT4X4 shadowView, DirectX::XMFLOAT4X4 shadowProj);
+	// sets the textures and values the pixel shader needs and uploads its buffers
+	void PreparePixelShader(ComPtr<ID3D11ShaderResourceView> shadowMap, ComPtr<ID3D11SamplerState> shadowSample);
 
 
 protected:
+	shared_ptr<Texture>& GetTextureSlot(MATERIAL_FEATURES options);
+	static inline ComPtr<ID3D11ShaderResourceView> GetSRV(const shared_ptr<Texture>& slot) { return slot ? slot->GetSRV() : nullptr; }
 
 	// shader pointers
 	shared_ptr<SimpleVertexShader> vertexShader;
 	shared_ptr<SimplePixelShader> pixelShader;
-	ComPtr<ID3D11ShaderResourceView> texture;
-	ComPtr<ID3D11ShaderResourceView> normalMap;
+	// textures can be shared with other materials through the texture cache
+	shared_ptr<Texture> texture;
+	shared_ptr<Texture> normalMap;
 	ComPtr<ID3D11SamplerState> samplerOptions;
-	ComPtr<ID3D11ShaderResourceView> roughness;
-	ComPtr<ID3D11ShaderResourceView> metalness;
+	shared_ptr<Texture> roughness;
+	shared_ptr<Texture> metalness;
 	// Sky stuff
 	ComPtr<ID3D11SamplerState> skySamplerOpt;
 	ComPtr<ID3D11ShaderResourceView> skySRV;
@@ -81,5 +93,7 @@ protected:
 	ID3D11Device* device;
 
 	int usePBR;
+
+	TextureCache<Texture>* textures = nullptr;
 };
 
@@ -1,4 +1,5 @@
 #include "Mesh.h"
+#include "TangentGenerator.h"
 
 Mesh::Mesh() {
 
@@ -6,224 +7,70 @@ Mesh::Mesh() {
 
 Mesh::Mesh(Vertex* verts, int numVerts, unsigned int* indexes, int numIndices, ID3D11Device* device)
 {
-	CalculateTangents(&verts[0], numVerts, &indexes[0], numIndices);
+	TangentGenerator::Generate(&verts[0], numVerts, &indexes[0], numIndices);
+	CreateBuffers(verts, numVerts, indexes, numIndices, device);
 
-	// create the vertex buffer using the supplied vertices
-	D3D11_BUFFER_DESC vbd;
-	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex) * numVerts;
-	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	vbd.CPUAccessFlags = 0;
-	vbd.MiscFlags = 0;
-	vbd.StructureByteStride = 0;
-
-	// Create the proper struct to hold the initial vertex data
-	D3D11_SUBRESOURCE_DATA initialVertexData;
-	initialVertexData.pSysMem = verts;
-
-	// Actually create the buffer with the initial data
-	device->CreateBuffer(&vbd, &initialVertexData, &vertexBuffer);
-
-	// set the number of indices
-	this->numIndices = numIndices;
+	// loaded meshes get theirs from the MeshSource
+	DirectX::XMFLOAT3 boundsMin = verts[0].Position;
+	DirectX::XMFLOAT3 boundsMax = verts[0].Position;
+	for (int i = 1; i < numVerts; i++)
+	{
+		const DirectX::XMFLOAT3& p = verts[i].Position;
+		boundsMin = DirectX::XMFLOAT3(fminf(boundsMin.x, p.x), fminf(boundsMin.y, p.y), fminf(boundsMin.z, p.z));
+		boundsMax = DirectX::XMFLOAT3(fmaxf(boundsMax.x, p.x), fmaxf(boundsMax.y, p.y), fmaxf(boundsMax.z, p.z));
+	}
+	bounds = Bounds::FromMinMax(boundsMin, boundsMax);
 
-	// create the index buffer
-	D3D11_BUFFER_DESC ibd;
-	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = sizeof(int) * this->numIndices;
-	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibd.CPUAccessFlags = 0;
-	ibd.MiscFlags = 0;
-	ibd.StructureByteStride = 0;
+	// small enough to be its own occluder
+	for (int i = 0; i < numVerts; i++) occluder.positions.push_back(verts[i].Position);
+	occluder.indices.assign(indexes, indexes + numIndices);
+}
 
-	// Create the proper struct to hold the initial index data
-	D3D11_SUBRESOURCE_DATA initialIndexData;
-	initialIndexData.pSysMem = indexes;
+Mesh::Mesh(const char* filename, ID3D11Device* device, VERTEX_FORMAT format)
+{
+	MeshSource source;
+	if (source.Load(filename, format))
+	{
+		Upload(source, device);
+	}
+}
 
-	// Actually create the buffer with the initial data
-	device->CreateBuffer(&ibd, &initialIndexData, &indexBuffer);
+void Mesh::Upload(const MeshSource& source, ID3D11Device* device)
+{
+	// cooked data is handed straight from the mapped file to the buffers
+	CreateBuffers(source.GetVertices(), source.GetVertexStride(), source.GetVertexCount(), source.GetIndices(), source.GetIndexStride(), source.GetIndexCount(), device);
+	lods.assign(source.GetLods(), source.GetLods() + source.GetLodCount());
+	vertexFormat = source.GetVertexFormat();
+	quantization = source.GetQuantization();
+	bounds = source.GetBounds();
+	source.BuildOccluder(occluder);
 }
 
-Mesh::Mesh(const char* filename, ID3D11Device* device)
+void Mesh::CreateBuffers(Vertex* verts, int numVerts, unsigned int* indexes, int numIndices, ID3D11Device* device)
 {
-	// File input object
-	std::ifstream obj(filename);
+	if (numVerts <= 0 || numIndices <= 0) return;
 
-	// Check for successful open
-	if (!obj.is_open())
+	// halve the index buffer when every index fits in 16 bits
+	if (numVerts <= 0xFFFF)
 	{
-		printf("Failed to open file.");
-		return;
+		std::vector<unsigned short> shortIndices(indexes, indexes + numIndices);
+		CreateBuffers(verts, sizeof(Vertex), numVerts, &shortIndices[0], sizeof(unsigned short), numIndices, device);
 	}
-		
-	
-	// Variables used while reading the file
-	std::vector<DirectX::XMFLOAT3> positions;     // Positions from the file
-	std::vector<DirectX::XMFLOAT3> normals;       // Normals from the file
-	std::vector<DirectX::XMFLOAT2> uvs;           // UVs from the file
-	std::vector<Vertex> verts;           // Verts we're assembling
-	std::vector<UINT> indices;           // Indices of these verts
-	unsigned int vertCounter = 0;        // Count of vertices/indices
-	char chars[100];                     // String for line reading
-	
-	// Still have data left?
-	while (obj.good())
+	else
 	{
-		// Get the line (100 characters should be more than enough)
-		obj.getline(chars, 100);
-
-		// Check the type of line
-		if (chars[0] == 'v' && chars[1] == 'n')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			DirectX::XMFLOAT3 norm;
-			sscanf_s(
-				chars,
-				"vn %f %f %f",
-				&norm.x, &norm.y, &norm.z);
-
-			// Add to the list of normals
-			normals.push_back(norm);
-		}
-		else if (chars[0] == 'v' && chars[1] == 't')
-		{
-			// Read the 2 numbers directly into an XMFLOAT2
-			DirectX::XMFLOAT2 uv;
-			sscanf_s(
-				chars,
-				"vt %f %f",
-				&uv.x, &uv.y);
-
-			// Add to the list of uv's
-			uvs.push_back(uv);
-		}
-		else if (chars[0] == 'v')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			DirectX::XMFLOAT3 pos;
-			sscanf_s(
-				chars,
-				"v %f %f %f",
-				&pos.x, &pos.y, &pos.z);
-
-			// Add to the positions
-			positions.push_back(pos);
-		}
-		else if (chars[0] == 'f')
-		{
-			// Read the face indices into an array
-			unsigned int i[12];
-			int facesRead = sscanf_s(
-				chars,
-				"f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-				&i[0], &i[1], &i[2],
-				&i[3], &i[4], &i[5],
-				&i[6], &i[7], &i[8],
-				&i[9], &i[10], &i[11]);
-
-			// - Create the verts by looking up
-			//    corresponding data from vectors
-			// - OBJ File indices are 1-based, so
-			//    they need to be adusted
-			Vertex v1;
-			v1.Position = positions[i[0] - 1];
-			v1.UV = uvs[i[1] - 1];
-			v1.Normal = normals[i[2] - 1];
-
-			Vertex v2;
-			v2.Position = positions[i[3] - 1];
-			v2.UV = uvs[i[4] - 1];
-			v2.Normal = normals[i[5] - 1];
-
-			Vertex v3;
-			v3.Position = positions[i[6] - 1];
-			v3.UV = uvs[i[7] - 1];
-			v3.Normal = normals[i[8] - 1];
-
-			// The model is most likely in a right-handed space,
-			// especially if it came from Maya.  We want to convert
-			// to a left-handed space for DirectX.  This means we 
-			// need to:
-			//  - Invert the Z position
-			//  - Invert the normal's Z
-			//  - Flip the winding order
-			// We also need to flip the UV coordinate since DirectX
-			// defines (0,0) as the top left of the texture, and many
-			// 3D modeling packages use the bottom left as (0,0)
-
-			// Flip the UV's since they're probably "upside down"
-			v1.UV.y = 1.0f - v1.UV.y;
-			v2.UV.y = 1.0f - v2.UV.y;
-			v3.UV.y = 1.0f - v3.UV.y;
-
-			// Flip Z (LH vs. RH)
-			v1.Position.z *= -1.0f;
-			v2.Position.z *= -1.0f;
-			v3.Position.z *= -1.0f;
-
-			// Flip normal Z
-			v1.Normal.z *= -1.0f;
-			v2.Normal.z *= -1.0f;
-			v3.Normal.z *= -1.0f;
-
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-
-			// Add three more indices
-			indices.push_back(vertCounter); vertCounter += 1;
-			indices.push_back(vertCounter); vertCounter += 1;
-			indices.push_back(vertCounter); vertCounter += 1;
-
-			// Was there a 4th face?
-			if (facesRead == 12)
-			{
-				// Make the last vertex
-				Vertex v4;
-				v4.Position = positions[i[9] - 1];
-				v4.UV = uvs[i[10] - 1];
-				v4.Normal = normals[i[11] - 1];
-
-				// Flip the UV, Z pos and normal
-				v4.UV.y = 1.0f - v4.UV.y;
-				v4.Position.z *= -1.0f;
-				v4.Normal.z *= -1.0f;
-
-				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-
-				// Add three more indices
-				indices.push_back(vertCounter); vertCounter += 1;
-				indices.push_back(vertCounter); vertCounter += 1;
-				indices.push_back(vertCounter); vertCounter += 1;
-			}
-		}
+		CreateBuffers(verts, sizeof(Vertex), numVerts, indexes, sizeof(unsigned int), numIndices, device);
 	}
+}
 
-	// Close the file and create the actual buffers
-	obj.close();
-
-	CalculateTangents(&verts[0], vertCounter, &indices[0], vertCounter);
-
-
-	// - At this point, "verts" is a vector of Vertex structs, and can be used
-	//    directly to create a vertex buffer:  &verts[0] is the address of the first vert
-	//
-	// - The vector "indices" is similar. It's a vector of unsigned ints and
-	//    can be used directly for the index buffer: &indices[0] is the address of the first int
-	//
-	// - "vertCounter" is BOTH the number of vertices and the number of indices
-	// - Yes, the indices are a bit redundant here (one per vertex).  Could you skip using
-	//    an index buffer in this case?  Sure!  Though, if your mesh class assumes you have
-	//    one, you'll need to write some extra code to handle cases when you don't.
+void Mesh::CreateBuffers(const void* verts, unsigned int vertexStride, int numVerts, const void* indexes, unsigned int indexStride, int numIndices, ID3D11Device* device)
+{
+	// D3D can't make empty buffers, without any the mesh just stays unloaded
+	if (numVerts <= 0 || numIndices <= 0) return;
 
 	// create the vertex buffer using the supplied vertices
 	D3D11_BUFFER_DESC vbd;
 	vbd.Usage = D3D11_USAGE_IMMUTABLE;
-	vbd.ByteWidth = sizeof(Vertex) * vertCounter;
+	vbd.ByteWidth = vertexStride * numVerts;
 	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	vbd.CPUAccessFlags = 0;
 	vbd.MiscFlags = 0;
@@ -231,18 +78,25 @@ Mesh::Mesh(const char* filename, ID3D11Device* device)
 
 	// Create the proper struct to hold the initial vertex data
 	D3D11_SUBRESOURCE_DATA initialVertexData;
-	initialVertexData.pSysMem = &verts[0];
+	initialVertexData.pSysMem = verts;
 
 	// Actually create the buffer with the initial data
 	device->CreateBuffer(&vbd, &initialVertexData, &vertexBuffer);
 
-	// set the number of indices
-	this->numIndices = vertCounter;
+	// set the number of indices and vertices
+	this->numIndices = numIndices;
+	this->numVertices = numVerts;
+	this->vertexStride = vertexStride;
+
+	// everything is LOD 0 unless the source says otherwise
+	lods.assign(1, MeshLod{ 0, (unsigned int)numIndices, 0.0f });
+
+	indexFormat = indexStride == sizeof(unsigned short) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
 
 	// create the index buffer
 	D3D11_BUFFER_DESC ibd;
 	ibd.Usage = D3D11_USAGE_IMMUTABLE;
-	ibd.ByteWidth = sizeof(int) * this->numIndices;
+	ibd.ByteWidth = GetIndexStride() * this->numIndices;
 	ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	ibd.CPUAccessFlags = 0;
 	ibd.MiscFlags = 0;
@@ -250,7 +104,7 @@ Mesh::Mesh(const char* filename, ID3D11Device* device)
 
 	// Create the proper struct to hold the initial index data
 	D3D11_SUBRESOURCE_DATA initialIndexData;
-	initialIndexData.pSysMem = &indices[0];
+	initialIndexData.pSysMem = indexes;
 
 	// Actually create the buffer with the initial data
 	device->CreateBuffer(&ibd, &initialIndexData, &indexBuffer);
@@ -275,77 +129,26 @@ ID3D11Buffer* Mesh::GetIndexBuffer()
 
 int Mesh::GetIndexCount()
 {
-	return numIndices;
+	return lods.empty() ? 0 : (int)lods[0].indexCount;
 }
 
-void Mesh::CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices)
+int Mesh::GetVertexCount()
 {
-	// Reset tangents
-	for (int i = 0; i < numVerts; i++)
-	{
-		verts[i].Tangent = DirectX::XMFLOAT3(0, 0, 0);
-	}
-
-	// Calculate tangents one whole triangle at a time
-	for (int i = 0; i < numVerts;)
-	{
-		// Grab indices and vertices of first triangle
-		unsigned int i1 = indices[i++];
-		unsigned int i2 = indices[i++];
-		unsigned int i3 = indices[i++];
-		Vertex* v1 = &verts[i1];
-		Vertex* v2 = &verts[i2];
-		Vertex* v3 = &verts[i3];
-
-		// Calculate vectors relative to triangle positions
-		float x1 = v2->Position.x - v1->Position.x;
-		float y1 = v2->Position.y - v1->Position.y;
-		float z1 = v2->Position.z - v1->Position.z;
-
-		float x2 = v3->Position.x - v1->Position.x;
-		float y2 = v3->Position.y - v1->Position.y;
-		float z2 = v3->Position.z - v1->Position.z;
-
-		// Do the same for vectors relative to triangle uv's
-		float s1 = v2->UV.x - v1->UV.x;
-		float t1 = v2->UV.y - v1->UV.y;
-
-		float s2 = v3->UV.x - v1->UV.x;
-		float t2 = v3->UV.y - v1->UV.y;
-
-		// Create vectors for tangent calculation
-		float r = 1.0f / (s1 * t2 - s2 * t1);
-
-		float tx = (t2 * x1 - t1 * x2) * r;
-		float ty = (t2 * y1 - t1 * y2) * r;
-		float tz = (t2 * z1 - t1 * z2) * r;
-
-		// Adjust tangents of each vert of the triangle
-		v1->Tangent.x += tx;
-		v1->Tangent.y += ty;
-		v1->Tangent.z += tz;
-
-		v2->Tangent.x += tx;
-		v2->Tangent.y += ty;
-		v2->Tangent.z += tz;
-
-		v3->Tangent.x += tx;
-		v3->Tangent.y += ty;
-		v3->Tangent.z += tz;
-	}
+	return numVertices;
+}
 
-	// Ensure all of the tangents are orthogonal to the normals
-	for (int i = 0; i < numVerts; i++)
-	{
-		// Grab the two vectors
-		DirectX::XMVECTOR normal =  XMLoadFloat3(&verts[i].Normal);
-		DirectX::XMVECTOR tangent =  XMLoadFloat3(&verts[i].Tangent);
+DXGI_FORMAT Mesh::GetIndexFormat()
+{
+	return indexFormat;
+}
 
-		// Use Gram-Schmidt orthogonalize
-		tangent = DirectX::XMVector3Normalize(
-			DirectX::XMVectorSubtract(tangent,DirectX::XMVectorMultiply(normal,DirectX::XMVector3Dot(normal, tangent))));
+unsigned int Mesh::GetIndexStride() const
+{
+	return indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int);
+}
 
-		// Store the tangent
-		XMStoreFloat3(&verts[i].Tangent, tangent);
-	}
+size_t Mesh::GetByteSize() const
+{
+	// size of the vertex and index buffers on the GPU
+	return vertexStride * numVertices + GetIndexStride() * numIndices;
 }
@@ -2,8 +2,9 @@
 
 #include "DXCore.h"
 #include "Vertex.h"
+#include "MeshSource.h"
+#include "Bounds.h"
 #include <DirectXMath.h>
-#include <fstream>
 #include <vector>
 #include <d3d11.h>
 
@@ -12,20 +13,54 @@ class Mesh
 public:
 	Mesh();
 	Mesh(Vertex* verts, int numVerts, unsigned int* indexes, int numIndices, ID3D11Device* device);
-	Mesh(const char* filename, ID3D11Device* device);
+	Mesh(const char* filename, ID3D11Device* device, VERTEX_FORMAT format = VERTEX_FORMAT::FULL);
 	~Mesh();
 
+	// creates the buffers for data loaded on another thread
+	void Upload(const MeshSource& source, ID3D11Device* device);
+
+	// false until it has buffers, and for good if the file couldn't be loaded
+	inline bool IsLoaded() const { return vertexBuffer != nullptr && indexBuffer != nullptr; }
+
 	// helper functions
 	ID3D11Buffer* GetVertexBuffer();
 	ID3D11Buffer* GetIndexBuffer();
+	// indices in LOD 0, the full detail mesh
 	int GetIndexCount();
+	int GetVertexCount();
+	// sizeof(Vertex) or sizeof(PackedVertex), for IASetVertexBuffers
+	inline unsigned int GetVertexStride() const { return vertexStride; }
+	inline VERTEX_FORMAT GetVertexFormat() const { return vertexFormat; }
+	inline const VertexQuantization& GetQuantization() const { return quantization; }
+	inline int GetLodCount() const { return (int)lods.size(); }
+	inline const MeshLod& GetLod(int lod) const { return lods[lod]; }
+	// model space, worked out when it's loaded
+	inline const Bounds& GetBounds() const { return bounds; }
+	// a CPU copy of a coarse LOD for the OcclusionCuller
+	inline const OccluderMesh& GetOccluder() const { return occluder; }
+	DXGI_FORMAT GetIndexFormat();
+	size_t GetByteSize() const;
 private:
-	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
+	unsigned int GetIndexStride() const;
+	void CreateBuffers(Vertex* verts, int numVerts, unsigned int* indexes, int numIndices, ID3D11Device* device);
+	void CreateBuffers(const void* verts, unsigned int vertexStride, int numVerts, const void* indexes, unsigned int indexStride, int numIndices, ID3D11Device* device);
 	// the vertex and index buffers
-	ID3D11Buffer* vertexBuffer;
-	ID3D11Buffer* indexBuffer;
+	ID3D11Buffer* vertexBuffer = nullptr;
+	ID3D11Buffer* indexBuffer = nullptr;
 
-	// how many indices are in the index buffer
-	int numIndices;
+	// how many indices are in the index buffer, counting every LOD
+	int numIndices = 0;
+	// which part of the index buffer each LOD draws
+	std::vector<MeshLod> lods;
+	// how many vertices are in the vertex buffer
+	int numVertices = 0;
+	// and what kind they are
+	unsigned int vertexStride = sizeof(Vertex);
+	VERTEX_FORMAT vertexFormat = VERTEX_FORMAT::FULL;
+	VertexQuantization quantization;
+	Bounds bounds;
+	OccluderMesh occluder;
+	// 16 bit indices are used whenever the vertex count allows it
+	DXGI_FORMAT indexFormat = DXGI_FORMAT_R32_UINT;
 };
 
@@ -0,0 +1,193 @@
+#include "MeshBinary.h"
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cfloat>
+#include <sys/stat.h>
+
+using namespace DirectX;
+
+bool CookedMesh::Open(const char* filename, VERTEX_FORMAT format)
+{
+	Close();
+	if (!file.Open(filename)) return false;
+
+	// don't keep a file mapped that won't be used, the cooker is about to write over it
+	if (!IsValid(format))
+	{
+		file.Close();
+		return false;
+	}
+
+	header = (const MeshBinaryHeader*)file.GetData();
+	return true;
+}
+
+void CookedMesh::Close()
+{
+	header = nullptr;
+	file.Close();
+}
+
+bool CookedMesh::IsValid(VERTEX_FORMAT format) const
+{
+	// make sure this is a complete file written by this version of the game
+	if (file.GetSize() < sizeof(MeshBinaryHeader)) return false;
+	const MeshBinaryHeader* h = (const MeshBinaryHeader*)file.GetData();
+	if (memcmp(h->magic, "MBIN", 4) != 0) return false;
+	if (h->version != MESH_BINARY_VERSION || h->vertexFormat != (unsigned int)format) return false;
+	if (h->vertexStride != (format == VERTEX_FORMAT::PACKED ? sizeof(PackedVertex) : sizeof(Vertex))) return false;
+	if (h->indexStride != 2 && h->indexStride != 4) return false;
+	if (h->vertexCount == 0 || h->indexCount == 0) return false;
+	if (h->vertexOffset + (unsigned long long)h->vertexCount * h->vertexStride > file.GetSize()) return false;
+	if (h->indexOffset + (unsigned long long)h->indexCount * h->indexStride > file.GetSize()) return false;
+	if (h->lodCount == 0 || h->lodCount > MESH_MAX_LODS) return false;
+	if (h->lodOffset + (unsigned long long)h->lodCount * sizeof(MeshLod) > file.GetSize()) return false;
+
+	// every LOD has to stay inside the index data
+	const MeshLod* lods = (const MeshLod*)(file.GetData() + h->lodOffset);
+	for (unsigned int i = 0; i < h->lodCount; i++)
+	{
+		if ((unsigned long long)lods[i].indexStart + lods[i].indexCount > h->indexCount) return false;
+	}
+	return true;
+}
+
+bool CookedMesh::IsBuiltFrom(unsigned long long sourceSize, unsigned long long sourceChecksum) const
+{
+	return header != nullptr && header->sourceSize == sourceSize && header->sourceChecksum == sourceChecksum;
+}
+
+bool CookedMesh::IsStampedWith(unsigned long long sourceSize, unsigned long long sourceTime) const
+{
+	return header != nullptr && header->sourceSize == sourceSize && header->sourceTime == sourceTime;
+}
+
+std::string MeshBinary::GetCookedPath(const char* sourcePath, VERTEX_FORMAT format)
+{
+	std::string path(sourcePath);
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	// only strip an extension that belongs to the file name
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+	{
+		path.erase(dot);
+	}
+	return path + (format == VERTEX_FORMAT::PACKED ? ".packed.meshbin" : ".meshbin");
+}
+
+unsigned long long MeshBinary::Checksum(const unsigned char* data, size_t size)
+{
+	unsigned long long hash = 0xCBF29CE484222325ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= data[i];
+		hash *= 0x100000001B3ull;
+	}
+	return hash;
+}
+
+bool MeshBinary::ChecksumFile(const char* filename, unsigned long long* size, unsigned long long* checksum)
+{
+	MappedFile source;
+	if (!source.Open(filename)) return false;
+
+	*size = source.GetSize();
+	*checksum = Checksum(source.GetData(), source.GetSize());
+	return true;
+}
+
+bool MeshBinary::StatFile(const char* filename, unsigned long long* size, unsigned long long* time)
+{
+#ifdef _WIN32
+	struct _stat64 info;
+	if (_stat64(filename, &info) != 0) return false;
+	*time = (unsigned long long)info.st_mtime * 1000000000ull;
+#else
+	struct stat info;
+	if (stat(filename, &info) != 0) return false;
+	*time = (unsigned long long)info.st_mtim.tv_sec * 1000000000ull + (unsigned long long)info.st_mtim.tv_nsec;
+#endif
+	*size = (unsigned long long)info.st_size;
+	return true;
+}
+
+bool MeshBinary::Write(const char* filename, const std::vector<Vertex>& verts, const std::vector<unsigned int>& indices,
+	const std::vector<MeshLod>& lods, VERTEX_FORMAT format, unsigned long long sourceSize, unsigned long long sourceChecksum,
+	unsigned long long sourceTime)
+{
+	if (verts.empty() || indices.empty() || lods.empty() || lods.size() > MESH_MAX_LODS) return false;
+
+	MeshBinaryHeader header = {};
+	memcpy(header.magic, "MBIN", 4);
+	header.version = MESH_BINARY_VERSION;
+	header.vertexFormat = (unsigned int)format;
+	header.vertexStride = format == VERTEX_FORMAT::PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+	header.vertexCount = (unsigned int)verts.size();
+	header.indexStride = verts.size() <= 0xFFFF ? 2 : 4;
+	header.indexCount = (unsigned int)indices.size();
+	header.sourceSize = sourceSize;
+	header.sourceChecksum = sourceChecksum;
+	header.sourceTime = sourceTime;
+	header.vertexOffset = sizeof(MeshBinaryHeader);
+	header.indexOffset = header.vertexOffset + (unsigned long long)verts.size() * header.vertexStride;
+	// keep the LOD table 4 byte aligned after 16 bit indices
+	header.lodOffset = (header.indexOffset + (unsigned long long)indices.size() * header.indexStride + 3) & ~3ull;
+	header.lodCount = (unsigned int)lods.size();
+
+	GetBounds(verts, &header.boundsMin, &header.boundsMax);
+
+	std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+	{
+		printf("Failed to write cooked mesh %s.\n", filename);
+		return false;
+	}
+
+	out.write((const char*)&header, sizeof(header));
+	if (format == VERTEX_FORMAT::PACKED)
+	{
+		std::vector<PackedVertex> packed(verts.size());
+		VertexPacker::Pack(&verts[0], verts.size(), VertexPacker::GetQuantization(header.boundsMin, header.boundsMax), &packed[0]);
+		out.write((const char*)&packed[0], sizeof(PackedVertex) * packed.size());
+	}
+	else
+	{
+		out.write((const char*)&verts[0], sizeof(Vertex) * verts.size());
+	}
+	if (header.indexStride == 2)
+	{
+		std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+		out.write((const char*)&shortIndices[0], sizeof(unsigned short) * shortIndices.size());
+	}
+	else
+	{
+		out.write((const char*)&indices[0], sizeof(unsigned int) * indices.size());
+	}
+
+	const char padding[4] = {};
+	unsigned long long written = header.indexOffset + (unsigned long long)indices.size() * header.indexStride;
+	out.write(padding, header.lodOffset - written);
+	out.write((const char*)&lods[0], sizeof(MeshLod) * lods.size());
+
+	bool ok = out.good();
+	out.close();
+
+	// a half written file would fail the size checks anyway, but don't leave it around
+	if (!ok) remove(filename);
+	return ok;
+}
+
+void MeshBinary::GetBounds(const std::vector<Vertex>& verts, XMFLOAT3* boundsMin, XMFLOAT3* boundsMax)
+{
+	XMVECTOR low = XMVectorReplicate(FLT_MAX);
+	XMVECTOR high = XMVectorReplicate(-FLT_MAX);
+	for (size_t i = 0; i < verts.size(); i++)
+	{
+		XMVECTOR pos = XMLoadFloat3(&verts[i].Position);
+		low = XMVectorMin(low, pos);
+		high = XMVectorMax(high, pos);
+	}
+	XMStoreFloat3(boundsMin, low);
+	XMStoreFloat3(boundsMax, high);
+}
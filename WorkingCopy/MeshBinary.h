@@ -0,0 +1,117 @@
+#pragma once
+
+#include "Vertex.h"
+#include "PackedVertex.h"
+#include "MappedFile.h"
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+// bump whenever the layout of the file or of Vertex changes,
+// or when the cooked data itself is built differently
+// 2: tangents no longer NaN/zero on triangles without UVs
+// 3: triangles and vertices reordered by MeshOptimizer
+// 4: LOD table
+// 5: optional packed vertices
+// 6: source modification time
+// 7: LODs collapse seams and borders instead of locking them
+#define MESH_BINARY_VERSION 7
+
+// LOD 0 plus up to three simplified levels
+#define MESH_MAX_LODS 4
+
+// --------------------------------------------------------
+// One level of detail: a range of the shared index buffer
+// --------------------------------------------------------
+struct MeshLod
+{
+	unsigned int indexStart;
+	unsigned int indexCount;
+	float error;                        // how far the surface moved from LOD 0, in model units
+};
+
+// --------------------------------------------------------
+// Start of a cooked .meshbin file.  The vertex and index
+// arrays follow at the given offsets, ready to be copied
+// into GPU buffers as they are
+// --------------------------------------------------------
+struct MeshBinaryHeader
+{
+	char magic[4];                      // "MBIN"
+	unsigned int version;               // MESH_BINARY_VERSION
+	unsigned int vertexStride;          // sizeof(Vertex) or sizeof(PackedVertex) when it was cooked
+	unsigned int vertexCount;
+	unsigned int indexStride;           // 2 or 4 bytes
+	unsigned int indexCount;
+	DirectX::XMFLOAT3 boundsMin;        // local space bounding box, packed positions are relative to it
+	DirectX::XMFLOAT3 boundsMax;
+	unsigned long long sourceSize;      // size of the OBJ it was cooked from
+	unsigned long long sourceChecksum;  // FNV-1a hash of the OBJ it was cooked from
+	unsigned long long sourceTime;      // and when that OBJ was last written, see MeshBinary::StatFile
+	unsigned long long vertexOffset;    // byte offsets from the start of the file
+	unsigned long long indexOffset;
+	unsigned long long lodOffset;
+	unsigned int lodCount;              // 1 to MESH_MAX_LODS, LOD 0 first
+	unsigned int vertexFormat;          // a VERTEX_FORMAT
+};
+
+// --------------------------------------------------------
+// A cooked mesh mapped straight from disk.  The vertex and
+// index pointers point into the mapping, nothing is copied
+// --------------------------------------------------------
+class CookedMesh
+{
+public:
+	// maps the file and checks that it is complete, current and holds this kind of vertex.
+	// nothing stays mapped when it returns false
+	bool Open(const char* filename, VERTEX_FORMAT format = VERTEX_FORMAT::FULL);
+	void Close();
+	inline bool IsOpen() const { return header != nullptr; }
+
+	// true if it was cooked from a file with this size and checksum
+	bool IsBuiltFrom(unsigned long long sourceSize, unsigned long long sourceChecksum) const;
+	// true if it was cooked from a file with this size and modification time, which
+	// is enough to trust it without reading the source
+	bool IsStampedWith(unsigned long long sourceSize, unsigned long long sourceTime) const;
+
+	inline const MeshBinaryHeader& GetHeader() const { return *header; }
+	inline const void* GetVertices() const { return file.GetData() + header->vertexOffset; }
+	inline VERTEX_FORMAT GetVertexFormat() const { return (VERTEX_FORMAT)header->vertexFormat; }
+	inline const void* GetIndices() const { return file.GetData() + header->indexOffset; }
+	inline const MeshLod* GetLods() const { return (const MeshLod*)(file.GetData() + header->lodOffset); }
+
+private:
+	MappedFile file;
+	const MeshBinaryHeader* header = nullptr;
+
+	bool IsValid(VERTEX_FORMAT format) const;
+};
+
+// --------------------------------------------------------
+// Helpers for writing and finding cooked meshes
+// --------------------------------------------------------
+class MeshBinary
+{
+public:
+	// Models/DeadTree.obj -> Models/DeadTree.meshbin, or Models/DeadTree.packed.meshbin
+	static std::string GetCookedPath(const char* sourcePath, VERTEX_FORMAT format = VERTEX_FORMAT::FULL);
+
+	// 64 bit FNV-1a hash
+	static unsigned long long Checksum(const unsigned char* data, size_t size);
+
+	// hashes a whole file, false if it can't be opened
+	static bool ChecksumFile(const char* filename, unsigned long long* size, unsigned long long* checksum);
+
+	// size and last write time of a file without reading it, the time is only
+	// compared with what the same call gave before. false if it doesn't exist
+	static bool StatFile(const char* filename, unsigned long long* size, unsigned long long* time);
+
+	// writes the final vertex and index data, using 16 bit indices when they fit
+	// and packing the verts if asked to
+	static bool Write(const char* filename, const std::vector<Vertex>& verts, const std::vector<unsigned int>& indices,
+		const std::vector<MeshLod>& lods, VERTEX_FORMAT format, unsigned long long sourceSize, unsigned long long sourceChecksum,
+		unsigned long long sourceTime);
+
+	// bounding box of the positions
+	static void GetBounds(const std::vector<Vertex>& verts, DirectX::XMFLOAT3* boundsMin, DirectX::XMFLOAT3* boundsMax);
+};
@@ -0,0 +1,286 @@
+#include "MeshBinary.h"
+#include "MeshSource.h"
+#include "ObjParser.h"
+#include "TangentGenerator.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <sys/utime.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+// --------------------------------------------------------
+// Cooks a copy of the cube and checks when the cooked file
+// is used, rebuilt or rejected.  A rejected or stale file
+// mustn't stay mapped: on Windows that stops the cooker
+// from writing over it.  A source that was only touched is
+// hashed and still uses the cooked file.
+//
+// Then times loading every model the old way, parsing the
+// OBJ and generating tangents, against mapping the cooked
+// file, each cold and warm.  Cold drops the files from the
+// page cache first, where the OS lets us
+// --------------------------------------------------------
+
+namespace
+{
+	const char* Source = "MeshBinaryTestCube.obj";
+
+	// whether this process still has the file mapped, where /proc says so
+	bool IsMapped(const std::string& path)
+	{
+		std::ifstream maps("/proc/self/maps");
+		std::string line;
+		while (std::getline(maps, line))
+		{
+			if (line.size() >= path.size() && line.compare(line.size() - path.size(), path.size(), path) == 0) return true;
+		}
+		return false;
+	}
+
+	std::string ReadAll(const char* filename)
+	{
+		std::ifstream in(filename, std::ios::binary);
+		std::stringstream text;
+		text << in.rdbuf();
+		return text.str();
+	}
+
+	void WriteAll(const char* filename, const std::string& text)
+	{
+		std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+		out << text;
+	}
+
+	void SetWriteTime(const char* filename, long seconds)
+	{
+		struct utimbuf times;
+		times.actime = seconds;
+		times.modtime = seconds;
+		utime(filename, &times);
+	}
+
+	// asks the OS to forget its cached copy of the file, so the next read comes off the disk
+	bool DropFromCache(const char* filename)
+	{
+#if defined(__linux__)
+		int file = open(filename, O_RDONLY);
+		if (file < 0) return false;
+		fdatasync(file);
+		bool dropped = posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		close(file);
+		return dropped;
+#else
+		(void)filename;
+		return false;
+#endif
+	}
+
+	// what Mesh did with an OBJ on every launch before meshes were cooked
+	double LoadText(const char* filename, size_t* bytes)
+	{
+		TestTimer timer;
+		MeshData data;
+		std::vector<Vertex> verts;
+		std::vector<unsigned int> indices;
+		if (!ObjParser::ParseFile(filename, data)) return -1.0;
+		ObjParser::WeldVertices(data, verts, indices);
+		TangentGenerator::Generate(&verts[0], (int)verts.size(), &indices[0], (int)indices.size());
+		*bytes = verts.size() * sizeof(Vertex) + indices.size() * sizeof(unsigned int);
+		return timer.Milliseconds();
+	}
+
+	// up to the point the data would be copied into buffers, reading all of it like CreateBuffer would
+	double LoadCooked(const char* filename, size_t* bytes, bool* cooked)
+	{
+		TestTimer timer;
+		MeshSource source;
+		if (!source.Load(filename)) return -1.0;
+		const unsigned char* vertices = (const unsigned char*)source.GetVertices();
+		const unsigned char* indices = (const unsigned char*)source.GetIndices();
+		size_t vertexBytes = (size_t)source.GetVertexCount() * source.GetVertexStride();
+		size_t indexBytes = (size_t)source.GetIndexCount() * source.GetIndexStride();
+		unsigned int sum = 0;
+		for (size_t i = 0; i < vertexBytes; i += 64) sum += vertices[i];
+		for (size_t i = 0; i < indexBytes; i += 64) sum += indices[i];
+		double ms = timer.Milliseconds();
+		*bytes = vertexBytes + indexBytes + (sum & 0);
+		*cooked = source.IsCooked();
+		return ms;
+	}
+}
+
+int main()
+{
+	std::string cube = ReadAll("Models/cube.obj");
+	CHECK(!cube.empty());
+	WriteAll(Source, cube);
+
+	std::string cookedPath = MeshBinary::GetCookedPath(Source);
+	remove(cookedPath.c_str());
+
+	// first load cooks, the second maps what it cooked
+	{
+		MeshSource source;
+		CHECK(source.Load(Source));
+		CHECK(!source.IsCooked());
+	}
+	unsigned long long size = 0, checksum = 0;
+	CHECK(MeshBinary::ChecksumFile(Source, &size, &checksum));
+	{
+		MeshSource source;
+		CHECK(source.Load(Source));
+		CHECK(source.IsCooked());
+		CHECK(source.GetLods()[0].indexCount == 72);
+	}
+
+	// every way Open can refuse a file leaves it closed
+	{
+		CookedMesh cooked;
+		CHECK(!cooked.Open(cookedPath.c_str(), VERTEX_FORMAT::PACKED));
+		CHECK(!cooked.IsOpen());
+		CHECK(!IsMapped(cookedPath));
+	}
+	std::string good = ReadAll(cookedPath.c_str());
+	std::string damaged[] = { good.substr(0, sizeof(MeshBinaryHeader) / 2), good.substr(0, good.size() - 8), "XBIN" + good.substr(4) };
+	for (const std::string& bytes : damaged)
+	{
+		WriteAll(cookedPath.c_str(), bytes);
+		CookedMesh cooked;
+		CHECK(!cooked.Open(cookedPath.c_str()));
+		CHECK(!cooked.IsOpen());
+		CHECK(!IsMapped(cookedPath));
+	}
+
+	// a damaged file is rebuilt
+	{
+		MeshSource source;
+		CHECK(source.Load(Source));
+		CHECK(!source.IsCooked());
+		CHECK(!IsMapped(cookedPath));
+	}
+	CHECK(ReadAll(cookedPath.c_str()) == good);
+
+	// so is one cooked from an older source, which Load lets go of before writing the new one
+	WriteAll(Source, cube + "# edited\n");
+	unsigned long long newSize = 0, newChecksum = 0;
+	CHECK(MeshBinary::ChecksumFile(Source, &newSize, &newChecksum));
+	{
+		MeshSource source;
+		CHECK(source.Load(Source));
+		CHECK(source.IsCooked() == false);
+		CHECK(!IsMapped(cookedPath));
+	}
+	{
+		CookedMesh cooked;
+		CHECK(cooked.Open(cookedPath.c_str()));
+		CHECK(cooked.IsBuiltFrom(newSize, newChecksum));
+		CHECK(!cooked.IsBuiltFrom(size, checksum));
+		cooked.Close();
+		CHECK(!IsMapped(cookedPath));
+	}
+
+	// touched without changing, the checksum still matches and the cooked file is used
+	SetWriteTime(Source, 1000000000);
+	unsigned long long touchedSize = 0, touchedTime = 0;
+	CHECK(MeshBinary::StatFile(Source, &touchedSize, &touchedTime));
+	CHECK(touchedSize == newSize && touchedTime == 1000000000ull * 1000000000ull);
+	{
+		CookedMesh cooked;
+		CHECK(cooked.Open(cookedPath.c_str()));
+		CHECK(!cooked.IsStampedWith(touchedSize, touchedTime));
+	}
+	{
+		MeshSource source;
+		CHECK(source.Load(Source));
+		CHECK(source.IsCooked());
+	}
+
+	// the same size with different text and a new time is rebuilt, and stamped with the new time
+	std::string edited = cube + "# edited\n";
+	edited[edited.size() - 2] = 'D';
+	WriteAll(Source, edited);
+	SetWriteTime(Source, 1100000000);
+	{
+		MeshSource source;
+		CHECK(source.Load(Source));
+		CHECK(!source.IsCooked());
+	}
+	{
+		CookedMesh cooked;
+		CHECK(cooked.Open(cookedPath.c_str()));
+		CHECK(cooked.IsStampedWith(newSize, 1100000000ull * 1000000000ull));
+	}
+	// and then loads from the cooked file without hashing
+	{
+		MeshSource source;
+		CHECK(source.Load(Source));
+		CHECK(source.IsCooked());
+	}
+
+	remove(cookedPath.c_str());
+	remove(Source);
+
+	// every model the game ships, cooked first so the cooked runs only time loading
+	const char* models[] = {
+		"Models/Campfire.obj", "Models/Campfire_Rocks.obj", "Models/DeadTree.obj", "Models/Plane.obj", "Models/Wall.obj",
+		"Models/cone.obj", "Models/cube.obj", "Models/cylinder.obj", "Models/helix.obj", "Models/sphere.obj", "Models/torus.obj"
+	};
+	for (const char* model : models)
+	{
+		MeshSource source;
+		CHECK(source.Load(model));
+	}
+
+	bool dropped = DropFromCache(models[0]);
+	printf("\n%-26s %10s %10s %10s %10s %10s\n", "model (ms)", "text cold", "text warm", "cook cold", "cook warm", "speedup");
+	double totals[4] = {};
+	for (const char* model : models)
+	{
+		std::string cooked = MeshBinary::GetCookedPath(model);
+		size_t textBytes = 0, cookedBytes = 0;
+		bool wasCooked = false;
+
+		DropFromCache(model);
+		double textCold = LoadText(model, &textBytes);
+		double textWarm = LoadText(model, &textBytes);
+		for (int i = 0; i < 4; i++) textWarm = std::min(textWarm, LoadText(model, &textBytes));
+
+		DropFromCache(model);
+		DropFromCache(cooked.c_str());
+		double cookedCold = LoadCooked(model, &cookedBytes, &wasCooked);
+		CHECK(wasCooked);
+		double cookedWarm = LoadCooked(model, &cookedBytes, &wasCooked);
+		for (int i = 0; i < 4; i++) cookedWarm = std::min(cookedWarm, LoadCooked(model, &cookedBytes, &wasCooked));
+		CHECK(wasCooked);
+
+		printf("%-26s %10.3f %10.3f %10.3f %10.3f %9.1fx\n", model, textCold, textWarm, cookedCold, cookedWarm, textWarm / cookedWarm);
+		totals[0] += textCold;
+		totals[1] += textWarm;
+		totals[2] += cookedCold;
+		totals[3] += cookedWarm;
+	}
+	printf("%-26s %10.3f %10.3f %10.3f %10.3f %9.1fx\n", "all", totals[0], totals[1], totals[2], totals[3], totals[1] / totals[3]);
+	// what every cooked load cost on top before it checked the size and time first
+	TestTimer hashTimer;
+	for (const char* model : models)
+	{
+		unsigned long long size = 0, checksum = 0;
+		MeshBinary::ChecksumFile(model, &size, &checksum);
+	}
+	printf("hashing every source, as each load used to: %.3f ms\n", hashTimer.Milliseconds());
+	if (!dropped) printf("couldn't drop files from the page cache here, cold runs only miss this process's caches\n");
+	CHECK(totals[3] < totals[1]);
+	CHECK(totals[2] < totals[0]);
+
+	return TestResult();
+}
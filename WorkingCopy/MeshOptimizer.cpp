@@ -0,0 +1,310 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+
+using namespace DirectX;
+
+namespace
+{
+	// Forsyth's tuning values, the cache is the size the scores model, not a hardware size
+	const int MaxCacheSize = 32;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	// how much we want to draw a triangle that uses this vertex next
+	float VertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		if (remainingTriangles == 0) return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// the three verts of the last triangle get a fixed score so the next one can't just reuse the same edge forever
+			if (cachePosition < 3) score = LastTriScore;
+			else score = powf(1.0f - (float)(cachePosition - 3) / (MaxCacheSize - 3), CacheDecayPower);
+		}
+
+		// boost vertices with few triangles left, so they get finished instead of left behind
+		return score + ValenceBoostScale * powf((float)remainingTriangles, -ValenceBoostPower);
+	}
+}
+
+void MeshOptimizer::Optimize(std::vector<Vertex>& verts, std::vector<unsigned int>& indices, bool overdraw)
+{
+	if (verts.empty() || indices.size() < 3) return;
+
+	OptimizeVertexCache(&indices[0], indices.size(), verts.size());
+	if (overdraw) OptimizeOverdraw(&indices[0], indices.size(), &verts[0], verts.size());
+	// last, since it renumbers the vertices the other passes refer to
+	OptimizeVertexFetch(verts, &indices[0], indices.size());
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) return;
+
+	// which triangles use each vertex, packed into one array
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		remaining[indices[i]]++;
+	}
+	std::vector<unsigned int> firstTriangle(vertexCount, 0);
+	for (size_t v = 1; v < vertexCount; v++)
+	{
+		firstTriangle[v] = firstTriangle[v - 1] + remaining[v - 1];
+	}
+	std::vector<unsigned int> adjacency(triangleCount * 3);
+	std::vector<unsigned int> filled(vertexCount, 0);
+	for (size_t i = 0; i < triangleCount * 3; i++)
+	{
+		unsigned int v = indices[i];
+		adjacency[firstTriangle[v] + filled[v]++] = (unsigned int)(i / 3);
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+	}
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	size_t bestTriangle = 0;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		if (triangleScore[t] > triangleScore[bestTriangle]) bestTriangle = t;
+	}
+
+	std::vector<unsigned int> output;
+	output.reserve(triangleCount * 3);
+	unsigned int cache[MaxCacheSize + 3];
+	size_t cacheCount = 0;
+	size_t cursor = 0;
+
+	for (size_t count = 0; count < triangleCount; count++)
+	{
+		// nothing in the cache has triangles left, start somewhere new
+		if (bestTriangle == SIZE_MAX)
+		{
+			while (emitted[cursor]) cursor++;
+			bestTriangle = cursor;
+		}
+
+		const unsigned int* tri = &indices[bestTriangle * 3];
+		emitted[bestTriangle] = true;
+		output.insert(output.end(), tri, tri + 3);
+
+		// take the triangle off its vertices' lists
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = tri[k];
+			unsigned int* list = &adjacency[firstTriangle[v]];
+			for (unsigned int i = 0; i < remaining[v]; i++)
+			{
+				if (list[i] == bestTriangle)
+				{
+					list[i] = list[remaining[v] - 1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// the triangle's verts go to the front of the LRU cache
+		unsigned int newCache[MaxCacheSize + 3];
+		size_t newCount = 0;
+		newCache[newCount++] = tri[0];
+		newCache[newCount++] = tri[1];
+		newCache[newCount++] = tri[2];
+		for (size_t i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			if (v != tri[0] && v != tri[1] && v != tri[2]) newCache[newCount++] = v;
+		}
+
+		// rescore everything that moved, pushing the change on to the vertex's triangles
+		for (size_t i = 0; i < newCount; i++)
+		{
+			unsigned int v = newCache[i];
+			cachePosition[v] = i < (size_t)MaxCacheSize ? (int)i : -1;
+
+			float score = VertexScore(cachePosition[v], remaining[v]);
+			float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+			for (unsigned int j = 0; j < remaining[v]; j++)
+			{
+				triangleScore[adjacency[firstTriangle[v] + j]] += delta;
+			}
+		}
+
+		cacheCount = std::min(newCount, (size_t)MaxCacheSize);
+		std::copy(newCache, newCache + cacheCount, cache);
+
+		// the next triangle is the best one touching the cache
+		bestTriangle = SIZE_MAX;
+		float bestScore = -FLT_MAX;
+		for (size_t i = 0; i < cacheCount; i++)
+		{
+			unsigned int v = cache[i];
+			for (unsigned int j = 0; j < remaining[v]; j++)
+			{
+				unsigned int t = adjacency[firstTriangle[v] + j];
+				if (triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					bestTriangle = t;
+				}
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::OptimizeOverdraw(unsigned int* indices, size_t indexCount, const Vertex* verts, size_t vertexCount)
+{
+	size_t triangleCount = indexCount / 3;
+	if (triangleCount == 0) return;
+
+	// start a new cluster wherever a triangle misses on all three verts,
+	// moving clusters around then costs (almost) nothing in cache hits
+	const unsigned int cacheSize = 16;
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	unsigned int time = cacheSize + 1;
+	std::vector<size_t> clusterStart;
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		int misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = indices[t * 3 + k];
+			if (time - cacheTime[v] > cacheSize)
+			{
+				cacheTime[v] = time++;
+				misses++;
+			}
+		}
+		if (t == 0 || misses == 3) clusterStart.push_back(t);
+	}
+	clusterStart.push_back(triangleCount);
+	size_t clusterCount = clusterStart.size() - 1;
+	if (clusterCount < 2) return;
+
+	// area weighted centre and normal of the mesh and of each cluster
+	struct Cluster
+	{
+		XMFLOAT3 centroid;
+		XMFLOAT3 normal;
+		float area;
+		float sortKey;
+		size_t index;
+	};
+	std::vector<Cluster> clusters(clusterCount);
+	XMVECTOR meshCentroid = XMVectorZero();
+	float meshArea = 0.0f;
+
+	for (size_t c = 0; c < clusterCount; c++)
+	{
+		XMVECTOR centroid = XMVectorZero();
+		XMVECTOR normal = XMVectorZero();
+		float area = 0.0f;
+		for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+		{
+			XMVECTOR p0 = XMLoadFloat3(&verts[indices[t * 3]].Position);
+			XMVECTOR p1 = XMLoadFloat3(&verts[indices[t * 3 + 1]].Position);
+			XMVECTOR p2 = XMLoadFloat3(&verts[indices[t * 3 + 2]].Position);
+
+			// length of the cross product is twice the area
+			XMVECTOR cross = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+			float triArea = XMVectorGetX(XMVector3Length(cross)) * 0.5f;
+			XMVECTOR center = XMVectorScale(XMVectorAdd(XMVectorAdd(p0, p1), p2), 1.0f / 3.0f);
+
+			centroid = XMVectorAdd(centroid, XMVectorScale(center, triArea));
+			normal = XMVectorAdd(normal, cross);
+			area += triArea;
+		}
+
+		meshCentroid = XMVectorAdd(meshCentroid, centroid);
+		meshArea += area;
+
+		if (area > 0.0f) centroid = XMVectorScale(centroid, 1.0f / area);
+		XMStoreFloat3(&clusters[c].centroid, centroid);
+		XMStoreFloat3(&clusters[c].normal, XMVector3Normalize(normal));
+		clusters[c].area = area;
+		clusters[c].index = c;
+	}
+	if (meshArea <= 0.0f) return;
+	meshCentroid = XMVectorScale(meshCentroid, 1.0f / meshArea);
+
+	// clusters facing away from the middle of the mesh are the ones most likely
+	// to be in front, drawing them first lets early z reject what's behind them
+	for (Cluster& cluster : clusters)
+	{
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&cluster.centroid), meshCentroid);
+		cluster.sortKey = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&cluster.normal)));
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<unsigned int> output;
+	output.reserve(triangleCount * 3);
+	for (const Cluster& cluster : clusters)
+	{
+		output.insert(output.end(), indices + clusterStart[cluster.index] * 3, indices + clusterStart[cluster.index + 1] * 3);
+	}
+	std::copy(output.begin(), output.end(), indices);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& verts, unsigned int* indices, size_t indexCount)
+{
+	std::vector<unsigned int> remap(verts.size(), UINT_MAX);
+	std::vector<Vertex> ordered;
+	ordered.reserve(verts.size());
+
+	// unreferenced verts are dropped along the way
+	for (size_t i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		if (remap[v] == UINT_MAX)
+		{
+			remap[v] = (unsigned int)ordered.size();
+			ordered.push_back(verts[v]);
+		}
+		indices[i] = remap[v];
+	}
+	verts.swap(ordered);
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats stats;
+	stats.triangles = (unsigned int)(indexCount / 3);
+
+	// a vertex is still cached if fewer than cacheSize misses happened since it was loaded
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<bool> used(vertexCount, false);
+	unsigned int time = cacheSize + 1;
+	for (size_t i = 0; i < stats.triangles * 3; i++)
+	{
+		unsigned int v = indices[i];
+		if (time - cacheTime[v] > cacheSize)
+		{
+			cacheTime[v] = time++;
+			stats.transforms++;
+		}
+		if (!used[v])
+		{
+			used[v] = true;
+			stats.vertices++;
+		}
+	}
+	return stats;
+}
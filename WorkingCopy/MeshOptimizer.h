@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Vertex.h"
+#include <vector>
+
+// --------------------------------------------------------
+// Results of running an index buffer through a simulated
+// post-transform vertex cache
+// --------------------------------------------------------
+struct VertexCacheStats
+{
+	unsigned int triangles = 0;
+	unsigned int vertices = 0;
+	unsigned int transforms = 0;    // cache misses, each one runs the vertex shader
+
+	// average cache miss ratio, 0.5 is ideal and 3 is no reuse at all
+	inline float ACMR() const { return triangles ? (float)transforms / triangles : 0.0f; }
+	// average transform to vertex ratio, 1 is ideal
+	inline float ATVR() const { return vertices ? (float)transforms / vertices : 0.0f; }
+};
+
+// --------------------------------------------------------
+// Reorders indexed triangle lists so the GPU does less work.
+// Runs on the CPU only, the cooker calls it once per mesh
+// and the result is saved in the cooked file
+// --------------------------------------------------------
+class MeshOptimizer
+{
+public:
+	// runs all of the passes below in the right order
+	static void Optimize(std::vector<Vertex>& verts, std::vector<unsigned int>& indices, bool overdraw = true);
+
+	// Forsyth's linear-speed ordering, so triangles reuse recently shaded vertices
+	static void OptimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+	// sorts clusters of the cache ordered triangles so outward facing ones are drawn first,
+	// clusters are only split where the cache was going to miss anyway
+	static void OptimizeOverdraw(unsigned int* indices, size_t indexCount, const Vertex* verts, size_t vertexCount);
+
+	// renumbers the vertices in the order they are first used, so fetches walk memory forwards
+	static void OptimizeVertexFetch(std::vector<Vertex>& verts, unsigned int* indices, size_t indexCount);
+
+	// counts the transforms a FIFO cache of the given size would need
+	static VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16);
+};
@@ -0,0 +1,127 @@
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Runs every model through MeshOptimizer and checks the
+// simulated vertex cache does no worse, the triangles are
+// the same ones with the same winding, and vertices are
+// numbered in the order they're first used
+// --------------------------------------------------------
+
+namespace
+{
+	// every triangle as the bytes of its three verts, starting from the smallest
+	// so a rotated triangle matches but a flipped one doesn't
+	std::vector<std::string> TriangleSet(const std::vector<Vertex>& verts, const std::vector<unsigned int>& indices)
+	{
+		std::vector<std::string> triangles;
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			std::string corners[3];
+			for (int c = 0; c < 3; c++) corners[c].assign((const char*)&verts[indices[t + c]], sizeof(Vertex));
+			int first = (int)(std::min_element(corners, corners + 3) - corners);
+			triangles.push_back(corners[first] + corners[(first + 1) % 3] + corners[(first + 2) % 3]);
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	bool UsedInOrder(const std::vector<Vertex>& verts, const std::vector<unsigned int>& indices)
+	{
+		unsigned int next = 0;
+		for (unsigned int index : indices)
+		{
+			if (index > next) return false;
+			if (index == next) next++;
+		}
+		return next == verts.size();
+	}
+
+	void Check(const char* name, const std::vector<Vertex>& verts, const std::vector<unsigned int>& indices)
+	{
+		VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(&indices[0], indices.size(), verts.size());
+
+		std::vector<unsigned int> cacheOnly = indices;
+		TestTimer timer;
+		MeshOptimizer::OptimizeVertexCache(&cacheOnly[0], cacheOnly.size(), verts.size());
+		double ms = timer.Milliseconds();
+		VertexCacheStats cached = MeshOptimizer::AnalyzeVertexCache(&cacheOnly[0], cacheOnly.size(), verts.size());
+
+		std::vector<Vertex> optimizedVerts = verts;
+		std::vector<unsigned int> optimizedIndices = indices;
+		MeshOptimizer::Optimize(optimizedVerts, optimizedIndices);
+		VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(&optimizedIndices[0], optimizedIndices.size(), optimizedVerts.size());
+
+		printf("%s: %u triangles, ACMR %.3f -> %.3f (%.3f before the overdraw pass), ATVR %.3f -> %.3f, vertex cache pass %.2f ms\n",
+			name, before.triangles, before.ACMR(), after.ACMR(), cached.ACMR(), before.ATVR(), after.ATVR(), ms);
+
+		CHECK(cached.ACMR() <= before.ACMR());
+		CHECK(after.ACMR() <= before.ACMR());
+		// the overdraw pass only splits where the cache missed, so it costs little
+		CHECK(after.ACMR() <= cached.ACMR() * 1.05f);
+		CHECK(optimizedVerts.size() == verts.size());
+		CHECK(TriangleSet(verts, indices) == TriangleSet(optimizedVerts, optimizedIndices));
+		CHECK(UsedInOrder(optimizedVerts, optimizedIndices));
+	}
+
+	void CheckModel(const char* filename)
+	{
+		MeshData data;
+		CHECK(ObjParser::ParseFile(filename, data));
+		std::vector<Vertex> verts;
+		std::vector<unsigned int> indices;
+		ObjParser::WeldVertices(data, verts, indices);
+		Check(filename, verts, indices);
+	}
+}
+
+int main()
+{
+	const char* models[] = {
+		"Models/Campfire.obj", "Models/Campfire_Rocks.obj", "Models/DeadTree.obj", "Models/helix.obj",
+		"Models/sphere.obj", "Models/torus.obj", "Models/cylinder.obj", "Models/cone.obj", "Models/cube.obj"
+	};
+	for (const char* model : models) CheckModel(model);
+
+	// a grid with its triangles shuffled has no reuse to start with, a good order gets close to 0.5 per triangle
+	const int side = 100;
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	for (int z = 0; z <= side; z++)
+	{
+		for (int x = 0; x <= side; x++)
+		{
+			Vertex v = {};
+			v.Position = XMFLOAT3((float)x, 0, (float)z);
+			v.Normal = XMFLOAT3(0, 1, 0);
+			verts.push_back(v);
+		}
+	}
+	std::vector<unsigned int> quads(side * side);
+	for (unsigned int i = 0; i < quads.size(); i++) quads[i] = i;
+	std::shuffle(quads.begin(), quads.end(), std::mt19937(7));
+	for (unsigned int quad : quads)
+	{
+		unsigned int a = quad / side * (side + 1) + quad % side;
+		unsigned int b = a + 1;
+		unsigned int c = a + side + 1;
+		unsigned int d = c + 1;
+		indices.insert(indices.end(), { a, c, b, b, c, d });
+	}
+	Check("shuffled grid", verts, indices);
+
+	std::vector<unsigned int> ordered = indices;
+	MeshOptimizer::OptimizeVertexCache(&ordered[0], ordered.size(), verts.size());
+	CHECK(MeshOptimizer::AnalyzeVertexCache(&ordered[0], ordered.size(), verts.size()).ACMR() < 0.8f);
+
+	return TestResult();
+}
@@ -0,0 +1,365 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+
+using namespace DirectX;
+
+namespace
+{
+	// each LOD aims for this fraction of LOD 0's triangles
+	const float LodTriangleRatio[MESH_MAX_LODS] = { 1.0f, 0.5f, 0.25f, 0.125f };
+
+	// and may move the surface at most this fraction of the mesh's size
+	const float LodMaxError = 0.1f;
+
+	// a LOD that saves less than this over the previous one isn't worth keeping
+	const float MinLodReduction = 0.8f;
+
+	// symmetric 4x4 matrix measuring squared distance to a set of planes
+	struct Quadric
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+		double planes;
+
+		void Clear() { memset(this, 0, sizeof(Quadric)); }
+
+		void AddPlane(double a, double b, double c, double d)
+		{
+			a2 += a * a; ab += a * b; ac += a * c; ad += a * d;
+			b2 += b * b; bc += b * c; bd += b * d;
+			c2 += c * c; cd += c * d;
+			d2 += d * d;
+			planes += 1;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+			b2 += q.b2; bc += q.bc; bd += q.bd;
+			c2 += q.c2; cd += q.cd;
+			d2 += q.d2;
+			planes += q.planes;
+		}
+
+		// mean squared distance to the planes
+		double Evaluate(const XMFLOAT3& p) const
+		{
+			if (planes <= 0) return 0;
+			double x = p.x, y = p.y, z = p.z;
+			double result = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+				+ b2 * y * y + 2 * bc * y * z + 2 * bd * y
+				+ c2 * z * z + 2 * cd * z
+				+ d2;
+			return result > 0 ? result / planes : 0;
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		unsigned int from;
+		unsigned int to;
+	};
+
+	struct PositionHash
+	{
+		size_t operator()(const XMFLOAT3& p) const
+		{
+			unsigned int bits[3];
+			memcpy(bits, &p, sizeof(bits));
+			return bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u;
+		}
+	};
+
+	struct PositionEqual
+	{
+		bool operator()(const XMFLOAT3& a, const XMFLOAT3& b) const { return memcmp(&a, &b, sizeof(XMFLOAT3)) == 0; }
+	};
+
+	XMVECTOR FaceNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+	{
+		XMVECTOR a = XMLoadFloat3(&p0);
+		return XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&p1), a), XMVectorSubtract(XMLoadFloat3(&p2), a));
+	}
+}
+
+float MeshSimplifier::Simplify(const std::vector<Vertex>& verts, const unsigned int* indices, size_t indexCount,
+	size_t targetIndexCount, float maxError, std::vector<unsigned int>& result)
+{
+	result.assign(indices, indices + indexCount);
+	size_t vertexCount = verts.size();
+	if (vertexCount == 0 || indexCount <= targetIndexCount) return 0.0f;
+
+	// verts that share a position but not a normal/uv sit on a seam, they're moved together
+	std::unordered_map<XMFLOAT3, unsigned int, PositionHash, PositionEqual> positions;
+	std::vector<unsigned int> positionId(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++)
+	{
+		auto inserted = positions.insert({ verts[v].Position, (unsigned int)positions.size() });
+		positionId[v] = inserted.first->second;
+	}
+	size_t positionCount = positions.size();
+
+	// the verts at each position
+	std::vector<unsigned int> firstSibling(positionCount + 1, 0);
+	std::vector<unsigned int> siblings(vertexCount);
+	for (size_t v = 0; v < vertexCount; v++) firstSibling[positionId[v] + 1]++;
+	for (size_t p = 0; p < positionCount; p++) firstSibling[p + 1] += firstSibling[p];
+	std::vector<unsigned int> filledSiblings(firstSibling.begin(), firstSibling.end() - 1);
+	for (size_t v = 0; v < vertexCount; v++) siblings[filledSiblings[positionId[v]]++] = (unsigned int)v;
+
+	// an edge is on an open border when it isn't used as often one way round as the other,
+	// so meshes exported twice over (the helix, the cube) still count as closed.  Edges more
+	// than two triangles use in the same direction can't be collapsed safely
+	auto edgeKey = [](unsigned int a, unsigned int b) { return ((unsigned long long)a << 32) | b; };
+	std::unordered_map<unsigned long long, int> edgeUses;
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			edgeUses[edgeKey(positionId[indices[i + k]], positionId[indices[i + (k + 1) % 3]])]++;
+		}
+	}
+	auto isBorder = [&](unsigned int a, unsigned int b) {
+		auto forward = edgeUses.find(edgeKey(a, b));
+		auto backward = edgeUses.find(edgeKey(b, a));
+		return (forward == edgeUses.end() ? 0 : forward->second) != (backward == edgeUses.end() ? 0 : backward->second);
+	};
+	std::vector<bool> border(positionCount, false);
+	std::vector<bool> locked(positionCount, false);
+	for (const auto& edge : edgeUses)
+	{
+		unsigned int a = (unsigned int)(edge.first >> 32);
+		unsigned int b = (unsigned int)(edge.first & 0xFFFFFFFFu);
+		if (isBorder(a, b)) border[a] = border[b] = true;
+		if (edge.second > 2) locked[a] = locked[b] = true;
+	}
+
+	// start every position with the planes of the triangles around it, and a plane standing
+	// on each border edge so border verts pay for pulling the outline in
+	std::vector<Quadric> quadrics(positionCount);
+	for (Quadric& q : quadrics) q.Clear();
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		const XMFLOAT3* p[3] = { &verts[indices[i]].Position, &verts[indices[i + 1]].Position, &verts[indices[i + 2]].Position };
+		XMVECTOR faceNormal = XMVector3Normalize(FaceNormal(*p[0], *p[1], *p[2]));
+		XMFLOAT3 n;
+		XMStoreFloat3(&n, faceNormal);
+		double d = -(n.x * (double)p[0]->x + n.y * (double)p[0]->y + n.z * (double)p[0]->z);
+		for (int k = 0; k < 3; k++)
+		{
+			quadrics[positionId[indices[i + k]]].AddPlane(n.x, n.y, n.z, d);
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int a = positionId[indices[i + k]];
+			unsigned int b = positionId[indices[i + (k + 1) % 3]];
+			if (!isBorder(a, b)) continue;
+
+			XMVECTOR edge = XMVectorSubtract(XMLoadFloat3(p[(k + 1) % 3]), XMLoadFloat3(p[k]));
+			XMFLOAT3 side;
+			XMStoreFloat3(&side, XMVector3Normalize(XMVector3Cross(edge, faceNormal)));
+			double sideD = -(side.x * (double)p[k]->x + side.y * (double)p[k]->y + side.z * (double)p[k]->z);
+			quadrics[a].AddPlane(side.x, side.y, side.z, sideD);
+			quadrics[b].AddPlane(side.x, side.y, side.z, sideD);
+		}
+	}
+
+	double maxCost = (double)maxError * maxError;
+	double reachedCost = 0.0;
+	std::vector<unsigned int> remap(vertexCount);
+	std::vector<unsigned int> moveTo(vertexCount);
+	std::vector<bool> touched(positionCount);
+	std::vector<unsigned int> firstTriangle(vertexCount + 1);
+	std::vector<unsigned int> adjacency;
+	std::vector<Collapse> collapses;
+
+	// each pass collapses a set of edges that don't share any triangles
+	while (result.size() > targetIndexCount)
+	{
+		size_t triangleCount = result.size() / 3;
+
+		// triangles around each vertex
+		std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+		for (unsigned int v : result) firstTriangle[v + 1]++;
+		for (size_t v = 0; v < vertexCount; v++) firstTriangle[v + 1] += firstTriangle[v];
+		adjacency.resize(result.size());
+		std::vector<unsigned int> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+		for (size_t i = 0; i < result.size(); i++)
+		{
+			adjacency[filled[result[i]]++] = (unsigned int)(i / 3);
+		}
+
+		// every half edge that could move its first position, border positions only along the border
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int a = result[i + k];
+				unsigned int b = result[i + (k + 1) % 3];
+				unsigned int pa = positionId[a];
+				unsigned int pb = positionId[b];
+				if (pa == pb) continue;
+				bool alongBorder = border[pa] && border[pb] && isBorder(pa, pb);
+				if (!locked[pa] && (!border[pa] || alongBorder))
+				{
+					Quadric q = quadrics[pa];
+					q.Add(quadrics[pb]);
+					collapses.push_back({ q.Evaluate(verts[b].Position), a, b });
+				}
+				if (!locked[pb] && (!border[pb] || alongBorder))
+				{
+					Quadric q = quadrics[pb];
+					q.Add(quadrics[pa]);
+					collapses.push_back({ q.Evaluate(verts[a].Position), b, a });
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+		// a collapse removes about two triangles, don't overshoot the target by much.  Nor take
+		// dearer collapses than the cheapest that many would cost, because cheap ones were
+		// skipped for sharing a triangle with one already taken: they come first next pass
+		size_t wanted = (triangleCount - targetIndexCount / 3) / 2 + 1;
+		double passCost = collapses.empty() ? 0.0 : collapses[std::min(wanted, collapses.size() - 1)].cost;
+		size_t done = 0;
+		for (size_t v = 0; v < vertexCount; v++) remap[v] = (unsigned int)v;
+		std::fill(touched.begin(), touched.end(), false);
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapse.cost > maxCost || collapse.cost > passCost || done >= wanted) break;
+			unsigned int from = positionId[collapse.from];
+			unsigned int to = positionId[collapse.to];
+			if (touched[from] || touched[to]) continue;
+
+			// every vert at the position moves to the one at the target it shares an edge with,
+			// so both sides of a seam keep their own normals and uvs
+			bool allowed = true;
+			for (unsigned int s = firstSibling[from]; s < firstSibling[from + 1] && allowed; s++)
+			{
+				unsigned int v = siblings[s];
+				moveTo[v] = UINT_MAX;
+				for (unsigned int j = firstTriangle[v]; j < firstTriangle[v + 1] && allowed; j++)
+				{
+					const unsigned int* tri = &result[adjacency[j] * 3];
+					for (int k = 0; k < 3; k++)
+					{
+						if (positionId[tri[k]] != to) continue;
+						// the seam splits at the target, there's no one vert to move to
+						if (moveTo[v] != UINT_MAX && moveTo[v] != tri[k]) allowed = false;
+						moveTo[v] = tri[k];
+					}
+				}
+				if (firstTriangle[v] != firstTriangle[v + 1] && moveTo[v] == UINT_MAX) allowed = false;
+			}
+			if (!allowed) continue;
+
+			// moving the position must not turn any of its other triangles over
+			const XMFLOAT3& target = verts[collapse.to].Position;
+			for (unsigned int s = firstSibling[from]; s < firstSibling[from + 1] && allowed; s++)
+			{
+				unsigned int v = siblings[s];
+				for (unsigned int j = firstTriangle[v]; j < firstTriangle[v + 1] && allowed; j++)
+				{
+					const unsigned int* tri = &result[adjacency[j] * 3];
+					if (positionId[tri[0]] == to || positionId[tri[1]] == to || positionId[tri[2]] == to) continue;
+
+					XMFLOAT3 p[3];
+					for (int k = 0; k < 3; k++) p[k] = verts[tri[k]].Position;
+					XMVECTOR before = FaceNormal(p[0], p[1], p[2]);
+					for (int k = 0; k < 3; k++) if (tri[k] == v) p[k] = target;
+					XMVECTOR after = FaceNormal(p[0], p[1], p[2]);
+					if (XMVectorGetX(XMVector3Dot(before, after)) <= 0.0f) allowed = false;
+				}
+			}
+			if (!allowed) continue;
+
+			quadrics[to].Add(quadrics[from]);
+			reachedCost = std::max(reachedCost, collapse.cost);
+			done++;
+
+			// everything sharing a triangle with the moved verts waits for the next pass
+			for (unsigned int s = firstSibling[from]; s < firstSibling[from + 1]; s++)
+			{
+				unsigned int v = siblings[s];
+				if (firstTriangle[v] != firstTriangle[v + 1]) remap[v] = moveTo[v];
+				for (unsigned int j = firstTriangle[v]; j < firstTriangle[v + 1]; j++)
+				{
+					const unsigned int* tri = &result[adjacency[j] * 3];
+					for (int k = 0; k < 3; k++) touched[positionId[tri[k]]] = true;
+				}
+			}
+		}
+		if (done == 0) break;
+
+		// drop the triangles that collapsed to a line
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			unsigned int a = remap[result[i]];
+			unsigned int b = remap[result[i + 1]];
+			unsigned int c = remap[result[i + 2]];
+			if (a == b || b == c || a == c) continue;
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+		result.resize(write);
+	}
+
+	return (float)sqrt(reachedCost);
+}
+
+void MeshSimplifier::BuildLods(const std::vector<Vertex>& verts, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods)
+{
+	lods.clear();
+	lods.push_back({ 0, (unsigned int)indices.size(), 0.0f });
+	if (verts.empty() || indices.size() < 3) return;
+
+	// errors are capped relative to the size of the mesh
+	XMVECTOR boundsMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR boundsMax = XMVectorReplicate(-FLT_MAX);
+	for (const Vertex& vert : verts)
+	{
+		XMVECTOR pos = XMLoadFloat3(&vert.Position);
+		boundsMin = XMVectorMin(boundsMin, pos);
+		boundsMax = XMVectorMax(boundsMax, pos);
+	}
+	float extent = XMVectorGetX(XMVector3Length(XMVectorSubtract(boundsMax, boundsMin)));
+
+	size_t baseCount = indices.size();
+	std::vector<unsigned int> lod;
+	for (int level = 1; level < MESH_MAX_LODS; level++)
+	{
+		// simplify from the full mesh every time, so errors don't stack up
+		size_t target = (size_t)(baseCount / 3 * LodTriangleRatio[level]) * 3;
+		float error = Simplify(verts, &indices[0], baseCount, target, extent * LodMaxError, lod);
+
+		const MeshLod& previous = lods.back();
+		if (lod.size() < 3 || lod.size() > previous.indexCount * MinLodReduction) break;
+
+		MeshOptimizer::OptimizeVertexCache(&lod[0], lod.size(), verts.size());
+		lods.push_back({ (unsigned int)indices.size(), (unsigned int)lod.size(), error });
+		indices.insert(indices.end(), lod.begin(), lod.end());
+	}
+}
+
+int MeshSimplifier::SelectLod(const MeshLod* lods, int lodCount, float maxScale, float distance, float projectionScale, float screenHeight, float pixelError)
+{
+	// how many pixels one unit covers at this distance
+	float pixelsPerUnit = projectionScale * screenHeight * 0.5f / fmaxf(distance, 0.001f);
+
+	for (int i = lodCount - 1; i > 0; i--)
+	{
+		if (lods[i].error * maxScale * pixelsPerUnit <= pixelError) return i;
+	}
+	return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Vertex.h"
+#include "MeshBinary.h"
+#include <vector>
+
+// --------------------------------------------------------
+// Builds lower detail versions of a mesh by collapsing
+// edges in order of their quadric error (Garland-Heckbert).
+//
+// Only the index list changes, every LOD draws from the same
+// vertex buffer.  The verts on both sides of a UV/normal seam
+// move together, each to its own side's vert at the target,
+// and verts on open borders only slide along the border, so
+// the LODs don't crack or tear
+// --------------------------------------------------------
+class MeshSimplifier
+{
+public:
+	// collapses edges until the index count is at most targetIndexCount or the next
+	// collapse would move the surface more than maxError, returns the error reached
+	static float Simplify(const std::vector<Vertex>& verts, const unsigned int* indices, size_t indexCount,
+		size_t targetIndexCount, float maxError, std::vector<unsigned int>& result);
+
+	// appends up to MESH_MAX_LODS - 1 coarser LODs after the index list, which is LOD 0,
+	// and describes every LOD's range of it
+	static void BuildLods(const std::vector<Vertex>& verts, std::vector<unsigned int>& indices, std::vector<MeshLod>& lods);
+
+	// the coarsest LOD whose error covers at most pixelError pixels on screen, for a mesh
+	// scaled by maxScale this far from a camera whose projection has this _22 (cot(fov / 2))
+	static int SelectLod(const MeshLod* lods, int lodCount, float maxScale, float distance, float projectionScale, float screenHeight, float pixelError = 1.0f);
+};
@@ -0,0 +1,208 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+#include "ObjParser.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <tuple>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Builds the LOD chains the cooker would for the game's
+// models and checks they're well formed and don't open any
+// new holes, then walks a camera
+// through a forest of trees and counts how many triangles
+// SelectLod picks per frame against drawing LOD 0
+// --------------------------------------------------------
+
+namespace
+{
+	// what Camera uses
+	const float FieldOfView = 0.25f * 3.1415926535f;
+	const float ScreenHeight = 720.0f;
+	const float DrawDistance = 100.0f;
+
+	// what Game::Update passes to Entity::SelectLod
+	const float GamePixelError = 4.0f;
+
+	struct LodMesh
+	{
+		std::vector<Vertex> verts;
+		std::vector<unsigned int> indices;
+		std::vector<MeshLod> lods;
+	};
+
+	// edges used a different number of times each way round, by position so seams don't count
+	size_t CountBorderEdges(const std::vector<Vertex>& verts, const unsigned int* indices, size_t indexCount)
+	{
+		std::map<std::tuple<float, float, float>, unsigned int> ids;
+		std::vector<unsigned int> position(verts.size());
+		for (size_t v = 0; v < verts.size(); v++)
+		{
+			auto key = std::make_tuple(verts[v].Position.x, verts[v].Position.y, verts[v].Position.z);
+			position[v] = ids.insert({ key, (unsigned int)ids.size() }).first->second;
+		}
+		std::map<std::pair<unsigned int, unsigned int>, int> uses;
+		for (size_t i = 0; i < indexCount; i += 3)
+		{
+			for (int k = 0; k < 3; k++) uses[{ position[indices[i + k]], position[indices[i + (k + 1) % 3]] }]++;
+		}
+		size_t border = 0;
+		for (const auto& edge : uses)
+		{
+			auto back = uses.find({ edge.first.second, edge.first.first });
+			if (back == uses.end() || back->second != edge.second) border++;
+		}
+		return border;
+	}
+
+	LodMesh Build(const char* filename)
+	{
+		LodMesh mesh;
+		MeshData data;
+		CHECK(ObjParser::ParseFile(filename, data));
+		ObjParser::WeldVertices(data, mesh.verts, mesh.indices);
+		MeshOptimizer::Optimize(mesh.verts, mesh.indices);
+		size_t baseCount = mesh.indices.size();
+
+		TestTimer timer;
+		MeshSimplifier::BuildLods(mesh.verts, mesh.indices, mesh.lods);
+		double ms = timer.Milliseconds();
+
+		printf("%s: %.2f ms", filename, ms);
+		for (const MeshLod& lod : mesh.lods) printf(", %u triangles (error %.4f)", lod.indexCount / 3, lod.error);
+		printf("\n");
+
+		CHECK(!mesh.lods.empty() && mesh.lods.size() <= MESH_MAX_LODS);
+		CHECK(mesh.lods[0].indexStart == 0 && mesh.lods[0].indexCount == baseCount && mesh.lods[0].error == 0.0f);
+		for (size_t i = 1; i < mesh.lods.size(); i++)
+		{
+			const MeshLod& lod = mesh.lods[i];
+			CHECK(lod.indexCount % 3 == 0 && lod.indexCount >= 3);
+			CHECK(lod.indexStart + lod.indexCount <= mesh.indices.size());
+			// each one has to be worth keeping over the last
+			CHECK(lod.indexCount <= mesh.lods[i - 1].indexCount * 0.8f);
+			CHECK(lod.error >= mesh.lods[i - 1].error);
+			// a seam pulled apart or a border pulled off its line would leave new open edges
+			CHECK(CountBorderEdges(mesh.verts, &mesh.indices[lod.indexStart], lod.indexCount) <= CountBorderEdges(mesh.verts, &mesh.indices[0], baseCount));
+			for (unsigned int t = lod.indexStart; t < lod.indexStart + lod.indexCount; t += 3)
+			{
+				unsigned int a = mesh.indices[t], b = mesh.indices[t + 1], c = mesh.indices[t + 2];
+				CHECK(a < mesh.verts.size() && b < mesh.verts.size() && c < mesh.verts.size());
+				CHECK(a != b && b != c && a != c);
+			}
+		}
+		return mesh;
+	}
+
+	// the game's tree grid with every spot filled, at the height SpawnTreeGrid puts them
+	std::vector<XMFLOAT3> TreeGrid()
+	{
+		std::vector<XMFLOAT3> trees;
+		for (int x = -150; x <= 150; x += 8)
+		{
+			for (int z = -150; z <= 150; z += 8) trees.push_back(XMFLOAT3((float)x, -3.0f, (float)z));
+		}
+		return trees;
+	}
+
+	// walks the camera corner to corner through the grid, drawing every copy of the mesh within
+	// the far plane, and returns the triangles per frame SelectLod picked
+	double WalkGrid(const char* name, const LodMesh& mesh, float pixelError, unsigned int* drawsPerLod = nullptr)
+	{
+		std::vector<XMFLOAT3> grid = TreeGrid();
+		int lodCount = (int)mesh.lods.size();
+		float projectionScale = 1.0f / tanf(FieldOfView * 0.5f);
+		unsigned long long fullTriangles = 0;
+		unsigned long long lodTriangles = 0;
+		unsigned int lodUse[MESH_MAX_LODS] = {};
+
+		const int frames = 300;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			float t = (float)frame / (frames - 1);
+			XMFLOAT3 camera(-140.0f + 280.0f * t, 0.0f, -140.0f + 280.0f * t);
+			for (const XMFLOAT3& position : grid)
+			{
+				float dx = position.x - camera.x, dy = position.y - camera.y, dz = position.z - camera.z;
+				float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+				if (distance > DrawDistance) continue;
+
+				int lod = MeshSimplifier::SelectLod(&mesh.lods[0], lodCount, 1.0f, distance, projectionScale, ScreenHeight, pixelError);
+				fullTriangles += mesh.lods[0].indexCount / 3;
+				lodTriangles += mesh.lods[lod].indexCount / 3;
+				lodUse[lod]++;
+			}
+		}
+
+		printf("%s grid at %.0f px: %.0f triangles per frame with LOD 0, %.0f with LODs (%.1f%%), draws per LOD:",
+			name, pixelError, (double)fullTriangles / frames, (double)lodTriangles / frames, 100.0 * lodTriangles / fullTriangles);
+		for (int i = 0; i < lodCount; i++) printf(" %u", lodUse[i]);
+		printf("\n");
+
+		CHECK(lodTriangles <= fullTriangles);
+		if (drawsPerLod != nullptr) std::copy(lodUse, lodUse + lodCount, drawsPerLod);
+		return (double)lodTriangles / frames;
+	}
+
+	// nothing coarser is picked further in, and every pick is the coarsest within the pixel error
+	void CheckSelection(const LodMesh& mesh, float pixelError)
+	{
+		int lodCount = (int)mesh.lods.size();
+		float projectionScale = 1.0f / tanf(FieldOfView * 0.5f);
+		int lastLod = 0;
+		for (float distance = 0.5f; distance < DrawDistance * 10; distance += 0.5f)
+		{
+			int lod = MeshSimplifier::SelectLod(&mesh.lods[0], lodCount, 1.0f, distance, projectionScale, ScreenHeight, pixelError);
+			float pixelsPerUnit = projectionScale * ScreenHeight * 0.5f / distance;
+			CHECK(lod >= lastLod);
+			CHECK(mesh.lods[lod].error * pixelsPerUnit <= pixelError);
+			for (int coarser = lod + 1; coarser < lodCount; coarser++) CHECK(mesh.lods[coarser].error * pixelsPerUnit > pixelError);
+			lastLod = lod;
+		}
+		CHECK(lastLod == lodCount - 1);
+	}
+}
+
+int main()
+{
+	const char* models[] = { "Models/Campfire.obj", "Models/Campfire_Rocks.obj", "Models/torus.obj" };
+	for (const char* model : models) Build(model);
+
+	// the tree is what the forest is made of, it needs the whole chain.  The helix is
+	// exported twice over and all its verts are on seams, it has to simplify anyway
+	LodMesh tree = Build("Models/DeadTree.obj");
+	LodMesh helix = Build("Models/helix.obj");
+	LodMesh sphere = Build("Models/sphere.obj");
+	CHECK(tree.lods.size() >= 3);
+	CHECK(helix.lods.size() >= 3);
+	CHECK(sphere.lods.size() == MESH_MAX_LODS);
+	CheckSelection(tree, 1.0f);
+	CheckSelection(tree, GamePixelError);
+	CheckSelection(sphere, 1.0f);
+	CheckSelection(sphere, 4.0f);
+
+	double last = 1e30;
+	for (float pixelError : { 1.0f, 2.0f, 4.0f, 8.0f })
+	{
+		double triangles = WalkGrid("DeadTree", tree, pixelError);
+		CHECK(triangles <= last);
+		last = triangles;
+	}
+
+	// at the game's budget every tree LOD gets drawn before the far plane, and the forest
+	// costs well under half of drawing LOD 0
+	unsigned int lodUse[MESH_MAX_LODS] = {};
+	double forest = WalkGrid("DeadTree", tree, GamePixelError, lodUse);
+	for (size_t i = 0; i < tree.lods.size(); i++) CHECK(lodUse[i] > 0);
+	CHECK(forest < 0.5 * WalkGrid("DeadTree", tree, 0.0f));
+
+	// a small smooth mesh has LODs worth using at the default error
+	CHECK(WalkGrid("sphere", sphere, 1.0f) < WalkGrid("sphere", sphere, 0.0f));
+
+	return TestResult();
+}
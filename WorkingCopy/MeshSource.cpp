@@ -0,0 +1,199 @@
+#include "MeshSource.h"
+#include "ObjParser.h"
+#include "TangentGenerator.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include <cstdio>
+#include <unordered_map>
+
+using namespace DirectX;
+
+bool MeshSource::Load(const char* filename, VERTEX_FORMAT format)
+{
+	cookedLoaded = false;
+	this->format = format;
+
+	// The source's size and write time say whether the cooked copy is still current
+	std::string cookedPath = MeshBinary::GetCookedPath(filename, format);
+	unsigned long long sourceSize = 0;
+	unsigned long long sourceTime = 0;
+	unsigned long long sourceChecksum = 0;
+	bool haveSource = MeshBinary::StatFile(filename, &sourceSize, &sourceTime);
+	bool haveChecksum = false;
+
+	// Use the cooked file if it matches (or if it's all we shipped)
+	if (cooked.Open(cookedPath.c_str(), format))
+	{
+		// only hash the source when it was written since, a copy or a checkout can
+		// change the time without changing what's in it
+		bool current = !haveSource || cooked.IsStampedWith(sourceSize, sourceTime);
+		if (!current && cooked.GetHeader().sourceSize == sourceSize)
+		{
+			haveChecksum = MeshBinary::ChecksumFile(filename, &sourceSize, &sourceChecksum);
+			current = haveChecksum && cooked.IsBuiltFrom(sourceSize, sourceChecksum);
+		}
+		if (current)
+		{
+			cookedLoaded = true;
+			quantization = VertexPacker::GetQuantization(cooked.GetHeader().boundsMin, cooked.GetHeader().boundsMax);
+			bounds = Bounds::FromMinMax(cooked.GetHeader().boundsMin, cooked.GetHeader().boundsMax);
+			return true;
+		}
+	}
+
+	// A stale cooked file is still mapped, and Windows won't let Write replace it while it is
+	cooked.Close();
+
+	// Parse the file into device independent data
+	MeshData data;
+	if (haveSource && !haveChecksum) haveChecksum = MeshBinary::ChecksumFile(filename, &sourceSize, &sourceChecksum);
+	if (!haveChecksum || !ObjParser::ParseFile(filename, data) || data.indices.empty())
+	{
+		printf("Failed to load mesh %s.\n", filename);
+		return false;
+	}
+
+	// Weld the face corners into unique verts and real indices
+	WeldStats stats = ObjParser::WeldVertices(data, verts, indices);
+	printf("%s: %u corners welded into %u verts (%.2fx smaller)\n", filename, stats.corners, stats.vertices, stats.ReductionRatio());
+
+	// Reorder for the post-transform cache, overdraw and vertex fetch
+	VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(&indices[0], indices.size(), verts.size());
+	MeshOptimizer::Optimize(verts, indices);
+	VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(&indices[0], indices.size(), verts.size());
+	printf("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", filename, before.ACMR(), after.ACMR(), before.ATVR(), after.ATVR());
+
+	// tangents come from the full detail triangles, the LODs reuse the same verts
+	TangentGenerator::Generate(&verts[0], (int)verts.size(), &indices[0], (int)indices.size());
+
+	// Simplified versions go after LOD 0 in the same index list
+	MeshSimplifier::BuildLods(verts, indices, lods);
+	for (size_t i = 1; i < lods.size(); i++)
+	{
+		printf("%s: LOD %zu has %u triangles (error %.4f)\n", filename, i, lods[i].indexCount / 3, lods[i].error);
+	}
+
+	// Cook it so the next run can skip all of the above
+	MeshBinary::Write(cookedPath.c_str(), verts, indices, lods, format, sourceSize, sourceChecksum, sourceTime);
+
+	// Pack the verts the same way the cooker just did
+	XMFLOAT3 boundsMin, boundsMax;
+	MeshBinary::GetBounds(verts, &boundsMin, &boundsMax);
+	quantization = VertexPacker::GetQuantization(boundsMin, boundsMax);
+	bounds = Bounds::FromMinMax(boundsMin, boundsMax);
+	if (format == VERTEX_FORMAT::PACKED)
+	{
+		VertexPackingError error = VertexPacker::MeasureError(&verts[0], verts.size(), quantization);
+		printf("%s: packed verts are off by up to %.5f units, %.3f deg normals, %.3f deg tangents, %.5f uv\n",
+			filename, error.position, error.normal, error.tangent, error.uv);
+
+		packedVerts.resize(verts.size());
+		VertexPacker::Pack(&verts[0], verts.size(), quantization, &packedVerts[0]);
+		verts.clear();
+	}
+
+	// halve the index data when every index fits in 16 bits, packed meshes have just cleared verts
+	if (GetVertexCount() <= 0xFFFF)
+	{
+		shortIndices.assign(indices.begin(), indices.end());
+		indices.clear();
+	}
+	return true;
+}
+
+const void* MeshSource::GetVertices() const
+{
+	if (cookedLoaded) return cooked.GetVertices();
+	return format == VERTEX_FORMAT::PACKED ? (const void*)&packedVerts[0] : (const void*)&verts[0];
+}
+
+unsigned int MeshSource::GetVertexStride() const
+{
+	return format == VERTEX_FORMAT::PACKED ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+const void* MeshSource::GetIndices() const
+{
+	if (cookedLoaded) return cooked.GetIndices();
+	return shortIndices.empty() ? (const void*)&indices[0] : (const void*)&shortIndices[0];
+}
+
+unsigned int MeshSource::GetIndexStride() const
+{
+	if (cookedLoaded) return cooked.GetHeader().indexStride;
+	return shortIndices.empty() ? sizeof(unsigned int) : sizeof(unsigned short);
+}
+
+int MeshSource::GetVertexCount() const
+{
+	if (cookedLoaded) return (int)cooked.GetHeader().vertexCount;
+	return format == VERTEX_FORMAT::PACKED ? (int)packedVerts.size() : (int)verts.size();
+}
+
+const MeshLod* MeshSource::GetLods() const
+{
+	return cookedLoaded ? cooked.GetLods() : &lods[0];
+}
+
+int MeshSource::GetLodCount() const
+{
+	return cookedLoaded ? (int)cooked.GetHeader().lodCount : (int)lods.size();
+}
+
+int MeshSource::GetIndexCount() const
+{
+	if (cookedLoaded) return (int)cooked.GetHeader().indexCount;
+	return shortIndices.empty() ? (int)indices.size() : (int)shortIndices.size();
+}
+
+void MeshSource::BuildOccluder(OccluderMesh& occluder, float maxErrorFraction) const
+{
+	occluder.positions.clear();
+	occluder.indices.clear();
+	if (GetLodCount() == 0 || GetVertexCount() == 0) return;
+
+	// the simplified LODs never move a surface by more than their error, which keeps
+	// the occluder close enough to the real silhouette to hide things behind it
+	const MeshLod* lods = GetLods();
+	int lod = 0;
+	for (int i = GetLodCount() - 1; i > 0; i--)
+	{
+		if (lods[i].error <= bounds.radius * maxErrorFraction)
+		{
+			lod = i;
+			break;
+		}
+	}
+
+	const unsigned char* vertexData = (const unsigned char*)GetVertices();
+	const unsigned char* indexData = (const unsigned char*)GetIndices();
+	unsigned int vertexStride = GetVertexStride();
+	unsigned int indexStride = GetIndexStride();
+	std::unordered_map<unsigned int, unsigned int> remap;
+	occluder.indices.reserve(lods[lod].indexCount);
+	for (unsigned int i = lods[lod].indexStart; i < lods[lod].indexStart + lods[lod].indexCount; i++)
+	{
+		unsigned int index = indexStride == sizeof(unsigned short) ? ((const unsigned short*)indexData)[i] : ((const unsigned int*)indexData)[i];
+		auto found = remap.find(index);
+		if (found == remap.end())
+		{
+			found = remap.emplace(index, (unsigned int)occluder.positions.size()).first;
+
+			const unsigned char* vertex = vertexData + (size_t)index * vertexStride;
+			if (format == VERTEX_FORMAT::PACKED)
+			{
+				// position = offset + unorm * scale
+				const unsigned short* packed = ((const PackedVertex*)vertex)->Position;
+				occluder.positions.push_back(XMFLOAT3(
+					quantization.offset.x + packed[0] / 65535.0f * quantization.scale.x,
+					quantization.offset.y + packed[1] / 65535.0f * quantization.scale.y,
+					quantization.offset.z + packed[2] / 65535.0f * quantization.scale.z));
+			}
+			else
+			{
+				occluder.positions.push_back(((const Vertex*)vertex)->Position);
+			}
+		}
+		occluder.indices.push_back(found->second);
+	}
+}
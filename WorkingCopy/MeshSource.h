@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Vertex.h"
+#include "MeshBinary.h"
+#include "Bounds.h"
+#include "OccluderMesh.h"
+#include <vector>
+
+// --------------------------------------------------------
+// The CPU side of loading a mesh: everything up to the
+// point where the data is ready to be copied to the GPU.
+//
+// Doesn't touch the device, so it can run on any thread.
+// The data either lives in a mapped cooked file or, the
+// first time a model is seen, in vectors built from the OBJ
+// --------------------------------------------------------
+class MeshSource
+{
+public:
+	// loads the cooked file if it's current, otherwise parses and cooks the OBJ
+	bool Load(const char* filename, VERTEX_FORMAT format = VERTEX_FORMAT::FULL);
+
+	// Vertex or PackedVertex data, depending on the format
+	const void* GetVertices() const;
+	unsigned int GetVertexStride() const;
+	inline VERTEX_FORMAT GetVertexFormat() const { return format; }
+	// turns packed positions back into model space
+	inline const VertexQuantization& GetQuantization() const { return quantization; }
+	// model space box and sphere around every vertex
+	inline const Bounds& GetBounds() const { return bounds; }
+	const void* GetIndices() const;
+	unsigned int GetIndexStride() const;
+	int GetVertexCount() const;
+	int GetIndexCount() const;
+	// ranges of the index data, LOD 0 first
+	const MeshLod* GetLods() const;
+	int GetLodCount() const;
+	inline bool IsCooked() const { return cookedLoaded; }
+
+	// the coarsest LOD that moved the surface less than maxErrorFraction of the bounds'
+	// radius, or LOD 0, with just the verts it uses
+	void BuildOccluder(OccluderMesh& occluder, float maxErrorFraction = 0.01f) const;
+
+private:
+	CookedMesh cooked;
+	bool cookedLoaded = false;
+	VERTEX_FORMAT format = VERTEX_FORMAT::FULL;
+	VertexQuantization quantization;
+	Bounds bounds;
+
+	// used when there was no current cooked file
+	std::vector<Vertex> verts;
+	std::vector<PackedVertex> packedVerts;
+	std::vector<unsigned short> shortIndices;
+	std::vector<unsigned int> indices;
+	std::vector<MeshLod> lods;
+};
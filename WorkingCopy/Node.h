@@ -1,7 +1,9 @@
 #pragma once
 #include <DirectXMath.h>
 #include "Collider.h"
+#include "QuadtreeSettings.h"
 #include <vector>
+#include <algorithm>
 using namespace std;
 
 struct QuadNode {
@@ -17,19 +19,15 @@ struct QuadNode {
     float xPos;
     float yPos;
     float length;
-
-    QuadNode(std::vector<Collider*> newObjects) {
-        xPos = 0;
-        yPos = 0;
-        length = 200;
-        objects = newObjects;
+    const QuadtreeSettings* settings;
+
+    // the root, covering the whole area in the settings
+    QuadNode(const QuadtreeSettings* n_settings) {
+        settings = n_settings;
+        xPos = settings->center.x;
+        yPos = settings->center.y;
+        length = settings->halfSize;
         depth = 0;
-        if (objects.size() >= 3) {
-            CreateChildNodes();
-            isLeaf = false;
-
-        }
-        isLeaf = true;
     }
 
     ~QuadNode() {
@@ -41,104 +39,117 @@ struct QuadNode {
         }
     }
 
-    QuadNode(std::vector<Collider*> newObjects, float n_Xpos, float n_Ypos, float n_length, int n_depth) {
+    QuadNode(const QuadtreeSettings* n_settings, float n_Xpos, float n_Ypos, float n_length, int n_depth) {
+        settings = n_settings;
         xPos = n_Xpos;
         yPos = n_Ypos;
         length = n_length;
         depth = n_depth;
-
-        GetObjectsInBounds(newObjects);
-
-        if (objects.size() >= 3 && depth <= 5) {
-            CreateChildNodes();
-            isLeaf = false;
-        }
-        else {
-            isLeaf = true;
-        }
-
     }
 
-    void GetObjectsInBounds(std::vector<Collider*> newObjects) {
-        for (int i = 0; i < newObjects.size(); i++) {
-
-            if (isInBounds(newObjects[i])) {
-                objects.push_back(newObjects[i]);
-            }
-        }
-
+    // loose nodes reach past their square by looseness * their size
+    bool isLoose() {
+        return settings->looseness > 0.0f;
     }
 
-    bool isInBounds(Collider* obj) {
-        float eXpos = obj->GetCenter().x;
-        float eYpos = obj->GetCenter().y;
-        if (obj->GetType() == 0) {
+    float looseLength() {
+        return length * (1.0f + settings->looseness);
+    }
 
-            float radius = obj->GetRadius();
+    // min x, min y, max x, max y against this node's (loose) square
+    bool overlaps(const DirectX::XMFLOAT4& box) {
+        float reach = looseLength();
+        return box.x <= xPos + reach && box.z >= xPos - reach &&
+            box.y <= yPos + reach && box.w >= yPos - reach;
+    }
 
-            if (eXpos <= xPos + length + radius && eXpos >= xPos - length - radius) {
-                if (eYpos <= yPos + length + radius && eYpos >= yPos - length - radius) {
-                    return true;
-                }
+    bool contains(const DirectX::XMFLOAT4& box) {
+        float reach = looseLength();
+        return box.x >= xPos - reach && box.z <= xPos + reach &&
+            box.y >= yPos - reach && box.w <= yPos + reach;
+    }
 
-            }
-        }
-        else {
-            float width = obj->GetSize().x;
-            float heigh = obj->GetSize().y;
-            if (abs(eXpos - xPos) <= width + length && abs(eYpos - yPos) <= heigh + length) {
-                return true;
-            }
-        }
-        return false;
+    bool shouldSplit() {
+        return objects.size() > settings->leafCapacity && depth < settings->maxDepth;
+    }
 
+    // the child whose square the center of the box is in
+    QuadNode* childFor(const DirectX::XMFLOAT4& box) {
+        float x = (box.x + box.z) * 0.5f;
+        float y = (box.y + box.w) * 0.5f;
+        if (x >= xPos) return y >= yPos ? child1 : child2;
+        return y >= yPos ? child3 : child4;
     }
 
 
     void CreateChildNodes() {
-        child1 = new QuadNode(objects, xPos + (length / 2), yPos + (length / 2), length / 2, depth + 1);
-        child2 = new QuadNode(objects, xPos + (length / 2), yPos - (length / 2), length / 2, depth + 1);
-        child3 = new QuadNode(objects, xPos - (length / 2), yPos + (length / 2), length / 2, depth + 1);
-        child4 = new QuadNode(objects, xPos - (length / 2), yPos - (length / 2), length / 2, depth + 1);
+        child1 = new QuadNode(settings, xPos + (length / 2), yPos + (length / 2), length / 2, depth + 1);
+        child2 = new QuadNode(settings, xPos + (length / 2), yPos - (length / 2), length / 2, depth + 1);
+        child3 = new QuadNode(settings, xPos - (length / 2), yPos + (length / 2), length / 2, depth + 1);
+        child4 = new QuadNode(settings, xPos - (length / 2), yPos - (length / 2), length / 2, depth + 1);
+        isLeaf = false;
+
+        // push the objects down, a loose node keeps the ones too big for any child
+        std::vector<Collider*> toPush;
+        toPush.swap(objects);
+        for (Collider* obj : toPush) {
+            if (isLoose()) AddLoose(obj);
+            else AddToTree(obj);
+        }
+    }
 
 
+    // appends every collider whose bounds overlap the query box to results, skipping
+    // colliders already stamped by this query (they straddle several leaves).
+    // tested counts the colliders whose bounds had to be checked
+    void getInteractions(const DirectX::XMFLOAT4& box, unsigned int stamp, std::vector<Collider*>& results, unsigned long long& tested) {
+        auto append = [&results](Collider* obj) { results.push_back(obj); };
+        visitInteractions(box, stamp, append, tested);
     }
 
-
-    std::vector<Collider*> getInteractions(Collider* playerCol) {
-        if (isLeaf) {
-            return objects;
+    // same walk as getInteractions, calling visit once per collider instead of storing it
+    template<class Visitor>
+    void visitInteractions(const DirectX::XMFLOAT4& box, unsigned int stamp, Visitor& visit, unsigned long long& tested) {
+        for (Collider* obj : objects) {
+            if (obj->queryStamp == stamp) continue;
+
+            // stamped even when it misses, so straddling colliders are only tested once
+            obj->queryStamp = stamp;
+            tested++;
+            DirectX::XMFLOAT4 b = obj->GetBounds();
+            if (b.x > box.z || b.z < box.x || b.y > box.w || b.w < box.y) continue;
+            visit(obj);
         }
+        if (isLeaf) return;
 
-        std::vector<Collider*> interactibles;
-        if (child1->isInBounds(playerCol)) {
-            std::vector<Collider*> c1Obj = child1->getInteractions(playerCol);
-            interactibles.insert(interactibles.end(), c1Obj.begin(), c1Obj.end());
-        }
-        if (child2->isInBounds(playerCol)) {
-            std::vector<Collider*> c2Obj = child2->getInteractions(playerCol);
-            interactibles.insert(interactibles.end(), c2Obj.begin(), c2Obj.end());
-        }
-        if (child3->isInBounds(playerCol)) {
-            std::vector<Collider*> c3Obj = child3->getInteractions(playerCol);
-            interactibles.insert(interactibles.end(), c3Obj.begin(), c3Obj.end());
+        if (child1->overlaps(box)) child1->visitInteractions(box, stamp, visit, tested);
+        if (child2->overlaps(box)) child2->visitInteractions(box, stamp, visit, tested);
+        if (child3->overlaps(box)) child3->visitInteractions(box, stamp, visit, tested);
+        if (child4->overlaps(box)) child4->visitInteractions(box, stamp, visit, tested);
+    }
+
+    // resets every stamp, for when the query counter wraps around
+    void clearStamps() {
+        for (Collider* obj : objects) {
+            obj->queryStamp = 0;
         }
-        if (child4->isInBounds(playerCol)) {
-            std::vector<Collider*> c4Obj = child4->getInteractions(playerCol);
-            interactibles.insert(interactibles.end(), c4Obj.begin(), c4Obj.end());
+        if (!isLeaf) {
+            child1->clearStamps();
+            child2->clearStamps();
+            child3->clearStamps();
+            child4->clearStamps();
         }
-        return interactibles;
     }
 
 
+    // files the object in every leaf its tree bounds overlap
     void AddToTree(Collider* newObj) {
-        if (isInBounds(newObj)) {
+        if (overlaps(newObj->treeBounds)) {
             if (isLeaf) {
 
                 objects.push_back(newObj);
-                if (objects.size() >= 3 && depth <= 5) {
+                if (shouldSplit()) {
                     CreateChildNodes();
-                    isLeaf = false;
                 }
             }
             else {
@@ -153,5 +164,87 @@ struct QuadNode {
 
     }
 
-};
+    // files the object in the deepest node whose loose square holds its tree bounds,
+    // anything that fits nowhere stays in the root
+    void AddLoose(Collider* newObj) {
+        if (!isLeaf) {
+            QuadNode* child = childFor(newObj->treeBounds);
+            if (child->contains(newObj->treeBounds)) {
+                child->AddLoose(newObj);
+                return;
+            }
+        }
+
+        objects.push_back(newObj);
+        if (isLeaf && shouldSplit()) {
+            CreateChildNodes();
+        }
+    }
+
+    // takes the object out of every leaf its tree bounds reach, merging
+    // children back into this node once they hold too few to be worth it
+    void RemoveFromTree(Collider* obj) {
+        if (!overlaps(obj->treeBounds)) return;
+
+        if (isLeaf) {
+            eraseObject(obj);
+            return;
+        }
+
+        child1->RemoveFromTree(obj);
+        child2->RemoveFromTree(obj);
+        child3->RemoveFromTree(obj);
+        child4->RemoveFromTree(obj);
+        TryMerge();
+    }
+
+    // follows the same path AddLoose took
+    void RemoveLoose(Collider* obj) {
+        if (!isLeaf) {
+            QuadNode* child = childFor(obj->treeBounds);
+            if (child->contains(obj->treeBounds)) {
+                child->RemoveLoose(obj);
+                TryMerge();
+                return;
+            }
+        }
+        eraseObject(obj);
+    }
+
+    void eraseObject(Collider* obj) {
+        for (size_t i = 0; i < objects.size(); i++) {
+            if (objects[i] == obj) {
+                objects[i] = objects.back();
+                objects.pop_back();
+                return;
+            }
+        }
+    }
 
+    // turns this node back into a leaf if its children are leaves that would
+    // not have been split in the first place
+    void TryMerge() {
+        if (isLeaf) return;
+        if (!child1->isLeaf || !child2->isLeaf || !child3->isLeaf || !child4->isLeaf) return;
+
+        // objects that straddle children are in more than one of them
+        std::vector<Collider*> merged(objects);
+        QuadNode* children[4] = { child1, child2, child3, child4 };
+        for (QuadNode* child : children) {
+            for (Collider* obj : child->objects) {
+                if (std::find(merged.begin(), merged.end(), obj) == merged.end()) {
+                    merged.push_back(obj);
+                    if (merged.size() > settings->leafCapacity) return;
+                }
+            }
+        }
+
+        delete child1;
+        delete child2;
+        delete child3;
+        delete child4;
+        isLeaf = true;
+        objects.swap(merged);
+    }
+
+};
@@ -0,0 +1,379 @@
+#include "ObjParser.h"
+#include <fstream>
+#include <unordered_map>
+#include <cstdio>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+	// powers of ten for the fraction and exponent parts
+	const double powersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	inline double PowerOfTen(int exponent)
+	{
+		double result = 1.0;
+		bool negative = exponent < 0;
+		if (negative) exponent = -exponent;
+		while (exponent > 22)
+		{
+			result *= 1e22;
+			exponent -= 22;
+		}
+		result *= powersOfTen[exponent];
+		return negative ? 1.0 / result : result;
+	}
+
+	inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+	inline bool IsSpace(char c) { return c == ' ' || c == '\t'; }
+	inline bool IsLineEnd(char c) { return c == '\n' || c == '\r' || c == '\0'; }
+
+	inline const char* SkipSpaces(const char* c)
+	{
+		while (IsSpace(*c)) c++;
+		return c;
+	}
+
+	inline const char* SkipLine(const char* c, const char* end)
+	{
+		while (c < end && *c != '\n') c++;
+		return c < end ? c + 1 : end;
+	}
+
+	// reads a float in the [-]digits[.digits][e[-]digits] form
+	// returns the first character after the number
+	const char* ScanFloat(const char* c, float* value)
+	{
+		c = SkipSpaces(c);
+
+		bool negative = false;
+		if (*c == '-') { negative = true; c++; }
+		else if (*c == '+') { c++; }
+
+		// gather up to 19 significant digits as an integer
+		unsigned long long mantissa = 0;
+		int digits = 0;
+		int exponent = 0;
+		while (IsDigit(*c))
+		{
+			if (digits < 19) { mantissa = mantissa * 10 + (*c - '0'); digits++; }
+			else exponent++;
+			c++;
+		}
+		if (*c == '.')
+		{
+			c++;
+			while (IsDigit(*c))
+			{
+				if (digits < 19) { mantissa = mantissa * 10 + (*c - '0'); digits++; exponent--; }
+				c++;
+			}
+		}
+		if (*c == 'e' || *c == 'E')
+		{
+			c++;
+			bool negativeExponent = false;
+			if (*c == '-') { negativeExponent = true; c++; }
+			else if (*c == '+') { c++; }
+			int e = 0;
+			while (IsDigit(*c))
+			{
+				if (e < 10000) e = e * 10 + (*c - '0');
+				c++;
+			}
+			exponent += negativeExponent ? -e : e;
+		}
+
+		double result = (double)mantissa;
+		if (exponent != 0) result *= PowerOfTen(exponent);
+		*value = (float)(negative ? -result : result);
+		return c;
+	}
+
+	// reads a signed integer, returns nullptr if there wasn't one
+	const char* ScanInt(const char* c, int* value)
+	{
+		bool negative = false;
+		if (*c == '-') { negative = true; c++; }
+		else if (*c == '+') { c++; }
+		if (!IsDigit(*c)) return nullptr;
+
+		int result = 0;
+		while (IsDigit(*c))
+		{
+			result = result * 10 + (*c - '0');
+			c++;
+		}
+		*value = negative ? -result : result;
+		return c;
+	}
+
+	// turns a 1 based or negative (relative) OBJ index into a zero based one
+	inline int ResolveIndex(int index, size_t count)
+	{
+		if (index > 0) return index - 1;
+		if (index < 0) return (int)count + index;
+		return -1;
+	}
+
+	inline bool InRange(int index, size_t count)
+	{
+		return index >= 0 && (size_t)index < count;
+	}
+
+	// key used to find corners that can share a vertex
+	struct CornerKey
+	{
+		int position;
+		int uv;
+		int normal;
+		bool operator==(const CornerKey& other) const
+		{
+			return position == other.position && uv == other.uv && normal == other.normal;
+		}
+	};
+
+	struct CornerKeyHash
+	{
+		size_t operator()(const CornerKey& key) const
+		{
+			// mix the three indices so neighbouring corners spread out
+			unsigned long long h = (unsigned int)key.position;
+			h = h * 0x9E3779B97F4A7C15ull ^ (unsigned int)key.uv;
+			h = h * 0x9E3779B97F4A7C15ull ^ (unsigned int)key.normal;
+			return (size_t)(h ^ (h >> 29));
+		}
+	};
+
+	// hashes the raw bits of a stream entry
+	template <typename T>
+	struct BitsHash
+	{
+		size_t operator()(const T& value) const
+		{
+			const unsigned int* words = reinterpret_cast<const unsigned int*>(&value);
+			unsigned long long h = 0;
+			for (size_t i = 0; i < sizeof(T) / sizeof(unsigned int); i++)
+				h = (h ^ words[i]) * 0x100000001B3ull;
+			return (size_t)(h ^ (h >> 29));
+		}
+	};
+
+	template <typename T>
+	struct BitsEqual
+	{
+		bool operator()(const T& a, const T& b) const { return memcmp(&a, &b, sizeof(T)) == 0; }
+	};
+
+	// for every entry, the index of the first entry with identical bits
+	template <typename T>
+	std::vector<int> RemapDuplicates(const std::vector<T>& stream)
+	{
+		std::vector<int> ids(stream.size());
+		std::unordered_map<T, int, BitsHash<T>, BitsEqual<T>> first;
+		first.reserve(stream.size());
+		for (size_t i = 0; i < stream.size(); i++)
+		{
+			ids[i] = first.insert({ stream[i], (int)i }).first->second;
+		}
+		return ids;
+	}
+}
+
+bool ObjParser::ParseFile(const char* filename, MeshData& data)
+{
+	// Read the whole file in one go
+	std::ifstream obj(filename, std::ios::binary | std::ios::ate);
+	if (!obj.is_open())
+	{
+		printf("Failed to open file %s.\n", filename);
+		return false;
+	}
+
+	std::streamsize size = obj.tellg();
+	obj.seekg(0, std::ios::beg);
+
+	// keep a terminator after the text so the scanners never run off the end
+	std::vector<char> text((size_t)size + 1, '\0');
+	if (size > 0 && !obj.read(text.data(), size))
+	{
+		printf("Failed to read file %s.\n", filename);
+		return false;
+	}
+	obj.close();
+
+	return Parse(text.data(), (size_t)size, data);
+}
+
+bool ObjParser::Parse(const char* text, size_t length, MeshData& data)
+{
+	data.positions.clear();
+	data.normals.clear();
+	data.uvs.clear();
+	data.indices.clear();
+
+	// corners of the face currently being read, reused for every face
+	std::vector<ObjCorner> face;
+	face.reserve(16);
+
+	const char* c = text;
+	const char* end = text + length;
+	while (c < end)
+	{
+		c = SkipSpaces(c);
+
+		if (c[0] == 'v' && c[1] == 'n' && IsSpace(c[2]))
+		{
+			XMFLOAT3 norm;
+			c = ScanFloat(c + 2, &norm.x);
+			c = ScanFloat(c, &norm.y);
+			c = ScanFloat(c, &norm.z);
+
+			// Flip normal Z (LH vs. RH)
+			norm.z *= -1.0f;
+			data.normals.push_back(norm);
+		}
+		else if (c[0] == 'v' && c[1] == 't' && IsSpace(c[2]))
+		{
+			XMFLOAT2 uv;
+			c = ScanFloat(c + 2, &uv.x);
+			c = ScanFloat(c, &uv.y);
+
+			// Flip the V since DirectX defines (0,0) as the top left
+			uv.y = 1.0f - uv.y;
+			data.uvs.push_back(uv);
+		}
+		else if (c[0] == 'v' && IsSpace(c[1]))
+		{
+			XMFLOAT3 pos;
+			c = ScanFloat(c + 1, &pos.x);
+			c = ScanFloat(c, &pos.y);
+			c = ScanFloat(c, &pos.z);
+
+			// Flip Z (LH vs. RH)
+			pos.z *= -1.0f;
+			data.positions.push_back(pos);
+		}
+		else if (c[0] == 'f' && IsSpace(c[1]))
+		{
+			face.clear();
+			c = SkipSpaces(c + 1);
+
+			// read corners until the end of the line
+			while (!IsLineEnd(*c))
+			{
+				int value = 0;
+				const char* next = ScanInt(c, &value);
+				if (next == nullptr) break;
+
+				ObjCorner corner = { ResolveIndex(value, data.positions.size()), -1, -1 };
+				c = next;
+				if (*c == '/')
+				{
+					c++;
+					// uv is optional (v//vn)
+					next = ScanInt(c, &value);
+					if (next != nullptr)
+					{
+						corner.uv = ResolveIndex(value, data.uvs.size());
+						c = next;
+					}
+					if (*c == '/')
+					{
+						c++;
+						next = ScanInt(c, &value);
+						if (next != nullptr)
+						{
+							corner.normal = ResolveIndex(value, data.normals.size());
+							c = next;
+						}
+					}
+				}
+
+				// drop anything that points outside of the streams
+				if (!InRange(corner.position, data.positions.size())) break;
+				if (!InRange(corner.uv, data.uvs.size())) corner.uv = -1;
+				if (!InRange(corner.normal, data.normals.size())) corner.normal = -1;
+
+				face.push_back(corner);
+				c = SkipSpaces(c);
+			}
+
+			// fan the polygon into triangles, flipping the winding order
+			for (size_t i = 2; i < face.size(); i++)
+			{
+				data.indices.push_back(face[0]);
+				data.indices.push_back(face[i]);
+				data.indices.push_back(face[i - 1]);
+			}
+		}
+
+		// move on to the next line
+		c = SkipLine(c, end);
+	}
+
+	return !data.indices.empty();
+}
+
+WeldStats ObjParser::WeldVertices(const MeshData& data, std::vector<Vertex>& verts, std::vector<unsigned int>& indices)
+{
+	verts.clear();
+	indices.clear();
+	indices.reserve(data.indices.size());
+
+	// exporters often write the same value many times (a normal per corner)
+	// so map every stream entry to the first entry holding the same value
+	std::vector<int> positionIds = RemapDuplicates(data.positions);
+	std::vector<int> uvIds = RemapDuplicates(data.uvs);
+	std::vector<int> normalIds = RemapDuplicates(data.normals);
+
+	// remembers which vertex every (position, uv, normal) triple became
+	std::unordered_map<CornerKey, unsigned int, CornerKeyHash> unique;
+	unique.reserve(data.indices.size());
+
+	for (size_t i = 0; i + 2 < data.indices.size(); i += 3)
+	{
+		// faces without normals get the flat normal of the triangle
+		XMVECTOR p0 = XMLoadFloat3(&data.positions[data.indices[i].position]);
+		XMVECTOR p1 = XMLoadFloat3(&data.positions[data.indices[i + 1].position]);
+		XMVECTOR p2 = XMLoadFloat3(&data.positions[data.indices[i + 2].position]);
+		XMFLOAT3 faceNormal;
+		XMStoreFloat3(&faceNormal, XMVector3Normalize(XMVector3Cross(p1 - p0, p2 - p0)));
+
+		for (size_t j = i; j < i + 3; j++)
+		{
+			const ObjCorner& corner = data.indices[j];
+
+			// flat normals belong to one triangle, so key them by the triangle
+			CornerKey key = { positionIds[corner.position], -1, -1 };
+			if (corner.uv >= 0) key.uv = uvIds[corner.uv];
+			key.normal = corner.normal >= 0 ? normalIds[corner.normal] : -2 - (int)(i / 3);
+
+			auto found = unique.find(key);
+			if (found != unique.end())
+			{
+				indices.push_back(found->second);
+				continue;
+			}
+
+			Vertex v = {};
+			v.Position = data.positions[corner.position];
+			v.UV = corner.uv >= 0 ? data.uvs[corner.uv] : XMFLOAT2(0, 0);
+			v.Normal = corner.normal >= 0 ? data.normals[corner.normal] : faceNormal;
+
+			unsigned int index = (unsigned int)verts.size();
+			unique.insert({ key, index });
+			indices.push_back(index);
+			verts.push_back(v);
+		}
+	}
+
+	WeldStats stats;
+	stats.corners = (unsigned int)indices.size();
+	stats.vertices = (unsigned int)verts.size();
+	return stats;
+}
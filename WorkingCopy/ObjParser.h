@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Vertex.h"
+#include <DirectXMath.h>
+#include <vector>
+
+// --------------------------------------------------------
+// One corner of a face, as zero based indices into the
+// MeshData streams.  -1 means the face didn't supply it
+// --------------------------------------------------------
+struct ObjCorner
+{
+	int position;
+	int uv;
+	int normal;
+};
+
+// --------------------------------------------------------
+// Device independent contents of an OBJ file
+//
+// Everything is already converted to DirectX conventions:
+// Z is flipped, V is flipped and faces are triangulated
+// with the winding order reversed
+// --------------------------------------------------------
+struct MeshData
+{
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<DirectX::XMFLOAT3> normals;
+	std::vector<DirectX::XMFLOAT2> uvs;
+	std::vector<ObjCorner> indices;     // three corners per triangle
+};
+
+// --------------------------------------------------------
+// How much welding shrank a mesh
+// --------------------------------------------------------
+struct WeldStats
+{
+	unsigned int corners = 0;   // vertices before welding (one per face corner)
+	unsigned int vertices = 0;  // unique vertices after welding
+	inline float ReductionRatio() const { return vertices > 0 ? (float)corners / vertices : 0.0f; }
+};
+
+// --------------------------------------------------------
+// Reads Wavefront OBJ files without going through iostreams
+// or sscanf.  Supports any length of line, n-gons, negative
+// (relative) indices and the v, v/vt, v//vn, v/vt/vn forms
+// --------------------------------------------------------
+class ObjParser
+{
+public:
+	// reads the whole file into memory and parses it
+	static bool ParseFile(const char* filename, MeshData& data);
+
+	// parses text that is already in memory, text[length] must be '\0'
+	static bool Parse(const char* text, size_t length, MeshData& data);
+
+	// turns every unique (position, uv, normal) triple into one vertex
+	// and builds an index buffer that points at them
+	static WeldStats WeldVertices(const MeshData& data, std::vector<Vertex>& verts, std::vector<unsigned int>& indices);
+};
@@ -0,0 +1,240 @@
+#include "ObjParser.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Holds ObjParser to what the getline/sscanf loop it replaced
+// in Mesh read from the same files, and measures both in MB/s
+// on the game's biggest models and a generated one with
+// millions of faces.
+//
+// Pass a face count to change the size of the generated file
+// --------------------------------------------------------
+
+namespace
+{
+	// the loop Mesh(filename, device) used to run, with sscanf for sscanf_s
+	bool OldLoad(const char* filename, std::vector<Vertex>& verts)
+	{
+		std::ifstream obj(filename);
+		if (!obj.is_open()) return false;
+
+		std::vector<XMFLOAT3> positions;
+		std::vector<XMFLOAT3> normals;
+		std::vector<XMFLOAT2> uvs;
+		char chars[100];
+
+		while (obj.good())
+		{
+			obj.getline(chars, 100);
+
+			if (chars[0] == 'v' && chars[1] == 'n')
+			{
+				XMFLOAT3 norm;
+				sscanf(chars, "vn %f %f %f", &norm.x, &norm.y, &norm.z);
+				normals.push_back(norm);
+			}
+			else if (chars[0] == 'v' && chars[1] == 't')
+			{
+				XMFLOAT2 uv;
+				sscanf(chars, "vt %f %f", &uv.x, &uv.y);
+				uvs.push_back(uv);
+			}
+			else if (chars[0] == 'v')
+			{
+				XMFLOAT3 pos;
+				sscanf(chars, "v %f %f %f", &pos.x, &pos.y, &pos.z);
+				positions.push_back(pos);
+			}
+			else if (chars[0] == 'f')
+			{
+				unsigned int i[12];
+				int facesRead = sscanf(
+					chars,
+					"f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u",
+					&i[0], &i[1], &i[2],
+					&i[3], &i[4], &i[5],
+					&i[6], &i[7], &i[8],
+					&i[9], &i[10], &i[11]);
+
+				Vertex v[4];
+				for (int c = 0; c < facesRead / 3; c++)
+				{
+					v[c].Position = positions[i[c * 3] - 1];
+					v[c].UV = uvs[i[c * 3 + 1] - 1];
+					v[c].Normal = normals[i[c * 3 + 2] - 1];
+					v[c].UV.y = 1.0f - v[c].UV.y;
+					v[c].Position.z *= -1.0f;
+					v[c].Normal.z *= -1.0f;
+				}
+
+				verts.push_back(v[0]);
+				verts.push_back(v[2]);
+				verts.push_back(v[1]);
+
+				if (facesRead == 12)
+				{
+					verts.push_back(v[0]);
+					verts.push_back(v[3]);
+					verts.push_back(v[2]);
+				}
+			}
+		}
+		return true;
+	}
+
+	// the parser's corners turned into one vertex each, the way the old loop made them
+	bool NewLoad(const char* filename, std::vector<Vertex>& verts)
+	{
+		MeshData data;
+		if (!ObjParser::ParseFile(filename, data)) return false;
+
+		verts.resize(data.indices.size());
+		for (size_t i = 0; i < data.indices.size(); i++)
+		{
+			const ObjCorner& corner = data.indices[i];
+			verts[i].Position = data.positions[corner.position];
+			verts[i].UV = data.uvs[corner.uv];
+			verts[i].Normal = data.normals[corner.normal];
+		}
+		return true;
+	}
+
+	// the parser rounds through doubles rather than like strtof, so allow the last bit
+	inline bool Near(float a, float b)
+	{
+		return fabsf(a - b) <= 1e-6f * (1.0f + fabsf(a));
+	}
+
+	bool SameVertices(const std::vector<Vertex>& a, const std::vector<Vertex>& b)
+	{
+		if (a.size() != b.size()) return false;
+		for (size_t i = 0; i < a.size(); i++)
+		{
+			if (!Near(a[i].Position.x, b[i].Position.x) || !Near(a[i].Position.y, b[i].Position.y) || !Near(a[i].Position.z, b[i].Position.z) ||
+				!Near(a[i].Normal.x, b[i].Normal.x) || !Near(a[i].Normal.y, b[i].Normal.y) || !Near(a[i].Normal.z, b[i].Normal.z) ||
+				!Near(a[i].UV.x, b[i].UV.x) || !Near(a[i].UV.y, b[i].UV.y))
+			{
+				printf("  vertex %zu differs\n", i);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	long FileSize(const char* filename)
+	{
+		FILE* file = fopen(filename, "rb");
+		if (!file) return 0;
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fclose(file);
+		return size;
+	}
+
+	// a grid of triangles with every corner in the v/vt/vn form the old loop needs
+	void WriteGrid(const char* filename, int faces)
+	{
+		int side = (int)sqrtf(faces / 2.0f);
+		FILE* file = fopen(filename, "w");
+		for (int z = 0; z <= side; z++)
+		{
+			for (int x = 0; x <= side; x++)
+			{
+				float height = sinf(x * 0.37f) * cosf(z * 0.23f);
+				fprintf(file, "v %f %f %f\n", x * 0.5f, height, z * 0.5f);
+				fprintf(file, "vt %f %f\n", (float)x / side, (float)z / side);
+			}
+		}
+		fprintf(file, "vn 0.000000 1.000000 0.000000\n");
+
+		for (int z = 0; z < side; z++)
+		{
+			for (int x = 0; x < side; x++)
+			{
+				int a = z * (side + 1) + x + 1;
+				int b = a + 1;
+				int c = a + side + 1;
+				int d = c + 1;
+				fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, c, c, b, b);
+				fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", b, b, c, c, d, d);
+			}
+		}
+		fclose(file);
+	}
+
+	// best of a few runs for small files, big ones are slow enough to time once
+	template<typename Load>
+	double BestMilliseconds(Load load, const char* filename, std::vector<Vertex>& verts, int runs)
+	{
+		double best = 1e30;
+		for (int run = 0; run < runs; run++)
+		{
+			verts.clear();
+			TestTimer timer;
+			CHECK(load(filename, verts));
+			double ms = timer.Milliseconds();
+			if (ms < best) best = ms;
+		}
+		return best;
+	}
+
+	// returns how many times faster the parser was
+	double Compare(const char* filename, int runs)
+	{
+		double megabytes = FileSize(filename) / (1024.0 * 1024.0);
+		std::vector<Vertex> oldVerts;
+		std::vector<Vertex> newVerts;
+		double oldMs = BestMilliseconds(OldLoad, filename, oldVerts, runs);
+		double newMs = BestMilliseconds(NewLoad, filename, newVerts, runs);
+
+		printf("%s: %.2f MB, %zu triangles, getline/sscanf %.1f MB/s, ObjParser %.1f MB/s (%.1fx)\n",
+			filename, megabytes, newVerts.size() / 3, megabytes / (oldMs / 1000.0), megabytes / (newMs / 1000.0), oldMs / newMs);
+
+		CHECK(!newVerts.empty());
+		CHECK(SameVertices(oldVerts, newVerts));
+		return oldMs / newMs;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int faces = argc > 1 ? atoi(argv[1]) : 2000000;
+
+	Compare("Models/Campfire.obj", 5);
+	Compare("Models/helix.obj", 5);
+	Compare("Models/torus.obj", 5);
+
+	const char* grid = "ObjParserTestGrid.obj";
+	WriteGrid(grid, faces);
+	double speedup = Compare(grid, 1);
+	remove(grid);
+
+	// on a file this size any real improvement is well past the timer's noise
+	CHECK(speedup > 1.0);
+
+	// things the old loop couldn't read at all: n-gons, negative indices, missing streams, long lines
+	// (the last face is still wound the other way round, 4 2 3)
+	const char* text =
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0.5 2 1e-1\n"
+		"vn 0 0 1\n"
+		"f 1//1 2//1 3//1 4//1 5//1\n"
+		"f -1 -2 -3\n"
+		"# a comment longer than the hundred characters the old loop read into its buffer at once, which it would have split in two\n";
+	MeshData data;
+	CHECK(ObjParser::Parse(text, strlen(text), data));
+	CHECK(data.positions.size() == 5);
+	CHECK(data.indices.size() == 4 * 3);
+	CHECK(data.indices[9].position == 4 && data.indices[10].position == 2 && data.indices[11].position == 3);
+	CHECK(data.indices[9].uv == -1 && data.indices[9].normal == -1);
+	CHECK(Near(data.positions[4].z, -0.1f));
+
+	return TestResult();
+}
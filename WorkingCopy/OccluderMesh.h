@@ -0,0 +1,21 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+// --------------------------------------------------------
+// Just the shape of a mesh, for the OcclusionCuller to
+// rasterize on the CPU.  Model space positions and a
+// triangle list, usually a coarse LOD of the real mesh
+// with only the vertices it uses
+// --------------------------------------------------------
+struct OccluderMesh
+{
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<unsigned int> indices;
+	// only faces pointing at the camera are drawn, which is enough for closed meshes.
+	// open ones, like a single wall, need both sides
+	bool twoSided = false;
+
+	inline bool IsEmpty() const { return indices.empty(); }
+	inline size_t GetTriangleCount() const { return indices.size() / 3; }
+};
@@ -0,0 +1,395 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+#if defined(_XM_AVX_INTRINSICS_) || defined(_XM_SSE_INTRINSICS_)
+#include <immintrin.h>
+#endif
+
+using namespace DirectX;
+
+namespace
+{
+	// the planes triangles are clipped against, inside where dot(plane, clip position) >= 0:
+	// near, left, right, bottom and top. nothing past the far plane is worth drawing but
+	// it can't hide anything either, so that one's left alone
+	const int ClipPlaneCount = 5;
+	const float ClipPlanes[ClipPlaneCount][4] = {
+		{ 0, 0, 1, 0 },
+		{ 1, 0, 0, 1 },
+		{ -1, 0, 0, 1 },
+		{ 0, 1, 0, 1 },
+		{ 0, -1, 0, 1 },
+	};
+
+	// boxes are tested this much nearer than they are, so a face lying right on the box
+	// (a wall, or the occluder's own box) doesn't hide it after rounding. a few dozen ulps
+	// near 1, about 0.2 units at the far plane of the game's camera
+	const float DepthBias = 2e-6f;
+
+	inline float PlaneDistance(const float plane[4], const XMFLOAT4& v)
+	{
+		return plane[0] * v.x + plane[1] * v.y + plane[2] * v.z + plane[3] * v.w;
+	}
+
+	// p * m for a row vector with w = 1
+	inline XMFLOAT4 TransformPoint(const XMFLOAT3& p, const XMFLOAT4X4& m)
+	{
+		return XMFLOAT4(
+			p.x * m.m[0][0] + p.y * m.m[1][0] + p.z * m.m[2][0] + m.m[3][0],
+			p.x * m.m[0][1] + p.y * m.m[1][1] + p.z * m.m[2][1] + m.m[3][1],
+			p.x * m.m[0][2] + p.y * m.m[1][2] + p.z * m.m[2][2] + m.m[3][2],
+			p.x * m.m[0][3] + p.y * m.m[1][3] + p.z * m.m[2][3] + m.m[3][3]);
+	}
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+{
+	tilesX = std::max((width + TileSize - 1) / TileSize, 1);
+	tilesY = std::max((height + TileSize - 1) / TileSize, 1);
+	this->width = tilesX * TileSize;
+	this->height = tilesY * TileSize;
+	depth.assign(this->width * this->height, 1.0f);
+	tileMax.assign(tilesX * tilesY, 1.0f);
+	XMStoreFloat4x4(&viewProjection, XMMatrixIdentity());
+}
+
+void OcclusionCuller::ChooseOccluders(XMFLOAT3 eye, const std::vector<Bounds>& bounds, std::vector<unsigned int>& chosen,
+	float minSize, size_t maxCount)
+{
+	// far away and small ones hide little and cost as much to draw
+	ranked.clear();
+	for (size_t i = 0; i < bounds.size(); i++)
+	{
+		float dx = bounds[i].center.x - eye.x;
+		float dy = bounds[i].center.y - eye.y;
+		float dz = bounds[i].center.z - eye.z;
+		// standing inside one still counts as big
+		float distance = sqrtf(dx * dx + dy * dy + dz * dz) + 0.001f;
+		float size = bounds[i].radius / distance;
+		if (size >= minSize) ranked.push_back(std::make_pair(size, (unsigned int)i));
+	}
+
+	// biggest on screen first, ties in the order they came
+	std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<float, unsigned int>& a, const std::pair<float, unsigned int>& b) {
+		return a.first > b.first;
+	});
+	if (ranked.size() > maxCount) ranked.resize(maxCount);
+
+	chosen.clear();
+	for (const std::pair<float, unsigned int>& candidate : ranked) chosen.push_back(candidate.second);
+}
+
+void OcclusionCuller::Begin(FXMMATRIX viewProjection)
+{
+	XMStoreFloat4x4(&this->viewProjection, viewProjection);
+	std::fill(depth.begin(), depth.end(), 1.0f);
+	std::fill(tileMax.begin(), tileMax.end(), 1.0f);
+	occluders.clear();
+	triangles.clear();
+}
+
+void OcclusionCuller::AddOccluder(const OccluderMesh* mesh, FXMMATRIX world)
+{
+	if (mesh == nullptr || mesh->IsEmpty()) return;
+
+	// straight to clip space
+	Occluder occluder;
+	occluder.mesh = mesh;
+	XMStoreFloat4x4(&occluder.world, world * XMLoadFloat4x4(&viewProjection));
+	occluders.push_back(occluder);
+}
+
+void OcclusionCuller::Render(int threads)
+{
+	// transforming and clipping is cheap next to filling, so it's done up front and
+	// the threads only share the finished triangles
+	triangles.clear();
+	for (const Occluder& occluder : occluders) {
+		const OccluderMesh& mesh = *occluder.mesh;
+		clipSpace.resize(mesh.positions.size());
+		for (size_t i = 0; i < mesh.positions.size(); i++) {
+			clipSpace[i] = TransformPoint(mesh.positions[i], occluder.world);
+		}
+		for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+			ClipTriangle(clipSpace[mesh.indices[i]], clipSpace[mesh.indices[i + 1]], clipSpace[mesh.indices[i + 2]], mesh.twoSided);
+		}
+	}
+
+	// every thread gets a band of whole tile rows, so none of them write the same pixel
+	int threadCount = std::min(std::max(threads, 1), tilesY);
+	if (threadCount <= 1) {
+		RasterizeTiles(0, tilesY);
+		return;
+	}
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threadCount; t++) {
+		workers.emplace_back([this, t, threadCount]() { RasterizeTiles(tilesY * t / threadCount, tilesY * (t + 1) / threadCount); });
+	}
+	RasterizeTiles(0, tilesY / threadCount);
+	for (std::thread& worker : workers) worker.join();
+}
+
+void OcclusionCuller::ClipTriangle(const XMFLOAT4& a, const XMFLOAT4& b, const XMFLOAT4& c, bool twoSided)
+{
+	// most triangles are entirely inside or entirely outside one plane
+	bool inside = true;
+	for (int p = 0; p < ClipPlaneCount; p++) {
+		float da = PlaneDistance(ClipPlanes[p], a);
+		float db = PlaneDistance(ClipPlanes[p], b);
+		float dc = PlaneDistance(ClipPlanes[p], c);
+		if (da < 0 && db < 0 && dc < 0) return;
+		if (da < 0 || db < 0 || dc < 0) inside = false;
+	}
+	if (inside) {
+		SetupTriangle(a, b, c, twoSided);
+		return;
+	}
+
+	// Sutherland-Hodgman, each plane can add at most one corner
+	XMFLOAT4 polygon[3 + ClipPlaneCount];
+	XMFLOAT4 next[3 + ClipPlaneCount];
+	int count = 3;
+	polygon[0] = a;
+	polygon[1] = b;
+	polygon[2] = c;
+	for (int p = 0; p < ClipPlaneCount && count >= 3; p++) {
+		int nextCount = 0;
+		for (int i = 0; i < count; i++) {
+			const XMFLOAT4& from = polygon[i];
+			const XMFLOAT4& to = polygon[(i + 1) % count];
+			float dFrom = PlaneDistance(ClipPlanes[p], from);
+			float dTo = PlaneDistance(ClipPlanes[p], to);
+			if (dFrom >= 0) next[nextCount++] = from;
+			if ((dFrom >= 0) != (dTo >= 0)) {
+				float t = dFrom / (dFrom - dTo);
+				next[nextCount++] = XMFLOAT4(from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t,
+					from.z + (to.z - from.z) * t, from.w + (to.w - from.w) * t);
+			}
+		}
+		count = nextCount;
+		std::copy(next, next + count, polygon);
+	}
+
+	// it's still convex, so a fan covers it
+	for (int i = 1; i + 1 < count; i++) {
+		SetupTriangle(polygon[0], polygon[i], polygon[i + 1], twoSided);
+	}
+}
+
+void OcclusionCuller::SetupTriangle(const XMFLOAT4& a, const XMFLOAT4& b, const XMFLOAT4& c, bool twoSided)
+{
+	// to pixels, y down, depth in 0-1
+	const XMFLOAT4* clip[3] = { &a, &b, &c };
+	float x[3], y[3], z[3];
+	for (int i = 0; i < 3; i++) {
+		float invW = 1.0f / clip[i]->w;
+		x[i] = (clip[i]->x * invW * 0.5f + 0.5f) * width;
+		y[i] = (0.5f - clip[i]->y * invW * 0.5f) * height;
+		z[i] = clip[i]->z * invW;
+	}
+
+	// front faces wind clockwise on screen, which is positive here with y down. when both
+	// sides are drawn the back faces are made to wind positive too
+	float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if (fabsf(area) < 1e-6f) return;
+	if (area < 0 && !twoSided) return;
+	float sign = area < 0 ? -1.0f : 1.0f;
+	area *= sign;
+
+	// which pixel centers it might cover
+	Triangle triangle;
+	triangle.minX = std::max((int)ceilf(std::min(x[0], std::min(x[1], x[2])) - 0.5f), 0);
+	triangle.maxX = std::min((int)floorf(std::max(x[0], std::max(x[1], x[2])) - 0.5f), width - 1);
+	triangle.minY = std::max((int)ceilf(std::min(y[0], std::min(y[1], y[2])) - 0.5f), 0);
+	triangle.maxY = std::min((int)floorf(std::max(y[0], std::max(y[1], y[2])) - 0.5f), height - 1);
+	if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY) return;
+
+	// the edge across from each corner is 0 on the edge and area at the corner, so
+	// dividing by area gives the barycentric weights the depth plane is built from
+	triangle.depthA = 0;
+	triangle.depthB = 0;
+	triangle.depthC = 0;
+	for (int i = 0; i < 3; i++) {
+		int from = (i + 1) % 3;
+		int to = (i + 2) % 3;
+		float edgeA = (y[from] - y[to]) * sign;
+		float edgeB = (x[to] - x[from]) * sign;
+		float edgeC = (x[from] * y[to] - y[from] * x[to]) * sign;
+		triangle.depthA += edgeA * z[i] / area;
+		triangle.depthB += edgeB * z[i] / area;
+		triangle.depthC += edgeC * z[i] / area;
+
+		// measured at pixel centers
+		triangle.edgeA[i] = edgeA;
+		triangle.edgeB[i] = edgeB;
+		triangle.edgeC[i] = edgeC + 0.5f * (edgeA + edgeB);
+		triangle.inverseEdgeA[i] = edgeA != 0 ? 1.0f / edgeA : 0.0f;
+	}
+	triangle.depthC += 0.5f * (triangle.depthA + triangle.depthB);
+	triangles.push_back(triangle);
+}
+
+void OcclusionCuller::RasterizeTiles(int startTile, int endTile)
+{
+	int startRow = startTile * TileSize;
+	int endRow = endTile * TileSize;
+
+	for (const Triangle& t : triangles) {
+		int minY = std::max(t.minY, startRow);
+		int maxY = std::min(t.maxY, endRow - 1);
+		for (int y = minY; y <= maxY; y++) {
+			// long thin triangles cover a sliver of their box, so each row works out where
+			// the edges cross it first. the edge tests still have the last word, so the
+			// span only has to be wide enough
+			float fy = (float)y;
+			float left = (float)t.minX;
+			float right = (float)t.maxX;
+			for (int e = 0; e < 3; e++) {
+				float rowValue = t.edgeB[e] * fy + t.edgeC[e];
+				if (t.edgeA[e] > 0) left = std::max(left, -rowValue * t.inverseEdgeA[e]);
+				else if (t.edgeA[e] < 0) right = std::min(right, -rowValue * t.inverseEdgeA[e]);
+				else if (rowValue < 0) right = -1.0f;
+			}
+			if (left > right) continue;
+			// both are inside the box, so truncating is rounding down
+			int spanStart = std::max((int)left - 1, t.minX);
+			int spanEnd = std::min((int)right + 1, t.maxX);
+			float* row = &depth[y * width];
+
+#if defined(_XM_AVX_INTRINSICS_) || defined(_XM_SSE_INTRINSICS_)
+			// 4 pixels a step, starting on a multiple of 4 so a step never runs off the row
+			spanStart &= ~3;
+			const __m128 zero = _mm_setzero_ps();
+			__m128 xs = _mm_add_ps(_mm_set1_ps((float)spanStart), _mm_setr_ps(0, 1, 2, 3));
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[0]), xs), _mm_set1_ps(t.edgeB[0] * fy + t.edgeC[0]));
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[1]), xs), _mm_set1_ps(t.edgeB[1] * fy + t.edgeC[1]));
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.edgeA[2]), xs), _mm_set1_ps(t.edgeB[2] * fy + t.edgeC[2]));
+			__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.depthA), xs), _mm_set1_ps(t.depthB * fy + t.depthC));
+			const __m128 step0 = _mm_set1_ps(t.edgeA[0] * 4);
+			const __m128 step1 = _mm_set1_ps(t.edgeA[1] * 4);
+			const __m128 step2 = _mm_set1_ps(t.edgeA[2] * 4);
+			const __m128 stepDepth = _mm_set1_ps(t.depthA * 4);
+			for (int x = spanStart; x <= spanEnd; x += 4) {
+				__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside)) {
+					__m128 current = _mm_loadu_ps(row + x);
+					__m128 nearer = _mm_min_ps(current, z);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, current)));
+				}
+				e0 = _mm_add_ps(e0, step0);
+				e1 = _mm_add_ps(e1, step1);
+				e2 = _mm_add_ps(e2, step2);
+				z = _mm_add_ps(z, stepDepth);
+			}
+#else
+			for (int x = spanStart; x <= spanEnd; x++) {
+				float fx = (float)x;
+				if (t.edgeA[0] * fx + t.edgeB[0] * fy + t.edgeC[0] < 0) continue;
+				if (t.edgeA[1] * fx + t.edgeB[1] * fy + t.edgeC[1] < 0) continue;
+				if (t.edgeA[2] * fx + t.edgeB[2] * fy + t.edgeC[2] < 0) continue;
+				row[x] = std::min(row[x], t.depthA * fx + t.depthB * fy + t.depthC);
+			}
+#endif
+		}
+	}
+
+	// the farthest thing drawn in each of this band's tiles
+	for (int ty = startTile; ty < endTile; ty++) {
+		for (int tx = 0; tx < tilesX; tx++) {
+			float farthest = 0.0f;
+			for (int y = ty * TileSize; y < (ty + 1) * TileSize; y++) {
+				const float* row = &depth[y * width + tx * TileSize];
+				for (int x = 0; x < TileSize; x++) farthest = std::max(farthest, row[x]);
+			}
+			tileMax[ty * tilesX + tx] = farthest;
+		}
+	}
+}
+
+bool OcclusionCuller::TestBox(XMFLOAT3 center, XMFLOAT3 extents) const
+{
+	// the rectangle the corners cover on screen, and the nearest of them
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float nearest = FLT_MAX;
+	for (int i = 0; i < 8; i++) {
+		XMFLOAT3 corner(center.x + ((i & 1) ? extents.x : -extents.x), center.y + ((i & 2) ? extents.y : -extents.y),
+			center.z + ((i & 4) ? extents.z : -extents.z));
+		XMFLOAT4 clip = TransformPoint(corner, viewProjection);
+		// reaching past the near plane, the camera's practically inside it
+		if (clip.z < 0) return true;
+
+		float invW = 1.0f / clip.w;
+		float x = (clip.x * invW * 0.5f + 0.5f) * width;
+		float y = (0.5f - clip.y * invW * 0.5f) * height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z * invW);
+	}
+	nearest -= DepthBias;
+
+	// every pixel it touches at all
+	if (maxX < 0 || maxY < 0 || minX >= width || minY >= height) return true;
+	int x0 = std::max((int)floorf(minX), 0);
+	int x1 = std::min((int)floorf(maxX), width - 1);
+	int y0 = std::max((int)floorf(minY), 0);
+	int y1 = std::min((int)floorf(maxY), height - 1);
+
+	// it shows wherever the depth buffer has something as far or farther than its nearest corner
+	for (int ty = y0 / TileSize; ty <= y1 / TileSize; ty++) {
+		for (int tx = x0 / TileSize; tx <= x1 / TileSize; tx++) {
+			if (tileMax[ty * tilesX + tx] < nearest) continue;
+
+			int startY = std::max(y0, ty * TileSize);
+			int endY = std::min(y1, ty * TileSize + TileSize - 1);
+			int startX = std::max(x0, tx * TileSize);
+			int endX = std::min(x1, tx * TileSize + TileSize - 1);
+			for (int y = startY; y <= endY; y++) {
+				const float* row = &depth[y * width];
+				for (int x = startX; x <= endX; x++) {
+					if (row[x] >= nearest) return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+size_t OcclusionCuller::Cull(const float* x, const float* y, const float* z, const float* extentX, const float* extentY, const float* extentZ,
+	size_t count, unsigned char* visible, int threads) const
+{
+	size_t threadCount = std::min((size_t)std::max(threads, 1), count);
+	if (threadCount <= 1) return CullRange(x, y, z, extentX, extentY, extentZ, 0, count, visible);
+
+	// each thread only writes its own range of visible
+	std::vector<size_t> hidden(threadCount, 0);
+	std::vector<std::thread> workers;
+	for (size_t t = 1; t < threadCount; t++) {
+		workers.emplace_back([=, &hidden]() {
+			hidden[t] = CullRange(x, y, z, extentX, extentY, extentZ, count * t / threadCount, count * (t + 1) / threadCount, visible);
+		});
+	}
+	hidden[0] = CullRange(x, y, z, extentX, extentY, extentZ, 0, count / threadCount, visible);
+	for (std::thread& worker : workers) worker.join();
+
+	size_t total = 0;
+	for (size_t h : hidden) total += h;
+	return total;
+}
+
+size_t OcclusionCuller::CullRange(const float* x, const float* y, const float* z, const float* extentX, const float* extentY, const float* extentZ,
+	size_t start, size_t end, unsigned char* visible) const
+{
+	size_t hidden = 0;
+	for (size_t i = start; i < end; i++) {
+		if (!visible[i]) continue;
+		if (!TestBox(XMFLOAT3(x[i], y[i], z[i]), XMFLOAT3(extentX[i], extentY[i], extentZ[i]))) {
+			visible[i] = 0;
+			hidden++;
+		}
+	}
+	return hidden;
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include "OccluderMesh.h"
+#include "Bounds.h"
+#include <DirectXMath.h>
+#include <vector>
+
+// --------------------------------------------------------
+// Drops things hidden behind other things before they're
+// drawn.
+//
+// A few big solid meshes (simplified) are rasterized on the
+// CPU into a small depth buffer, then the world boxes the
+// frustum kept are projected onto it.  A box is dropped only
+// when something nearer than its nearest corner was drawn at
+// every pixel it covers, so it errs towards drawing.
+//
+// The rasterizer fills 4 pixels at a time with SSE.  Render
+// and Cull can be split between threads: each one fills its
+// own band of rows, then tests its own share of the boxes.
+// An 8x8 tile grid keeps the farthest depth under each tile,
+// so most boxes are settled without reading their pixels
+// --------------------------------------------------------
+class OcclusionCuller
+{
+public:
+	// both are rounded up to whole tiles
+	OcclusionCuller(int width = 256, int height = 128);
+
+	// picks which of the candidates are worth rasterizing from eye: the ones at least
+	// minSize big on screen, going by radius over distance, biggest first and at most
+	// maxCount of them. chosen gets their indices into bounds
+	void ChooseOccluders(DirectX::XMFLOAT3 eye, const std::vector<Bounds>& bounds, std::vector<unsigned int>& chosen,
+		float minSize = 0.15f, size_t maxCount = 64);
+
+	// clears the depth buffer for a new camera. viewProjection is row vector and not
+	// transposed, like Frustum's
+	void Begin(DirectX::FXMMATRIX viewProjection);
+	// world is not transposed, the mesh has to stay around until Render
+	void AddOccluder(const OccluderMesh* mesh, DirectX::FXMMATRIX world);
+	// transforms, clips and rasterizes every occluder added since Begin
+	void Render(int threads = 1);
+
+	// after Render, false when the box is certainly hidden
+	bool TestBox(DirectX::XMFLOAT3 center, DirectX::XMFLOAT3 extents) const;
+	// clears visible[i] for every box still marked visible that turns out hidden, boxes are
+	// parallel arrays like Frustum::Cull's. returns how many it cleared
+	size_t Cull(const float* x, const float* y, const float* z, const float* extentX, const float* extentY, const float* extentZ,
+		size_t count, unsigned char* visible, int threads = 1) const;
+
+	inline int GetWidth() const { return width; }
+	inline int GetHeight() const { return height; }
+	// 0 at the near plane, 1 at the far plane and wherever nothing was drawn
+	inline float GetDepth(int x, int y) const { return depth[y * width + x]; }
+	inline size_t GetOccluderCount() const { return occluders.size(); }
+	// after clipping, from the last Render
+	inline size_t GetTriangleCount() const { return triangles.size(); }
+
+private:
+	struct Occluder
+	{
+		const OccluderMesh* mesh;
+		DirectX::XMFLOAT4X4 world;
+	};
+
+	// a triangle in pixels, ready to fill
+	struct Triangle
+	{
+		// inside where a * x + b * y + c >= 0 for all three edges, and depth is the same
+		// kind of plane. both are measured at pixel centers
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		// where each edge crosses a row, without dividing
+		float inverseEdgeA[3];
+		float depthA;
+		float depthB;
+		float depthC;
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+	};
+
+	static const int TileSize = 8;
+
+	int width;
+	int height;
+	int tilesX;
+	int tilesY;
+	DirectX::XMFLOAT4X4 viewProjection;
+	std::vector<float> depth;
+	// the farthest depth in each tile
+	std::vector<float> tileMax;
+	std::vector<Occluder> occluders;
+	std::vector<Triangle> triangles;
+	std::vector<DirectX::XMFLOAT4> clipSpace;
+	// ChooseOccluders' candidates with how big they are
+	std::vector<std::pair<float, unsigned int>> ranked;
+
+	void ClipTriangle(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, const DirectX::XMFLOAT4& c, bool twoSided);
+	void SetupTriangle(const DirectX::XMFLOAT4& a, const DirectX::XMFLOAT4& b, const DirectX::XMFLOAT4& c, bool twoSided);
+	// fills and then sums up the tile rows from startTile to endTile
+	void RasterizeTiles(int startTile, int endTile);
+	size_t CullRange(const float* x, const float* y, const float* z, const float* extentX, const float* extentY, const float* extentZ,
+		size_t start, size_t end, unsigned char* visible) const;
+};
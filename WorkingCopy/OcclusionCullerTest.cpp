@@ -0,0 +1,202 @@
+#include "OcclusionCuller.h"
+#include "TransformSystem.h"
+#include "MeshSource.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Grows the game's forest of DeadTrees in a TransformSystem
+// and runs what Game::CullOccluded does from just outside
+// it.  While the trees still have the empty placeholder's
+// bounds no occluder is big enough to be chosen.  With the
+// mesh's bounds the nearest trees are chosen, rasterized,
+// and hide stones behind their trunks but not ones in
+// front of them
+// --------------------------------------------------------
+
+namespace
+{
+	const float Pi = 3.1415926535f;
+
+	struct Tree
+	{
+		TransformHandle handle;
+		XMFLOAT3 position;
+	};
+
+	// Game::SpawnTreeGrid(150, 150, 8), with the same spawn chance and offsets
+	std::vector<Tree> SpawnTreeGrid(TransformSystem& system, int extent, int step)
+	{
+		std::vector<Tree> trees;
+		srand(1);
+		for (int i = -extent; i <= extent; i += step)
+		{
+			for (int j = -extent; j <= extent; j += step)
+			{
+				if (rand() % 100 + 1 > 40) continue;
+				float offsetX = (rand() % 10 + 1) / 10.0f * (step / 2);
+				float offsetZ = (rand() % 10 + 1) / 10.0f * (step / 3);
+				float angle = (rand() % 360) * Pi / 180.0f;
+
+				Tree tree;
+				tree.handle = system.Create();
+				tree.position = XMFLOAT3(i + offsetX, -3.0f, j + offsetZ);
+				system.SetPosition(tree.handle, tree.position);
+				system.SetRotation(tree.handle, XMFLOAT4(0, sinf(angle / 2), 0, cosf(angle / 2)));
+				trees.push_back(tree);
+			}
+		}
+		return trees;
+	}
+
+	// how near the box comes to point
+	float DistanceToBox(XMFLOAT3 point, const Bounds& box)
+	{
+		float dx = fmaxf(fabsf(point.x - box.center.x) - box.extents.x, 0.0f);
+		float dy = fmaxf(fabsf(point.y - box.center.y) - box.extents.y, 0.0f);
+		float dz = fmaxf(fabsf(point.z - box.center.z) - box.extents.z, 0.0f);
+		return sqrtf(dx * dx + dy * dy + dz * dz);
+	}
+
+	XMFLOAT3 Along(XMFLOAT3 eye, XMFLOAT3 target, float distance)
+	{
+		float dx = target.x - eye.x;
+		float dy = target.y - eye.y;
+		float dz = target.z - eye.z;
+		float length = sqrtf(dx * dx + dy * dy + dz * dz);
+		return XMFLOAT3(eye.x + dx / length * distance, eye.y + dy / length * distance, eye.z + dz / length * distance);
+	}
+}
+
+int main()
+{
+	// what the game loads for every tree, and the occluder Mesh::Upload builds from it
+	MeshSource source;
+	CHECK(source.Load("Models/DeadTree.obj", VERTEX_FORMAT::PACKED));
+	OccluderMesh occluder;
+	source.BuildOccluder(occluder);
+	printf("DeadTree occluder: %zu triangles, radius %.2f\n", occluder.GetTriangleCount(), source.GetBounds().radius);
+	CHECK(!occluder.IsEmpty());
+
+	TransformSystem system;
+	std::vector<Tree> trees = SpawnTreeGrid(system, 150, 8);
+
+	// the camera just outside the forest, looking into it down +z
+	XMFLOAT3 eye(0, 0, -158);
+	XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&eye), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+	XMMATRIX viewProjection = view * XMMatrixPerspectiveFovLH(0.25f * Pi, 1280.0f / 720.0f, 0.1f, 100.0f);
+	Frustum frustum(viewProjection);
+
+	// made while loading, every tree has the placeholder's empty bounds and the culling tree is built over them
+	for (const Tree& tree : trees) system.SetLocalBounds(tree.handle, Bounds());
+	system.Update(1);
+	system.Cull(frustum);
+
+	OcclusionCuller culler;
+	std::vector<Bounds> bounds;
+	std::vector<unsigned int> chosen;
+	for (const Tree& tree : trees) bounds.push_back(system.GetWorldBounds(tree.handle));
+	culler.ChooseOccluders(eye, bounds, chosen);
+	printf("%zu trees, %zu chosen as occluders with the placeholder's bounds\n", trees.size(), chosen.size());
+	CHECK(chosen.empty());
+
+	// FinishLoading gives them the mesh's, the culling tree is refitted around them
+	for (const Tree& tree : trees) system.SetLocalBounds(tree.handle, source.GetBounds());
+
+	// stones behind the nearest trunks, and in front of every occluder on the way to them
+	Bounds stone = Bounds::FromMinMax(XMFLOAT3(-0.05f, -0.05f, -0.05f), XMFLOAT3(0.05f, 0.05f, 0.05f));
+	std::vector<TransformHandle> behind;
+	std::vector<TransformHandle> inFront;
+	system.Update(1);
+	bounds.clear();
+	for (const Tree& tree : trees) bounds.push_back(system.GetWorldBounds(tree.handle));
+	culler.ChooseOccluders(eye, bounds, chosen);
+	// nothing drawn comes nearer the camera than this
+	float nearest = 1e30f;
+	for (unsigned int i : chosen) nearest = fminf(nearest, DistanceToBox(eye, bounds[i]));
+	for (unsigned int i : chosen)
+	{
+		// halfway up the trunk, where it's thickest and has no branches
+		XMFLOAT3 trunk(trees[i].position.x, trees[i].position.y + 1.0f, trees[i].position.z);
+		float dx = trunk.x - eye.x;
+		float dz = trunk.z - eye.z;
+		float distance = sqrtf(dx * dx + (trunk.y - eye.y) * (trunk.y - eye.y) + dz * dz);
+		if (!frustum.TestBox(trunk, XMFLOAT3(0.1f, 0.1f, 0.1f))) continue;
+
+		TransformHandle hidden = system.Create();
+		system.SetLocalBounds(hidden, stone);
+		system.SetPosition(hidden, Along(eye, trunk, distance + 3.0f));
+		behind.push_back(hidden);
+
+		TransformHandle seen = system.Create();
+		system.SetLocalBounds(seen, stone);
+		system.SetPosition(seen, Along(eye, trunk, nearest - 0.2f));
+		inFront.push_back(seen);
+	}
+	system.Update(1);
+	system.Cull(frustum);
+
+	// the culling tree over the real boxes keeps what testing every box does
+	size_t inView = 0;
+	for (const Tree& tree : trees)
+	{
+		Bounds world = system.GetWorldBounds(tree.handle);
+		bool kept = frustum.TestBox(world.center, world.extents);
+		inView += kept;
+		CHECK(system.IsVisible(tree.handle) == kept);
+	}
+
+	// chosen: at least 0.15 big on screen, biggest first, at most 64, and no bigger one left out
+	bounds.clear();
+	for (const Tree& tree : trees) bounds.push_back(system.GetWorldBounds(tree.handle));
+	culler.ChooseOccluders(eye, bounds, chosen);
+	auto size = [&](unsigned int i) {
+		float dx = bounds[i].center.x - eye.x;
+		float dy = bounds[i].center.y - eye.y;
+		float dz = bounds[i].center.z - eye.z;
+		return bounds[i].radius / (sqrtf(dx * dx + dy * dy + dz * dz) + 0.001f);
+	};
+	size_t bigEnough = 0;
+	for (unsigned int i = 0; i < (unsigned int)bounds.size(); i++) bigEnough += size(i) >= 0.15f;
+	printf("%zu trees in view, %zu big enough on screen, %zu chosen\n", inView, bigEnough, chosen.size());
+	CHECK(!chosen.empty());
+	CHECK(chosen.size() == (bigEnough < 64 ? bigEnough : 64));
+	for (size_t c = 1; c < chosen.size(); c++) CHECK(size(chosen[c - 1]) >= size(chosen[c]));
+	CHECK(size(chosen.back()) >= 0.15f);
+
+	// rasterized the way Game::CullOccluded does, with one thread and with four
+	size_t hidden[2] = {};
+	for (int pass = 0; pass < 2; pass++)
+	{
+		int threads = pass == 0 ? 1 : 4;
+		system.Cull(frustum);
+		size_t before = system.GetVisibleCount();
+		culler.Begin(viewProjection);
+		for (unsigned int i : chosen)
+		{
+			XMFLOAT4X4 world = system.GetWorldMatrix(trees[i].handle);
+			culler.AddOccluder(&occluder, XMMatrixTranspose(XMLoadFloat4x4(&world)));
+		}
+		culler.Render(threads);
+		system.Occlude(culler, threads);
+		hidden[pass] = before - system.GetVisibleCount();
+
+		int behindShown = 0;
+		int inFrontHidden = 0;
+		for (TransformHandle handle : behind) behindShown += system.IsVisible(handle);
+		for (TransformHandle handle : inFront) inFrontHidden += !system.IsVisible(handle);
+		printf("%d thread(s): %zu triangles, %zu of %zu hidden, %d of %zu stones behind trunks shown, %d in front hidden\n",
+			threads, culler.GetTriangleCount(), hidden[pass], before, behindShown, behind.size(), inFrontHidden);
+		CHECK(culler.GetOccluderCount() == chosen.size());
+		CHECK(!behind.empty() && behindShown == 0);
+		CHECK(inFrontHidden == 0);
+	}
+	CHECK(hidden[0] == hidden[1]);
+
+	return TestResult();
+}
@@ -0,0 +1,159 @@
+#include "PackedVertex.h"
+#include <DirectXPackedVector.h>
+#include <cmath>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+const D3D11_INPUT_ELEMENT_DESC PackedVertexLayout[PACKED_VERTEX_LAYOUT_COUNT] =
+{
+	{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+namespace
+{
+	// float in [-1, 1] <-> SNORM16, the way D3D converts it back
+	short ToSnorm(float f)
+	{
+		f = fminf(fmaxf(f, -1.0f), 1.0f);
+		return (short)lroundf(f * 32767.0f);
+	}
+
+	float FromSnorm(short s)
+	{
+		return fmaxf(s / 32767.0f, -1.0f);
+	}
+
+	// float in [0, 1] <-> UNORM16
+	unsigned short ToUnorm(float f)
+	{
+		f = fminf(fmaxf(f, 0.0f), 1.0f);
+		return (unsigned short)lroundf(f * 65535.0f);
+	}
+
+	float AngleBetween(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		XMVECTOR va = XMVector3Normalize(XMLoadFloat3(&a));
+		XMVECTOR vb = XMVector3Normalize(XMLoadFloat3(&b));
+		float cosine = fminf(fmaxf(XMVectorGetX(XMVector3Dot(va, vb)), -1.0f), 1.0f);
+		return XMConvertToDegrees(acosf(cosine));
+	}
+}
+
+VertexQuantization VertexPacker::GetQuantization(const XMFLOAT3& boundsMin, const XMFLOAT3& boundsMax)
+{
+	VertexQuantization quantization;
+	quantization.offset = boundsMin;
+	quantization.scale = XMFLOAT3(boundsMax.x - boundsMin.x, boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z);
+	return quantization;
+}
+
+void VertexPacker::Pack(const Vertex* verts, size_t count, const VertexQuantization& quantization, PackedVertex* packed)
+{
+	// flat axes all pack to 0
+	const float* offset = &quantization.offset.x;
+	const float* scale = &quantization.scale.x;
+	float inverseScale[3];
+	for (int k = 0; k < 3; k++) inverseScale[k] = scale[k] > 0.0f ? 1.0f / scale[k] : 0.0f;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const float* position = &verts[i].Position.x;
+		for (int k = 0; k < 3; k++)
+		{
+			packed[i].Position[k] = ToUnorm((position[k] - offset[k]) * inverseScale[k]);
+		}
+		packed[i].Position[3] = 0;
+
+		EncodeOctahedral(verts[i].Normal, packed[i].Normal);
+		EncodeOctahedral(verts[i].Tangent, packed[i].Tangent);
+		packed[i].UV[0] = XMConvertFloatToHalf(verts[i].UV.x);
+		packed[i].UV[1] = XMConvertFloatToHalf(verts[i].UV.y);
+	}
+}
+
+void VertexPacker::Unpack(const PackedVertex* packed, size_t count, const VertexQuantization& quantization, Vertex* verts)
+{
+	const float* offset = &quantization.offset.x;
+	const float* scale = &quantization.scale.x;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		float* position = &verts[i].Position.x;
+		for (int k = 0; k < 3; k++)
+		{
+			position[k] = offset[k] + packed[i].Position[k] / 65535.0f * scale[k];
+		}
+
+		verts[i].Normal = DecodeOctahedral(packed[i].Normal);
+		verts[i].Tangent = DecodeOctahedral(packed[i].Tangent);
+		verts[i].UV.x = XMConvertHalfToFloat(packed[i].UV[0]);
+		verts[i].UV.y = XMConvertHalfToFloat(packed[i].UV[1]);
+	}
+}
+
+VertexPackingError VertexPacker::MeasureError(const Vertex* verts, size_t count, const VertexQuantization& quantization)
+{
+	VertexPackingError error;
+	for (size_t i = 0; i < count; i++)
+	{
+		PackedVertex packed;
+		Vertex unpacked;
+		Pack(&verts[i], 1, quantization, &packed);
+		Unpack(&packed, 1, quantization, &unpacked);
+
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&verts[i].Position), XMLoadFloat3(&unpacked.Position));
+		error.position = fmaxf(error.position, XMVectorGetX(XMVector3Length(offset)));
+		error.uv = fmaxf(error.uv, fmaxf(fabsf(verts[i].UV.x - unpacked.UV.x), fabsf(verts[i].UV.y - unpacked.UV.y)));
+
+		// zero vectors can't survive the trip, and don't matter
+		if (XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&verts[i].Normal))) > 0.0f)
+			error.normal = fmaxf(error.normal, AngleBetween(verts[i].Normal, unpacked.Normal));
+		if (XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&verts[i].Tangent))) > 0.0f)
+			error.tangent = fmaxf(error.tangent, AngleBetween(verts[i].Tangent, unpacked.Tangent));
+	}
+	return error;
+}
+
+void VertexPacker::EncodeOctahedral(const XMFLOAT3& v, short encoded[2])
+{
+	// project onto the octahedron |x| + |y| + |z| = 1
+	float length = fabsf(v.x) + fabsf(v.y) + fabsf(v.z);
+	if (length <= 0.0f)
+	{
+		encoded[0] = encoded[1] = 0;
+		return;
+	}
+	float x = v.x / length;
+	float y = v.y / length;
+
+	// and fold the lower half over the top one
+	if (v.z < 0.0f)
+	{
+		float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	encoded[0] = ToSnorm(x);
+	encoded[1] = ToSnorm(y);
+}
+
+XMFLOAT3 VertexPacker::DecodeOctahedral(const short encoded[2])
+{
+	// same math as DecodeOctahedral() in packedvertex.hlsli
+	float x = FromSnorm(encoded[0]);
+	float y = FromSnorm(encoded[1]);
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	float t = fmaxf(-z, 0.0f);
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, XMVector3Normalize(XMVectorSet(x, y, z, 0.0f)));
+	return result;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Vertex.h"
+#include <DirectXMath.h>
+#include <d3d11.h>
+
+// which vertex struct a mesh's vertex buffer holds
+enum class VERTEX_FORMAT { FULL, PACKED };
+
+// --------------------------------------------------------
+// A compressed version of Vertex, 20 bytes instead of 44.
+//
+// Positions are 16 bit fractions of the mesh's bounding box,
+// normals and tangents are octahedral encoded and UVs are
+// half floats.  The GPU unpacks the formats for free, only
+// the bounding box and octahedral decode are done in the
+// shader (see packedvertex.hlsli)
+// --------------------------------------------------------
+struct PackedVertex
+{
+	unsigned short Position[4];     // UNORM16 inside the bounds, w is unused
+	short Normal[2];                // SNORM16 octahedral
+	short Tangent[2];               // SNORM16 octahedral
+	unsigned short UV[2];           // half floats
+};
+
+// --------------------------------------------------------
+// How to turn a packed position back into model space:
+// position = offset + unorm * scale
+// --------------------------------------------------------
+struct VertexQuantization
+{
+	DirectX::XMFLOAT3 offset = DirectX::XMFLOAT3(0, 0, 0);
+	DirectX::XMFLOAT3 scale = DirectX::XMFLOAT3(1, 1, 1);
+};
+
+// --------------------------------------------------------
+// Largest differences between some verts and their
+// packed and unpacked copies
+// --------------------------------------------------------
+struct VertexPackingError
+{
+	float position = 0.0f;          // model units
+	float normal = 0.0f;            // degrees
+	float tangent = 0.0f;           // degrees
+	float uv = 0.0f;
+};
+
+// input layout for PackedVertex, reflection would pick 32 bit float formats
+#define PACKED_VERTEX_LAYOUT_COUNT 4
+extern const D3D11_INPUT_ELEMENT_DESC PackedVertexLayout[PACKED_VERTEX_LAYOUT_COUNT];
+
+// --------------------------------------------------------
+// Converts between Vertex and PackedVertex on the CPU
+// --------------------------------------------------------
+class VertexPacker
+{
+public:
+	// the quantization that covers a bounding box
+	static VertexQuantization GetQuantization(const DirectX::XMFLOAT3& boundsMin, const DirectX::XMFLOAT3& boundsMax);
+
+	static void Pack(const Vertex* verts, size_t count, const VertexQuantization& quantization, PackedVertex* packed);
+	static void Unpack(const PackedVertex* packed, size_t count, const VertexQuantization& quantization, Vertex* verts);
+
+	// packs and unpacks every vertex and reports the worst of each attribute
+	static VertexPackingError MeasureError(const Vertex* verts, size_t count, const VertexQuantization& quantization);
+
+	// unit vector <-> two snorms, zero vectors come back as +Z
+	static void EncodeOctahedral(const DirectX::XMFLOAT3& v, short encoded[2]);
+	static DirectX::XMFLOAT3 DecodeOctahedral(const short encoded[2]);
+};
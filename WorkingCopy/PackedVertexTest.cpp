@@ -0,0 +1,161 @@
+#include "MeshSource.h"
+#include "ObjParser.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Round trips verts through PackedVertex and checks the
+// loss stays within what the formats promise, then loads a
+// packed mesh too big for 16 bit indices, fresh and cooked
+// --------------------------------------------------------
+
+namespace
+{
+	// indices out of a MeshSource, whichever size they are
+	std::vector<unsigned int> GetIndices(const MeshSource& source)
+	{
+		std::vector<unsigned int> indices(source.GetIndexCount());
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			indices[i] = source.GetIndexStride() == sizeof(unsigned short)
+				? ((const unsigned short*)source.GetIndices())[i]
+				: ((const unsigned int*)source.GetIndices())[i];
+		}
+		return indices;
+	}
+
+	// LOD 0's triangles as positions, the order of the verts is the cooker's business
+	std::vector<XMFLOAT3> GetTriangles(const MeshSource& source)
+	{
+		std::vector<Vertex> verts(source.GetVertexCount());
+		VertexPacker::Unpack((const PackedVertex*)source.GetVertices(), verts.size(), source.GetQuantization(), &verts[0]);
+		std::vector<unsigned int> indices = GetIndices(source);
+		std::vector<XMFLOAT3> triangles;
+		for (unsigned int i = 0; i < source.GetLods()[0].indexCount; i++) triangles.push_back(verts[indices[i]].Position);
+		return triangles;
+	}
+
+	void WriteGrid(const char* filename, int side)
+	{
+		FILE* file = fopen(filename, "w");
+		for (int z = 0; z <= side; z++)
+		{
+			for (int x = 0; x <= side; x++)
+			{
+				fprintf(file, "v %d 0 %d\n", x, z);
+				fprintf(file, "vt %f %f\n", (float)x / side, (float)z / side);
+			}
+		}
+		fprintf(file, "vn 0 1 0\n");
+		for (int z = 0; z < side; z++)
+		{
+			for (int x = 0; x < side; x++)
+			{
+				int a = z * (side + 1) + x + 1;
+				int b = a + 1;
+				int c = a + side + 1;
+				int d = c + 1;
+				fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, c, c, d, d, b, b);
+			}
+		}
+		fclose(file);
+	}
+}
+
+int main()
+{
+	static_assert(sizeof(PackedVertex) == 20, "PackedVertex has to match packedvertex.hlsli");
+
+	// octahedral normals are good to a twentieth of a degree everywhere
+	srand(1);
+	float worst = 0;
+	for (int i = 0; i < 100000; i++)
+	{
+		XMFLOAT3 v(rand() / (float)RAND_MAX * 2 - 1, rand() / (float)RAND_MAX * 2 - 1, rand() / (float)RAND_MAX * 2 - 1);
+		if (v.x * v.x + v.y * v.y + v.z * v.z < 1e-6f) continue;
+		short encoded[2];
+		VertexPacker::EncodeOctahedral(v, encoded);
+		XMFLOAT3 decoded = VertexPacker::DecodeOctahedral(encoded);
+		float cosine = XMVectorGetX(XMVector3Dot(XMVector3Normalize(XMLoadFloat3(&v)), XMLoadFloat3(&decoded)));
+		float degrees = acosf(fminf(cosine, 1.0f)) * 180.0f / XM_PI;
+		if (degrees > worst) worst = degrees;
+	}
+	printf("octahedral normals: worst %.4f degrees\n", worst);
+	CHECK(worst < 0.05f);
+
+	// the game's packed meshes
+	const char* models[] = { "Models/DeadTree.obj", "Models/Campfire.obj", "Models/torus.obj" };
+	for (const char* model : models)
+	{
+		MeshData data;
+		CHECK(ObjParser::ParseFile(model, data));
+		std::vector<Vertex> verts;
+		std::vector<unsigned int> indices;
+		ObjParser::WeldVertices(data, verts, indices);
+
+		XMFLOAT3 boundsMin, boundsMax;
+		MeshBinary::GetBounds(verts, &boundsMin, &boundsMax);
+		VertexQuantization quantization = VertexPacker::GetQuantization(boundsMin, boundsMax);
+		VertexPackingError error = VertexPacker::MeasureError(&verts[0], verts.size(), quantization);
+		printf("%s: position %.5f, normal %.3f deg, uv %.5f\n", model, error.position, error.normal, error.uv);
+
+		// half a step of 16 bits over the largest side, and a half float's precision at the largest UV
+		float largest = fmaxf(boundsMax.x - boundsMin.x, fmaxf(boundsMax.y - boundsMin.y, boundsMax.z - boundsMin.z));
+		CHECK(error.position <= largest / 65535.0f);
+		CHECK(error.normal < 0.05f);
+		CHECK(error.uv < 0.01f);
+	}
+
+	// more verts than 16 bit indices reach
+	const char* grid = "PackedVertexTestGrid.obj";
+	WriteGrid(grid, 300);
+	std::string cookedPath = MeshBinary::GetCookedPath(grid, VERTEX_FORMAT::PACKED);
+	remove(cookedPath.c_str());
+
+	MeshSource fresh;
+	CHECK(fresh.Load(grid, VERTEX_FORMAT::PACKED));
+	CHECK(!fresh.IsCooked());
+	CHECK(fresh.GetVertexCount() == 301 * 301);
+	CHECK(fresh.GetIndexStride() == sizeof(unsigned int));
+
+	MeshSource cooked;
+	CHECK(cooked.Load(grid, VERTEX_FORMAT::PACKED));
+	CHECK(cooked.IsCooked());
+	CHECK(cooked.GetIndexStride() == sizeof(unsigned int));
+
+	// every index reaches its own vert, none of them wrapped at 65536
+	std::vector<unsigned int> freshIndices = GetIndices(fresh);
+	unsigned int highest = 0;
+	for (unsigned int index : freshIndices) highest = index > highest ? index : highest;
+	CHECK(highest == 301 * 301 - 1);
+	CHECK(freshIndices == GetIndices(cooked));
+
+	std::vector<XMFLOAT3> freshTriangles = GetTriangles(fresh);
+	std::vector<XMFLOAT3> cookedTriangles = GetTriangles(cooked);
+	CHECK(freshTriangles.size() == 300 * 300 * 6);
+	bool same = freshTriangles.size() == cookedTriangles.size();
+	for (size_t i = 0; same && i < freshTriangles.size(); i++)
+	{
+		same = fabsf(freshTriangles[i].x - cookedTriangles[i].x) < 0.01f && fabsf(freshTriangles[i].z - cookedTriangles[i].z) < 0.01f;
+	}
+	CHECK(same);
+
+	// and every triangle is one of the grid's, half of a unit square
+	bool inGrid = true;
+	for (size_t i = 0; inGrid && i < freshTriangles.size(); i += 3)
+	{
+		const XMFLOAT3* t = &freshTriangles[i];
+		float area = fabsf((t[1].x - t[0].x) * (t[2].z - t[0].z) - (t[2].x - t[0].x) * (t[1].z - t[0].z)) * 0.5f;
+		inGrid = fabsf(area - 0.5f) < 0.01f;
+	}
+	CHECK(inGrid);
+
+	remove(cookedPath.c_str());
+	remove(grid);
+	return TestResult();
+}
@@ -1,5 +1,7 @@
 #include "Quadtree.h"
 
+using namespace DirectX;
+
 Quadtree::~Quadtree()
 {
     if (rootNode != NULL) {
@@ -7,9 +9,11 @@ Quadtree::~Quadtree()
     }
 }
 
-Quadtree::Quadtree()
+Quadtree::Quadtree(const QuadtreeSettings& settings) : settings(settings)
 {
     rootNode = NULL;
+    queryStamp = 0;
+    looseMargin = 1.0f;
 }
 
 void Quadtree::CreateQuadtree(vector<Collider*> newObjects)
@@ -17,19 +21,72 @@ void Quadtree::CreateQuadtree(vector<Collider*> newObjects)
     if (rootNode != NULL) {
         delete rootNode;
     }
-    rootNode =  new QuadNode(newObjects);
+    rootNode = new QuadNode(&settings);
+    for (Collider* col : newObjects) {
+        addToTree(col);
+    }
 }
 
 void Quadtree::addToTree(Collider* newVal)
 {
-   
-        rootNode->AddToTree(newVal);
-    
-    
+    if (rootNode == NULL) {
+        rootNode = new QuadNode(&settings);
+    }
+
+    SetTreeBounds(newVal);
+    if (rootNode->isLoose()) rootNode->AddLoose(newVal);
+    else rootNode->AddToTree(newVal);
+}
+
+void Quadtree::Remove(Collider* col)
+{
+    if (rootNode == NULL) return;
+    if (rootNode->isLoose()) rootNode->RemoveLoose(col);
+    else rootNode->RemoveFromTree(col);
 }
 
-std::vector<Collider*> Quadtree::GetCollidableObjects(Collider* playerCol)
+void Quadtree::Update(Collider* col)
 {
-    return rootNode->getInteractions(playerCol);
+    if (rootNode == NULL) return;
+
+    // still inside the bounds it was filed under, nothing to do
+    XMFLOAT4 bounds = col->GetBounds();
+    const XMFLOAT4& loose = col->treeBounds;
+    if (bounds.x >= loose.x && bounds.y >= loose.y && bounds.z <= loose.z && bounds.w <= loose.w) {
+        return;
+    }
+
+    Remove(col);
+    addToTree(col);
+}
+
+void Quadtree::SetTreeBounds(Collider* col)
+{
+    XMFLOAT4 bounds = col->GetBounds();
+    col->treeBounds = XMFLOAT4(bounds.x - looseMargin, bounds.y - looseMargin, bounds.z + looseMargin, bounds.w + looseMargin);
+}
+
+void Quadtree::GetCollidableObjects(Collider* playerCol, std::vector<Collider*>& results)
+{
+    GetCollidableObjects(playerCol->GetBounds(), results);
+}
+
+void Quadtree::GetCollidableObjects(const XMFLOAT4& box, std::vector<Collider*>& results)
+{
+    results.clear();
+    if (rootNode == NULL) return;
+    rootNode->getInteractions(box, NextQueryStamp(), results, queryStats.tested);
+    queryStats.queries++;
+    queryStats.candidates += results.size();
+}
+
+unsigned int Quadtree::NextQueryStamp()
+{
+    // 0 is what new colliders start with, so it's never a real stamp
+    if (++queryStamp == 0) {
+        rootNode->clearStamps();
+        queryStamp = 1;
+    }
+    return queryStamp;
 }
 
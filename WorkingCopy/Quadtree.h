@@ -1,7 +1,7 @@
-
-
 #pragma once
 #include "Node.h"
+#include "QuadtreeSettings.h"
+#include "Broadphase.h"
 #include <vector>
 #include <DirectXMath.h>
 
@@ -9,23 +9,52 @@
 
 
 using namespace std;
-class Quadtree
+class Quadtree : public Broadphase
 {
 
 public:
 
     ~Quadtree();
-    Quadtree();
+    Quadtree(const QuadtreeSettings& settings = QuadtreeSettings());
     void CreateQuadtree(std::vector<Collider*> newObjects);
     void addToTree(Collider* newVal);
-    std::vector<Collider*> GetCollidableObjects(Collider* playerCol);
+    void Add(Collider* col) override { addToTree(col); }
+    void Remove(Collider* col) override;
+    // it's only refiled once it leaves its loose bounds
+    void Update(Collider* col) override;
+    void GetCollidableObjects(Collider* playerCol, std::vector<Collider*>& results) override;
+    void GetCollidableObjects(const DirectX::XMFLOAT4& box, std::vector<Collider*>& results) override;
+
+    // calls visit(Collider*) for every collider GetCollidableObjects would return
+    template<class Visitor>
+    void VisitCollidableObjects(Collider* playerCol, Visitor visit) {
+        VisitCollidableObjects(playerCol->GetBounds(), visit);
+    }
+
+    template<class Visitor>
+    void VisitCollidableObjects(const DirectX::XMFLOAT4& box, Visitor visit) {
+        if (rootNode == NULL) return;
+        unsigned long long found = 0;
+        auto counted = [&visit, &found](Collider* col) { found++; visit(col); };
+        rootNode->visitInteractions(box, NextQueryStamp(), counted, queryStats.tested);
+        queryStats.queries++;
+        queryStats.candidates += found;
+    }
+
+    inline const QuadtreeSettings& GetSettings() const { return settings; }
 
 private:
+    QuadtreeSettings settings;
     QuadNode* rootNode;
+    unsigned int queryStamp;
+    // how far past its real bounds a collider can move before it's refiled
+    float looseMargin;
 
-    
+    void SetTreeBounds(Collider* col);
 
-};
+    unsigned int NextQueryStamp();
 
+    
 
+};
 
@@ -0,0 +1,18 @@
+#pragma once
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Size and shape of a quadtree
+// --------------------------------------------------------
+struct QuadtreeSettings
+{
+    DirectX::XMFLOAT2 center = DirectX::XMFLOAT2(0, 0);
+    float halfSize = 200.0f;        // the root covers center +- halfSize
+    int maxDepth = 6;               // 16 at most, Morton keys are 32 bit
+    unsigned int leafCapacity = 3;  // nodes with more objects than this split until maxDepth
+
+    // Quadtree only: 0 files objects in every leaf they touch, above 0 every
+    // node's bounds grow by this fraction of its size on each side and
+    // objects live in the one smallest node they fit in
+    float looseness = 0.0f;
+};
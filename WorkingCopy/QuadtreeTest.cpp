@@ -0,0 +1,383 @@
+#include "Quadtree.h"
+#include "LinearQuadtree.h"
+#include "BroadphaseTest.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <new>
+#include <vector>
+
+using namespace DirectX;
+using namespace BroadphaseTest;
+
+// --------------------------------------------------------
+// Fills a quadtree with circles and rectangles and checks
+// every query returns exactly the colliders whose bounds
+// overlap the box, each once, without allocating once the
+// results vector has grown, loose or not.  The linear
+// quadtree has to return the same colliders as the linked
+// one, and a tree that colliders are added to, removed
+// from and moved around in every frame has to keep
+// matching brute force.  Last, both trees are built over
+// a dense forest of 100k trees and timed against each
+// other
+// --------------------------------------------------------
+
+namespace
+{
+	// counts every allocation made while counting is on
+	bool countAllocations = false;
+	unsigned long long allocations = 0;
+
+	// moves, removes and adds colliders every frame and checks queries against what's in the tree
+	void Stress(const char* name, const QuadtreeSettings& settings)
+	{
+		const float extent = 180.0f;
+		std::vector<Collider*> inTree = MakeColliders(1500, extent);
+		std::vector<Collider*> outOfTree = MakeColliders(500, extent);
+		std::vector<XMFLOAT2> velocity(inTree.size() + outOfTree.size());
+		for (XMFLOAT2& v : velocity) v = XMFLOAT2(Random(0.6f), Random(0.6f));
+
+		Quadtree tree(settings);
+		tree.CreateQuadtree(inTree);
+
+		int wrong = 0;
+		unsigned long long found = 0;
+		std::vector<Collider*> results;
+		TestTimer timer;
+		const int frames = 300;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			Move(inTree, velocity, extent);
+			for (Collider* col : inTree) tree.Update(col);
+
+			// swap a few in and out
+			for (int i = 0; i < 10; i++)
+			{
+				size_t leaving = rand() % inTree.size();
+				size_t joining = rand() % outOfTree.size();
+				tree.Remove(inTree[leaving]);
+				outOfTree[joining]->SetCenter(XMFLOAT2(Random(extent), Random(extent)));
+				tree.Add(outOfTree[joining]);
+				std::swap(inTree[leaving], outOfTree[joining]);
+			}
+
+			for (int i = 0; i < 20; i++)
+			{
+				XMFLOAT4 box = RandomBox(extent);
+				tree.GetCollidableObjects(box, results);
+				if (!SameSet(results, BruteForce(inTree, box))) wrong++;
+				found += results.size();
+			}
+			Collider* col = inTree[rand() % inTree.size()];
+			tree.GetCollidableObjects(col, results);
+			if (!SameSet(results, BruteForce(inTree, col->GetBounds()))) wrong++;
+		}
+
+		// everything taken out and put back, nothing left behind
+		for (Collider* col : inTree) tree.Remove(col);
+		tree.GetCollidableObjects(XMFLOAT4(-extent * 2, -extent * 2, extent * 2, extent * 2), results);
+		CHECK(results.empty());
+		for (Collider* col : inTree) tree.Add(col);
+		tree.GetCollidableObjects(XMFLOAT4(-extent * 2, -extent * 2, extent * 2, extent * 2), results);
+		CHECK(SameSet(results, inTree));
+
+		printf("%s: %d frames of moving, adding and removing in %.1f ms, %d wrong queries, %.1f found per query\n",
+			name, frames, timer.Milliseconds(), wrong, (double)found / (frames * 20));
+		CHECK(wrong == 0);
+	}
+
+	// the game's trees, but a hundred thousand of them packed over the whole root square, with
+	// the player's collider walking through them.  Both trees are built with the same settings
+	// and have to give the same answers, brute force checks a few
+	void DenseForest(const char* name, const QuadtreeSettings& settings)
+	{
+		ColliderStore* store = ColliderStore::Instance();
+		const int side = 317;
+		const float step = 2.0f * settings.halfSize / side;
+		std::vector<Collider*> trees;
+		for (int i = 0; i < side; i++)
+		{
+			for (int j = 0; j < side; j++)
+			{
+				if (rand() % 100 < 1) continue;
+				Collider* tree = store->Get(store->CreateCircle(0.3f + rand() % 10 / 20.0f));
+				float x = -settings.halfSize + (i + 0.5f) * step + Random(step * 0.4f);
+				float y = -settings.halfSize + (j + 0.5f) * step + Random(step * 0.4f);
+				tree->SetCenter(XMFLOAT2(x, y));
+				trees.push_back(tree);
+			}
+		}
+
+		TestTimer timer;
+		Quadtree tree(settings);
+		tree.CreateQuadtree(trees);
+		double treeBuildMs = timer.Milliseconds();
+		LinearQuadtree linear(settings);
+		timer = TestTimer();
+		linear.Build(trees);
+		double linearBuildMs = timer.Milliseconds();
+
+		Collider* player = store->Get(store->CreateCircle(0.2f));
+		std::vector<XMFLOAT2> walk;
+		for (int i = 0; i < 100000; i++) walk.push_back(XMFLOAT2(Random(settings.halfSize), Random(settings.halfSize)));
+
+		int wrong = 0;
+		std::vector<Collider*> results;
+		std::vector<Collider*> linearResults;
+		for (size_t i = 0; i < walk.size(); i += 100)
+		{
+			player->SetCenter(walk[i]);
+			tree.GetCollidableObjects(player, results);
+			linear.GetCollidableObjects(player, linearResults);
+			if (!SameSet(linearResults, results)) wrong++;
+			if (i % 1000 == 0 && !SameSet(results, BruteForce(trees, player->GetBounds()))) wrong++;
+		}
+		CHECK(wrong == 0);
+
+		results.reserve(64);
+		linearResults.reserve(64);
+		tree.ResetQueryStats();
+		unsigned long long found = 0;
+		timer = TestTimer();
+		for (const XMFLOAT2& center : walk)
+		{
+			player->SetCenter(center);
+			tree.GetCollidableObjects(player, results);
+			found += results.size();
+		}
+		double treeMs = timer.Milliseconds();
+		unsigned long long linearFound = 0;
+		timer = TestTimer();
+		for (const XMFLOAT2& center : walk)
+		{
+			player->SetCenter(center);
+			linear.GetCollidableObjects(player, linearResults);
+			linearFound += linearResults.size();
+		}
+		double linearMs = timer.Milliseconds();
+		CHECK(linearFound == found);
+
+		const BroadphaseQueryStats& stats = tree.GetQueryStats();
+		printf("%s, %zu trees: built in %.1f ms linked, %.1f ms linear (%zu nodes), %.0f ns per query linked, %.0f ns linear, "
+			"%.1f tested and %.2f found per query\n",
+			name, trees.size(), treeBuildMs, linearBuildMs, linear.GetNodeCount(), treeMs * 1e6 / walk.size(), linearMs * 1e6 / walk.size(),
+			stats.AverageTested(), (double)found / walk.size());
+		// every query only looks at its own corner of the forest
+		CHECK(stats.AverageTested() < 100.0f);
+	}
+}
+
+void* operator new(size_t size)
+{
+	if (countAllocations) allocations++;
+	void* memory = malloc(size ? size : 1);
+	if (memory == nullptr) throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	free(memory);
+}
+
+int main()
+{
+	srand(3);
+	const float extent = 180.0f;
+	std::vector<Collider*> colliders = MakeColliders(4000, extent);
+
+	Quadtree tree;
+	tree.CreateQuadtree(colliders);
+
+	// every box query and every collider's own query against brute force
+	int wrong = 0;
+	std::vector<Collider*> results;
+	for (int i = 0; i < 2000; i++)
+	{
+		XMFLOAT4 box = RandomBox(extent);
+		tree.GetCollidableObjects(box, results);
+		if (!SameSet(results, BruteForce(colliders, box))) wrong++;
+
+		std::vector<Collider*> visited;
+		tree.VisitCollidableObjects(box, [&visited](Collider* col) { visited.push_back(col); });
+		if (!SameSet(visited, results)) wrong++;
+	}
+	for (size_t i = 0; i < colliders.size(); i += 7)
+	{
+		tree.GetCollidableObjects(colliders[i], results);
+		if (!SameSet(results, BruteForce(colliders, colliders[i]->GetBounds()))) wrong++;
+	}
+	CHECK(wrong == 0);
+
+	// once results is big enough, queries don't touch the heap
+	std::vector<XMFLOAT4> boxes;
+	for (int i = 0; i < 100000; i++) boxes.push_back(RandomBox(extent));
+	results.reserve(colliders.size());
+	tree.ResetQueryStats();
+
+	unsigned long long found = 0;
+	unsigned long long visited = 0;
+	allocations = 0;
+	countAllocations = true;
+	TestTimer timer;
+	for (const XMFLOAT4& box : boxes)
+	{
+		tree.GetCollidableObjects(box, results);
+		found += results.size();
+	}
+	double treeMs = timer.Milliseconds();
+	for (const XMFLOAT4& box : boxes) tree.VisitCollidableObjects(box, [&visited](Collider*) { visited++; });
+	countAllocations = false;
+	CHECK(allocations == 0);
+	CHECK(visited == found);
+
+	// and the counter does see the heap
+	countAllocations = true;
+	std::vector<Collider*> grown;
+	grown.reserve(16);
+	countAllocations = false;
+	CHECK(allocations == 1);
+
+	timer = TestTimer();
+	for (size_t i = 0; i < boxes.size(); i += 10) BruteForce(colliders, boxes[i]);
+	double bruteMs = timer.Milliseconds() * 10;
+
+	BroadphaseQueryStats stats = tree.GetQueryStats();
+	printf("%zu colliders: %.0f ns per query, %.0f ns brute force, %.1f found, %.1f tested per query\n",
+		colliders.size(), treeMs * 1e6 / boxes.size(), bruteMs * 1e6 / boxes.size(),
+		(double)found / boxes.size(), (double)stats.tested / stats.queries);
+
+	// the linear tree only takes collider queries, so a rectangle is moved over the boxes
+	LinearQuadtree linear;
+	timer = TestTimer();
+	linear.Build(colliders);
+	double buildMs = timer.Milliseconds();
+	Collider* probe = ColliderStore::Instance()->Get(ColliderStore::Instance()->CreateRect(XMFLOAT2(8, 8)));
+
+	wrong = 0;
+	std::vector<Collider*> linearResults;
+	for (int i = 0; i < 2000; i++)
+	{
+		probe->SetCenter(XMFLOAT2(Random(extent), Random(extent)));
+		tree.GetCollidableObjects(probe, results);
+		linear.GetCollidableObjects(probe, linearResults);
+		if (!SameSet(linearResults, results)) wrong++;
+	}
+	for (size_t i = 0; i < colliders.size(); i += 7)
+	{
+		linear.GetCollidableObjects(colliders[i], linearResults);
+		if (!SameSet(linearResults, BruteForce(colliders, colliders[i]->GetBounds()))) wrong++;
+	}
+	CHECK(wrong == 0);
+	CHECK(linear.GetObjectCount() == colliders.size());
+
+	// rebuilding after everything moved reuses the storage and still matches
+	for (Collider* col : colliders)
+	{
+		XMFLOAT2 center = col->GetCenter();
+		col->SetCenter(XMFLOAT2(center.x + Random(3.0f), center.y + Random(3.0f)));
+	}
+	tree.CreateQuadtree(colliders);
+	allocations = 0;
+	countAllocations = true;
+	timer = TestTimer();
+	linear.Build(colliders);
+	double rebuildMs = timer.Milliseconds();
+	countAllocations = false;
+	CHECK(allocations == 0);
+	wrong = 0;
+	for (int i = 0; i < 2000; i++)
+	{
+		probe->SetCenter(XMFLOAT2(Random(extent), Random(extent)));
+		linear.GetCollidableObjects(probe, linearResults);
+		if (!SameSet(linearResults, BruteForce(colliders, probe->GetBounds()))) wrong++;
+	}
+	CHECK(wrong == 0);
+
+	// the same probe positions through both trees
+	std::vector<XMFLOAT2> probes;
+	for (int i = 0; i < 100000; i++) probes.push_back(XMFLOAT2(Random(extent), Random(extent)));
+	linearResults.reserve(colliders.size());
+	timer = TestTimer();
+	for (const XMFLOAT2& center : probes)
+	{
+		probe->SetCenter(center);
+		tree.GetCollidableObjects(probe, results);
+	}
+	treeMs = timer.Milliseconds();
+	timer = TestTimer();
+	for (const XMFLOAT2& center : probes)
+	{
+		probe->SetCenter(center);
+		linear.GetCollidableObjects(probe, linearResults);
+	}
+	double linearMs = timer.Milliseconds();
+	printf("linear quadtree: %zu nodes, built in %.2f ms (%.2f ms rebuilding), %.0f ns per query against %.0f ns for the linked one\n",
+		linear.GetNodeCount(), buildMs, rebuildMs, linearMs * 1e6 / probes.size(), treeMs * 1e6 / probes.size());
+
+	Stress("quadtree", QuadtreeSettings());
+
+	// loose nodes keep every collider in one node, with the same settings as CollisionManager
+	QuadtreeSettings looseSettings;
+	looseSettings.looseness = 0.5f;
+	Quadtree loose(looseSettings);
+	loose.CreateQuadtree(colliders);
+
+	// one of them past the root's square, the loose tree keeps it in the root
+	Collider* outside = ColliderStore::Instance()->Get(ColliderStore::Instance()->CreateCircle(1.0f));
+	outside->SetCenter(XMFLOAT2(260.0f, 0.0f));
+	loose.Add(outside);
+	std::vector<Collider*> withOutside = colliders;
+	withOutside.push_back(outside);
+
+	wrong = 0;
+	tree.ResetQueryStats();
+	loose.ResetQueryStats();
+	for (int i = 0; i < 5000; i++)
+	{
+		XMFLOAT4 box = RandomBox(extent);
+		tree.GetCollidableObjects(box, results);
+		loose.GetCollidableObjects(box, linearResults);
+		std::vector<Collider*> expected = BruteForce(colliders, box);
+		if (!SameSet(linearResults, expected)) wrong++;
+		if (!SameSet(results, expected)) wrong++;
+	}
+	for (size_t i = 0; i < colliders.size(); i += 7)
+	{
+		loose.GetCollidableObjects(colliders[i], results);
+		if (!SameSet(results, BruteForce(withOutside, colliders[i]->GetBounds()))) wrong++;
+	}
+	loose.GetCollidableObjects(outside, results);
+	CHECK(results.size() == 1 && results[0] == outside);
+	CHECK(wrong == 0);
+
+	allocations = 0;
+	countAllocations = true;
+	timer = TestTimer();
+	for (const XMFLOAT4& box : boxes) loose.GetCollidableObjects(box, results);
+	double looseMs = timer.Milliseconds();
+	countAllocations = false;
+	CHECK(allocations == 0);
+
+	BroadphaseQueryStats tight = tree.GetQueryStats();
+	BroadphaseQueryStats loosened = loose.GetQueryStats();
+	printf("loose quadtree: %.0f ns per query, %.1f tested per query against %.1f, %.1f found\n",
+		looseMs * 1e6 / boxes.size(), (double)loosened.tested / loosened.queries, (double)tight.tested / tight.queries,
+		(double)loosened.candidates / loosened.queries);
+
+	Stress("loose quadtree", looseSettings);
+
+	// the game's settings leave about 25 trees in every leaf at this density, two more levels about 1.5
+	DenseForest("dense forest", QuadtreeSettings());
+	QuadtreeSettings deepSettings;
+	deepSettings.maxDepth = 8;
+	DenseForest("dense forest 2 levels deeper", deepSettings);
+	DenseForest("dense forest, loose", looseSettings);
+
+	return TestResult();
+}
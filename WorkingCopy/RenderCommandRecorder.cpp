@@ -0,0 +1,58 @@
+#include "RenderCommandRecorder.h"
+
+void RenderCommandRecorder::BindShader(RENDER_PASS pass, unsigned int object)
+{
+	Record(RENDER_COMMAND::BIND_SHADER, pass, object);
+}
+
+void RenderCommandRecorder::BindMaterial(RENDER_PASS pass, unsigned int object)
+{
+	Record(RENDER_COMMAND::BIND_MATERIAL, pass, object);
+}
+
+void RenderCommandRecorder::BindMesh(RENDER_PASS pass, unsigned int object)
+{
+	Record(RENDER_COMMAND::BIND_MESH, pass, object);
+}
+
+void RenderCommandRecorder::Draw(RENDER_PASS pass, unsigned int object)
+{
+	Record(RENDER_COMMAND::DRAW, pass, object);
+}
+
+void RenderCommandRecorder::SetUploadSize(RENDER_PASS pass, RENDER_COMMAND command, unsigned int bytes)
+{
+	uploadSizes[(int)pass][(int)command] = bytes;
+}
+
+void RenderCommandRecorder::Clear()
+{
+	commands.clear();
+	stats = RenderStats();
+}
+
+void RenderCommandRecorder::Replay(RenderBackend& backend) const
+{
+	for (const RenderCommand& command : commands)
+	{
+		switch (command.type)
+		{
+		case RENDER_COMMAND::BIND_SHADER: backend.BindShader(command.pass, command.object); break;
+		case RENDER_COMMAND::BIND_MATERIAL: backend.BindMaterial(command.pass, command.object); break;
+		case RENDER_COMMAND::BIND_MESH: backend.BindMesh(command.pass, command.object); break;
+		default: backend.Draw(command.pass, command.object); break;
+		}
+	}
+}
+
+void RenderCommandRecorder::Record(RENDER_COMMAND type, RENDER_PASS pass, unsigned int object)
+{
+	RenderCommand command;
+	command.type = type;
+	command.pass = pass;
+	command.object = object;
+	commands.push_back(command);
+
+	stats.commands[(int)type]++;
+	stats.bytesUploaded += uploadSizes[(int)pass][(int)type];
+}
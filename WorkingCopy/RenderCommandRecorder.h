@@ -0,0 +1,61 @@
+#pragma once
+#include "RenderQueue.h"
+#include <vector>
+
+enum class RENDER_COMMAND { BIND_SHADER, BIND_MATERIAL, BIND_MESH, DRAW, COUNT };
+
+struct RenderCommand
+{
+	RENDER_COMMAND type;
+	RENDER_PASS pass;
+	unsigned int object;
+};
+
+// what a frame's commands added up to
+struct RenderStats
+{
+	unsigned int commands[(int)RENDER_COMMAND::COUNT] = {};
+	// constant buffer bytes, from the sizes given to the recorder
+	size_t bytesUploaded = 0;
+
+	inline unsigned int GetStateChanges() const
+	{
+		return commands[(int)RENDER_COMMAND::BIND_SHADER] + commands[(int)RENDER_COMMAND::BIND_MATERIAL] + commands[(int)RENDER_COMMAND::BIND_MESH];
+	}
+	inline unsigned int GetDraws() const { return commands[(int)RENDER_COMMAND::DRAW]; }
+};
+
+// --------------------------------------------------------
+// A RenderBackend that only writes the commands down, with
+// no graphics API behind it.  They can be replayed into a
+// real backend later, or just counted: how many times state
+// changed and how many bytes of constants that uploaded, so
+// a frame's draw order can be measured anywhere.
+//
+// Bytes are per command and pass, set to match the buffers
+// the game's shaders copy for each one
+// --------------------------------------------------------
+class RenderCommandRecorder : public RenderBackend
+{
+public:
+	void BindShader(RENDER_PASS pass, unsigned int object) override;
+	void BindMaterial(RENDER_PASS pass, unsigned int object) override;
+	void BindMesh(RENDER_PASS pass, unsigned int object) override;
+	void Draw(RENDER_PASS pass, unsigned int object) override;
+
+	void SetUploadSize(RENDER_PASS pass, RENDER_COMMAND command, unsigned int bytes);
+	// forgets the commands and their stats, not the upload sizes
+	void Clear();
+	// sends every command to backend, in the order they came
+	void Replay(RenderBackend& backend) const;
+
+	inline const std::vector<RenderCommand>& GetCommands() const { return commands; }
+	inline const RenderStats& GetStats() const { return stats; }
+
+private:
+	std::vector<RenderCommand> commands;
+	RenderStats stats;
+	unsigned int uploadSizes[(int)RENDER_PASS::COUNT][(int)RENDER_COMMAND::COUNT] = {};
+
+	void Record(RENDER_COMMAND type, RENDER_PASS pass, unsigned int object);
+};
@@ -0,0 +1,155 @@
+#include "RenderQueue.h"
+
+namespace
+{
+	// the low bits of id, shifted into place
+	inline uint64_t KeyField(unsigned int id, int bits, int shift)
+	{
+		return ((uint64_t)id & ((1ull << bits) - 1)) << shift;
+	}
+
+	template<typename Key, typename Map>
+	unsigned int Intern(Map& ids, const Key& key)
+	{
+		auto found = ids.find(key);
+		if (found != ids.end()) return found->second;
+		unsigned int id = (unsigned int)ids.size();
+		ids.emplace(key, id);
+		return id;
+	}
+}
+
+void RenderQueue::Begin()
+{
+	items.clear();
+	sorted.clear();
+	dirty = false;
+	shaderIds.clear();
+	materialIds.clear();
+	meshIds.clear();
+}
+
+unsigned int RenderQueue::GetShaderId(const void* vertexShader, const void* pixelShader)
+{
+	return Intern(shaderIds, std::make_pair(vertexShader, pixelShader));
+}
+
+unsigned int RenderQueue::GetMaterialId(const void* material)
+{
+	return Intern(materialIds, material);
+}
+
+unsigned int RenderQueue::GetMeshId(const void* mesh)
+{
+	return Intern(meshIds, mesh);
+}
+
+void RenderQueue::Add(RENDER_PASS pass, unsigned int shader, unsigned int material, unsigned int mesh, float depth, unsigned int object)
+{
+	// nearer sorts first, anything outside 0..1 just goes to the ends
+	const uint64_t maxDepth = (1ull << DepthBits) - 1;
+	uint64_t depthField = depth <= 0.0f ? 0 : (depth >= 1.0f ? maxDepth : (uint64_t)(depth * maxDepth));
+
+	Item item;
+	item.key = KeyField((unsigned int)pass, PassBits, 64 - PassBits)
+		| KeyField(shader, ShaderBits, MaterialBits + MeshBits + DepthBits)
+		| KeyField(material, MaterialBits, MeshBits + DepthBits)
+		| KeyField(mesh, MeshBits, DepthBits)
+		| depthField;
+	item.object = object;
+	item.shader = shader;
+	item.material = material;
+	item.mesh = mesh;
+	item.pass = pass;
+	items.push_back(item);
+	dirty = true;
+}
+
+void RenderQueue::Sort()
+{
+	size_t count = items.size();
+	sorted.resize(count);
+	sortScratch.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		sorted[i].key = items[i].key;
+		sorted[i].item = (unsigned int)i;
+	}
+
+	// 8 bits a pass like the quadtrees' sort, skipping digits every key shares. most
+	// frames have a few shaders and materials, so the upper passes mostly go
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		unsigned int counts[257] = {};
+		for (size_t i = 0; i < count; i++)
+		{
+			counts[((sorted[i].key >> shift) & 0xFF) + 1]++;
+		}
+		if (counts[((sorted[0].key >> shift) & 0xFF) + 1] == count) continue;
+
+		for (int d = 0; d < 256; d++)
+		{
+			counts[d + 1] += counts[d];
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			unsigned int digit = (sorted[i].key >> shift) & 0xFF;
+			sortScratch[counts[digit]++] = sorted[i];
+		}
+		sorted.swap(sortScratch);
+	}
+	dirty = false;
+}
+
+void RenderQueue::Submit(RenderBackend& backend, RENDER_PASS pass)
+{
+	if (items.empty()) return;
+	if (dirty) Sort();
+
+	// passes are the top of the key, so each one is a single run
+	unsigned int shader = NoId, material = NoId, mesh = NoId;
+	bool started = false;
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		const Item& item = items[sorted[i].item];
+		if (item.pass != pass)
+		{
+			if (started) break;
+			continue;
+		}
+		started = true;
+		Draw(backend, item, shader, material, mesh);
+	}
+}
+
+void RenderQueue::SubmitUnsorted(RenderBackend& backend, RENDER_PASS pass)
+{
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		if (items[i].pass != pass) continue;
+		unsigned int shader = NoId, material = NoId, mesh = NoId;
+		Draw(backend, items[i], shader, material, mesh);
+	}
+}
+
+void RenderQueue::Draw(RenderBackend& backend, const Item& item, unsigned int& shader, unsigned int& material, unsigned int& mesh)
+{
+	if (item.shader != shader)
+	{
+		backend.BindShader(item.pass, item.object);
+		shader = item.shader;
+		material = NoId;
+		mesh = NoId;
+	}
+	if (item.material != material)
+	{
+		backend.BindMaterial(item.pass, item.object);
+		material = item.material;
+	}
+	if (item.mesh != mesh)
+	{
+		backend.BindMesh(item.pass, item.object);
+		mesh = item.mesh;
+	}
+	backend.Draw(item.pass, item.object);
+}
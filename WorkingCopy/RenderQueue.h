@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// the passes a frame draws entities in, in order
+enum class RENDER_PASS { SHADOW, MAIN, COUNT };
+
+// --------------------------------------------------------
+// Whatever actually sets state and draws for a RenderQueue.
+// It's only told which object needs what bound, objects are
+// the numbers they were added to the queue with.
+//
+// A shader bind forgets the material and mesh, which are
+// bound again right after it, since their constants live in
+// the shader's buffers
+// --------------------------------------------------------
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() {}
+
+	virtual void BindShader(RENDER_PASS pass, unsigned int object) = 0;
+	virtual void BindMaterial(RENDER_PASS pass, unsigned int object) = 0;
+	virtual void BindMesh(RENDER_PASS pass, unsigned int object) = 0;
+	virtual void Draw(RENDER_PASS pass, unsigned int object) = 0;
+};
+
+// --------------------------------------------------------
+// Collects a frame's draws and sorts them so things that
+// share state are drawn together.
+//
+// Every item gets a 64 bit key, from the top: pass, shader,
+// material, mesh, then depth front to back, so a radix sort
+// groups them by the most expensive state first and draws
+// nearer things first within a mesh.  Submit then binds
+// each piece of state only when it changes from the last
+// item.  Ids are compared in full, so running out of bits
+// for one only costs some order
+// --------------------------------------------------------
+class RenderQueue
+{
+public:
+	// forgets the last frame's items and ids
+	void Begin();
+
+	// small ids for pointers to state, they're handed out in order and only last until Begin
+	unsigned int GetShaderId(const void* vertexShader, const void* pixelShader);
+	unsigned int GetMaterialId(const void* material);
+	unsigned int GetMeshId(const void* mesh);
+
+	// depth is 0 at the camera and 1 at the far plane, object is handed back to the backend
+	void Add(RENDER_PASS pass, unsigned int shader, unsigned int material, unsigned int mesh, float depth, unsigned int object);
+
+	// sorts if anything was added since, then draws one pass through the backend
+	void Submit(RenderBackend& backend, RENDER_PASS pass);
+	// in the order they were added, binding everything for every item. only to compare against
+	void SubmitUnsorted(RenderBackend& backend, RENDER_PASS pass);
+
+	inline size_t GetCount() const { return items.size(); }
+	inline uint64_t GetKey(size_t item) const { return items[item].key; }
+
+	// how many bits of each id and of the depth make it into the key
+	static const int PassBits = 4;
+	static const int ShaderBits = 8;
+	static const int MaterialBits = 12;
+	static const int MeshBits = 16;
+	static const int DepthBits = 24;
+
+private:
+	struct Item
+	{
+		uint64_t key;
+		unsigned int object;
+		unsigned int shader;
+		unsigned int material;
+		unsigned int mesh;
+		RENDER_PASS pass;
+	};
+
+	// a key and which item it's for, what the sort moves around
+	struct SortEntry
+	{
+		uint64_t key;
+		unsigned int item;
+	};
+
+	static const unsigned int NoId = 0xFFFFFFFF;
+
+	std::vector<Item> items;
+	std::vector<SortEntry> sorted;
+	std::vector<SortEntry> sortScratch;
+	bool dirty = false;
+	std::map<std::pair<const void*, const void*>, unsigned int> shaderIds;
+	std::unordered_map<const void*, unsigned int> materialIds;
+	std::unordered_map<const void*, unsigned int> meshIds;
+
+	void Sort();
+	void Draw(RenderBackend& backend, const Item& item, unsigned int& shader, unsigned int& material, unsigned int& mesh);
+};
@@ -0,0 +1,255 @@
+#include "RenderQueue.h"
+#include "RenderCommandRecorder.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+// --------------------------------------------------------
+// Fills a RenderQueue the way Game::QueueEntities does, for
+// the game's props and forest seen from all over the map.
+// Checks Submit draws exactly what SubmitUnsorted draws,
+// each with its own shader, material and mesh bound, in key
+// order, binding each state once per run of items that
+// share it.  It has to change state far less often than
+// drawing in the order things were added.  Then does the
+// same with more materials than the key has bits for
+// --------------------------------------------------------
+
+namespace
+{
+	const float Pi = 3.1415926535f;
+
+	struct Object
+	{
+		unsigned int vertexShader;  // 0 and 1 for the main pass, +2 for the shadow pass
+		unsigned int material;
+		unsigned int mesh;
+		float x;
+		float z;
+	};
+
+	struct Drawn
+	{
+		RENDER_PASS pass;
+		unsigned int object;
+		unsigned int shader;
+		unsigned int material;
+		unsigned int mesh;
+	};
+
+	// a backend that remembers what's bound and checks every draw against the object's own state
+	class CheckingBackend : public RenderBackend
+	{
+	public:
+		CheckingBackend(const std::vector<Object>& objects) : objects(objects) {}
+
+		void BindShader(RENDER_PASS pass, unsigned int object) override
+		{
+			shader = ShaderOf(pass, object);
+			material = Unbound;
+			mesh = Unbound;
+		}
+		void BindMaterial(RENDER_PASS pass, unsigned int object) override { material = MaterialOf(pass, object); }
+		void BindMesh(RENDER_PASS pass, unsigned int object) override { mesh = objects[object].mesh; }
+		void Draw(RENDER_PASS pass, unsigned int object) override
+		{
+			if (shader != ShaderOf(pass, object) || material != MaterialOf(pass, object) || mesh != objects[object].mesh) wrongState++;
+			drawn.push_back({ pass, object, shader, material, mesh });
+		}
+
+		void Reset()
+		{
+			shader = material = mesh = Unbound;
+			drawn.clear();
+		}
+
+		std::vector<Drawn> drawn;
+		int wrongState = 0;
+
+	private:
+		static const unsigned int Unbound = 0xFFFFFFFF;
+		// the shadow pass has no material, its bind is for nothing
+		static const unsigned int NoMaterial = 0xFFFFFFFE;
+
+		const std::vector<Object>& objects;
+		unsigned int shader = Unbound;
+		unsigned int material = Unbound;
+		unsigned int mesh = Unbound;
+
+		unsigned int ShaderOf(RENDER_PASS pass, unsigned int object) const
+		{
+			return objects[object].vertexShader + (pass == RENDER_PASS::SHADOW ? 2 : 0);
+		}
+		unsigned int MaterialOf(RENDER_PASS pass, unsigned int object) const
+		{
+			return pass == RENDER_PASS::SHADOW ? NoMaterial : objects[object].material;
+		}
+	};
+
+	// how many runs of the same shader, shader and material, and all three a pass has to bind at least
+	unsigned int LeastStateChanges(const std::vector<Drawn>& drawn, RENDER_PASS pass)
+	{
+		std::set<unsigned int> shaders;
+		std::set<std::pair<unsigned int, unsigned int>> materials;
+		std::set<std::tuple<unsigned int, unsigned int, unsigned int>> meshes;
+		for (const Drawn& d : drawn)
+		{
+			if (d.pass != pass) continue;
+			shaders.insert(d.shader);
+			materials.insert(std::make_pair(d.shader, d.material));
+			meshes.insert(std::make_tuple(d.shader, d.material, d.mesh));
+		}
+		return (unsigned int)(shaders.size() + materials.size() + meshes.size());
+	}
+
+	std::vector<std::pair<int, unsigned int>> DrawSet(const std::vector<Drawn>& drawn)
+	{
+		std::vector<std::pair<int, unsigned int>> set;
+		for (const Drawn& d : drawn) set.push_back(std::make_pair((int)d.pass, d.object));
+		std::sort(set.begin(), set.end());
+		return set;
+	}
+}
+
+int main()
+{
+	// the props from Game::CreateBasicGeometry, a forest sharing one packed mesh and material, and the lanterns
+	std::vector<Object> objects = {
+		{ 0, 0, 0, 0, 0 }, { 0, 1, 1, -15, 100 }, { 0, 2, 2, 100, 70 }, { 0, 3, 3, 70, -25 }, { 0, 3, 3, 99, 66 },
+		{ 0, 4, 4, -90, 18 }, { 0, 5, 5, -86, 29 }, { 0, 6, 6, -86, 29 }, { 0, 7, 7, -3, 8 }, { 0, 8, 8, -40, -80 },
+		{ 0, 9, 9, 99, 66 }, { 0, 10, 10, 16, 0 }, { 0, 11, 11, 1.5f, -1.5f },
+	};
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> spread(-150.0f, 150.0f);
+	for (int i = 0; i < 700; i++) objects.push_back({ 1, 12, 12, spread(random), spread(random) });
+	const float lanternX[] = { -15, 97, 70, -45, -90 };
+	const float lanternZ[] = { 95, 70, -31, -80, 22 };
+	for (int i = 0; i < 5; i++) objects.push_back({ 0, 13, 13, lanternX[i], lanternZ[i] });
+
+	// stand-ins for the D3D objects, only their addresses are used
+	std::vector<char> vertexShaders(4), pixelShader(1), materials(14), meshes(14);
+
+	RenderQueue queue;
+	RenderCommandRecorder recorder;
+	recorder.SetUploadSize(RENDER_PASS::MAIN, RENDER_COMMAND::BIND_MATERIAL, 16 + 8224 + 16);
+	recorder.SetUploadSize(RENDER_PASS::MAIN, RENDER_COMMAND::DRAW, 320);
+	recorder.SetUploadSize(RENDER_PASS::SHADOW, RENDER_COMMAND::DRAW, 192);
+	CheckingBackend sorted(objects);
+	CheckingBackend unsorted(objects);
+
+	int wrongSet = 0;
+	int outOfOrder = 0;
+	int extraBinds = 0;
+	unsigned long long sortedChanges = 0;
+	unsigned long long unsortedChanges = 0;
+	unsigned long long sortedBytes = 0;
+	unsigned long long unsortedBytes = 0;
+	unsigned long long draws = 0;
+	const int frames = 200;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		// somewhere on the map looking any way, what's in a 45 degree cone up to the far plane is in view
+		float cameraX = spread(random) * 0.8f;
+		float cameraZ = spread(random) * 0.8f;
+		float yaw = (spread(random) / 150.0f + 1.0f) * Pi;
+		float forwardX = sinf(yaw);
+		float forwardZ = cosf(yaw);
+
+		queue.Begin();
+		unsigned int noMaterial = queue.GetMaterialId(nullptr);
+		for (unsigned int i = 0; i < (unsigned int)objects.size(); i++)
+		{
+			const Object& o = objects[i];
+			float dx = o.x - cameraX;
+			float dz = o.z - cameraZ;
+			float distance = sqrtf(dx * dx + dz * dz);
+			float ahead = dx * forwardX + dz * forwardZ;
+			unsigned int mesh = queue.GetMeshId(&meshes[o.mesh]);
+			// the ground is always in both, the flashlight's cone is narrower than the camera's
+			if (i == 0 || (distance < 100 && ahead > distance * 0.8f))
+				queue.Add(RENDER_PASS::SHADOW, queue.GetShaderId(&vertexShaders[o.vertexShader + 2], nullptr), noMaterial, mesh, 0.0f, i);
+			if (i == 0 || (distance < 100 && ahead > distance * 0.7f))
+				queue.Add(RENDER_PASS::MAIN, queue.GetShaderId(&vertexShaders[o.vertexShader], &pixelShader[0]), queue.GetMaterialId(&materials[o.material]), mesh, distance / 100.0f, i);
+		}
+		// handed out in order, the same pointers get the same id
+		CHECK(queue.GetMaterialId(nullptr) == noMaterial && noMaterial == 0);
+
+		recorder.Clear();
+		sorted.Reset();
+		for (RENDER_PASS pass : { RENDER_PASS::SHADOW, RENDER_PASS::MAIN }) queue.Submit(recorder, pass);
+		recorder.Replay(sorted);
+		RenderStats sortedStats = recorder.GetStats();
+
+		recorder.Clear();
+		unsorted.Reset();
+		for (RENDER_PASS pass : { RENDER_PASS::SHADOW, RENDER_PASS::MAIN }) queue.SubmitUnsorted(recorder, pass);
+		recorder.Replay(unsorted);
+		RenderStats unsortedStats = recorder.GetStats();
+
+		if (DrawSet(sorted.drawn) != DrawSet(unsorted.drawn) || sorted.drawn.size() != queue.GetCount()) wrongSet++;
+		// the shadow pass first, then nearer things first within each run of the same state
+		for (size_t d = 1; d < sorted.drawn.size(); d++)
+		{
+			const Drawn& a = sorted.drawn[d - 1];
+			const Drawn& b = sorted.drawn[d];
+			if ((int)a.pass > (int)b.pass) outOfOrder++;
+			if (a.pass == b.pass && a.shader == b.shader && a.material == b.material && a.mesh == b.mesh && b.pass == RENDER_PASS::MAIN)
+			{
+				const Object& oa = objects[a.object];
+				const Object& ob = objects[b.object];
+				float da = sqrtf((oa.x - cameraX) * (oa.x - cameraX) + (oa.z - cameraZ) * (oa.z - cameraZ));
+				float db = sqrtf((ob.x - cameraX) * (ob.x - cameraX) + (ob.z - cameraZ) * (ob.z - cameraZ));
+				if (da > db + 1e-3f) outOfOrder++;
+			}
+		}
+		unsigned int least = LeastStateChanges(sorted.drawn, RENDER_PASS::SHADOW) + LeastStateChanges(sorted.drawn, RENDER_PASS::MAIN);
+		if (sortedStats.GetStateChanges() != least) extraBinds++;
+
+		sortedChanges += sortedStats.GetStateChanges();
+		unsortedChanges += unsortedStats.GetStateChanges();
+		sortedBytes += sortedStats.bytesUploaded;
+		unsortedBytes += unsortedStats.bytesUploaded;
+		draws += sortedStats.GetDraws();
+		if (sortedStats.GetDraws() != unsortedStats.GetDraws()) wrongSet++;
+	}
+	printf("%zu objects, %.0f draws a frame\n", objects.size(), draws / (double)frames);
+	printf("in the order added: %.1f state changes and %.1f KB of constants a frame\n", unsortedChanges / (double)frames, unsortedBytes / 1024.0 / frames);
+	printf("sorted:             %.1f state changes and %.1f KB of constants a frame\n", sortedChanges / (double)frames, sortedBytes / 1024.0 / frames);
+	CHECK(sorted.wrongState == 0 && unsorted.wrongState == 0);
+	CHECK(wrongSet == 0);
+	CHECK(outOfOrder == 0);
+	CHECK(extraBinds == 0);
+	CHECK(draws > 0);
+	CHECK(sortedChanges * 4 < unsortedChanges);
+	CHECK(sortedBytes < unsortedBytes);
+
+	// more materials than fit in the key: runs can interleave but every draw still gets its own
+	std::vector<Object> many;
+	for (unsigned int i = 0; i < 10000; i++) many.push_back({ i % 2, (i * 7919) % 5000, i % 300, 0, 0 });
+	std::vector<char> manyMaterials(5000), manyMeshes(300);
+	CheckingBackend checker(many);
+	queue.Begin();
+	for (unsigned int i = 0; i < (unsigned int)many.size(); i++)
+	{
+		const Object& o = many[i];
+		queue.Add(RENDER_PASS::MAIN, queue.GetShaderId(&vertexShaders[o.vertexShader], &pixelShader[0]),
+			queue.GetMaterialId(&manyMaterials[o.material]), queue.GetMeshId(&manyMeshes[o.mesh]), (i % 97) / 97.0f, i);
+	}
+	// the next one handed out, past what the key holds
+	CHECK(queue.GetMaterialId(nullptr) == manyMaterials.size() && manyMaterials.size() > (1u << RenderQueue::MaterialBits));
+	queue.Submit(checker, RENDER_PASS::MAIN);
+	queue.Submit(checker, RENDER_PASS::SHADOW);
+	printf("%zu draws over %zu materials, %d with the wrong state\n", checker.drawn.size(), manyMaterials.size(), checker.wrongState);
+	CHECK(checker.wrongState == 0);
+	CHECK(checker.drawn.size() == many.size());
+	std::vector<std::pair<int, unsigned int>> expected;
+	for (unsigned int i = 0; i < (unsigned int)many.size(); i++) expected.push_back(std::make_pair((int)RENDER_PASS::MAIN, i));
+	CHECK(DrawSet(checker.drawn) == expected);
+
+	return TestResult();
+}
@@ -0,0 +1,34 @@
+#include "packedvertex.hlsli"
+
+// Same as ShadowVS.hlsl, for meshes cooked with PackedVertex
+cbuffer externalData : register(b0)
+{
+	matrix world;
+	matrix view;
+	matrix projection;
+
+	// the mesh's VertexQuantization
+	float3 positionOffset;
+	float3 positionScale;
+};
+
+// Out of the vertex shader (and eventually input to the PS)
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+};
+
+// --------------------------------------------------------
+// The entry point (main method) for our vertex shader
+// --------------------------------------------------------
+VertexToPixel main(PackedVertexInput input)
+{
+	VertexToPixel output;
+
+	// only the position is needed for depth
+	float3 position = UnpackPosition(input.position, positionOffset, positionScale);
+	matrix worldViewProj = mul(mul(world, view), projection);
+	output.position = mul(float4(position, 1.0f), worldViewProj);
+
+	return output;
+}
@@ -608,6 +608,21 @@ SimpleVertexShader::SimpleVertexShader(ID3D11Device * device, ID3D11DeviceContex
 	this->perInstanceCompatible = perInstanceCompatible;
 }
 
+// --------------------------------------------------------
+// Constructor overload which takes an input layout description
+//
+// The layout is created from the description when the shader
+// loads, instead of guessing 32 bit formats from reflection
+// --------------------------------------------------------
+SimpleVertexShader::SimpleVertexShader(ID3D11Device * device, ID3D11DeviceContext * context, const D3D11_INPUT_ELEMENT_DESC * layoutDesc, unsigned int layoutCount)
+	: ISimpleShader(device, context)
+{
+	this->inputLayout = 0;
+	this->shader = 0;
+	this->perInstanceCompatible = false;
+	this->customLayoutDesc.assign(layoutDesc, layoutDesc + layoutCount);
+}
+
 // --------------------------------------------------------
 // Destructor - Clean up actual shader (base will be called automatically)
 // --------------------------------------------------------
@@ -655,6 +670,18 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 	if (inputLayout)
 		return true;
 
+	// Or a description of one?
+	if (!customLayoutDesc.empty())
+	{
+		HRESULT hr = device->CreateInputLayout(
+			&customLayoutDesc[0],
+			(unsigned int)customLayoutDesc.size(),
+			shaderBlob->GetBufferPointer(),
+			shaderBlob->GetBufferSize(),
+			&inputLayout);
+		return hr == S_OK;
+	}
+
 	// Vertex shader was created successfully, so we now use the
 	// shader code to re-reflect and create an input layout that 
 	// matches what the vertex shader expects.  Code adapted from:
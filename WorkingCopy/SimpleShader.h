@@ -153,6 +153,7 @@ class SimpleVertexShader : public ISimpleShader
 public:
 	SimpleVertexShader(ID3D11Device* device, ID3D11DeviceContext* context);
 	SimpleVertexShader(ID3D11Device* device, ID3D11DeviceContext* context, ID3D11InputLayout* inputLayout, bool perInstanceCompatible);
+	SimpleVertexShader(ID3D11Device* device, ID3D11DeviceContext* context, const D3D11_INPUT_ELEMENT_DESC* layoutDesc, unsigned int layoutCount);
 	~SimpleVertexShader();
 	ID3D11VertexShader* GetDirectXShader() { return shader; }
 	ID3D11InputLayout* GetInputLayout() { return inputLayout; }
@@ -165,6 +166,8 @@ protected:
 	bool perInstanceCompatible;
 	ID3D11InputLayout* inputLayout;
 	ID3D11VertexShader* shader;
+	// formats the shader can't be reflected for, such as packed vertices
+	std::vector<D3D11_INPUT_ELEMENT_DESC> customLayoutDesc;
 	bool CreateShader(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
 	void CleanUp();
@@ -151,6 +151,7 @@ void SlenderMan::CheckForStatic()
 		//return
 	}
 
+	XMFLOAT3 position = GetPosition();
 	XMVECTOR temp = XMVector3Dot(XMVector3Normalize(XMLoadFloat3(&player->GetDirection())), XMVector3Normalize(XMLoadFloat3(&position) - XMLoadFloat3(&player->GetPosition())));
 	XMFLOAT3 temp2;
 	XMStoreFloat3(&temp2, temp);
@@ -195,6 +196,7 @@ void SlenderMan::CheckStandingStill(float deltaTime)
 
 void SlenderMan::GetDistance()
 {
+	XMFLOAT3 position = GetPosition();
 	XMVECTOR posTemp = XMLoadFloat3(&position);
 	XMVECTOR playerPositionTemp = XMLoadFloat3(&player->GetPosition());
 	XMVECTOR distanceFromPlayer = posTemp - playerPositionTemp;
@@ -206,11 +208,13 @@ void SlenderMan::GetDistance()
 
 void SlenderMan::TurnToFacePlayer()
 {
+	XMFLOAT4 rotation = GetRotation();
 	XMVECTOR dir = XMVector3Rotate(XMVectorSet(0, 0, 1, 0), XMLoadFloat4(&rotation));
 }
 
 float SlenderMan::DistancefromPlayer()
 {
+	XMFLOAT3 position = GetPosition();
 	return sqrt(pow(player->GetPosition().x - position.x, 2) +
 		pow(player->GetPosition().y - position.y, 2) +
 		pow(player->GetPosition().z - position.z, 2));
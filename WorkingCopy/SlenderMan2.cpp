@@ -2,6 +2,7 @@
 
 float SlenderMan2::GetDistanceXFromPlayer()
 {
+	XMFLOAT3 position = GetPosition();
 	XMVECTOR SlenderManPosition = XMLoadFloat3(&position);
 	XMVECTOR playerPositionTemp = XMLoadFloat3(&player->GetPosition());
 	XMVECTOR distanceFromPlayerV = SlenderManPosition - playerPositionTemp;
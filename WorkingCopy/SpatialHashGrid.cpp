@@ -0,0 +1,223 @@
+#include "SpatialHashGrid.h"
+#include <cmath>
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+    // keeps cell coordinates well inside int range for huge or infinite bounds
+    const float MaxCell = (float)(1 << 24);
+
+    int ToCell(float value, float invCellSize)
+    {
+        float cell = floorf(value * invCellSize);
+        return (int)std::max(-MaxCell, std::min(MaxCell, cell));
+    }
+
+    float Width(const XMFLOAT4& bounds)
+    {
+        return std::max(bounds.z - bounds.x, bounds.w - bounds.y);
+    }
+}
+
+SpatialHashGrid::SpatialHashGrid(const SpatialHashSettings& settings) : settings(settings)
+{
+    unsigned int count = 1;
+    while (count < settings.bucketCount) count <<= 1;
+    buckets.resize(count);
+    bucketMask = count - 1;
+
+    queryStamp = 0;
+    objectCount = 0;
+    widthSum = 0.0;
+    cellSize = 0.0f;
+    invCellSize = 0.0f;
+    if (settings.cellSize > 0.0f) SetCellSize(settings.cellSize);
+}
+
+float SpatialHashGrid::ChooseCellSize(const std::vector<Collider*>& colliders)
+{
+    double sum = 0.0;
+    for (Collider* col : colliders) {
+        sum += Width(col->GetBounds());
+    }
+    float average = colliders.empty() ? 0.0f : (float)(sum / colliders.size());
+    return std::max(average * 2.0f, 1.0f);
+}
+
+void SpatialHashGrid::Build(const std::vector<Collider*>& colliders)
+{
+    for (std::vector<Collider*>& bucket : buckets) bucket.clear();
+    largeObjects.clear();
+    objectCount = 0;
+    widthSum = 0.0;
+
+    if (settings.cellSize <= 0.0f && !colliders.empty()) SetCellSize(ChooseCellSize(colliders));
+    // the cells already fit all of them, Add would resize for the first few on their own
+    for (Collider* col : colliders) {
+        col->treeBounds = col->GetBounds();
+        objectCount++;
+        widthSum += Width(col->treeBounds);
+        Insert(col);
+    }
+}
+
+void SpatialHashGrid::Add(Collider* col)
+{
+    col->treeBounds = col->GetBounds();
+    objectCount++;
+    widthSum += Width(col->treeBounds);
+
+    if (settings.cellSize <= 0.0f) {
+        // resize once the average drifts to half or double what the cells were sized for
+        float ideal = std::max((float)(widthSum / objectCount) * 2.0f, 1.0f);
+        if (cellSize <= 0.0f) {
+            SetCellSize(ideal);
+        }
+        else if (ideal > cellSize * 2.0f || ideal < cellSize * 0.5f) {
+            Insert(col);
+            Rehash(ideal);
+            return;
+        }
+    }
+    Insert(col);
+}
+
+void SpatialHashGrid::Remove(Collider* col)
+{
+    Erase(col);
+    objectCount--;
+    widthSum -= Width(col->treeBounds);
+}
+
+void SpatialHashGrid::Update(Collider* col)
+{
+    XMFLOAT4 bounds = col->GetBounds();
+    CellRange before = GetCellRange(col->treeBounds);
+    CellRange after = GetCellRange(bounds);
+
+    // same cells, nothing to move
+    if (before.minX == after.minX && before.minY == after.minY && before.maxX == after.maxX && before.maxY == after.maxY) {
+        widthSum += Width(bounds) - Width(col->treeBounds);
+        col->treeBounds = bounds;
+        return;
+    }
+
+    Erase(col);
+    widthSum += Width(bounds) - Width(col->treeBounds);
+    col->treeBounds = bounds;
+    Insert(col);
+}
+
+void SpatialHashGrid::GetCollidableObjects(Collider* col, std::vector<Collider*>& results)
+{
+    GetCollidableObjects(col->GetBounds(), results);
+}
+
+void SpatialHashGrid::GetCollidableObjects(const XMFLOAT4& box, std::vector<Collider*>& results)
+{
+    results.clear();
+    VisitCollidableObjects(box, [&results](Collider* other) { results.push_back(other); });
+}
+
+SpatialHashGrid::CellRange SpatialHashGrid::GetCellRange(const XMFLOAT4& bounds) const
+{
+    CellRange range;
+    range.minX = ToCell(bounds.x, invCellSize);
+    range.minY = ToCell(bounds.y, invCellSize);
+    range.maxX = ToCell(bounds.z, invCellSize);
+    range.maxY = ToCell(bounds.w, invCellSize);
+    return range;
+}
+
+unsigned int SpatialHashGrid::Hash(int x, int y) const
+{
+    // large primes so neighbouring cells land in different buckets
+    return (((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u)) & bucketMask;
+}
+
+bool SpatialHashGrid::IsLarge(const CellRange& range) const
+{
+    long long cells = (long long)(range.maxX - range.minX + 1) * (range.maxY - range.minY + 1);
+    return cells > settings.maxCellsPerCollider;
+}
+
+void SpatialHashGrid::Insert(Collider* col)
+{
+    CellRange range = GetCellRange(col->treeBounds);
+    if (IsLarge(range)) {
+        largeObjects.push_back(col);
+        return;
+    }
+
+    for (int y = range.minY; y <= range.maxY; y++) {
+        for (int x = range.minX; x <= range.maxX; x++) {
+            buckets[Hash(x, y)].push_back(col);
+        }
+    }
+}
+
+void SpatialHashGrid::Erase(Collider* col)
+{
+    CellRange range = GetCellRange(col->treeBounds);
+    if (IsLarge(range)) {
+        largeObjects.erase(std::remove(largeObjects.begin(), largeObjects.end(), col), largeObjects.end());
+        return;
+    }
+
+    // buckets are short, order doesn't matter
+    for (int y = range.minY; y <= range.maxY; y++) {
+        for (int x = range.minX; x <= range.maxX; x++) {
+            std::vector<Collider*>& bucket = buckets[Hash(x, y)];
+            for (size_t i = 0; i < bucket.size(); i++) {
+                if (bucket[i] == col) {
+                    bucket[i] = bucket.back();
+                    bucket.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void SpatialHashGrid::SetCellSize(float size)
+{
+    cellSize = size;
+    invCellSize = 1.0f / size;
+}
+
+void SpatialHashGrid::Rehash(float newCellSize)
+{
+    // pull every collider out once, they can be in several buckets
+    unsigned int stamp = NextQueryStamp();
+    rehashScratch.clear();
+    for (std::vector<Collider*>& bucket : buckets) {
+        for (Collider* col : bucket) {
+            if (col->queryStamp == stamp) continue;
+            col->queryStamp = stamp;
+            rehashScratch.push_back(col);
+        }
+        bucket.clear();
+    }
+    rehashScratch.insert(rehashScratch.end(), largeObjects.begin(), largeObjects.end());
+    largeObjects.clear();
+
+    SetCellSize(newCellSize);
+    for (Collider* col : rehashScratch) {
+        Insert(col);
+    }
+}
+
+unsigned int SpatialHashGrid::NextQueryStamp()
+{
+    // 0 is what new colliders start with, so it's never a real stamp
+    if (++queryStamp == 0) {
+        for (std::vector<Collider*>& bucket : buckets) {
+            for (Collider* col : bucket) col->queryStamp = 0;
+        }
+        for (Collider* col : largeObjects) col->queryStamp = 0;
+        queryStamp = 1;
+    }
+    return queryStamp;
+}
@@ -0,0 +1,129 @@
+#pragma once
+#include "Broadphase.h"
+#include <vector>
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Size of a spatial hash grid
+// --------------------------------------------------------
+struct SpatialHashSettings
+{
+    float cellSize = 0.0f;              // 0 picks it from the colliders, see ChooseCellSize
+    unsigned int bucketCount = 4096;    // rounded up to a power of two
+    int maxCellsPerCollider = 16;       // colliders covering more cells go in a list every query checks
+};
+
+// --------------------------------------------------------
+// A uniform grid of square cells, hashed into a fixed set
+// of buckets so it doesn't need to know how big the world
+// is.  Colliders are filed in every cell their bounds
+// touch, which is a handful when the cells are about the
+// size of the colliders, so adding, removing and moving
+// them is constant time.
+//
+// With an automatic cell size the grid keeps the average
+// collider width and rehashes when it drifts too far
+// from what the cells were sized for
+// --------------------------------------------------------
+class SpatialHashGrid : public Broadphase
+{
+public:
+    SpatialHashGrid(const SpatialHashSettings& settings = SpatialHashSettings());
+
+    // replaces everything in the grid, sizing the cells for these colliders first if it's automatic
+    void Build(const std::vector<Collider*>& colliders);
+
+    void Add(Collider* col) override;
+    void Remove(Collider* col) override;
+    // only touches the buckets when the collider moved into different cells
+    void Update(Collider* col) override;
+    void GetCollidableObjects(Collider* col, std::vector<Collider*>& results) override;
+    void GetCollidableObjects(const DirectX::XMFLOAT4& box, std::vector<Collider*>& results) override;
+
+    // calls visit(Collider*) for every collider GetCollidableObjects would return
+    template<class Visitor>
+    void VisitCollidableObjects(Collider* col, Visitor visit) { VisitCollidableObjects(col->GetBounds(), visit); }
+    template<class Visitor>
+    void VisitCollidableObjects(const DirectX::XMFLOAT4& query, Visitor visit);
+
+    // twice the average collider width, so most colliders touch at most 4 cells
+    static float ChooseCellSize(const std::vector<Collider*>& colliders);
+
+    inline float GetCellSize() const { return cellSize; }
+    inline size_t GetObjectCount() const { return objectCount; }
+
+private:
+    struct CellRange
+    {
+        int minX;
+        int minY;
+        int maxX;
+        int maxY;
+    };
+
+    SpatialHashSettings settings;
+    float cellSize;
+    float invCellSize;
+    unsigned int bucketMask;
+    std::vector<std::vector<Collider*>> buckets;
+    // colliders too big to file cell by cell
+    std::vector<Collider*> largeObjects;
+    unsigned int queryStamp;
+
+    // for the automatic cell size
+    size_t objectCount;
+    double widthSum;
+    std::vector<Collider*> rehashScratch;
+
+    CellRange GetCellRange(const DirectX::XMFLOAT4& bounds) const;
+    unsigned int Hash(int x, int y) const;
+    bool IsLarge(const CellRange& range) const;
+    // file or unfile the collider by its treeBounds
+    void Insert(Collider* col);
+    void Erase(Collider* col);
+    void SetCellSize(float size);
+    void Rehash(float newCellSize);
+
+    unsigned int NextQueryStamp();
+};
+
+template<class Visitor>
+void SpatialHashGrid::VisitCollidableObjects(const DirectX::XMFLOAT4& query, Visitor visit)
+{
+    unsigned int stamp = NextQueryStamp();
+    unsigned long long found = 0;
+
+    // stamped even when it misses, colliders are in several cells and cells can share a bucket
+    auto test = [&](Collider* obj) {
+        if (obj->queryStamp == stamp) return;
+        obj->queryStamp = stamp;
+        queryStats.tested++;
+        DirectX::XMFLOAT4 b = obj->GetBounds();
+        if (b.x > query.z || b.z < query.x || b.y > query.w || b.w < query.y) return;
+        found++;
+        visit(obj);
+    };
+
+    for (Collider* obj : largeObjects) test(obj);
+
+    if (cellSize > 0.0f) {
+        CellRange range = GetCellRange(query);
+        long long cells = (long long)(range.maxX - range.minX + 1) * (range.maxY - range.minY + 1);
+        if (cells > (long long)buckets.size()) {
+            // the query covers more cells than there are buckets, just go through all of them once
+            for (std::vector<Collider*>& bucket : buckets) {
+                for (Collider* obj : bucket) test(obj);
+            }
+        }
+        else {
+            for (int y = range.minY; y <= range.maxY; y++) {
+                for (int x = range.minX; x <= range.maxX; x++) {
+                    for (Collider* obj : buckets[Hash(x, y)]) test(obj);
+                }
+            }
+        }
+    }
+
+    queryStats.queries++;
+    queryStats.candidates += found;
+}
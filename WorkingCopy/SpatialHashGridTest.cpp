@@ -0,0 +1,163 @@
+#include "SpatialHashGrid.h"
+#include "Quadtree.h"
+#include "BroadphaseTest.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+using namespace BroadphaseTest;
+
+// --------------------------------------------------------
+// Checks the spatial hash grid returns exactly what brute
+// force does: built in one go, with colliders moving, added
+// and removed, with colliders too big for the cells, with
+// few enough buckets that cells share them, and with the
+// cell size following the colliders as they're added
+// --------------------------------------------------------
+
+namespace
+{
+	const float Extent = 180.0f;
+
+	// box queries and every fifth collider's own query, returns how many went wrong
+	int CheckQueries(SpatialHashGrid& grid, const std::vector<Collider*>& colliders, int boxes)
+	{
+		int wrong = 0;
+		std::vector<Collider*> results;
+		for (int i = 0; i < boxes; i++)
+		{
+			XMFLOAT4 box = RandomBox(Extent);
+			grid.GetCollidableObjects(box, results);
+			if (!SameSet(results, BruteForce(colliders, box))) wrong++;
+		}
+		for (size_t i = 0; i < colliders.size(); i += 5)
+		{
+			grid.GetCollidableObjects(colliders[i], results);
+			if (!SameSet(results, BruteForce(colliders, colliders[i]->GetBounds()))) wrong++;
+		}
+		return wrong;
+	}
+
+	void Stress(const char* name, const SpatialHashSettings& settings)
+	{
+		std::vector<Collider*> inGrid = MakeColliders(1500, Extent);
+		std::vector<Collider*> outOfGrid = MakeColliders(500, Extent);
+		std::vector<XMFLOAT2> velocity(inGrid.size());
+		for (XMFLOAT2& v : velocity) v = XMFLOAT2(Random(0.6f), Random(0.6f));
+
+		SpatialHashGrid grid(settings);
+		grid.Build(inGrid);
+
+		int wrong = 0;
+		TestTimer timer;
+		const int frames = 300;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			Move(inGrid, velocity, Extent);
+			for (Collider* col : inGrid) grid.Update(col);
+
+			for (int i = 0; i < 10; i++)
+			{
+				size_t leaving = rand() % inGrid.size();
+				size_t joining = rand() % outOfGrid.size();
+				grid.Remove(inGrid[leaving]);
+				outOfGrid[joining]->SetCenter(XMFLOAT2(Random(Extent), Random(Extent)));
+				grid.Add(outOfGrid[joining]);
+				std::swap(inGrid[leaving], outOfGrid[joining]);
+			}
+
+			if (frame % 10 == 0) wrong += CheckQueries(grid, inGrid, 20);
+		}
+		CHECK(grid.GetObjectCount() == inGrid.size());
+
+		// everything taken out, nothing left behind
+		std::vector<Collider*> results;
+		for (Collider* col : inGrid) grid.Remove(col);
+		grid.GetCollidableObjects(XMFLOAT4(-Extent * 2, -Extent * 2, Extent * 2, Extent * 2), results);
+		CHECK(results.empty());
+
+		printf("%s: %d frames of moving, adding and removing in %.1f ms, %d wrong queries\n", name, frames, timer.Milliseconds(), wrong);
+		CHECK(wrong == 0);
+	}
+}
+
+int main()
+{
+	srand(5);
+	std::vector<Collider*> colliders = MakeColliders(4000, Extent);
+
+	// cells sized from the colliders
+	SpatialHashGrid grid;
+	grid.Build(colliders);
+	CHECK(grid.GetCellSize() == SpatialHashGrid::ChooseCellSize(colliders));
+	CHECK(grid.GetObjectCount() == colliders.size());
+	CHECK(CheckQueries(grid, colliders, 2000) == 0);
+
+	// a query bigger than the whole bucket table goes through every bucket once
+	std::vector<Collider*> results;
+	grid.GetCollidableObjects(XMFLOAT4(-1e6f, -1e6f, 1e6f, 1e6f), results);
+	CHECK(SameSet(results, colliders));
+
+	// 16 buckets, so nearly every bucket holds cells from all over the map
+	SpatialHashSettings crowded;
+	crowded.bucketCount = 16;
+	SpatialHashGrid crowdedGrid(crowded);
+	crowdedGrid.Build(colliders);
+	CHECK(CheckQueries(crowdedGrid, colliders, 500) == 0);
+
+	// small fixed cells, so the big rectangles go in the list every query checks
+	SpatialHashSettings tiny;
+	tiny.cellSize = 0.5f;
+	tiny.maxCellsPerCollider = 4;
+	SpatialHashGrid tinyGrid(tiny);
+	tinyGrid.Build(colliders);
+	CHECK(CheckQueries(tinyGrid, colliders, 500) == 0);
+
+	// added one at a time from tiny circles to big rectangles, the cells grow with them and rehash
+	SpatialHashGrid growing;
+	std::vector<Collider*> added;
+	float firstCellSize = 0.0f;
+	for (int i = 0; i < 400; i++)
+	{
+		ColliderHandle handle = i < 200
+			? ColliderStore::Instance()->CreateCircle(0.1f)
+			: ColliderStore::Instance()->CreateRect(XMFLOAT2(20.0f, 20.0f));
+		Collider* col = ColliderStore::Instance()->Get(handle);
+		col->SetCenter(XMFLOAT2(Random(Extent), Random(Extent)));
+		growing.Add(col);
+		added.push_back(col);
+		if (i == 0) firstCellSize = growing.GetCellSize();
+	}
+	CHECK(growing.GetCellSize() > firstCellSize * 2.0f);
+	CHECK(CheckQueries(growing, added, 500) == 0);
+
+	Stress("automatic cells", SpatialHashSettings());
+	SpatialHashSettings fixed;
+	fixed.cellSize = 4.0f;
+	Stress("4 unit cells", fixed);
+
+	// the same boxes through the grid and the quadtree CollisionManager would make otherwise
+	QuadtreeSettings looseSettings;
+	looseSettings.looseness = 0.5f;
+	Quadtree tree(looseSettings);
+	tree.CreateQuadtree(colliders);
+	std::vector<XMFLOAT4> boxes;
+	for (int i = 0; i < 100000; i++) boxes.push_back(RandomBox(Extent));
+	results.reserve(colliders.size());
+	grid.ResetQueryStats();
+
+	TestTimer timer;
+	for (const XMFLOAT4& box : boxes) grid.GetCollidableObjects(box, results);
+	double gridMs = timer.Milliseconds();
+	timer = TestTimer();
+	for (const XMFLOAT4& box : boxes) tree.GetCollidableObjects(box, results);
+	double treeMs = timer.Milliseconds();
+
+	BroadphaseQueryStats stats = grid.GetQueryStats();
+	printf("%zu colliders in %.2f unit cells: %.0f ns per query against %.0f ns for the loose quadtree, %.1f tested, %.1f found per query\n",
+		colliders.size(), grid.GetCellSize(), gridMs * 1e6 / boxes.size(), treeMs * 1e6 / boxes.size(),
+		(double)stats.tested / stats.queries, (double)stats.candidates / stats.queries);
+
+	return TestResult();
+}
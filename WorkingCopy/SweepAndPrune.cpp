@@ -0,0 +1,164 @@
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+SweepAndPrune::SweepAndPrune()
+{
+    maxWidth[0] = 0.0f;
+    maxWidth[1] = 0.0f;
+    sweepAxis = 0;
+    dirty = false;
+    added = 0;
+}
+
+void SweepAndPrune::Add(Collider* col)
+{
+    Box box;
+    box.col = col;
+    box.bounds = col->GetBounds();
+    unsigned int index = (unsigned int)boxes.size();
+    boxes.push_back(box);
+
+    // appended unsorted, the next Refresh moves them into place
+    for (int a = 0; a < 2; a++) {
+        Endpoint min = { a == 0 ? box.bounds.x : box.bounds.y, index, 0 };
+        Endpoint max = { a == 0 ? box.bounds.z : box.bounds.w, index, 1 };
+        axes[a].push_back(min);
+        axes[a].push_back(max);
+    }
+    added++;
+    dirty = true;
+}
+
+void SweepAndPrune::Remove(Collider* col)
+{
+    unsigned int index = 0;
+    while (index < boxes.size() && boxes[index].col != col) index++;
+    if (index == boxes.size()) return;
+
+    // the last box takes its place, so its endpoints get its new index
+    unsigned int last = (unsigned int)boxes.size() - 1;
+    boxes[index] = boxes[last];
+    boxes.pop_back();
+
+    for (int a = 0; a < 2; a++) {
+        std::vector<Endpoint>& axis = axes[a];
+        size_t kept = 0;
+        for (size_t i = 0; i < axis.size(); i++) {
+            if (axis[i].box == index) continue;
+            axis[kept] = axis[i];
+            if (axis[kept].box == last) axis[kept].box = index;
+            kept++;
+        }
+        axis.resize(kept);
+    }
+}
+
+void SweepAndPrune::Update(Collider*)
+{
+    // every collider's bounds are read again on the next sort, whichever one moved
+    dirty = true;
+}
+
+void SweepAndPrune::GetCollidableObjects(Collider* col, std::vector<Collider*>& results)
+{
+    GetCollidableObjects(col->GetBounds(), results);
+}
+
+void SweepAndPrune::GetCollidableObjects(const XMFLOAT4& box, std::vector<Collider*>& results)
+{
+    results.clear();
+    VisitCollidableObjects(box, [&results](Collider* other) { results.push_back(other); });
+}
+
+void SweepAndPrune::FindPairs(std::vector<Pair>& pairs)
+{
+    pairs.clear();
+    if (dirty) Refresh();
+
+    active.clear();
+    for (const Endpoint& point : axes[sweepAxis]) {
+        if (point.isMax) {
+            // active is only as long as the boxes overlapping here, a scan is fine
+            for (size_t i = 0; i < active.size(); i++) {
+                if (active[i] == point.box) {
+                    active[i] = active.back();
+                    active.pop_back();
+                    break;
+                }
+            }
+            continue;
+        }
+
+        // everything active overlaps this box on the sweep axis, check the other one
+        const XMFLOAT4& b = boxes[point.box].bounds;
+        for (unsigned int other : active) {
+            const XMFLOAT4& o = boxes[other].bounds;
+            bool overlaps = sweepAxis == 0 ? (o.y <= b.w && o.w >= b.y) : (o.x <= b.z && o.z >= b.x);
+            if (overlaps) {
+                Pair pair = { boxes[other].col, boxes[point.box].col };
+                pairs.push_back(pair);
+            }
+        }
+        active.push_back(point.box);
+    }
+}
+
+void SweepAndPrune::Refresh()
+{
+    // sweep along whichever axis the centers are most spread out on
+    float sum[2] = { 0.0f, 0.0f };
+    float sumSq[2] = { 0.0f, 0.0f };
+    maxWidth[0] = 0.0f;
+    maxWidth[1] = 0.0f;
+    for (Box& box : boxes) {
+        box.bounds = box.col->GetBounds();
+        float center[2] = { (box.bounds.x + box.bounds.z) * 0.5f, (box.bounds.y + box.bounds.w) * 0.5f };
+        for (int a = 0; a < 2; a++) {
+            sum[a] += center[a];
+            sumSq[a] += center[a] * center[a];
+        }
+        maxWidth[0] = std::max(maxWidth[0], box.bounds.z - box.bounds.x);
+        maxWidth[1] = std::max(maxWidth[1], box.bounds.w - box.bounds.y);
+    }
+    float count = (float)std::max<size_t>(boxes.size(), 1);
+    float variance[2];
+    for (int a = 0; a < 2; a++) {
+        variance[a] = sumSq[a] / count - (sum[a] / count) * (sum[a] / count);
+    }
+    sweepAxis = variance[1] > variance[0] ? 1 : 0;
+
+    for (int a = 0; a < 2; a++) {
+        for (Endpoint& point : axes[a]) {
+            const XMFLOAT4& b = boxes[point.box].bounds;
+            if (a == 0) point.value = point.isMax ? b.z : b.x;
+            else point.value = point.isMax ? b.w : b.y;
+        }
+        // a big batch of new boxes isn't nearly sorted anymore
+        if (added * 8 > boxes.size()) std::sort(axes[a].begin(), axes[a].end(), Before);
+        else InsertionSort(axes[a]);
+    }
+    added = 0;
+    dirty = false;
+}
+
+bool SweepAndPrune::Before(const Endpoint& a, const Endpoint& b)
+{
+    if (a.value != b.value) return a.value < b.value;
+    return a.isMax < b.isMax;
+}
+
+void SweepAndPrune::InsertionSort(std::vector<Endpoint>& axis)
+{
+    // nearly sorted every frame, each endpoint only moves past the few it crossed
+    for (size_t i = 1; i < axis.size(); i++) {
+        Endpoint point = axis[i];
+        size_t j = i;
+        while (j > 0 && Before(point, axis[j - 1])) {
+            axis[j] = axis[j - 1];
+            j--;
+        }
+        axis[j] = point;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include "Broadphase.h"
+#include <vector>
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Sort and sweep over colliders that move every frame.
+//
+// Both axes keep a sorted array of box endpoints.  Things
+// don't move far between frames so the arrays are nearly
+// sorted already and an insertion sort puts them back in
+// close to linear time.  FindPairs then sweeps the axis
+// the boxes are most spread along, only testing boxes
+// whose ranges on it overlap.
+//
+// Every collider is assumed to move, bounds are all read
+// again the next time the arrays are sorted
+// --------------------------------------------------------
+class SweepAndPrune : public Broadphase
+{
+public:
+    struct Pair
+    {
+        Collider* a;
+        Collider* b;
+    };
+
+    SweepAndPrune();
+
+    void Add(Collider* col) override;
+    void Remove(Collider* col) override;
+    // just marks the arrays for sorting, they're sorted once however many moved
+    void Update(Collider* col) override;
+    void GetCollidableObjects(Collider* col, std::vector<Collider*>& results) override;
+    void GetCollidableObjects(const DirectX::XMFLOAT4& box, std::vector<Collider*>& results) override;
+
+    // calls visit(Collider*) for every collider GetCollidableObjects would return
+    template<class Visitor>
+    void VisitCollidableObjects(Collider* col, Visitor visit) { VisitCollidableObjects(col->GetBounds(), visit); }
+    template<class Visitor>
+    void VisitCollidableObjects(const DirectX::XMFLOAT4& query, Visitor visit);
+
+    // fills pairs with every pair of colliders whose bounds overlap, each pair once.
+    // pairs is cleared first
+    void FindPairs(std::vector<Pair>& pairs);
+
+    inline size_t GetObjectCount() const { return boxes.size(); }
+
+private:
+    struct Endpoint
+    {
+        float value;
+        unsigned int box;
+        unsigned int isMax;     // 0 for the min end, mins sort first so touching boxes overlap
+    };
+
+    struct Box
+    {
+        Collider* col;
+        DirectX::XMFLOAT4 bounds;
+    };
+
+    std::vector<Box> boxes;
+    // x then y
+    std::vector<Endpoint> axes[2];
+    // widest box on each axis, so queries know how far back to start
+    float maxWidth[2];
+    // the axis FindPairs sweeps
+    int sweepAxis;
+    bool dirty;
+    // boxes added since the last sort, lots of them are sorted from scratch instead
+    size_t added;
+    // boxes whose min end the sweep has passed but not their max
+    std::vector<unsigned int> active;
+
+    // reads the bounds again and puts both arrays back in order
+    void Refresh();
+    static void InsertionSort(std::vector<Endpoint>& axis);
+    static bool Before(const Endpoint& a, const Endpoint& b);
+};
+
+template<class Visitor>
+void SweepAndPrune::VisitCollidableObjects(const DirectX::XMFLOAT4& query, Visitor visit)
+{
+    if (dirty) Refresh();
+
+    std::vector<Endpoint>& axis = axes[0];
+
+    // no box reaching the query can start further left than its width
+    float start = query.x - maxWidth[0];
+    size_t first = 0;
+    size_t last = axis.size();
+    while (first < last) {
+        size_t middle = (first + last) / 2;
+        if (axis[middle].value < start) first = middle + 1;
+        else last = middle;
+    }
+
+    unsigned long long found = 0;
+    for (size_t i = first; i < axis.size() && axis[i].value <= query.z; i++) {
+        if (axis[i].isMax) continue;
+
+        queryStats.tested++;
+        const DirectX::XMFLOAT4& b = boxes[axis[i].box].bounds;
+        if (b.x > query.z || b.z < query.x || b.y > query.w || b.w < query.y) continue;
+        found++;
+        visit(boxes[axis[i].box].col);
+    }
+
+    queryStats.queries++;
+    queryStats.candidates += found;
+}
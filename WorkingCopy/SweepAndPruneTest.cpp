@@ -0,0 +1,146 @@
+#include "SweepAndPrune.h"
+#include "BroadphaseTest.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace DirectX;
+using namespace BroadphaseTest;
+
+// --------------------------------------------------------
+// Moves colliders around every frame and checks FindPairs
+// returns every pair whose bounds overlap exactly once, and
+// queries return what brute force does, as colliders come
+// and go.  Prints the time per frame against testing every
+// pair
+// --------------------------------------------------------
+
+namespace
+{
+	typedef std::pair<Collider*, Collider*> ColliderPair;
+
+	ColliderPair Ordered(Collider* a, Collider* b)
+	{
+		return a < b ? ColliderPair(a, b) : ColliderPair(b, a);
+	}
+
+	std::set<ColliderPair> BrutePairs(const std::vector<Collider*>& colliders)
+	{
+		std::set<ColliderPair> pairs;
+		for (size_t i = 0; i < colliders.size(); i++)
+		{
+			XMFLOAT4 bounds = colliders[i]->GetBounds();
+			for (size_t j = i + 1; j < colliders.size(); j++)
+			{
+				if (Overlaps(bounds, colliders[j]->GetBounds())) pairs.insert(Ordered(colliders[i], colliders[j]));
+			}
+		}
+		return pairs;
+	}
+
+	// false if a pair came back twice or isn't one brute force found
+	bool SamePairs(const std::vector<SweepAndPrune::Pair>& pairs, const std::set<ColliderPair>& expected)
+	{
+		std::set<ColliderPair> found;
+		for (const SweepAndPrune::Pair& pair : pairs)
+		{
+			if (pair.a == pair.b || !found.insert(Ordered(pair.a, pair.b)).second) return false;
+		}
+		return found == expected;
+	}
+}
+
+int main()
+{
+	srand(9);
+
+	// packed tighter than the quadtree tests, so there are plenty of pairs
+	for (int count : { 300, 1000, 3000 })
+	{
+		const float extent = 5.0f * sqrtf((float)count);
+		std::vector<Collider*> inSweep = MakeColliders(count, extent);
+		std::vector<Collider*> outOfSweep = MakeColliders(count / 5, extent);
+		std::vector<XMFLOAT2> velocity(inSweep.size());
+		for (XMFLOAT2& v : velocity) v = XMFLOAT2(Random(0.5f), Random(0.5f));
+
+		SweepAndPrune sweep;
+		for (Collider* col : inSweep) sweep.Add(col);
+
+		int wrongPairs = 0;
+		int wrongQueries = 0;
+		double sweepMs = 0.0;
+		double bruteMs = 0.0;
+		unsigned long long pairCount = 0;
+		std::vector<SweepAndPrune::Pair> pairs;
+		std::vector<Collider*> results;
+		const int frames = 60;
+		for (int frame = 0; frame < frames; frame++)
+		{
+			Move(inSweep, velocity, extent);
+			for (Collider* col : inSweep) sweep.Update(col);
+
+			// a few come and go, and every so often a lot arrive at once
+			int swaps = frame % 20 == 10 ? count / 5 : 3;
+			for (int i = 0; i < swaps; i++)
+			{
+				size_t leaving = rand() % inSweep.size();
+				size_t joining = rand() % outOfSweep.size();
+				sweep.Remove(inSweep[leaving]);
+				outOfSweep[joining]->SetCenter(XMFLOAT2(Random(extent), Random(extent)));
+				sweep.Add(outOfSweep[joining]);
+				std::swap(inSweep[leaving], outOfSweep[joining]);
+			}
+
+			TestTimer timer;
+			sweep.FindPairs(pairs);
+			sweepMs += timer.Milliseconds();
+			timer = TestTimer();
+			std::set<ColliderPair> expected = BrutePairs(inSweep);
+			bruteMs += timer.Milliseconds();
+
+			if (!SamePairs(pairs, expected)) wrongPairs++;
+			pairCount += pairs.size();
+
+			for (int i = 0; i < 20; i++)
+			{
+				Collider* col = inSweep[rand() % inSweep.size()];
+				sweep.GetCollidableObjects(col, results);
+				if (!SameSet(results, BruteForce(inSweep, col->GetBounds()))) wrongQueries++;
+
+				XMFLOAT4 box = RandomBox(extent);
+				sweep.GetCollidableObjects(box, results);
+				if (!SameSet(results, BruteForce(inSweep, box))) wrongQueries++;
+			}
+		}
+
+		CHECK(sweep.GetObjectCount() == inSweep.size());
+		CHECK(wrongPairs == 0);
+		CHECK(wrongQueries == 0);
+		printf("%5d colliders: %.1f pairs, %.3f ms per frame sorting and sweeping, %.3f ms testing every pair, %d wrong frames, %d wrong queries\n",
+			count, (double)pairCount / frames, sweepMs / frames, bruteMs / frames, wrongPairs, wrongQueries);
+
+		// everything taken out, nothing left behind
+		for (Collider* col : inSweep) sweep.Remove(col);
+		sweep.FindPairs(pairs);
+		CHECK(pairs.empty() && sweep.GetObjectCount() == 0);
+	}
+
+	// boxes that only touch still count, the same as the other broadphases
+	ColliderStore* store = ColliderStore::Instance();
+	Collider* left = store->Get(store->CreateRect(XMFLOAT2(2, 2)));
+	Collider* right = store->Get(store->CreateRect(XMFLOAT2(2, 2)));
+	left->SetCenter(XMFLOAT2(1000, 1000));
+	right->SetCenter(XMFLOAT2(1002, 1000));
+	SweepAndPrune touching;
+	touching.Add(left);
+	touching.Add(right);
+	std::vector<SweepAndPrune::Pair> pairs;
+	touching.FindPairs(pairs);
+	CHECK(pairs.size() == 1);
+
+	return TestResult();
+}
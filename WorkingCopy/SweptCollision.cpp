@@ -0,0 +1,162 @@
+#include "SweptCollision.h"
+#include "ContactSolver.h"
+#include <cmath>
+using namespace DirectX;
+
+bool SweptCollision::CircleTimeOfImpact(Collider* mover, XMFLOAT2 start, XMFLOAT2 delta, Collider* other, Hit* hit)
+{
+    if (mover->GetType() != Collider::circle) return false;
+
+    XMFLOAT2 center = other->GetCenter();
+    XMFLOAT2 normal;
+    float depth;
+    if (ContactSolver::Penetration(mover, start, other, center, &normal, &depth)) {
+        // already touching, only stop it from going further in
+        if (delta.x * normal.x + delta.y * normal.y <= 0.0f) return false;
+        hit->time = 0.0f;
+        hit->normal = XMFLOAT2(-normal.x, -normal.y);
+        hit->other = other;
+        return true;
+    }
+
+    float time;
+    float radius = mover->GetRadius();
+    if (other->GetType() == Collider::circle) {
+        float radSum = radius + other->GetRadius();
+        if (!CircleCircle(start, delta, radSum, center, &time)) return false;
+
+        normal.x = (start.x + delta.x * time - center.x) / radSum;
+        normal.y = (start.y + delta.y * time - center.y) / radSum;
+    }
+    else {
+        XMFLOAT2 half = other->GetSize();
+        half.x *= 0.5f;
+        half.y *= 0.5f;
+        if (!CircleRect(start, delta, radius, center, half, &time, &normal)) return false;
+    }
+
+    hit->time = time;
+    hit->normal = normal;
+    hit->other = other;
+    return true;
+}
+
+bool SweptCollision::FirstHit(Collider* mover, XMFLOAT2 start, XMFLOAT2 delta, const std::vector<Collider*>& candidates, Hit* hit)
+{
+    bool found = false;
+    Hit candidateHit;
+    for (Collider* other : candidates) {
+        if (other == mover || !other->IsEnabled() || other->IsTrigger() || !mover->Interacts(other)) continue;
+
+        if (CircleTimeOfImpact(mover, start, delta, other, &candidateHit) && (!found || candidateHit.time < hit->time)) {
+            *hit = candidateHit;
+            found = true;
+        }
+    }
+    return found;
+}
+
+XMFLOAT2 SweptCollision::MoveAndSlide(Collider* mover, XMFLOAT2 start, XMFLOAT2 delta, const std::vector<Collider*>& candidates, int maxHits, float skin)
+{
+    if (mover->GetType() != Collider::circle) return XMFLOAT2(start.x + delta.x, start.y + delta.y);
+
+    XMFLOAT2 position = start;
+    XMFLOAT2 move = delta;
+    for (int i = 0; i < maxHits; i++) {
+        if (move.x * move.x + move.y * move.y < 1e-12f) return position;
+
+        Hit hit;
+        if (!FirstHit(mover, position, move, candidates, &hit)) {
+            position.x += move.x;
+            position.y += move.y;
+            return position;
+        }
+
+        // up to the hit and a little back out, so the next sweep doesn't start touching it
+        position.x += move.x * hit.time + hit.normal.x * skin;
+        position.y += move.y * hit.time + hit.normal.y * skin;
+
+        // the rest of the move, minus the part going into the surface
+        XMFLOAT2 rest(move.x * (1.0f - hit.time), move.y * (1.0f - hit.time));
+        float into = rest.x * hit.normal.x + rest.y * hit.normal.y;
+        if (into < 0.0f) {
+            rest.x -= hit.normal.x * into;
+            rest.y -= hit.normal.y * into;
+        }
+        move = rest;
+    }
+
+    // wedged between things, it stays where the last hit left it
+    return position;
+}
+
+bool SweptCollision::CircleCircle(XMFLOAT2 start, XMFLOAT2 delta, float radius, XMFLOAT2 center, float* time)
+{
+    // |start + delta * t - center| = radius, the smaller root
+    float mx = start.x - center.x;
+    float my = start.y - center.y;
+    float a = delta.x * delta.x + delta.y * delta.y;
+    float b = mx * delta.x + my * delta.y;
+    float c = mx * mx + my * my - radius * radius;
+    if (a < 1e-12f || c <= 0.0f || b >= 0.0f) return false;
+
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) return false;
+
+    float t = (-b - sqrtf(discriminant)) / a;
+    if (t > 1.0f) return false;
+    *time = t > 0.0f ? t : 0.0f;
+    return true;
+}
+
+bool SweptCollision::CircleRect(XMFLOAT2 start, XMFLOAT2 delta, float radius, XMFLOAT2 center, XMFLOAT2 half,
+    float* time, XMFLOAT2* normal)
+{
+    // the rectangle grown by the radius, with round corners. the circle's center
+    // hits that where the circle hits the rectangle
+    float px = start.x - center.x;
+    float py = start.y - center.y;
+    float reachX = half.x + radius;
+    float reachY = half.y + radius;
+    float best = 2.0f;
+
+    // flat sides, only while the center is between the corners
+    if (delta.x != 0.0f) {
+        float side = delta.x < 0.0f ? reachX : -reachX;
+        if ((delta.x < 0.0f && px >= side) || (delta.x > 0.0f && px <= side)) {
+            float t = (side - px) / delta.x;
+            if (t < best && fabsf(py + delta.y * t) <= half.y) {
+                best = t;
+                *normal = XMFLOAT2(delta.x < 0.0f ? 1.0f : -1.0f, 0.0f);
+            }
+        }
+    }
+    if (delta.y != 0.0f) {
+        float side = delta.y < 0.0f ? reachY : -reachY;
+        if ((delta.y < 0.0f && py >= side) || (delta.y > 0.0f && py <= side)) {
+            float t = (side - py) / delta.y;
+            if (t < best && fabsf(px + delta.x * t) <= half.x) {
+                best = t;
+                *normal = XMFLOAT2(0.0f, delta.y < 0.0f ? 1.0f : -1.0f);
+            }
+        }
+    }
+
+    // round corners, a hit only counts if it's on the corner's quarter of the circle
+    for (int corner = 0; corner < 4; corner++) {
+        float cx = (corner & 1) ? half.x : -half.x;
+        float cy = (corner & 2) ? half.y : -half.y;
+        float t;
+        if (!CircleCircle(XMFLOAT2(px, py), delta, radius, XMFLOAT2(cx, cy), &t) || t >= best) continue;
+
+        float hx = px + delta.x * t - cx;
+        float hy = py + delta.y * t - cy;
+        if (hx * cx < 0.0f || hy * cy < 0.0f) continue;
+        best = t;
+        *normal = XMFLOAT2(hx / radius, hy / radius);
+    }
+
+    if (best > 1.0f) return false;
+    *time = best;
+    return true;
+}
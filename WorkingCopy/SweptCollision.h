@@ -0,0 +1,47 @@
+#pragma once
+#include "Collider.h"
+#include <vector>
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Collision along a path instead of at one position, so
+// something that moves further than the width of a
+// collider in one frame can't end up on the other side.
+//
+// A moving circle is swept against circles and rectangles
+// for the time of impact, the fraction of the move where
+// they first touch.  MoveAndSlide stops it there and sends
+// what's left of the move along the surface it hit
+// --------------------------------------------------------
+class SweptCollision
+{
+public:
+    // the first thing a move runs into
+    struct Hit
+    {
+        float time;                     // 0 to 1 along the move
+        DirectX::XMFLOAT2 normal;       // out of other, towards the mover
+        Collider* other;
+    };
+
+    // how far a circle of the given radius at start gets along delta before touching other.
+    // starting inside other counts as a hit at 0 if the move goes further in, and no hit if
+    // it's on the way out
+    static bool CircleTimeOfImpact(Collider* mover, DirectX::XMFLOAT2 start, DirectX::XMFLOAT2 delta, Collider* other, Hit* hit);
+
+    // the earliest hit among candidates, skipping the mover, disabled colliders, triggers and
+    // colliders the mover doesn't interact with
+    static bool FirstHit(Collider* mover, DirectX::XMFLOAT2 start, DirectX::XMFLOAT2 delta, const std::vector<Collider*>& candidates, Hit* hit);
+
+    // where a circular mover starting at start ends up after trying to move by delta. at each
+    // hit it stops skin short and slides the rest of the move along the surface, up to maxHits
+    // times.  it never goes further than the length of delta, so a box that big around start
+    // holds every candidate.  rectangle movers aren't swept and just move
+    static DirectX::XMFLOAT2 MoveAndSlide(Collider* mover, DirectX::XMFLOAT2 start, DirectX::XMFLOAT2 delta, const std::vector<Collider*>& candidates,
+        int maxHits = 4, float skin = 0.001f);
+
+private:
+    static bool CircleCircle(DirectX::XMFLOAT2 start, DirectX::XMFLOAT2 delta, float radius, DirectX::XMFLOAT2 center, float* time);
+    static bool CircleRect(DirectX::XMFLOAT2 start, DirectX::XMFLOAT2 delta, float radius, DirectX::XMFLOAT2 center, DirectX::XMFLOAT2 half,
+        float* time, DirectX::XMFLOAT2* normal);
+};
@@ -0,0 +1,171 @@
+#include "SweptCollision.h"
+#include "ColliderStore.h"
+#include "SpatialHashGrid.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Runs the player's circle at a line of trees and a thin
+// wall at frame times from 60 fps down to a two second
+// hitch, the way CollisionManager::SweepCollider does, and
+// checks it never comes out the other side or inside
+// anything.  Only testing where each frame ends would let
+// it through
+// --------------------------------------------------------
+
+namespace
+{
+	const float PlayerRadius = 0.2f;
+	// what the camera moves at while running
+	const float RunSpeed = 10.0f;
+	const float TreeRadius = 0.4f;
+	// leaves gaps of 0.1, narrower than the player
+	const float TreeSpacing = 0.9f;
+	const float WallX = 20.0f;
+
+	bool Near(float a, float b)
+	{
+		return fabsf(a - b) < 1e-4f;
+	}
+
+	// whether the player would be inside any of them at position
+	bool Overlapping(XMFLOAT2 position, const std::vector<Collider*>& colliders)
+	{
+		for (Collider* col : colliders)
+		{
+			XMFLOAT2 center = col->GetCenter();
+			if (col->GetType() == Collider::circle)
+			{
+				float dx = position.x - center.x;
+				float dy = position.y - center.y;
+				float reach = PlayerRadius + col->GetRadius() - 1e-3f;
+				if (dx * dx + dy * dy < reach * reach) return true;
+			}
+			else
+			{
+				XMFLOAT2 half(col->GetSize().x / 2.0f, col->GetSize().y / 2.0f);
+				float px = fminf(fmaxf(position.x, center.x - half.x), center.x + half.x);
+				float py = fminf(fmaxf(position.y, center.y - half.y), center.y + half.y);
+				float dx = position.x - px;
+				float dy = position.y - py;
+				float reach = PlayerRadius - 1e-3f;
+				if (dx * dx + dy * dy < reach * reach) return true;
+			}
+		}
+		return false;
+	}
+}
+
+int main()
+{
+	ColliderStore* store = ColliderStore::Instance();
+	Collider* player = store->Get(store->CreateCircle(PlayerRadius));
+
+	// time of impact against one rectangle
+	Collider* box = store->Get(store->CreateRect(XMFLOAT2(2, 2)));
+	box->SetCenter(XMFLOAT2(10, 10));
+	SweptCollision::Hit hit;
+	CHECK(SweptCollision::CircleTimeOfImpact(player, XMFLOAT2(10, 5), XMFLOAT2(0, 10), box, &hit));
+	CHECK(Near(hit.time, (9.0f - PlayerRadius - 5.0f) / 10.0f));
+	CHECK(Near(hit.normal.x, 0.0f) && Near(hit.normal.y, -1.0f));
+	// diagonally into the corner, the normal points out of it
+	CHECK(SweptCollision::CircleTimeOfImpact(player, XMFLOAT2(5, 5), XMFLOAT2(10, 10), box, &hit));
+	CHECK(Near(hit.normal.x, -sqrtf(0.5f)) && Near(hit.normal.y, -sqrtf(0.5f)));
+	CHECK(Near(hit.time, (4.0f - PlayerRadius * sqrtf(0.5f)) / 10.0f));
+	CHECK(!SweptCollision::CircleTimeOfImpact(player, XMFLOAT2(5, 5), XMFLOAT2(-10, 10), box, &hit));
+	// starting inside, only going further in counts
+	CHECK(SweptCollision::CircleTimeOfImpact(player, XMFLOAT2(10, 8.9f), XMFLOAT2(0, 1), box, &hit) && hit.time == 0.0f);
+	CHECK(!SweptCollision::CircleTimeOfImpact(player, XMFLOAT2(10, 8.9f), XMFLOAT2(0, -1), box, &hit));
+
+	// and one circle
+	Collider* ball = store->Get(store->CreateCircle(1.0f));
+	ball->SetCenter(XMFLOAT2(0, 50));
+	CHECK(SweptCollision::CircleTimeOfImpact(player, XMFLOAT2(-10, 50), XMFLOAT2(20, 0), ball, &hit));
+	CHECK(Near(hit.time, (10.0f - 1.0f - PlayerRadius) / 20.0f));
+	CHECK(Near(hit.normal.x, -1.0f) && Near(hit.normal.y, 0.0f));
+
+	// the first hit skips triggers, disabled colliders and the mover itself
+	Collider* trigger = store->Get(store->CreateCircle(1.0f));
+	trigger->SetCenter(XMFLOAT2(-5, 50));
+	trigger->SetTrigger(true);
+	Collider* disabled = store->Get(store->CreateCircle(1.0f));
+	disabled->SetCenter(XMFLOAT2(-3, 50));
+	disabled->SetEnabled(false);
+	CHECK(SweptCollision::FirstHit(player, XMFLOAT2(-10, 50), XMFLOAT2(20, 0), { player, trigger, disabled, ball }, &hit));
+	CHECK(hit.other == ball);
+
+	// into a wall at an angle, it stops at the wall and slides along it instead of stopping dead
+	XMFLOAT2 slid = SweptCollision::MoveAndSlide(player, XMFLOAT2(9, 5), XMFLOAT2(2, 6), { box });
+	CHECK(slid.y <= 9.0f - PlayerRadius && slid.y > 9.0f - PlayerRadius - 0.01f);
+	CHECK(slid.x > 10.99f);
+
+	// the line of trees along x = 0 and a wall thinner than the player along x = 20
+	std::vector<Collider*> obstacles;
+	for (int i = -50; i <= 50; i++)
+	{
+		Collider* tree = store->Get(store->CreateCircle(TreeRadius));
+		tree->SetCenter(XMFLOAT2(0.0f, i * TreeSpacing));
+		obstacles.push_back(tree);
+	}
+	for (int i = -5; i <= 5; i++)
+	{
+		Collider* wall = store->Get(store->CreateRect(XMFLOAT2(0.05f, 10.0f)));
+		wall->SetCenter(XMFLOAT2(WallX, i * 10.0f));
+		obstacles.push_back(wall);
+	}
+	SpatialHashGrid grid;
+	grid.Build(obstacles);
+
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+	std::vector<Collider*> candidates;
+	for (float frameTime : { 1.0f / 60.0f, 0.1f, 0.25f, 0.5f, 1.0f, 2.0f })
+	{
+		int crossings = 0;
+		int endTestCrossings = 0;
+		int inside = 0;
+		int frames = 0;
+		TestTimer timer;
+		for (int run = 0; run < 200; run++)
+		{
+			XMFLOAT2 position(-3.0f + uniform(random) * 2.0f, uniform(random) * 30.0f);
+			XMFLOAT2 direction(1.0f, uniform(random) * 0.8f);
+			float length = sqrtf(direction.x * direction.x + direction.y * direction.y);
+			XMFLOAT2 move(direction.x / length * RunSpeed * frameTime, direction.y / length * RunSpeed * frameTime);
+
+			for (int frame = 0; frame < 60; frame++)
+			{
+				// what testing only the end of the move would have let through
+				XMFLOAT2 naive(position.x + move.x, position.y + move.y);
+				if ((position.x < 0.0f) != (naive.x < 0.0f) && fabsf(naive.y) < 50 * TreeSpacing && !Overlapping(naive, obstacles)) endTestCrossings++;
+
+				// what SweepCollider gathers
+				float reach = sqrtf(move.x * move.x + move.y * move.y) + PlayerRadius + 0.01f;
+				grid.GetCollidableObjects(XMFLOAT4(position.x - reach, position.y - reach, position.x + reach, position.y + reach), candidates);
+				player->SetCenter(position);
+				XMFLOAT2 end = SweptCollision::MoveAndSlide(player, position, move, candidates);
+
+				// past the ends of the line or the wall it can just walk around
+				auto crossesAt = [&](float x) { return position.y + (end.y - position.y) * (x - position.x) / (end.x - position.x); };
+				if ((position.x < 0.0f) != (end.x < 0.0f) && fabsf(crossesAt(0.0f)) < 50 * TreeSpacing) crossings++;
+				if ((position.x < WallX) != (end.x < WallX) && fabsf(crossesAt(WallX)) < 55.0f) crossings++;
+				if (Overlapping(end, obstacles)) inside++;
+				position = end;
+				frames++;
+			}
+		}
+		printf("%.3f s frames: %d crossings, %d inside, %d an end position test would have let through, %.2f us per move\n",
+			frameTime, crossings, inside, endTestCrossings, timer.Milliseconds() * 1000.0 / frames);
+		CHECK(crossings == 0);
+		CHECK(inside == 0);
+		// long frames jump the whole line of trees, that's what the sweep is for
+		if (frameTime >= 0.1f) CHECK(endTestCrossings > 0);
+	}
+
+	return TestResult();
+}
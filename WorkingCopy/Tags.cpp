@@ -0,0 +1,28 @@
+#include "Tags.h"
+
+std::vector<std::string>& Tags::Names()
+{
+	// index 0 is None
+	static std::vector<std::string> names(1);
+	return names;
+}
+
+unsigned int Tags::Intern(const char* name)
+{
+	if (name == nullptr) return None;
+
+	// there's only a handful of tags, and this only runs when one is set
+	std::vector<std::string>& names = Names();
+	for (unsigned int i = 1; i < names.size(); i++) {
+		if (names[i] == name) return i;
+	}
+	names.push_back(name);
+	return (unsigned int)names.size() - 1;
+}
+
+const char* Tags::GetName(unsigned int id)
+{
+	std::vector<std::string>& names = Names();
+	if (id == None || id >= names.size()) return nullptr;
+	return names[id].c_str();
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include <string>
+
+// --------------------------------------------------------
+// Turns tag names into small ids once, when they're set,
+// so comparing tags afterwards is comparing integers
+// --------------------------------------------------------
+class Tags
+{
+public:
+	// the id of entities without a tag
+	static const unsigned int None = 0;
+
+	// the same name always gets the same id, nullptr is None
+	static unsigned int Intern(const char* name);
+	// nullptr for None
+	static const char* GetName(unsigned int id);
+
+private:
+	static std::vector<std::string>& Names();
+};
+
@@ -0,0 +1,103 @@
+#include "TangentGenerator.h"
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	// triangles whose UVs span less than this have no usable tangent direction
+	const float MinUVArea = 1e-12f;
+}
+
+void TangentGenerator::Generate(Vertex* verts, int numVerts, const unsigned int* indices, int numIndices, float* handedness)
+{
+	if (numVerts <= 0) return;
+
+	// the tangents are summed in place, the bitangents only when their sign is wanted
+	for (int i = 0; i < numVerts; i++) verts[i].Tangent = XMFLOAT3(0, 0, 0);
+	std::vector<XMFLOAT3> bitangents(handedness != nullptr ? numVerts : 0, XMFLOAT3(0, 0, 0));
+
+	AccumulateTriangles(verts, indices, numIndices / 3, handedness != nullptr ? &bitangents[0] : nullptr);
+	FinishVertices(verts, numVerts, handedness != nullptr ? &bitangents[0] : nullptr, handedness);
+}
+
+void TangentGenerator::AccumulateTriangles(Vertex* verts, const unsigned int* indices, int numTriangles, XMFLOAT3* bitangents)
+{
+	// one triangle at a time, the math is cheap next to reading and adding into its corners
+	for (int tri = 0; tri < numTriangles; tri++)
+	{
+		const unsigned int* corner = &indices[tri * 3];
+		const Vertex& v1 = verts[corner[0]];
+		const Vertex& v2 = verts[corner[1]];
+		const Vertex& v3 = verts[corner[2]];
+
+		// edges relative to the first corner
+		float x1 = v2.Position.x - v1.Position.x;
+		float y1 = v2.Position.y - v1.Position.y;
+		float z1 = v2.Position.z - v1.Position.z;
+		float x2 = v3.Position.x - v1.Position.x;
+		float y2 = v3.Position.y - v1.Position.y;
+		float z2 = v3.Position.z - v1.Position.z;
+
+		float s1 = v2.UV.x - v1.UV.x;
+		float t1 = v2.UV.y - v1.UV.y;
+		float s2 = v3.UV.x - v1.UV.x;
+		float t2 = v3.UV.y - v1.UV.y;
+
+		// no UV area (or NaN UVs), nothing to add instead of dividing by zero
+		float det = s1 * t2 - s2 * t1;
+		if (!(fabsf(det) > MinUVArea)) continue;
+		float r = 1.0f / det;
+
+		XMFLOAT3 tangent((t2 * x1 - t1 * x2) * r, (t2 * y1 - t1 * y2) * r, (t2 * z1 - t1 * z2) * r);
+		for (int k = 0; k < 3; k++)
+		{
+			XMFLOAT3& sum = verts[corner[k]].Tangent;
+			sum.x += tangent.x;
+			sum.y += tangent.y;
+			sum.z += tangent.z;
+		}
+
+		if (bitangents == nullptr) continue;
+
+		XMFLOAT3 bitangent((s1 * x2 - s2 * x1) * r, (s1 * y2 - s2 * y1) * r, (s1 * z2 - s2 * z1) * r);
+		for (int k = 0; k < 3; k++)
+		{
+			XMFLOAT3& sum = bitangents[corner[k]];
+			sum.x += bitangent.x;
+			sum.y += bitangent.y;
+			sum.z += bitangent.z;
+		}
+	}
+}
+
+void TangentGenerator::FinishVertices(Vertex* verts, int numVerts, const XMFLOAT3* bitangents, float* handedness)
+{
+	for (int i = 0; i < numVerts; i++)
+	{
+		XMVECTOR normal = XMLoadFloat3(&verts[i].Normal);
+		XMVECTOR tangent = XMLoadFloat3(&verts[i].Tangent);
+
+		// Use Gram-Schmidt orthogonalize
+		tangent = XMVectorSubtract(tangent, XMVectorMultiply(normal, XMVector3Dot(normal, tangent)));
+
+		// nothing usable was summed here (or it was NaN), pick any direction along the surface
+		float lengthSq = XMVectorGetX(XMVector3LengthSq(tangent));
+		if (!(lengthSq >= 1e-20f))
+		{
+			XMVECTOR axis = fabsf(verts[i].Normal.x) < 0.9f ? XMVectorSet(1, 0, 0, 0) : XMVectorSet(0, 1, 0, 0);
+			tangent = XMVectorSubtract(axis, XMVectorMultiply(normal, XMVector3Dot(normal, axis)));
+			lengthSq = XMVectorGetX(XMVector3LengthSq(tangent));
+		}
+		// the length is already known, no need for XMVector3Normalize to find it again
+		tangent = XMVectorScale(tangent, 1.0f / sqrtf(lengthSq));
+		XMStoreFloat3(&verts[i].Tangent, tangent);
+
+		if (handedness != nullptr)
+		{
+			// -1 when the UVs are mirrored compared to cross(normal, tangent)
+			float side = XMVectorGetX(XMVector3Dot(XMVector3Cross(normal, tangent), XMLoadFloat3(&bitangents[i])));
+			handedness[i] = side < 0.0f ? -1.0f : 1.0f;
+		}
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Vertex.h"
+#include <vector>
+
+// --------------------------------------------------------
+// Builds per vertex tangents for an indexed triangle list.
+//
+// Triangles are summed straight into their corners, then
+// every vertex is orthogonalized and normalized in a second
+// flat pass.
+//
+// Triangles with no UV area add nothing, and vertices that
+// end up with no usable tangent get one perpendicular to
+// the normal instead of NaNs
+// --------------------------------------------------------
+class TangentGenerator
+{
+public:
+	// handedness (optional, numVerts long) gets +1 or -1, the sign of the bitangent
+	static void Generate(Vertex* verts, int numVerts, const unsigned int* indices, int numIndices, float* handedness = nullptr);
+
+private:
+	// sums each triangle's tangent into its corners' Tangent, and bitangent if asked for
+	static void AccumulateTriangles(Vertex* verts, const unsigned int* indices, int numTriangles, DirectX::XMFLOAT3* bitangents);
+	static void FinishVertices(Vertex* verts, int numVerts, const DirectX::XMFLOAT3* bitangents, float* handedness);
+};
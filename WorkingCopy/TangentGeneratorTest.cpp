@@ -0,0 +1,267 @@
+#include "TangentGenerator.h"
+#include "ObjParser.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Holds TangentGenerator to the one triangle at a time loop
+// Mesh::CalculateTangents used to run, on the game's models
+// and a million triangle grid, and times both.
+//
+// Where a vertex's triangles nearly cancel (the poles of the
+// sphere) the summed tangent is mostly rounding error, and
+// FMA or a different summing order can turn it anywhere in
+// the tangent plane.  Those vertices are only held to being
+// unit length and perpendicular to the normal
+// --------------------------------------------------------
+
+namespace
+{
+	// Mesh::CalculateTangents as it was
+	void OldTangents(Vertex* verts, int numVerts, const unsigned int* indices, int numIndices)
+	{
+		// Reset tangents
+		for (int i = 0; i < numVerts; i++)
+		{
+			verts[i].Tangent = DirectX::XMFLOAT3(0, 0, 0);
+		}
+
+		// Calculate tangents one whole triangle at a time
+		for (int i = 0; i + 2 < numIndices;)
+		{
+			// Grab indices and vertices of first triangle
+			unsigned int i1 = indices[i++];
+			unsigned int i2 = indices[i++];
+			unsigned int i3 = indices[i++];
+			Vertex* v1 = &verts[i1];
+			Vertex* v2 = &verts[i2];
+			Vertex* v3 = &verts[i3];
+
+			// Calculate vectors relative to triangle positions
+			float x1 = v2->Position.x - v1->Position.x;
+			float y1 = v2->Position.y - v1->Position.y;
+			float z1 = v2->Position.z - v1->Position.z;
+
+			float x2 = v3->Position.x - v1->Position.x;
+			float y2 = v3->Position.y - v1->Position.y;
+			float z2 = v3->Position.z - v1->Position.z;
+
+			// Do the same for vectors relative to triangle uv's
+			float s1 = v2->UV.x - v1->UV.x;
+			float t1 = v2->UV.y - v1->UV.y;
+
+			float s2 = v3->UV.x - v1->UV.x;
+			float t2 = v3->UV.y - v1->UV.y;
+
+			// Create vectors for tangent calculation
+			float r = 1.0f / (s1 * t2 - s2 * t1);
+
+			float tx = (t2 * x1 - t1 * x2) * r;
+			float ty = (t2 * y1 - t1 * y2) * r;
+			float tz = (t2 * z1 - t1 * z2) * r;
+
+			// Adjust tangents of each vert of the triangle
+			v1->Tangent.x += tx;
+			v1->Tangent.y += ty;
+			v1->Tangent.z += tz;
+
+			v2->Tangent.x += tx;
+			v2->Tangent.y += ty;
+			v2->Tangent.z += tz;
+
+			v3->Tangent.x += tx;
+			v3->Tangent.y += ty;
+			v3->Tangent.z += tz;
+		}
+
+		// Ensure all of the tangents are orthogonal to the normals
+		for (int i = 0; i < numVerts; i++)
+		{
+			// Grab the two vectors
+			DirectX::XMVECTOR normal =  XMLoadFloat3(&verts[i].Normal);
+			DirectX::XMVECTOR tangent =  XMLoadFloat3(&verts[i].Tangent);
+
+			// Use Gram-Schmidt orthogonalize
+			tangent = DirectX::XMVector3Normalize(
+				DirectX::XMVectorSubtract(tangent,DirectX::XMVectorMultiply(normal,DirectX::XMVector3Dot(normal, tangent))));
+
+			// Store the tangent
+			XMStoreFloat3(&verts[i].Tangent, tangent);
+		}
+	}
+
+	inline bool IsFinite(const XMFLOAT3& v) { return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z); }
+
+	inline float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return fabsf(a.x - b.x) + fabsf(a.y - b.y) + fabsf(a.z - b.z);
+	}
+
+	// how much of each vertex's summed tangent survives cancellation, the length of the
+	// sum over the sum of the lengths, both in the tangent plane.  Near 0 it's ill-conditioned
+	std::vector<float> Conditioning(const std::vector<Vertex>& verts, const std::vector<unsigned int>& indices)
+	{
+		std::vector<XMFLOAT3> sums(verts.size(), XMFLOAT3(0, 0, 0));
+		std::vector<double> lengths(verts.size(), 0.0);
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const Vertex* v[3] = { &verts[indices[i]], &verts[indices[i + 1]], &verts[indices[i + 2]] };
+			double s1 = v[1]->UV.x - v[0]->UV.x, t1 = v[1]->UV.y - v[0]->UV.y;
+			double s2 = v[2]->UV.x - v[0]->UV.x, t2 = v[2]->UV.y - v[0]->UV.y;
+			double det = s1 * t2 - s2 * t1;
+			if (fabs(det) <= 1e-12) continue;
+			double t[3] = {
+				(t2 * (v[1]->Position.x - v[0]->Position.x) - t1 * (v[2]->Position.x - v[0]->Position.x)) / det,
+				(t2 * (v[1]->Position.y - v[0]->Position.y) - t1 * (v[2]->Position.y - v[0]->Position.y)) / det,
+				(t2 * (v[1]->Position.z - v[0]->Position.z) - t1 * (v[2]->Position.z - v[0]->Position.z)) / det };
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int index = indices[i + k];
+				const XMFLOAT3& n = verts[index].Normal;
+				double along = t[0] * n.x + t[1] * n.y + t[2] * n.z;
+				double x = t[0] - n.x * along, y = t[1] - n.y * along, z = t[2] - n.z * along;
+				sums[index].x += (float)x;
+				sums[index].y += (float)y;
+				sums[index].z += (float)z;
+				lengths[index] += sqrt(x * x + y * y + z * z);
+			}
+		}
+
+		std::vector<float> conditioning(verts.size(), 0.0f);
+		for (size_t i = 0; i < verts.size(); i++)
+		{
+			const XMFLOAT3& sum = sums[i];
+			if (lengths[i] > 0) conditioning[i] = (float)(sqrt(sum.x * sum.x + sum.y * sum.y + sum.z * sum.z) / lengths[i]);
+		}
+		return conditioning;
+	}
+
+	void Compare(const char* name, const std::vector<Vertex>& mesh, const std::vector<unsigned int>& indices)
+	{
+		std::vector<Vertex> old = mesh;
+		std::vector<Vertex> generated = mesh;
+		std::vector<Vertex> handed = mesh;
+		std::vector<float> handedness(mesh.size());
+		int numVerts = (int)mesh.size();
+		int numIndices = (int)indices.size();
+
+		TestTimer oldTimer;
+		OldTangents(&old[0], numVerts, &indices[0], numIndices);
+		double oldMs = oldTimer.Milliseconds();
+
+		TestTimer generatedTimer;
+		TangentGenerator::Generate(&generated[0], numVerts, &indices[0], numIndices);
+		double generatedMs = generatedTimer.Milliseconds();
+
+		TestTimer handedTimer;
+		TangentGenerator::Generate(&handed[0], numVerts, &indices[0], numIndices, &handedness[0]);
+		double handedMs = handedTimer.Milliseconds();
+
+		// the old loop left NaNs where triangles had no UV area, only compare where it didn't
+		std::vector<float> conditioning = Conditioning(mesh, indices);
+		float maxError = 0;
+		int oldNaNs = 0;
+		int illConditioned = 0;
+		for (int i = 0; i < numVerts; i++)
+		{
+			const XMFLOAT3& normal = generated[i].Normal;
+			const XMFLOAT3& tangent = generated[i].Tangent;
+			CHECK(IsFinite(tangent));
+			CHECK(fabsf(tangent.x * tangent.x + tangent.y * tangent.y + tangent.z * tangent.z - 1.0f) < 1e-3f);
+			// OBJ normals are only unit length to a few digits
+			CHECK(fabsf(tangent.x * normal.x + tangent.y * normal.y + tangent.z * normal.z) < 2e-3f);
+			// asking for the handedness doesn't change the tangents
+			CHECK(Distance(tangent, handed[i].Tangent) == 0.0f);
+			CHECK(handedness[i] == 1.0f || handedness[i] == -1.0f);
+
+			if (!IsFinite(old[i].Tangent) || Distance(old[i].Tangent, XMFLOAT3(0, 0, 0)) == 0)
+			{
+				oldNaNs++;
+				continue;
+			}
+			if (conditioning[i] < 0.01f)
+			{
+				illConditioned++;
+				continue;
+			}
+			float error = Distance(old[i].Tangent, tangent);
+			if (error > maxError) maxError = error;
+		}
+
+		printf("%s: %d verts, %d triangles, old %.2f ms, new %.2f ms (%.1fx), with handedness %.2f ms, max difference %.1e, %d old NaNs, %d ill-conditioned\n",
+			name, numVerts, numIndices / 3, oldMs, generatedMs, oldMs / generatedMs, handedMs, maxError, oldNaNs, illConditioned);
+		CHECK(maxError < 1e-3f);
+		// only a few poles may be left out
+		CHECK(illConditioned <= numVerts / 50);
+	}
+
+	void CompareModel(const char* filename)
+	{
+		MeshData data;
+		CHECK(ObjParser::ParseFile(filename, data));
+		std::vector<Vertex> verts;
+		std::vector<unsigned int> indices;
+		ObjParser::WeldVertices(data, verts, indices);
+		Compare(filename, verts, indices);
+	}
+}
+
+int main()
+{
+	CompareModel("Models/Campfire.obj");
+	CompareModel("Models/helix.obj");
+	CompareModel("Models/sphere.obj");
+	CompareModel("Models/DeadTree.obj");
+
+	// a wavy grid, a million triangles
+	const int side = 708;
+	std::vector<Vertex> verts;
+	std::vector<unsigned int> indices;
+	for (int z = 0; z <= side; z++)
+	{
+		for (int x = 0; x <= side; x++)
+		{
+			Vertex v = {};
+			float dx = cosf(x * 0.05f) * cosf(z * 0.05f) * 0.05f;
+			float dz = -sinf(x * 0.05f) * sinf(z * 0.05f) * 0.05f;
+			float length = sqrtf(dx * dx + 1.0f + dz * dz);
+			v.Position = XMFLOAT3(x * 0.1f, sinf(x * 0.05f) * cosf(z * 0.05f), z * 0.1f);
+			v.Normal = XMFLOAT3(-dx / length, 1.0f / length, -dz / length);
+			v.UV = XMFLOAT2((float)x / side, (float)z / side);
+			verts.push_back(v);
+		}
+	}
+	for (int z = 0; z < side; z++)
+	{
+		for (int x = 0; x < side; x++)
+		{
+			unsigned int a = z * (side + 1) + x;
+			unsigned int b = a + 1;
+			unsigned int c = a + side + 1;
+			unsigned int d = c + 1;
+			indices.insert(indices.end(), { a, c, b, b, c, d });
+		}
+	}
+	Compare("grid", verts, indices);
+
+	// no UVs at all: the old loop made NaNs, these have to be usable anyway
+	Vertex flat[3] = {};
+	flat[0].Position = XMFLOAT3(0, 0, 0);
+	flat[1].Position = XMFLOAT3(1, 0, 0);
+	flat[2].Position = XMFLOAT3(0, 0, 1);
+	for (Vertex& v : flat) v.Normal = XMFLOAT3(0, 1, 0);
+	unsigned int triangle[3] = { 0, 1, 2 };
+	TangentGenerator::Generate(flat, 3, triangle, 3);
+	for (Vertex& v : flat)
+	{
+		CHECK(IsFinite(v.Tangent));
+		CHECK(fabsf(v.Tangent.y) < 1e-6f);
+		CHECK(fabsf(v.Tangent.x * v.Tangent.x + v.Tangent.z * v.Tangent.z - 1.0f) < 1e-4f);
+	}
+
+	return TestResult();
+}
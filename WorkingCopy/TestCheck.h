@@ -0,0 +1,41 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+// --------------------------------------------------------
+// What the test programs in CMakeLists.txt share.  CHECK
+// prints a failed condition and keeps going, main returns
+// TestResult() so ctest sees any of them
+// --------------------------------------------------------
+namespace TestCheck
+{
+	inline int& Failures()
+	{
+		static int failures = 0;
+		return failures;
+	}
+}
+
+#define CHECK(condition) \
+	do { if (!(condition)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); TestCheck::Failures()++; } } while (0)
+
+inline int TestResult()
+{
+	if (TestCheck::Failures() > 0) printf("%d checks failed\n", TestCheck::Failures());
+	return TestCheck::Failures() > 0 ? 1 : 0;
+}
+
+// wall clock time since it was made, for the numbers the tests print
+class TestTimer
+{
+public:
+	TestTimer() : start(std::chrono::high_resolution_clock::now()) {}
+
+	inline double Milliseconds() const
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+private:
+	std::chrono::high_resolution_clock::time_point start;
+};
@@ -0,0 +1,98 @@
+#include "Texture.h"
+#include "WICTextureLoader.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// bits per texel, or per texel of a 4x4 block for the BC formats
+	unsigned int BitsPerPixel(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+			return 128;
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+			return 64;
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+		case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		case DXGI_FORMAT_B8G8R8X8_UNORM:
+		case DXGI_FORMAT_R10G10B10A2_UNORM:
+		case DXGI_FORMAT_R32_FLOAT:
+		case DXGI_FORMAT_R16G16_UNORM:
+			return 32;
+		case DXGI_FORMAT_R16_UNORM:
+		case DXGI_FORMAT_R16_FLOAT:
+		case DXGI_FORMAT_R8G8_UNORM:
+		case DXGI_FORMAT_B5G6R5_UNORM:
+			return 16;
+		case DXGI_FORMAT_R8_UNORM:
+		case DXGI_FORMAT_A8_UNORM:
+		case DXGI_FORMAT_BC2_UNORM:
+		case DXGI_FORMAT_BC2_UNORM_SRGB:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC6H_UF16:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return 8;
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_UNORM:
+			return 4;
+		default:
+			// unknown formats are counted as plain RGBA
+			return 32;
+		}
+	}
+
+	bool IsBlockCompressed(DXGI_FORMAT format)
+	{
+		return format >= DXGI_FORMAT_BC1_TYPELESS && format <= DXGI_FORMAT_BC5_SNORM
+			|| format >= DXGI_FORMAT_BC6H_TYPELESS && format <= DXGI_FORMAT_BC7_UNORM_SRGB;
+	}
+}
+
+std::shared_ptr<Texture> Texture::Load(ID3D11Device* device, ID3D11DeviceContext* context, const wchar_t* file, bool srgb, D3D11_USAGE usage)
+{
+	// new CreateWICTextureFromFileEx doe gamma correction on hardware automaticcaly and faster
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+	HRESULT hr = CreateWICTextureFromFileEx(device, context, file, 0, usage, D3D11_BIND_SHADER_RESOURCE, 0, 0,
+		srgb ? WIC_LOADER_FORCE_SRGB : WIC_LOADER_IGNORE_SRGB, nullptr, texture->ReleaseAndGetAddressOf());
+	if (FAILED(hr)) return nullptr;
+	return texture;
+}
+
+size_t Texture::GetByteSize() const
+{
+	if (srv == nullptr) return 0;
+
+	ComPtr<ID3D11Resource> resource;
+	srv->GetResource(&resource);
+	ComPtr<ID3D11Texture2D> texture2D;
+	if (FAILED(resource.As(&texture2D))) return 0;
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture2D->GetDesc(&desc);
+
+	unsigned int bits = BitsPerPixel(desc.Format);
+	bool blocks = IsBlockCompressed(desc.Format);
+	size_t bytes = 0;
+	unsigned int width = desc.Width;
+	unsigned int height = desc.Height;
+	for (unsigned int mip = 0; mip < desc.MipLevels; mip++)
+	{
+		// compressed mips are stored as whole 4x4 blocks
+		size_t w = blocks ? ((width + 3) / 4) * 4 : width;
+		size_t h = blocks ? ((height + 3) / 4) * 4 : height;
+		bytes += w * h * bits / 8;
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	return bytes * desc.ArraySize;
+}
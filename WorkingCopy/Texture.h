@@ -0,0 +1,34 @@
+#pragma once
+
+#include "DXCore.h"
+#include <wrl/client.h>
+#include <memory>
+
+using namespace Microsoft::WRL;
+
+// --------------------------------------------------------
+// A shader resource view that can be shared between
+// materials and filled in after the material is made
+// (async loads only create the view at the load barrier)
+// --------------------------------------------------------
+class Texture
+{
+public:
+	Texture() = default;
+	explicit Texture(ComPtr<ID3D11ShaderResourceView> _srv) : srv(_srv) {}
+
+	// loads the file straight away through WIC
+	static std::shared_ptr<Texture> Load(ID3D11Device* device, ID3D11DeviceContext* context, const wchar_t* file, bool srgb, D3D11_USAGE usage);
+
+	inline ComPtr<ID3D11ShaderResourceView> GetSRV() const { return srv; }
+	// false until the view is created, and for good if the file couldn't be decoded
+	inline bool IsLoaded() const { return srv != nullptr; }
+	inline void SetSRV(ComPtr<ID3D11ShaderResourceView> _srv) { srv = _srv; }
+	inline ID3D11ShaderResourceView** ReleaseAndGetAddressOf() { return srv.ReleaseAndGetAddressOf(); }
+
+	// video memory held by the texture, including its mips
+	size_t GetByteSize() const;
+
+private:
+	ComPtr<ID3D11ShaderResourceView> srv;
+};
@@ -0,0 +1,57 @@
+#pragma once
+#include "AssetCache.h"
+#include <string>
+
+// --------------------------------------------------------
+// Everything that makes two texture loads different.
+// The same file read as sRGB colour and as linear data
+// are two different textures, so both flags are in the key
+// --------------------------------------------------------
+struct TextureKey
+{
+	std::string path;
+	bool srgb = true;
+	unsigned int usage = 0;  // how the renderer creates it, opaque to the cache
+
+	std::string ToString() const
+	{
+		return CanonicalAssetPath(path) + (srgb ? "|srgb|" : "|linear|") + std::to_string(usage);
+	}
+};
+
+// --------------------------------------------------------
+// Shares one texture between every material that asks for
+// the same (path, sRGB, usage).
+//
+// Like AssetCache this layer knows nothing about DirectX,
+// the owner of the device supplies the loader and sizer
+// --------------------------------------------------------
+template <typename T>
+class TextureCache
+{
+public:
+	using Loader = std::function<std::shared_ptr<T>(const TextureKey& key)>;
+	using Sizer = typename AssetCache<T>::Sizer;
+
+	TextureCache() = default;
+	TextureCache(Loader _loader, Sizer _sizer) : loader(_loader), cache(nullptr, _sizer) {}
+
+	// returns the shared texture, loading it the first time the key is seen
+	std::shared_ptr<T> Get(const TextureKey& key)
+	{
+		return cache.GetOrLoad(key.ToString(), [this, &key]() { return loader ? loader(key) : nullptr; });
+	}
+
+	inline bool Contains(const TextureKey& key) const { return cache.ContainsKey(key.ToString()); }
+	inline size_t Trim() { return cache.Trim(); }
+	inline size_t RemoveFailed(const std::function<bool(const T& texture)>& failed) { return cache.RemoveFailed(failed); }
+	inline void Clear() { cache.Clear(); }
+	inline void RecountBytes() { cache.RecountBytes(); }
+
+	inline size_t GetCount() const { return cache.GetCount(); }
+	inline const AssetCacheStats& GetStats() const { return cache.GetStats(); }
+
+private:
+	Loader loader;
+	AssetCache<T> cache;
+};
@@ -0,0 +1,100 @@
+#include "TextureCache.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Checks TextureCache shares one texture between every
+// spelling of a path, but keeps the sRGB, linear and
+// differently created reads of the same file apart, and
+// counts hits, misses and bytes the way the game reports
+// them.  No device, the loader hands out fake textures
+// --------------------------------------------------------
+
+namespace
+{
+	// what the cache holds in place of a Texture, sized like one once it's "loaded"
+	struct FakeTexture
+	{
+		TextureKey key;
+		size_t bytes;
+	};
+}
+
+int main()
+{
+	// the key: the canonical path, then the flags
+	TextureKey key;
+	key.path = "Textures\\Bark.png";
+	CHECK(key.ToString() == "textures/bark.png|srgb|0");
+	key.srgb = false;
+	key.usage = 2;
+	CHECK(key.ToString() == "textures/bark.png|linear|2");
+
+	std::vector<TextureKey> loaded;
+	TextureCache<FakeTexture> cache(
+		[&](const TextureKey& key) -> std::shared_ptr<FakeTexture> {
+			loaded.push_back(key);
+			if (CanonicalAssetPath(key.path) == "textures/missing.png") return nullptr;
+			return std::make_shared<FakeTexture>(FakeTexture{ key, key.srgb ? 4096u : 1024u });
+		},
+		[](const FakeTexture& texture) { return texture.bytes; });
+
+	// every spelling of the file is the same texture, the loader sees it once and as asked for
+	TextureKey bark{ "Textures/Bark.png" };
+	TextureKey barkAgain{ "./textures\\BARK.png" };
+	std::shared_ptr<FakeTexture> colour = cache.Get(bark);
+	CHECK(colour && cache.Get(barkAgain) == colour);
+	CHECK(loaded.size() == 1 && loaded[0].path == "Textures/Bark.png" && loaded[0].srgb);
+	CHECK(cache.Contains(barkAgain));
+
+	// the same file as linear data, or created another way, is another texture
+	TextureKey barkLinear{ "Textures/Bark.png", false };
+	TextureKey barkImmutable{ "Textures/Bark.png", true, 1 };
+	CHECK(!cache.Contains(barkLinear) && !cache.Contains(barkImmutable));
+	std::shared_ptr<FakeTexture> linear = cache.Get(barkLinear);
+	std::shared_ptr<FakeTexture> immutable = cache.Get(barkImmutable);
+	CHECK(linear && linear != colour && !linear->key.srgb);
+	CHECK(immutable && immutable != colour && immutable != linear && immutable->key.usage == 1);
+	CHECK(cache.Get(TextureKey{ "textures/bark.PNG", false }) == linear);
+	CHECK(loaded.size() == 3 && cache.GetCount() == 3);
+
+	const AssetCacheStats& stats = cache.GetStats();
+	CHECK(stats.hits == 2 && stats.misses == 3 && stats.failures == 0);
+	CHECK(stats.bytes == 4096 + 1024 + 4096);
+	CHECK(stats.bytesSaved == 4096 + 1024);
+
+	// failures aren't kept, the next request asks the loader again
+	CHECK(cache.Get(TextureKey{ "Textures/Missing.png" }) == nullptr);
+	CHECK(cache.Get(TextureKey{ "Textures/Missing.png" }) == nullptr);
+	CHECK(loaded.size() == 5 && stats.failures == 2 && cache.GetCount() == 3);
+
+	// a texture made while loading is cached empty: RecountBytes sizes it once it's
+	// loaded, RemoveFailed drops it if its load didn't finish
+	TextureKey normals{ "Textures/Bark_Normal.png", false };
+	std::shared_ptr<FakeTexture> pending = cache.Get(normals);
+	pending->bytes = 0;
+	cache.RecountBytes();
+	CHECK(stats.bytes == 4096 + 1024 + 4096);
+	CHECK(cache.RemoveFailed([](const FakeTexture& texture) { return texture.bytes == 0; }) == 1);
+	CHECK(stats.failures == 3 && !cache.Contains(normals) && cache.GetCount() == 3);
+	CHECK(cache.Get(normals) != pending && loaded.size() == 7);
+	pending.reset();
+
+	// Trim drops only what no material holds
+	CHECK(cache.Trim() == 1);
+	CHECK(!cache.Contains(normals) && cache.Contains(bark));
+	immutable.reset();
+	CHECK(cache.Trim() == 1);
+	CHECK(cache.GetCount() == 2 && stats.bytes == 4096 + 1024);
+	CHECK(cache.Contains(bark) && cache.Contains(barkLinear) && !cache.Contains(barkImmutable));
+	CHECK(cache.Trim() == 0);
+
+	cache.Clear();
+	CHECK(cache.GetCount() == 0 && stats.bytes == 0);
+	printf("%u hits, %u misses, %u failures\n", stats.hits, stats.misses, stats.failures);
+
+	return TestResult();
+}
@@ -0,0 +1,84 @@
+#include "TextureDecoder.h"
+#include <wincodec.h>
+
+#pragma comment(lib, "windowscodecs.lib")
+
+bool TextureDecoder::Decode(const wchar_t* filename, DecodedImage& image)
+{
+	// each call gets its own factory so threads never share WIC objects
+	ComPtr<IWICImagingFactory> factory;
+	if (FAILED(CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(&factory))))
+		return false;
+
+	ComPtr<IWICBitmapDecoder> decoder;
+	if (FAILED(factory->CreateDecoderFromFilename(filename, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, &decoder)))
+	{
+		wprintf(L"Failed to decode texture %s.\n", filename);
+		return false;
+	}
+
+	ComPtr<IWICBitmapFrameDecode> frame;
+	if (FAILED(decoder->GetFrame(0, &frame)))
+		return false;
+
+	UINT width = 0;
+	UINT height = 0;
+	frame->GetSize(&width, &height);
+	if (width == 0 || height == 0)
+		return false;
+
+	// convert whatever the file holds to plain RGBA
+	ComPtr<IWICFormatConverter> converter;
+	if (FAILED(factory->CreateFormatConverter(&converter)))
+		return false;
+	if (FAILED(converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0, WICBitmapPaletteTypeCustom)))
+		return false;
+
+	image.width = width;
+	image.height = height;
+	image.pixels.resize((size_t)width * height * 4);
+	return SUCCEEDED(converter->CopyPixels(nullptr, width * 4, (UINT)image.pixels.size(), &image.pixels[0]));
+}
+
+HRESULT TextureDecoder::CreateTexture(ID3D11Device* device, ID3D11DeviceContext* context, const DecodedImage& image, bool srgb, D3D11_USAGE usage, ID3D11ShaderResourceView** srv)
+{
+	// only a default texture can be rendered into to fill its mips, any other usage
+	// gets the top level alone as its initial data, like CreateWICTextureFromFileEx does
+	bool mips = usage == D3D11_USAGE_DEFAULT;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = image.width;
+	desc.Height = image.height;
+	desc.MipLevels = mips ? 0 : 1;
+	desc.ArraySize = 1;
+	desc.Format = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Usage = usage;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | (mips ? D3D11_BIND_RENDER_TARGET : 0);
+	desc.CPUAccessFlags = usage == D3D11_USAGE_DYNAMIC ? D3D11_CPU_ACCESS_WRITE : 0;
+	desc.MiscFlags = mips ? D3D11_RESOURCE_MISC_GENERATE_MIPS : 0;
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = &image.pixels[0];
+	data.SysMemPitch = image.width * 4;
+
+	ComPtr<ID3D11Texture2D> texture;
+	HRESULT hr = device->CreateTexture2D(&desc, mips ? nullptr : &data, &texture);
+	if (FAILED(hr)) return hr;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = desc.Format;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = (UINT)-1;
+	hr = device->CreateShaderResourceView(texture.Get(), &srvDesc, srv);
+	if (FAILED(hr)) return hr;
+
+	if (mips)
+	{
+		context->UpdateSubresource(texture.Get(), 0, nullptr, &image.pixels[0], image.width * 4, 0);
+		context->GenerateMips(*srv);
+	}
+	return S_OK;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "DXCore.h"
+#include <vector>
+
+// --------------------------------------------------------
+// An image decoded to 32 bit RGBA, ready to be uploaded
+// --------------------------------------------------------
+struct DecodedImage
+{
+	unsigned int width = 0;
+	unsigned int height = 0;
+	std::vector<unsigned char> pixels;
+};
+
+// --------------------------------------------------------
+// Splits texture loading in two so the slow part (reading
+// and decoding the file) can happen away from the device
+// --------------------------------------------------------
+class TextureDecoder
+{
+public:
+	// decodes any image WIC can read, safe to call from worker threads
+	static bool Decode(const wchar_t* filename, DecodedImage& image);
+
+	// creates a texture from the pixels, mipmapped when the usage is DEFAULT,
+	// must run on the thread that owns the context
+	static HRESULT CreateTexture(ID3D11Device* device, ID3D11DeviceContext* context, const DecodedImage& image, bool srgb, D3D11_USAGE usage, ID3D11ShaderResourceView** srv);
+};
@@ -0,0 +1,238 @@
+#include "TransformSystem.h"
+#include <thread>
+#include <algorithm>
+using namespace DirectX;
+
+namespace
+{
+	// leaves big enough to fill a few SIMD batches
+	QuadtreeSettings CullingSettings()
+	{
+		QuadtreeSettings settings;
+		settings.maxDepth = 8;
+		settings.leafCapacity = 32;
+		return settings;
+	}
+}
+
+TransformSystem::TransformSystem() : tree(CullingSettings())
+{
+}
+
+TransformSystem* TransformSystem::Instance()
+{
+	static TransformSystem system;
+	return &system;
+}
+
+TransformHandle TransformSystem::Create()
+{
+	unsigned int index;
+	if (!freeSlots.empty()) {
+		index = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else {
+		index = (unsigned int)generations.size();
+		positions.push_back(XMFLOAT3(0, 0, 0));
+		scales.push_back(XMFLOAT3(1, 1, 1));
+		rotations.push_back(XMFLOAT4(0, 0, 0, 1));
+		worlds.push_back(XMFLOAT4X4());
+		localBounds.push_back(Bounds());
+		boundsX.push_back(0);
+		boundsY.push_back(0);
+		boundsZ.push_back(0);
+		extentX.push_back(0);
+		extentY.push_back(0);
+		extentZ.push_back(0);
+		worldRadius.push_back(0);
+		for (std::vector<unsigned char>& set : visible) set.push_back(0);
+		dirty.push_back(0);
+		listed.push_back(0);
+		generations.push_back(0);
+	}
+
+	positions[index] = XMFLOAT3(0, 0, 0);
+	scales[index] = XMFLOAT3(1, 1, 1);
+	XMStoreFloat4(&rotations[index], XMQuaternionIdentity());
+	XMStoreFloat4x4(&worlds[index], XMMatrixIdentity());
+	localBounds[index] = Bounds();
+	for (std::vector<unsigned char>& set : visible) set[index] = 0;
+	MarkDirty(index);
+	treeStale = true;
+
+	TransformHandle handle;
+	handle.index = index;
+	handle.generation = generations[index];
+	return handle;
+}
+
+void TransformSystem::Destroy(TransformHandle handle)
+{
+	if (!IsAlive(handle)) return;
+
+	// it may still be in the dirty list, rebuilding it once more does no harm.
+	// it stays in the culling tree too until the next rebuild, Cull skips it
+	generations[handle.index]++;
+	freeSlots.push_back(handle.index);
+	for (std::vector<unsigned char>& set : visible) set[handle.index] = 0;
+}
+
+bool TransformSystem::IsAlive(TransformHandle handle) const
+{
+	return handle.index < generations.size() && generations[handle.index] == handle.generation;
+}
+
+void TransformSystem::SetPosition(TransformHandle handle, XMFLOAT3 position)
+{
+	positions[handle.index] = position;
+	MarkDirty(handle.index);
+}
+
+void TransformSystem::SetScale(TransformHandle handle, XMFLOAT3 scale)
+{
+	scales[handle.index] = scale;
+	MarkDirty(handle.index);
+}
+
+void TransformSystem::SetRotation(TransformHandle handle, XMFLOAT4 rotation)
+{
+	rotations[handle.index] = rotation;
+	MarkDirty(handle.index);
+}
+
+void TransformSystem::SetLocalBounds(TransformHandle handle, const Bounds& bounds)
+{
+	localBounds[handle.index] = bounds;
+	MarkDirty(handle.index);
+}
+
+Bounds TransformSystem::GetWorldBounds(TransformHandle handle) const
+{
+	Bounds bounds;
+	unsigned int i = handle.index;
+	bounds.center = XMFLOAT3(boundsX[i], boundsY[i], boundsZ[i]);
+	bounds.extents = XMFLOAT3(extentX[i], extentY[i], extentZ[i]);
+	bounds.radius = worldRadius[i];
+	return bounds;
+}
+
+void TransformSystem::Cull(const Frustum& frustum, CULL_VIEW view)
+{
+	size_t count = generations.size();
+	if (count == 0) return;
+
+	if (treeStale) {
+		// every live slot, the boxes are already in world space after Update
+		std::vector<unsigned char> freed(count, 0);
+		for (unsigned int slot : freeSlots) freed[slot] = 1;
+		std::vector<unsigned int> live;
+		live.reserve(count - freeSlots.size());
+		for (unsigned int i = 0; i < (unsigned int)count; i++) {
+			if (!freed[i]) live.push_back(i);
+		}
+		tree.Build(live, count, &boundsX[0], &boundsY[0], &boundsZ[0], &extentX[0], &extentY[0], &extentZ[0]);
+		treeStale = false;
+	}
+
+	std::vector<unsigned char>& set = visible[(int)view];
+	size_t kept = tree.Cull(frustum, &set[0]);
+	// freed slots can still be in the tree
+	for (unsigned int slot : freeSlots) {
+		kept -= set[slot];
+		set[slot] = 0;
+	}
+	visibleCount[(int)view] = kept;
+}
+
+void TransformSystem::Occlude(const OcclusionCuller& culler, int threads, CULL_VIEW view)
+{
+	size_t count = generations.size();
+	if (count == 0) return;
+
+	// freed slots are never marked visible, so they're skipped
+	std::vector<unsigned char>& set = visible[(int)view];
+	visibleCount[(int)view] -= culler.Cull(&boundsX[0], &boundsY[0], &boundsZ[0], &extentX[0], &extentY[0], &extentZ[0], count, &set[0], threads);
+}
+
+void TransformSystem::Update(int threads)
+{
+	size_t count = dirtyList.size();
+	size_t threadCount = (size_t)std::max(threads, 1);
+	threadCount = std::min(threadCount, count / MinPerThread);
+
+	if (threadCount <= 1) {
+		ComputeRange(0, count);
+	}
+	else {
+		// no slot is in the list twice, so the threads never write the same one
+		std::vector<std::thread> workers;
+		for (size_t t = 1; t < threadCount; t++) {
+			workers.emplace_back([this, t, threadCount, count]() { ComputeRange(count * t / threadCount, count * (t + 1) / threadCount); });
+		}
+		ComputeRange(0, count / threadCount);
+		for (std::thread& worker : workers) worker.join();
+	}
+
+	// the tree refits around whatever moved, unless it's being rebuilt anyway.
+	// anything brought up to date early by Update(handle) is still in the list
+	if (!treeStale) {
+		for (unsigned int index : dirtyList) {
+			if (!tree.Contains(index)) continue;
+			Bounds bounds;
+			bounds.center = XMFLOAT3(boundsX[index], boundsY[index], boundsZ[index]);
+			bounds.extents = XMFLOAT3(extentX[index], extentY[index], extentZ[index]);
+			tree.Move(index, bounds);
+		}
+	}
+
+	for (unsigned int index : dirtyList) listed[index] = 0;
+	dirtyList.clear();
+}
+
+void TransformSystem::Update(TransformHandle handle)
+{
+	// it stays in the dirty list, Update skips it unless it changes again
+	if (dirty[handle.index]) Compute(handle.index);
+}
+
+void TransformSystem::MarkDirty(unsigned int index)
+{
+	dirty[index] = 1;
+	if (listed[index]) return;
+	listed[index] = 1;
+	dirtyList.push_back(index);
+}
+
+void TransformSystem::ComputeRange(size_t start, size_t end)
+{
+	for (size_t i = start; i < end; i++) {
+		unsigned int index = dirtyList[i];
+		if (dirty[index]) Compute(index);
+	}
+}
+
+void TransformSystem::Compute(unsigned int index)
+{
+	// scaling * rotation * translation, without the two full matrix multiplies:
+	// the scale just scales the rotation's rows and the translation is the last row
+	const XMFLOAT3& scale = scales[index];
+	const XMFLOAT3& position = positions[index];
+	XMMATRIX world = XMMatrixRotationQuaternion(XMLoadFloat4(&rotations[index]));
+	world.r[0] = XMVectorScale(world.r[0], scale.x);
+	world.r[1] = XMVectorScale(world.r[1], scale.y);
+	world.r[2] = XMVectorScale(world.r[2], scale.z);
+	world.r[3] = XMVectorSet(position.x, position.y, position.z, 1.0f);
+
+	XMStoreFloat4x4(&worlds[index], XMMatrixTranspose(world));
+
+	Bounds bounds = localBounds[index].Transform(world);
+	boundsX[index] = bounds.center.x;
+	boundsY[index] = bounds.center.y;
+	boundsZ[index] = bounds.center.z;
+	extentX[index] = bounds.extents.x;
+	extentY[index] = bounds.extents.y;
+	extentZ[index] = bounds.extents.z;
+	worldRadius[index] = bounds.radius;
+	dirty[index] = 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "Bounds.h"
+#include "Frustum.h"
+#include "CullingQuadtree.h"
+#include "OcclusionCuller.h"
+#include <vector>
+#include <DirectXMath.h>
+
+// the cameras TransformSystem culls for, each keeps its own visible set
+enum class CULL_VIEW { CAMERA, SHADOW, COUNT };
+
+// refers to a transform in the TransformSystem
+struct TransformHandle
+{
+	unsigned int index = 0xFFFFFFFF;
+	unsigned int generation = 0;
+
+	inline bool IsValid() const { return index != 0xFFFFFFFF; }
+};
+
+// --------------------------------------------------------
+// Owns every entity's position, rotation, scale and world
+// matrix.  They live in parallel arrays indexed by slot,
+// and every change marks its slot dirty, so once a frame
+// Update can rebuild just the matrices that changed in one
+// pass over contiguous memory instead of visiting every
+// entity through its shared_ptr.
+//
+// Each one also has model space bounds, which Update
+// carries into world space with the matrix.  The world
+// boxes are kept as parallel arrays too, and a
+// CullingQuadtree over them lets Cull throw away or accept
+// whole patches of the world at once, testing only what's
+// near the edge of the frustum in SIMD batches.  It's
+// rebuilt when transforms are created and refitted after
+// Update moves them.  Occlude can then take out whatever an
+// OcclusionCuller finds hidden
+//
+// Slots are reused once freed, each one keeps a generation
+// so handles to a destroyed transform can be told apart
+// --------------------------------------------------------
+class TransformSystem
+{
+public:
+	TransformSystem();
+
+	// the system every entity keeps its transform in
+	static TransformSystem* Instance();
+
+	// at the origin, unrotated and unscaled
+	TransformHandle Create();
+	void Destroy(TransformHandle handle);
+	bool IsAlive(TransformHandle handle) const;
+
+	// the handle isn't checked, it has to be alive
+	inline DirectX::XMFLOAT3 GetPosition(TransformHandle handle) const { return positions[handle.index]; }
+	inline DirectX::XMFLOAT3 GetScale(TransformHandle handle) const { return scales[handle.index]; }
+	inline DirectX::XMFLOAT4 GetRotation(TransformHandle handle) const { return rotations[handle.index]; }
+	// transposed for the shaders, only up to date after Update
+	inline const DirectX::XMFLOAT4X4& GetWorldMatrix(TransformHandle handle) const { return worlds[handle.index]; }
+	inline bool IsDirty(TransformHandle handle) const { return dirty[handle.index] != 0; }
+	// world space bounds, only up to date after Update
+	Bounds GetWorldBounds(TransformHandle handle) const;
+	// from the last Cull for that view
+	inline bool IsVisible(TransformHandle handle, CULL_VIEW view = CULL_VIEW::CAMERA) const { return visible[(int)view][handle.index] != 0; }
+
+	void SetPosition(TransformHandle handle, DirectX::XMFLOAT3 position);
+	void SetScale(TransformHandle handle, DirectX::XMFLOAT3 scale);
+	void SetRotation(TransformHandle handle, DirectX::XMFLOAT4 rotation);
+	// model space, usually the mesh's
+	void SetLocalBounds(TransformHandle handle, const Bounds& bounds);
+
+	// rebuilds the world matrix of every dirty transform, split between up to threads threads
+	void Update(int threads = 1);
+	// rebuilds just this one now if it's dirty
+	void Update(TransformHandle handle);
+	// marks every transform whose world box is at least partly inside the frustum as
+	// visible to view, call after Update
+	void Cull(const Frustum& frustum, CULL_VIEW view = CULL_VIEW::CAMERA);
+	// then unmarks the ones hidden behind what the culler rasterized, call after its Render
+	void Occlude(const OcclusionCuller& culler, int threads = 1, CULL_VIEW view = CULL_VIEW::CAMERA);
+
+	inline size_t GetCount() const { return generations.size() - freeSlots.size(); }
+	// how many changed since the last Update, including any already rebuilt by Update(handle)
+	inline size_t GetDirtyCount() const { return dirtyList.size(); }
+	// how many the last Cull for that view kept
+	inline size_t GetVisibleCount(CULL_VIEW view = CULL_VIEW::CAMERA) const { return visibleCount[(int)view]; }
+	inline const CullingQuadtree& GetCullingTree() const { return tree; }
+
+private:
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<DirectX::XMFLOAT3> scales;
+	std::vector<DirectX::XMFLOAT4> rotations;
+	std::vector<DirectX::XMFLOAT4X4> worlds;
+	std::vector<Bounds> localBounds;
+	// world boxes for Cull
+	std::vector<float> boundsX;
+	std::vector<float> boundsY;
+	std::vector<float> boundsZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+	std::vector<float> worldRadius;
+	std::vector<unsigned char> visible[(int)CULL_VIEW::COUNT];
+	size_t visibleCount[(int)CULL_VIEW::COUNT] = {};
+	CullingQuadtree tree;
+	// slots were created since the tree was built
+	bool treeStale = true;
+	std::vector<unsigned char> dirty;
+	std::vector<unsigned int> generations;
+	std::vector<unsigned int> freeSlots;
+	// every slot changed since the last Update, once each, so Update doesn't have to look at
+	// the rest.  ones Update(handle) already rebuilt stay listed, the tree still has to move them
+	std::vector<unsigned int> dirtyList;
+	// 1 for each slot in dirtyList, dirty or not
+	std::vector<unsigned char> listed;
+
+	// fewer dirty transforms than this aren't worth starting a thread for
+	static const unsigned int MinPerThread = 4096;
+
+	void MarkDirty(unsigned int index);
+	void Compute(unsigned int index);
+	void ComputeRange(size_t start, size_t end);
+};
@@ -0,0 +1,229 @@
+#include "TransformSystem.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Checks TransformSystem builds the same world matrices as
+// Entity did before it, threaded or not, that transforms
+// brought up to date early with Update(handle) and changed
+// again are rebuilt once more and not listed twice, and
+// that culling sees where they moved to.  Then times a
+// frame against the entity by entity loop
+// --------------------------------------------------------
+
+namespace
+{
+	// Entity's fields and ComputeWorldMatrix before the TransformSystem
+	struct OldEntity
+	{
+		XMFLOAT4X4 worldMatrix;
+		XMFLOAT3 position;
+		XMFLOAT3 scale;
+		XMFLOAT4 rotation;
+		bool isDirty = true;
+
+		void ComputeWorldMatrix()
+		{
+			if (!isDirty) return;
+			XMMATRIX translation = XMMatrixTranslation(position.x, position.y, position.z);
+			XMMATRIX scaling = XMMatrixScaling(scale.x, scale.y, scale.z);
+			XMMATRIX rotating = XMMatrixRotationQuaternion(XMLoadFloat4(&rotation));
+			XMStoreFloat4x4(&worldMatrix, XMMatrixTranspose(scaling * rotating * translation));
+			isDirty = false;
+		}
+	};
+
+	float Difference(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		float largest = 0.0f;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++) largest = fmaxf(largest, fabsf(a.m[i][j] - b.m[i][j]));
+		}
+		return largest;
+	}
+
+	// a view looking down -z from the origin, the way Camera builds it
+	Frustum LookingDownZ()
+	{
+		XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0, 0, 0, 0), XMVectorSet(0, 0, -1, 0), XMVectorSet(0, 1, 0, 0));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(0.25f * XM_PI, 16.0f / 9.0f, 0.1f, 100.0f);
+		return Frustum(view * projection);
+	}
+
+	// times the entity by entity loop against TransformSystem::Update over count transforms,
+	// first with every one moving each frame and then with one in a hundred
+	void Benchmark(int count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+		Bounds unitBox = Bounds::FromMinMax(XMFLOAT3(-1, 0, -1), XMFLOAT3(1, 4, 1));
+		TransformSystem system;
+		std::vector<TransformHandle> handles;
+		std::vector<std::shared_ptr<OldEntity>> olds;
+		std::vector<std::unique_ptr<char[]>> other;
+		for (int i = 0; i < count; i++)
+		{
+			olds.push_back(std::make_shared<OldEntity>());
+			other.emplace_back(new char[64 + random() % 512]);
+			OldEntity& old = *olds[i];
+			old.position = XMFLOAT3(uniform(random) * 150, uniform(random) * 3, uniform(random) * 150);
+			old.scale = XMFLOAT3(1, 1, 1);
+			old.rotation = XMFLOAT4(0, 0, 0, 1);
+			old.ComputeWorldMatrix();
+			TransformHandle handle = system.Create();
+			system.SetPosition(handle, old.position);
+			system.SetLocalBounds(handle, unitBox);
+			handles.push_back(handle);
+		}
+		system.Update(1);
+
+		const int frames = 10;
+		for (int stride : { 1, 100 })
+		{
+			double oldMs = 0.0;
+			double newMs = 0.0;
+			for (int frame = 0; frame < frames; frame++)
+			{
+				// a different hundredth each frame, so the static case doesn't keep hitting the same ones
+				for (int i = frame % stride; i < count; i += stride)
+				{
+					olds[i]->position.y += 0.01f;
+					olds[i]->isDirty = true;
+					system.SetPosition(handles[i], olds[i]->position);
+				}
+				TestTimer timer;
+				for (const std::shared_ptr<OldEntity>& old : olds) old->ComputeWorldMatrix();
+				oldMs += timer.Milliseconds();
+				timer = TestTimer();
+				system.Update(1);
+				newMs += timer.Milliseconds();
+			}
+			printf("%d transforms, 1 in %d moving: %.3f ms entity by entity, %.3f ms through the TransformSystem\n",
+				count, stride, oldMs / frames, newMs / frames);
+			CHECK(system.GetDirtyCount() == 0);
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+	Bounds unitBox = Bounds::FromMinMax(XMFLOAT3(-1, 0, -1), XMFLOAT3(1, 4, 1));
+
+	// enough dirty transforms that Update splits them between threads
+	const int count = 40000;
+	TransformSystem single;
+	TransformSystem threaded;
+	// behind shared_ptrs like Game's entities, made between everything else the game allocates
+	std::vector<std::shared_ptr<OldEntity>> olds;
+	std::vector<std::unique_ptr<char[]>> other;
+	std::vector<TransformHandle> singleHandles;
+	std::vector<TransformHandle> threadedHandles;
+	for (int i = 0; i < count; i++)
+	{
+		olds.push_back(std::make_shared<OldEntity>());
+		other.emplace_back(new char[64 + random() % 512]);
+		OldEntity& old = *olds[i];
+		old.position = XMFLOAT3(uniform(random) * 150, uniform(random) * 3, uniform(random) * 150);
+		old.scale = XMFLOAT3(1 + uniform(random) * 0.5f, 1 + uniform(random) * 0.5f, 1 + uniform(random) * 0.5f);
+		XMStoreFloat4(&old.rotation, XMQuaternionRotationAxis(XMVector3Normalize(XMVectorSet(uniform(random), 1, uniform(random), 0)), uniform(random) * XM_PI));
+
+		for (TransformSystem* system : { &single, &threaded })
+		{
+			TransformHandle handle = system->Create();
+			system->SetPosition(handle, old.position);
+			system->SetScale(handle, old.scale);
+			system->SetRotation(handle, old.rotation);
+			system->SetLocalBounds(handle, unitBox);
+			(system == &single ? singleHandles : threadedHandles).push_back(handle);
+		}
+	}
+	CHECK(single.GetDirtyCount() == (size_t)count);
+
+	// some brought up to date early, then changed again before the frame's Update
+	for (int i = 0; i < count; i += 3)
+	{
+		for (TransformSystem* system : { &single, &threaded })
+		{
+			TransformHandle handle = (system == &single ? singleHandles : threadedHandles)[i];
+			system->Update(handle);
+			CHECK(!system->IsDirty(handle));
+			if (i % 2 == 0)
+			{
+				XMFLOAT3 position = olds[i]->position;
+				system->SetPosition(handle, XMFLOAT3(position.x + 1, position.y, position.z));
+			}
+		}
+		if (i % 2 == 0) olds[i]->position.x += 1;
+	}
+	// nothing listed twice
+	CHECK(single.GetDirtyCount() == (size_t)count);
+	CHECK(threaded.GetDirtyCount() == (size_t)count);
+
+	single.Update(1);
+	threaded.Update(4);
+	CHECK(single.GetDirtyCount() == 0 && threaded.GetDirtyCount() == 0);
+
+	float largest = 0.0f;
+	int different = 0;
+	int wrongBounds = 0;
+	for (int i = 0; i < count; i++)
+	{
+		olds[i]->ComputeWorldMatrix();
+		const XMFLOAT4X4& world = single.GetWorldMatrix(singleHandles[i]);
+		largest = fmaxf(largest, Difference(world, olds[i]->worldMatrix));
+		if (Difference(world, threaded.GetWorldMatrix(threadedHandles[i])) != 0.0f) different++;
+
+		Bounds expected = unitBox.Transform(XMMatrixTranspose(XMLoadFloat4x4(&olds[i]->worldMatrix)));
+		Bounds bounds = single.GetWorldBounds(singleHandles[i]);
+		if (fabsf(bounds.center.x - expected.center.x) > 1e-3f || fabsf(bounds.extents.y - expected.extents.y) > 1e-3f || fabsf(bounds.radius - expected.radius) > 1e-3f) wrongBounds++;
+	}
+	printf("largest difference from the old world matrices %g\n", largest);
+	CHECK(largest < 1e-4f);
+	CHECK(different == 0);
+	CHECK(wrongBounds == 0);
+
+	// one moved into view after being rebuilt early still gets refitted in the culling tree
+	TransformSystem culled;
+	TransformHandle inView = culled.Create();
+	TransformHandle moving = culled.Create();
+	culled.SetLocalBounds(inView, unitBox);
+	culled.SetLocalBounds(moving, unitBox);
+	culled.SetPosition(inView, XMFLOAT3(0, 0, -20));
+	culled.SetPosition(moving, XMFLOAT3(0, 0, 50));
+	culled.Update();
+	Frustum frustum = LookingDownZ();
+	culled.Cull(frustum);
+	CHECK(culled.IsVisible(inView) && !culled.IsVisible(moving));
+
+	culled.SetPosition(moving, XMFLOAT3(5, 0, -30));
+	culled.Update(moving);
+	culled.SetPosition(moving, XMFLOAT3(3, 0, -30));
+	CHECK(culled.GetDirtyCount() == 1);
+	culled.Update();
+	culled.Cull(frustum);
+	CHECK(culled.IsVisible(inView) && culled.IsVisible(moving));
+	CHECK(culled.GetWorldBounds(moving).center.x == 3.0f);
+
+	// rebuilt early and not touched again, it's only refitted
+	culled.SetPosition(moving, XMFLOAT3(0, 0, 60));
+	culled.Update(moving);
+	XMFLOAT4X4 before = culled.GetWorldMatrix(moving);
+	culled.Update();
+	culled.Cull(frustum);
+	CHECK(!culled.IsVisible(moving));
+	CHECK(Difference(before, culled.GetWorldMatrix(moving)) == 0.0f);
+
+	// what a frame costs for a small and a big world, with everything moving and with
+	// most of it standing still the way the forest does
+	for (int size : { 10000, 100000 }) Benchmark(size, random);
+
+	return TestResult();
+}
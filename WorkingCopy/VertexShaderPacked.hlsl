@@ -0,0 +1,57 @@
+#include "packedvertex.hlsli"
+
+// Same as VertexShader.hlsl, for meshes cooked with PackedVertex
+cbuffer externalData : register(b0)
+{
+	matrix world;
+	matrix view;
+	matrix projection;
+
+	matrix shadowView;
+	matrix shadowProjection;
+
+	// the mesh's VertexQuantization
+	float3 positionOffset;
+	float3 positionScale;
+};
+
+// Must match VertexShader.hlsl's output, the same pixel shader is used
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+	float3 normal		: NORMAL;
+	float2 uv			: TEXCOORD;
+	float3 worldPos		: POSITION;
+	float3 tangent		: TANGENT;
+	float4 posForShadow : SHADOWPOS;
+};
+
+// --------------------------------------------------------
+// The entry point (main method) for our vertex shader
+// --------------------------------------------------------
+VertexToPixel main(PackedVertexInput input)
+{
+	VertexToPixel output;
+
+	// unpack the vertex, then carry on like VertexShader.hlsl
+	float3 position = UnpackPosition(input.position, positionOffset, positionScale);
+	float3 normal = DecodeOctahedral(input.normal);
+	float3 tangent = DecodeOctahedral(input.tangent);
+
+	matrix worldViewProj = mul(mul(world, view), projection);
+	output.position = mul(float4(position, 1.0f), worldViewProj);
+
+	// calculate shadow positions
+	matrix shadowWVP = mul(mul(world, shadowView), shadowProjection);
+	output.posForShadow = mul(float4(position, 1.0f), shadowWVP);
+
+	// calculate normals and tangents
+	float3x3 worldNoTran = (float3x3)world;
+	output.normal = normalize(mul(normal, worldNoTran));
+	output.tangent = normalize(mul(tangent, worldNoTran));
+
+	output.uv = input.uv;
+	output.worldPos = mul(float4(position, 1.0f), world).xyz;
+
+	return output;
+}
@@ -0,0 +1,31 @@
+// Include guard
+#ifndef _PACKED_VERTEX_HLSL
+#define _PACKED_VERTEX_HLSL
+
+// Matches PackedVertex and PackedVertexLayout in the C++ code.
+// The input assembler has already turned the UNORM/SNORM/half
+// values into floats, only the bounds and octahedral decode are left
+struct PackedVertexInput
+{
+	float4 position		: POSITION;     // 0-1 inside the mesh's bounds
+	float2 normal		: NORMAL;       // octahedral
+	float2 uv			: TEXCOORD;
+	float2 tangent		: TANGENT;      // octahedral
+};
+
+// position = offset + unorm * scale, see VertexQuantization
+float3 UnpackPosition(float4 packedPosition, float3 offset, float3 scale)
+{
+	return offset + packedPosition.xyz * scale;
+}
+
+// same math as VertexPacker::DecodeOctahedral()
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 v = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float t = saturate(-v.z);
+	v.xy += (v.xy >= 0.0f) ? -t : t;
+	return normalize(v);
+}
+
+#endif